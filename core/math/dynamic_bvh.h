@@ -250,7 +250,7 @@ private:
 
 	void _extract_leaves(Node *p_node, List<ID> *r_elements);
 
-	_FORCE_INLINE_ bool _ray_aabb(const Vector3 &rayFrom, const Vector3 &rayInvDirection, const unsigned int raySign[3], const Vector3 bounds[2], real_t &tmin, real_t lambda_min, real_t lambda_max) {
+	_FORCE_INLINE_ bool _ray_aabb(const Vector3 &rayFrom, const Vector3 &rayInvDirection, const unsigned int raySign[3], const Vector3 bounds[2], real_t &tmin, real_t lambda_min, real_t lambda_max) const {
 		real_t tmax, tymin, tymax, tzmin, tzmax;
 		tmin = (bounds[raySign[0]].x - rayFrom.x) * rayInvDirection.x;
 		tmax = (bounds[1 - raySign[0]].x - rayFrom.x) * rayInvDirection.x;
@@ -306,11 +306,11 @@ public:
 	};
 
 	template <class QueryResult>
-	_FORCE_INLINE_ void aabb_query(const AABB &p_aabb, QueryResult &r_result);
+	_FORCE_INLINE_ void aabb_query(const AABB &p_aabb, QueryResult &r_result) const;
 	template <class QueryResult>
 	_FORCE_INLINE_ void convex_query(const Plane *p_planes, int p_plane_count, const Vector3 *p_points, int p_point_count, QueryResult &r_result);
 	template <class QueryResult>
-	_FORCE_INLINE_ void ray_query(const Vector3 &p_from, const Vector3 &p_to, QueryResult &r_result);
+	_FORCE_INLINE_ void ray_query(const Vector3 &p_from, const Vector3 &p_to, QueryResult &r_result) const;
 
 	void set_index(uint32_t p_index);
 	uint32_t get_index() const;
@@ -319,7 +319,7 @@ public:
 };
 
 template <class QueryResult>
-void DynamicBVH::aabb_query(const AABB &p_box, QueryResult &r_result) {
+void DynamicBVH::aabb_query(const AABB &p_box, QueryResult &r_result) const {
 	if (!bvh_root) {
 		return;
 	}
@@ -417,7 +417,7 @@ void DynamicBVH::convex_query(const Plane *p_planes, int p_plane_count, const Ve
 	} while (depth > 0);
 }
 template <class QueryResult>
-void DynamicBVH::ray_query(const Vector3 &p_from, const Vector3 &p_to, QueryResult &r_result) {
+void DynamicBVH::ray_query(const Vector3 &p_from, const Vector3 &p_to, QueryResult &r_result) const {
 	if (!bvh_root) {
 		return;
 	}
@@ -729,6 +729,8 @@ public:
 	Variant callv(const StringName &p_method, const Array &p_args);
 	virtual Variant call(const StringName &p_method, const Variant **p_args, int p_argcount, Callable::CallError &r_error);
 	Variant call(const StringName &p_name, VARIANT_ARG_LIST); // C++ helper
+	// Classes overriding call() return true, so callers caching the method lookups (like GDScript) still go through it.
+	virtual bool has_custom_call() const { return false; }
 
 	void notification(int p_notification, bool p_reversed = false);
 	virtual String to_string();
@@ -821,6 +823,21 @@ public:
 bool predelete_handler(Object *p_object);
 void postinitialize_handler(Object *p_object);
 
+#ifdef DEBUG_ENABLED
+// Prevents the object from being freed while one of its methods is running.
+struct _ObjectDebugLock {
+	Object *obj;
+
+	_ObjectDebugLock(Object *p_obj) {
+		obj = p_obj;
+		obj->_lock_index.ref();
+	}
+	~_ObjectDebugLock() {
+		obj->_lock_index.unref();
+	}
+};
+#endif
+
 class ObjectDB {
 //this needs to add up to 63, 1 bit is for reference
 #define OBJECTDB_VALIDATOR_BITS 39
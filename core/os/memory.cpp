@@ -33,6 +33,10 @@
 #include "core/error/error_macros.h"
 #include "core/templates/safe_refcount.h"
 
+#ifdef SMALL_OBJECT_ALLOCATOR_ENABLED
+#include "core/os/small_object_allocator.h"
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -65,6 +69,16 @@ SafeNumeric<uint64_t> Memory::max_usage;
 
 SafeNumeric<uint64_t> Memory::alloc_count;
 
+#ifdef SMALL_OBJECT_ALLOCATOR_ENABLED
+#define _raw_alloc(m_size) SmallObjectAllocator::alloc(m_size)
+#define _raw_realloc(m_mem, m_size) SmallObjectAllocator::realloc(m_mem, m_size)
+#define _raw_free(m_mem) SmallObjectAllocator::free(m_mem)
+#else
+#define _raw_alloc(m_size) malloc(m_size)
+#define _raw_realloc(m_mem, m_size) realloc(m_mem, m_size)
+#define _raw_free(m_mem) free(m_mem)
+#endif
+
 void *Memory::alloc_static(size_t p_bytes, bool p_pad_align) {
 #ifdef DEBUG_ENABLED
 	bool prepad = true;
@@ -72,7 +86,7 @@ void *Memory::alloc_static(size_t p_bytes, bool p_pad_align) {
 	bool prepad = p_pad_align;
 #endif
 
-	void *mem = malloc(p_bytes + (prepad ? PAD_ALIGN : 0));
+	void *mem = _raw_alloc(p_bytes + (prepad ? PAD_ALIGN : 0));
 
 	ERR_FAIL_COND_V(!mem, nullptr);
 
@@ -121,12 +135,12 @@ void *Memory::realloc_static(void *p_memory, size_t p_bytes, bool p_pad_align) {
 #endif
 
 		if (p_bytes == 0) {
-			free(mem);
+			_raw_free(mem);
 			return nullptr;
 		} else {
 			*s = p_bytes;
 
-			mem = (uint8_t *)realloc(mem, p_bytes + PAD_ALIGN);
+			mem = (uint8_t *)_raw_realloc(mem, p_bytes + PAD_ALIGN);
 			ERR_FAIL_COND_V(!mem, nullptr);
 
 			s = (uint64_t *)mem;
@@ -136,7 +150,7 @@ void *Memory::realloc_static(void *p_memory, size_t p_bytes, bool p_pad_align) {
 			return mem + PAD_ALIGN;
 		}
 	} else {
-		mem = (uint8_t *)realloc(mem, p_bytes);
+		mem = (uint8_t *)_raw_realloc(mem, p_bytes);
 
 		ERR_FAIL_COND_V(mem == nullptr && p_bytes > 0, nullptr);
 
@@ -165,9 +179,9 @@ void Memory::free_static(void *p_ptr, bool p_pad_align) {
 		mem_usage.sub(*s);
 #endif
 
-		free(mem);
+		_raw_free(mem);
 	} else {
-		free(mem);
+		_raw_free(mem);
 	}
 }
 
@@ -0,0 +1,449 @@
+/*************************************************************************/
+/*  small_object_allocator.cpp                                           */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "small_object_allocator.h"
+
+#include "core/error/error_macros.h"
+#include "core/os/spin_lock.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <new>
+
+#define CHUNK_BITS 16
+#define CHUNK_SIZE (size_t(1) << CHUNK_BITS)
+#define CHUNK_HEADER_SIZE 64
+#define CHUNKS_PER_SUPERBLOCK 16
+
+// The chunk map has a bit per chunk-sized range of the first 2^48 bytes of
+// address space, in 2^16 leaves. The root and the leaves are allocated with the
+// first superblock they cover, so builds without the allocator enabled don't
+// pay for them.
+#define CHUNK_MAP_ADDRESS_BITS 48
+#define CHUNK_MAP_LEAF_BITS 16
+#define CHUNK_MAP_ROOT_SIZE (1 << (CHUNK_MAP_ADDRESS_BITS - CHUNK_BITS - CHUNK_MAP_LEAF_BITS))
+#define CHUNK_MAP_LEAF_WORDS ((1 << CHUNK_MAP_LEAF_BITS) / 64)
+
+struct SmallObjectThreadCache;
+
+struct SmallObjectChunk {
+	SmallObjectThreadCache *owner = nullptr;
+	// In the owner list of chunks with free blocks, when `listed`.
+	SmallObjectChunk *prev = nullptr;
+	SmallObjectChunk *next = nullptr;
+	void *free_list = nullptr;
+	uint8_t *bump = nullptr; // Blocks from here on were never allocated.
+	uint32_t used = 0;
+	uint32_t capacity = 0;
+	uint32_t block_size = 0;
+	uint8_t size_class = 0;
+	bool listed = false;
+};
+
+static_assert(sizeof(SmallObjectChunk) <= CHUNK_HEADER_SIZE, "Chunk header doesn't fit before the first block.");
+
+struct SmallObjectThreadCache {
+	SmallObjectChunk *chunks[SmallObjectAllocator::SIZE_CLASS_COUNT] = {};
+	// Blocks freed by other threads, linked through their first word.
+	std::atomic<void *> remote_frees = { nullptr };
+
+	SmallObjectThreadCache *next_cache = nullptr;
+	SmallObjectThreadCache *next_orphan = nullptr;
+
+	// Only written by the thread using the cache, read by get_stats().
+	std::atomic<uint64_t> bytes[SmallObjectAllocator::SIZE_CLASS_COUNT] = {};
+	std::atomic<uint64_t> cache_hits = { 0 };
+	std::atomic<uint64_t> cache_misses = { 0 };
+	std::atomic<uint64_t> remote_frees_count = { 0 };
+};
+
+static const uint16_t size_class_sizes[SmallObjectAllocator::SIZE_CLASS_COUNT] = { 16, 32, 48, 64, 80, 96, 112, 128, 160, 192, 224, 256 };
+// Size class by size in 16 byte units, rounded up.
+static const uint8_t size_classes[SmallObjectAllocator::MAX_SMALL_SIZE / 16 + 1] = { 0, 0, 1, 2, 3, 4, 5, 6, 7, 8, 8, 9, 9, 10, 10, 11, 11 };
+
+static SpinLock global_lock;
+static SmallObjectThreadCache *caches = nullptr;
+static SmallObjectThreadCache *orphan_caches = nullptr;
+static SmallObjectChunk *empty_chunks = nullptr;
+static uint8_t *superblock_pos = nullptr;
+static uint8_t *superblock_end = nullptr;
+static uint64_t chunk_count = 0;
+static bool system_only = false;
+
+typedef std::atomic<uint64_t> ChunkMapWord;
+typedef std::atomic<ChunkMapWord *> ChunkMapLeaf;
+static std::atomic<ChunkMapLeaf *> chunk_map = { nullptr };
+
+static thread_local SmallObjectThreadCache *thread_cache = nullptr;
+static thread_local bool thread_cache_released = false;
+
+struct SmallObjectThreadExit {
+	bool registered = false;
+
+	~SmallObjectThreadExit() {
+		// Memory freed from now on goes through the remote list of the cache, and
+		// memory allocated comes from the system.
+		thread_cache_released = true;
+		if (!thread_cache) {
+			return;
+		}
+		global_lock.lock();
+		thread_cache->next_orphan = orphan_caches;
+		orphan_caches = thread_cache;
+		global_lock.unlock();
+		thread_cache = nullptr;
+	}
+};
+
+static thread_local SmallObjectThreadExit thread_exit;
+
+static _FORCE_INLINE_ void _add(std::atomic<uint64_t> &r_counter, uint64_t p_value) {
+	r_counter.store(r_counter.load(std::memory_order_relaxed) + p_value, std::memory_order_relaxed);
+}
+
+static _FORCE_INLINE_ void _sub(std::atomic<uint64_t> &r_counter, uint64_t p_value) {
+	r_counter.store(r_counter.load(std::memory_order_relaxed) - p_value, std::memory_order_relaxed);
+}
+
+static _FORCE_INLINE_ SmallObjectChunk *_get_chunk(const void *p_memory) {
+	return (SmallObjectChunk *)((uintptr_t)p_memory & ~uintptr_t(CHUNK_SIZE - 1));
+}
+
+static SmallObjectThreadCache *_create_thread_cache() {
+	if (thread_cache_released) {
+		return nullptr;
+	}
+
+	global_lock.lock();
+	SmallObjectThreadCache *cache = orphan_caches;
+	if (cache) {
+		orphan_caches = cache->next_orphan;
+		cache->next_orphan = nullptr;
+	} else {
+		void *mem = ::malloc(sizeof(SmallObjectThreadCache));
+		if (mem) {
+			cache = new (mem) SmallObjectThreadCache;
+			cache->next_cache = caches;
+			caches = cache;
+		}
+	}
+	global_lock.unlock();
+
+	if (cache) {
+		thread_exit.registered = true; // Constructs the thread local, so it releases the cache on exit.
+		thread_cache = cache;
+	}
+	return cache;
+}
+
+// Must be called with the global lock held.
+static bool _map_superblock(uint8_t *p_from, uint8_t *p_to) {
+	uintptr_t first = (uintptr_t)p_from >> CHUNK_BITS;
+	uintptr_t last = ((uintptr_t)p_to - 1) >> CHUNK_BITS;
+	if ((uint64_t)last >> (CHUNK_MAP_ADDRESS_BITS - CHUNK_BITS)) {
+		return false;
+	}
+
+	ChunkMapLeaf *root = chunk_map.load(std::memory_order_relaxed);
+	if (!root) {
+		// Large enough for the system to map it lazily, only the pages covering
+		// the address ranges in use are ever touched.
+		root = (ChunkMapLeaf *)::calloc(CHUNK_MAP_ROOT_SIZE, sizeof(ChunkMapLeaf));
+		if (!root) {
+			return false;
+		}
+		chunk_map.store(root, std::memory_order_release);
+	}
+
+	for (uintptr_t i = first; i <= last; i++) {
+		ChunkMapWord *leaf = root[i >> CHUNK_MAP_LEAF_BITS].load(std::memory_order_relaxed);
+		if (!leaf) {
+			leaf = (ChunkMapWord *)::calloc(CHUNK_MAP_LEAF_WORDS, sizeof(ChunkMapWord));
+			if (!leaf) {
+				return false;
+			}
+			root[i >> CHUNK_MAP_LEAF_BITS].store(leaf, std::memory_order_release);
+		}
+	}
+
+	// Only set the bits once all leaves exist, so a failure doesn't leave a part mapped.
+	for (uintptr_t i = first; i <= last; i++) {
+		ChunkMapWord *leaf = root[i >> CHUNK_MAP_LEAF_BITS].load(std::memory_order_relaxed);
+		uint32_t bit = i & ((1 << CHUNK_MAP_LEAF_BITS) - 1);
+		leaf[bit >> 6].fetch_or(uint64_t(1) << (bit & 63), std::memory_order_relaxed);
+	}
+	return true;
+}
+
+// Must be called with the global lock held.
+static SmallObjectChunk *_take_chunk() {
+	if (empty_chunks) {
+		SmallObjectChunk *chunk = empty_chunks;
+		empty_chunks = chunk->next;
+		return chunk;
+	}
+
+	if (superblock_pos == superblock_end) {
+		if (system_only) {
+			return nullptr;
+		}
+		// The system allocator gives no alignment guarantee this large, so allocate
+		// an extra chunk and skip the unaligned start.
+		uint8_t *mem = (uint8_t *)::malloc((CHUNKS_PER_SUPERBLOCK + 1) * CHUNK_SIZE);
+		if (!mem) {
+			return nullptr;
+		}
+		uint8_t *from = (uint8_t *)(((uintptr_t)mem + CHUNK_SIZE - 1) & ~uintptr_t(CHUNK_SIZE - 1));
+		uint8_t *to = from + CHUNKS_PER_SUPERBLOCK * CHUNK_SIZE;
+		if (!_map_superblock(from, to)) {
+			// Out of the mapped address range, which can't change, so stop trying.
+			::free(mem);
+			system_only = true;
+			return nullptr;
+		}
+		// Superblocks are never given back to the system: chunks are reused instead.
+		superblock_pos = from;
+		superblock_end = to;
+	}
+
+	SmallObjectChunk *chunk = (SmallObjectChunk *)superblock_pos;
+	superblock_pos += CHUNK_SIZE;
+	chunk_count++;
+	return chunk;
+}
+
+static _FORCE_INLINE_ void _link_chunk(SmallObjectThreadCache *p_cache, SmallObjectChunk *p_chunk) {
+	SmallObjectChunk *&head = p_cache->chunks[p_chunk->size_class];
+	p_chunk->prev = nullptr;
+	p_chunk->next = head;
+	if (head) {
+		head->prev = p_chunk;
+	}
+	head = p_chunk;
+	p_chunk->listed = true;
+}
+
+static _FORCE_INLINE_ void _unlink_chunk(SmallObjectThreadCache *p_cache, SmallObjectChunk *p_chunk) {
+	if (p_chunk->prev) {
+		p_chunk->prev->next = p_chunk->next;
+	} else {
+		p_cache->chunks[p_chunk->size_class] = p_chunk->next;
+	}
+	if (p_chunk->next) {
+		p_chunk->next->prev = p_chunk->prev;
+	}
+	p_chunk->prev = nullptr;
+	p_chunk->next = nullptr;
+	p_chunk->listed = false;
+}
+
+static void _free_local(SmallObjectThreadCache *p_cache, SmallObjectChunk *p_chunk, void *p_block) {
+	*(void **)p_block = p_chunk->free_list;
+	p_chunk->free_list = p_block;
+	p_chunk->used--;
+	_sub(p_cache->bytes[p_chunk->size_class], p_chunk->block_size);
+
+	if (!p_chunk->listed) {
+		_link_chunk(p_cache, p_chunk);
+	} else if (p_chunk->used == 0 && (p_chunk->prev || p_chunk->next)) {
+		// Keep one empty chunk per size class, give the others to any thread.
+		_unlink_chunk(p_cache, p_chunk);
+		global_lock.lock();
+		p_chunk->next = empty_chunks;
+		empty_chunks = p_chunk;
+		global_lock.unlock();
+	}
+}
+
+static void _drain_remote_frees(SmallObjectThreadCache *p_cache) {
+	void *block = p_cache->remote_frees.exchange(nullptr, std::memory_order_acquire);
+	while (block) {
+		void *next = *(void **)block;
+		_free_local(p_cache, _get_chunk(block), block);
+		block = next;
+	}
+}
+
+static SmallObjectChunk *_refill(SmallObjectThreadCache *p_cache, int p_size_class) {
+	_drain_remote_frees(p_cache);
+	if (p_cache->chunks[p_size_class]) {
+		_add(p_cache->cache_hits, 1);
+		return p_cache->chunks[p_size_class];
+	}
+
+	global_lock.lock();
+	SmallObjectChunk *chunk = _take_chunk();
+	global_lock.unlock();
+	if (!chunk) {
+		return nullptr;
+	}
+	_add(p_cache->cache_misses, 1);
+
+	chunk->owner = p_cache;
+	chunk->free_list = nullptr;
+	chunk->bump = (uint8_t *)chunk + CHUNK_HEADER_SIZE;
+	chunk->used = 0;
+	chunk->block_size = size_class_sizes[p_size_class];
+	chunk->capacity = (CHUNK_SIZE - CHUNK_HEADER_SIZE) / chunk->block_size;
+	chunk->size_class = p_size_class;
+	_link_chunk(p_cache, chunk);
+	return chunk;
+}
+
+void *SmallObjectAllocator::alloc(size_t p_bytes) {
+	if (p_bytes > MAX_SMALL_SIZE) {
+		return ::malloc(p_bytes);
+	}
+
+	SmallObjectThreadCache *cache = thread_cache;
+	if (unlikely(!cache)) {
+		cache = _create_thread_cache();
+		if (!cache) {
+			return ::malloc(p_bytes);
+		}
+	}
+
+	const int size_class = size_classes[(p_bytes + 15) >> 4];
+	SmallObjectChunk *chunk = cache->chunks[size_class];
+	if (likely(chunk)) {
+		_add(cache->cache_hits, 1);
+	} else {
+		chunk = _refill(cache, size_class);
+		if (!chunk) {
+			return ::malloc(p_bytes);
+		}
+	}
+
+	void *block = chunk->free_list;
+	if (block) {
+		chunk->free_list = *(void **)block;
+	} else {
+		block = chunk->bump;
+		chunk->bump += chunk->block_size;
+	}
+
+	chunk->used++;
+	if (chunk->used == chunk->capacity) {
+		_unlink_chunk(cache, chunk);
+	}
+	_add(cache->bytes[size_class], chunk->block_size);
+
+	return block;
+}
+
+void *SmallObjectAllocator::realloc(void *p_memory, size_t p_bytes) {
+	if (!p_memory) {
+		return alloc(p_bytes);
+	}
+	if (!owns(p_memory)) {
+		return ::realloc(p_memory, p_bytes);
+	}
+	if (p_bytes == 0) {
+		// Like the system realloc, so callers see the same behavior.
+		free(p_memory);
+		return nullptr;
+	}
+
+	SmallObjectChunk *chunk = _get_chunk(p_memory);
+	if (p_bytes <= MAX_SMALL_SIZE && size_classes[(p_bytes + 15) >> 4] == chunk->size_class) {
+		return p_memory;
+	}
+
+	void *mem = alloc(p_bytes);
+	if (!mem) {
+		return nullptr;
+	}
+	memcpy(mem, p_memory, MIN(p_bytes, (size_t)chunk->block_size));
+	free(p_memory);
+	return mem;
+}
+
+void SmallObjectAllocator::free(void *p_memory) {
+	if (!owns(p_memory)) {
+		::free(p_memory);
+		return;
+	}
+
+	SmallObjectChunk *chunk = _get_chunk(p_memory);
+	SmallObjectThreadCache *cache = thread_cache;
+	if (likely(chunk->owner == cache)) {
+		_free_local(cache, chunk, p_memory);
+		return;
+	}
+
+	std::atomic<void *> &remote_frees = chunk->owner->remote_frees;
+	void *head = remote_frees.load(std::memory_order_relaxed);
+	do {
+		*(void **)p_memory = head;
+	} while (!remote_frees.compare_exchange_weak(head, p_memory, std::memory_order_release, std::memory_order_relaxed));
+
+	if (cache) {
+		_add(cache->remote_frees_count, 1);
+	}
+}
+
+bool SmallObjectAllocator::owns(const void *p_memory) {
+	uint64_t index = (uint64_t)(uintptr_t)p_memory >> CHUNK_BITS;
+	if (index >> (CHUNK_MAP_ADDRESS_BITS - CHUNK_BITS)) {
+		return false;
+	}
+	const ChunkMapLeaf *root = chunk_map.load(std::memory_order_acquire);
+	if (!root) {
+		return false;
+	}
+	const ChunkMapWord *leaf = root[index >> CHUNK_MAP_LEAF_BITS].load(std::memory_order_acquire);
+	if (!leaf) {
+		return false;
+	}
+	uint32_t bit = index & ((1 << CHUNK_MAP_LEAF_BITS) - 1);
+	return leaf[bit >> 6].load(std::memory_order_relaxed) & (uint64_t(1) << (bit & 63));
+}
+
+size_t SmallObjectAllocator::get_size_class_size(int p_size_class) {
+	ERR_FAIL_INDEX_V(p_size_class, SIZE_CLASS_COUNT, 0);
+	return size_class_sizes[p_size_class];
+}
+
+void SmallObjectAllocator::get_stats(Stats &r_stats) {
+	r_stats = Stats();
+
+	global_lock.lock();
+	for (SmallObjectThreadCache *cache = caches; cache; cache = cache->next_cache) {
+		for (int i = 0; i < SIZE_CLASS_COUNT; i++) {
+			r_stats.bytes[i] += cache->bytes[i].load(std::memory_order_relaxed);
+		}
+		r_stats.cache_hits += cache->cache_hits.load(std::memory_order_relaxed);
+		r_stats.cache_misses += cache->cache_misses.load(std::memory_order_relaxed);
+		r_stats.remote_frees += cache->remote_frees_count.load(std::memory_order_relaxed);
+	}
+	r_stats.chunk_count = chunk_count;
+	global_lock.unlock();
+}
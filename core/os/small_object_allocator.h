@@ -0,0 +1,75 @@
+/*************************************************************************/
+/*  small_object_allocator.h                                             */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef SMALL_OBJECT_ALLOCATOR_H
+#define SMALL_OBJECT_ALLOCATOR_H
+
+#include "core/typedefs.h"
+
+#include <stddef.h>
+
+// Allocator for small blocks, used by Memory::alloc_static() when the engine is
+// built with `small_object_allocator=yes`.
+//
+// Blocks are carved by size class from 64 KiB chunks. Every thread has a cache
+// owning the chunks it allocates from, so allocating and freeing from the owner
+// thread never takes a lock. A block freed by another thread is pushed to a
+// lock-free list of the owning cache, which takes it back on its next slow path.
+// When a thread exits, its cache is kept with its chunks and adopted by the next
+// thread needing one.
+//
+// Larger blocks, and blocks that weren't allocated here, go to the system allocator.
+
+class SmallObjectAllocator {
+public:
+	enum {
+		SIZE_CLASS_COUNT = 12,
+		MAX_SMALL_SIZE = 256,
+	};
+
+	struct Stats {
+		uint64_t bytes[SIZE_CLASS_COUNT] = {}; // In use, per size class.
+		uint64_t cache_hits = 0; // Allocations served from the chunks of the thread cache.
+		uint64_t cache_misses = 0; // Allocations which needed a new chunk.
+		uint64_t remote_frees = 0;
+		uint64_t chunk_count = 0;
+	};
+
+	static void *alloc(size_t p_bytes);
+	static void *realloc(void *p_memory, size_t p_bytes);
+	static void free(void *p_memory);
+
+	static bool owns(const void *p_memory);
+
+	static size_t get_size_class_size(int p_size_class);
+	static void get_stats(Stats &r_stats);
+};
+
+#endif // SMALL_OBJECT_ALLOCATOR_H
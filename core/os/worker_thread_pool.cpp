@@ -0,0 +1,471 @@
+/*************************************************************************/
+/*  worker_thread_pool.cpp                                               */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "worker_thread_pool.h"
+
+#include "core/os/os.h"
+
+WorkerThreadPool *WorkerThreadPool::singleton = nullptr;
+thread_local WorkerThreadPool::ThreadData *WorkerThreadPool::current_thread = nullptr;
+
+void WorkerThreadPool::TaskDeque::push_back(Task *p_task) {
+	if (count == buffer.size()) {
+		// Grow, unwrapping the ring so the new buffer starts at head.
+		uint32_t old_size = buffer.size();
+		uint32_t new_size = MAX(old_size * 2, 16u);
+		LocalVector<Task *> new_buffer;
+		new_buffer.resize(new_size);
+		for (uint32_t i = 0; i < count; i++) {
+			new_buffer[i] = buffer[(head + i) & (old_size - 1)];
+		}
+		buffer = new_buffer;
+		head = 0;
+	}
+	buffer[(head + count) & (buffer.size() - 1)] = p_task;
+	count++;
+}
+
+WorkerThreadPool::Task *WorkerThreadPool::TaskDeque::pop_back() {
+	if (count == 0) {
+		return nullptr;
+	}
+	count--;
+	return buffer[(head + count) & (buffer.size() - 1)];
+}
+
+WorkerThreadPool::Task *WorkerThreadPool::TaskDeque::pop_front() {
+	if (count == 0) {
+		return nullptr;
+	}
+	Task *task = buffer[head];
+	head = (head + 1) & (buffer.size() - 1);
+	count--;
+	return task;
+}
+
+void WorkerThreadPool::_thread_function(void *p_user) {
+	ThreadData *thread = static_cast<ThreadData *>(p_user);
+	WorkerThreadPool *pool = thread->pool;
+	current_thread = thread;
+
+	while (true) {
+		Task *task = pool->_pop_task(true);
+		if (task) {
+			pool->_process_task(task);
+			continue;
+		}
+
+		// Announce the intent to sleep before checking the queues one last
+		// time, so a task pushed in between is never missed.
+		pool->sleeping_threads.fetch_add(1);
+		task = pool->_pop_task(true);
+		if (task) {
+			pool->sleeping_threads.fetch_sub(1);
+			pool->_process_task(task);
+			continue;
+		}
+		if (pool->exit_threads.load()) {
+			pool->sleeping_threads.fetch_sub(1);
+			break;
+		}
+		pool->task_available_semaphore.wait();
+		pool->sleeping_threads.fetch_sub(1);
+		if (pool->exit_threads.load()) {
+			break;
+		}
+	}
+
+	current_thread = nullptr;
+}
+
+void WorkerThreadPool::_push_tasks(Task **p_tasks, uint32_t p_count) {
+	if (p_count == 0) {
+		return;
+	}
+
+	uint32_t low_priority_count = 0;
+	for (uint32_t i = 0; i < p_count; i++) {
+		if (p_tasks[i]->low_priority) {
+			low_priority_count++;
+		}
+	}
+
+	ThreadData *thread = _get_current_thread();
+	if (thread && low_priority_count < p_count) {
+		thread->lock.lock();
+		for (uint32_t i = 0; i < p_count; i++) {
+			if (!p_tasks[i]->low_priority) {
+				thread->queue.push_back(p_tasks[i]);
+			}
+		}
+		thread->lock.unlock();
+	}
+	if (!thread || low_priority_count > 0) {
+		global_lock.lock();
+		for (uint32_t i = 0; i < p_count; i++) {
+			if (p_tasks[i]->low_priority) {
+				low_priority_queue.push_back(p_tasks[i]);
+			} else if (!thread) {
+				global_queue.push_back(p_tasks[i]);
+			}
+		}
+		global_lock.unlock();
+	}
+
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	uint32_t to_wake = MIN(sleeping_threads.load(), p_count);
+	for (uint32_t i = 0; i < to_wake; i++) {
+		task_available_semaphore.post();
+	}
+}
+
+WorkerThreadPool::Task *WorkerThreadPool::_pop_task(bool p_low_priority) {
+	Task *task = nullptr;
+
+	ThreadData *thread = _get_current_thread();
+	if (thread) {
+		thread->lock.lock();
+		task = thread->queue.pop_back();
+		thread->lock.unlock();
+		if (task) {
+			return task;
+		}
+	}
+
+	global_lock.lock();
+	task = global_queue.pop_front();
+	global_lock.unlock();
+	if (task) {
+		return task;
+	}
+
+	// Steal the oldest task from another worker, starting with the next one
+	// so victims are spread evenly.
+	uint32_t from = thread ? thread->index + 1 : 0;
+	for (uint32_t i = 0; i < thread_count; i++) {
+		ThreadData &victim = threads[(from + i) % thread_count];
+		if (&victim == thread) {
+			continue;
+		}
+		victim.lock.lock();
+		task = victim.queue.pop_front();
+		victim.lock.unlock();
+		if (task) {
+			return task;
+		}
+	}
+
+	if (p_low_priority) {
+		global_lock.lock();
+		task = low_priority_queue.pop_front();
+		global_lock.unlock();
+	}
+	return task;
+}
+
+void WorkerThreadPool::_process_group_elements(Group *p_group) {
+	while (true) {
+		uint32_t work_index = p_group->index.fetch_add(1, std::memory_order_relaxed);
+		if (work_index >= p_group->max) {
+			break;
+		}
+		if (p_group->native_func) {
+			p_group->native_func(p_group->native_func_userdata, work_index);
+		} else {
+			p_group->template_userdata.userdata->callback_indexed(work_index);
+		}
+		p_group->completed_index.fetch_add(1, std::memory_order_release);
+	}
+}
+
+void WorkerThreadPool::_complete(Completion &p_completion) {
+	// Called with task_mutex held, so the waiter can't release the task or
+	// group before the semaphore has been posted.
+	p_completion.completed.store(true);
+	uint32_t waiting = p_completion.waiting.load();
+	for (uint32_t i = 0; i < waiting; i++) {
+		p_completion.semaphore.post();
+	}
+}
+
+void WorkerThreadPool::_process_task(Task *p_task) {
+	if (p_task->group) {
+		Group *group = p_task->group;
+		_process_group_elements(group);
+		task_allocator.free(p_task);
+
+		if (group->finished_tasks.fetch_add(1) + 1 == group->task_count) {
+			MutexLock lock(task_mutex);
+			_complete(group->completion);
+		}
+		return;
+	}
+
+	if (p_task->native_func) {
+		p_task->native_func(p_task->native_func_userdata);
+	} else {
+		p_task->template_userdata.userdata->callback();
+	}
+
+	LocalVector<Task *> ready;
+	task_mutex.lock();
+	for (uint32_t i = 0; i < p_task->dependents.size(); i++) {
+		Task *dependent = p_task->dependents[i];
+		dependent->pending_dependencies--;
+		if (dependent->pending_dependencies == 0) {
+			ready.push_back(dependent);
+		}
+	}
+	p_task->dependents.clear();
+	_complete(p_task->completion);
+	task_mutex.unlock();
+
+	_push_tasks(ready.ptr(), ready.size());
+}
+
+void WorkerThreadPool::_wait_for(Completion &p_completion) {
+	// Threads outside the pool leave the low priority tasks to the workers,
+	// unless there are none to run them.
+	const bool low_priority = _get_current_thread() != nullptr || thread_count == 0;
+	while (!p_completion.completed.load()) {
+		// Help with pending work instead of blocking.
+		Task *task = _pop_task(low_priority);
+		if (task) {
+			_process_task(task);
+			continue;
+		}
+
+		// Nothing left to help with, the awaited work is running elsewhere.
+		p_completion.waiting.fetch_add(1);
+		if (!p_completion.completed.load()) {
+			p_completion.semaphore.wait();
+		}
+		p_completion.waiting.fetch_sub(1);
+	}
+}
+
+WorkerThreadPool::TaskID WorkerThreadPool::_add_task(Task *p_task, const TaskID *p_dependencies, uint32_t p_dependency_count, bool p_high_priority) {
+	p_task->low_priority = !p_high_priority;
+	task_mutex.lock();
+	TaskID id = last_task++;
+	p_task->self = id;
+	for (uint32_t i = 0; i < p_dependency_count; i++) {
+		Task **dependency = tasks.getptr(p_dependencies[i]);
+		ERR_CONTINUE_MSG(!dependency, "Invalid task dependency ID: " + itos(p_dependencies[i]) + ".");
+		if (!(*dependency)->completion.completed.load()) {
+			(*dependency)->dependents.push_back(p_task);
+			p_task->pending_dependencies++;
+		}
+	}
+	tasks[id] = p_task;
+	bool ready = p_task->pending_dependencies == 0;
+	task_mutex.unlock();
+
+	if (ready) {
+		_push_tasks(&p_task, 1);
+	}
+	return id;
+}
+
+WorkerThreadPool::TaskID WorkerThreadPool::add_native_task(void (*p_func)(void *), void *p_userdata, const TaskID *p_dependencies, uint32_t p_dependency_count, bool p_high_priority) {
+	Task *task = task_allocator.alloc();
+	task->native_func = p_func;
+	task->native_func_userdata = p_userdata;
+	return _add_task(task, p_dependencies, p_dependency_count, p_high_priority);
+}
+
+bool WorkerThreadPool::is_task_completed(TaskID p_task_id) const {
+	MutexLock lock(task_mutex);
+	Task *const *task = tasks.getptr(p_task_id);
+	ERR_FAIL_COND_V_MSG(!task, false, "Invalid Task ID.");
+	return (*task)->completion.completed.load();
+}
+
+void WorkerThreadPool::wait_for_task_completion(TaskID p_task_id) {
+	task_mutex.lock();
+	Task **taskp = tasks.getptr(p_task_id);
+	if (!taskp) {
+		task_mutex.unlock();
+		ERR_FAIL_MSG("Invalid Task ID."); // Invalid task, or already waited on.
+	}
+	Task *task = *taskp;
+	task_mutex.unlock();
+
+	_wait_for(task->completion);
+
+	task_mutex.lock();
+	tasks.erase(p_task_id);
+	task->template_userdata.release();
+	task_allocator.free(task);
+	task_mutex.unlock();
+}
+
+WorkerThreadPool::GroupID WorkerThreadPool::_add_group_task(Group *p_group, uint32_t p_elements, int p_tasks) {
+	if (p_tasks < 0) {
+		p_tasks = thread_count;
+	}
+	p_group->max = p_elements;
+	p_group->task_count = MIN(uint32_t(MAX(p_tasks, 1)), p_elements);
+
+	task_mutex.lock();
+	GroupID id = last_task++;
+	p_group->self = id;
+	groups[id] = p_group;
+	if (p_group->task_count == 0) {
+		_complete(p_group->completion);
+	}
+	task_mutex.unlock();
+
+	if (p_group->task_count == 0) {
+		return id;
+	}
+
+	Task **group_tasks = (Task **)alloca(sizeof(Task *) * p_group->task_count);
+	for (uint32_t i = 0; i < p_group->task_count; i++) {
+		group_tasks[i] = task_allocator.alloc();
+		group_tasks[i]->group = p_group;
+	}
+	_push_tasks(group_tasks, p_group->task_count);
+
+	return id;
+}
+
+WorkerThreadPool::GroupID WorkerThreadPool::add_native_group_task(void (*p_func)(void *, uint32_t), void *p_userdata, uint32_t p_elements, int p_tasks) {
+	Group *group = group_allocator.alloc();
+	group->native_func = p_func;
+	group->native_func_userdata = p_userdata;
+	return _add_group_task(group, p_elements, p_tasks);
+}
+
+uint32_t WorkerThreadPool::get_group_processed_element_count(GroupID p_group) const {
+	MutexLock lock(task_mutex);
+	Group *const *group = groups.getptr(p_group);
+	ERR_FAIL_COND_V_MSG(!group, 0, "Invalid Group ID.");
+	return (*group)->completed_index.load(std::memory_order_acquire);
+}
+
+bool WorkerThreadPool::is_group_task_completed(GroupID p_group) const {
+	MutexLock lock(task_mutex);
+	Group *const *group = groups.getptr(p_group);
+	ERR_FAIL_COND_V_MSG(!group, false, "Invalid Group ID.");
+	return (*group)->completion.completed.load();
+}
+
+void WorkerThreadPool::wait_for_group_task_completion(GroupID p_group) {
+	task_mutex.lock();
+	Group **groupp = groups.getptr(p_group);
+	if (!groupp) {
+		task_mutex.unlock();
+		ERR_FAIL_MSG("Invalid Group ID."); // Invalid group, or already waited on.
+	}
+	Group *group = *groupp;
+	task_mutex.unlock();
+
+	// Process elements on this thread too, rather than only waiting for the tasks to do it.
+	_process_group_elements(group);
+	_wait_for(group->completion);
+
+	task_mutex.lock();
+	groups.erase(p_group);
+	group->template_userdata.release();
+	group_allocator.free(group);
+	task_mutex.unlock();
+}
+
+int WorkerThreadPool::get_thread_index() const {
+	ThreadData *thread = _get_current_thread();
+	return thread ? int(thread->index) : -1;
+}
+
+void WorkerThreadPool::init(int p_thread_count) {
+	ERR_FAIL_COND(threads != nullptr);
+#ifdef NO_THREADS
+	// Everything runs on the waiting thread.
+	p_thread_count = 0;
+#else
+	if (p_thread_count < 0) {
+		p_thread_count = OS::get_singleton()->get_processor_count();
+	}
+#endif
+
+	thread_count = p_thread_count;
+	if (thread_count == 0) {
+		return;
+	}
+
+	exit_threads.store(false);
+	threads = memnew_arr(ThreadData, thread_count);
+	for (uint32_t i = 0; i < thread_count; i++) {
+		threads[i].pool = this;
+		threads[i].index = i;
+	}
+	for (uint32_t i = 0; i < thread_count; i++) {
+		threads[i].thread.start(&WorkerThreadPool::_thread_function, &threads[i]);
+	}
+}
+
+void WorkerThreadPool::finish() {
+	if (threads == nullptr) {
+		return;
+	}
+
+	task_mutex.lock();
+	if (tasks.size() || groups.size()) {
+		WARN_PRINT("WorkerThreadPool finished with " + itos(tasks.size()) + " task(s) and " + itos(groups.size()) + " group(s) never waited on.");
+	}
+	task_mutex.unlock();
+
+	exit_threads.store(true);
+	for (uint32_t i = 0; i < thread_count; i++) {
+		task_available_semaphore.post();
+	}
+	for (uint32_t i = 0; i < thread_count; i++) {
+		threads[i].thread.wait_to_finish();
+	}
+
+	memdelete_arr(threads);
+	threads = nullptr;
+	thread_count = 0;
+}
+
+WorkerThreadPool::WorkerThreadPool() {
+	exit_threads.store(false);
+	sleeping_threads.store(0);
+	if (!singleton) {
+		singleton = this;
+	}
+}
+
+WorkerThreadPool::~WorkerThreadPool() {
+	finish();
+	if (singleton == this) {
+		singleton = nullptr;
+	}
+}
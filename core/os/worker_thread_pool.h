@@ -0,0 +1,279 @@
+/*************************************************************************/
+/*  worker_thread_pool.h                                                 */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef WORKER_THREAD_POOL_H
+#define WORKER_THREAD_POOL_H
+
+#include "core/os/memory.h"
+#include "core/os/mutex.h"
+#include "core/os/semaphore.h"
+#include "core/os/spin_lock.h"
+#include "core/os/thread.h"
+#include "core/templates/hash_map.h"
+#include "core/templates/local_vector.h"
+#include "core/templates/paged_allocator.h"
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+
+// Engine-wide work-stealing scheduler.
+//
+// Every worker owns a deque: tasks it spawns are pushed to the back and popped
+// from the back (LIFO, cache friendly), while idle workers steal from the front
+// of other deques. Tasks added from threads outside the pool go to a shared
+// queue. A thread waiting on a task or group keeps running pending tasks until
+// the awaited one completes, so nested parallel work never deadlocks the pool.
+//
+// Low priority tasks, meant for long work that nobody waits on right away, go
+// to a separate queue. Only the workers run them: a thread outside the pool
+// that waits on a task or group never picks up one of them, so a wait on the
+// main thread is not delayed by unrelated long work.
+//
+// Every task and group ID must be waited on exactly once, which releases it.
+
+class WorkerThreadPool {
+public:
+	typedef int64_t TaskID;
+	typedef int64_t GroupID;
+
+	enum {
+		INVALID_TASK_ID = -1
+	};
+
+private:
+	struct BaseTemplateUserdata {
+		virtual void callback() {}
+		virtual void callback_indexed(uint32_t p_index) {}
+		virtual ~BaseTemplateUserdata() {}
+	};
+
+	template <class C, class M, class U>
+	struct TaskUserData : public BaseTemplateUserdata {
+		C *instance;
+		M method;
+		U userdata;
+		virtual void callback() override {
+			(instance->*method)(userdata);
+		}
+	};
+
+	template <class C, class M, class U>
+	struct GroupUserData : public BaseTemplateUserdata {
+		C *instance;
+		M method;
+		U userdata;
+		virtual void callback_indexed(uint32_t p_index) override {
+			(instance->*method)(p_index, userdata);
+		}
+	};
+
+	// Small enough for the common (instance, method, userdata) triple, so
+	// dispatching templated work does not need a heap allocation.
+	struct TemplateStorage {
+		alignas(std::max_align_t) uint8_t data[64];
+		BaseTemplateUserdata *userdata = nullptr;
+
+		template <class T>
+		T *alloc() {
+			if constexpr (sizeof(T) <= sizeof(data) && alignof(T) <= alignof(std::max_align_t)) {
+				T *ud = new (data) T;
+				userdata = ud;
+				return ud;
+			} else {
+				T *ud = memnew(T);
+				userdata = ud;
+				return ud;
+			}
+		}
+
+		void release() {
+			if (!userdata) {
+				return;
+			}
+			if ((void *)userdata == (void *)data) {
+				userdata->~BaseTemplateUserdata();
+			} else {
+				memdelete(userdata);
+			}
+			userdata = nullptr;
+		}
+	};
+
+	struct Completion {
+		std::atomic<bool> completed;
+		std::atomic<uint32_t> waiting;
+		Semaphore semaphore;
+
+		Completion() {
+			completed.store(false);
+			waiting.store(0);
+		}
+	};
+
+	struct Group;
+
+	struct Task {
+		TaskID self = INVALID_TASK_ID;
+		void (*native_func)(void *) = nullptr;
+		void *native_func_userdata = nullptr;
+		TemplateStorage template_userdata;
+		Group *group = nullptr; // Set for the tasks that run the elements of a group.
+		bool low_priority = false;
+		uint32_t pending_dependencies = 0;
+		LocalVector<Task *> dependents;
+		Completion completion;
+	};
+
+	struct Group {
+		GroupID self = INVALID_TASK_ID;
+		void (*native_func)(void *, uint32_t) = nullptr;
+		void *native_func_userdata = nullptr;
+		TemplateStorage template_userdata;
+		uint32_t max = 0;
+		uint32_t task_count = 0;
+		std::atomic<uint32_t> index;
+		std::atomic<uint32_t> completed_index;
+		std::atomic<uint32_t> finished_tasks;
+		Completion completion;
+
+		Group() {
+			index.store(0);
+			completed_index.store(0);
+			finished_tasks.store(0);
+		}
+	};
+
+	struct TaskDeque {
+		LocalVector<Task *> buffer;
+		uint32_t head = 0;
+		uint32_t count = 0;
+
+		void push_back(Task *p_task);
+		Task *pop_back();
+		Task *pop_front();
+	};
+
+	struct ThreadData {
+		WorkerThreadPool *pool = nullptr;
+		uint32_t index = 0;
+		Thread thread;
+		SpinLock lock;
+		TaskDeque queue;
+	};
+
+	static WorkerThreadPool *singleton;
+	static thread_local ThreadData *current_thread;
+
+	ThreadData *threads = nullptr;
+	uint32_t thread_count = 0;
+	std::atomic<bool> exit_threads;
+
+	SpinLock global_lock;
+	TaskDeque global_queue;
+	TaskDeque low_priority_queue; // Also guarded by global_lock.
+
+	Semaphore task_available_semaphore;
+	std::atomic<uint32_t> sleeping_threads;
+
+	Mutex task_mutex;
+	PagedAllocator<Task, true> task_allocator;
+	PagedAllocator<Group, true> group_allocator;
+	HashMap<TaskID, Task *> tasks;
+	HashMap<GroupID, Group *> groups;
+	TaskID last_task = 1;
+
+	static void _thread_function(void *p_user);
+
+	_FORCE_INLINE_ ThreadData *_get_current_thread() const {
+		return (current_thread && current_thread->pool == this) ? current_thread : nullptr;
+	}
+
+	void _push_tasks(Task **p_tasks, uint32_t p_count);
+	Task *_pop_task(bool p_low_priority);
+	void _process_task(Task *p_task);
+	void _process_group_elements(Group *p_group);
+	void _complete(Completion &p_completion);
+	void _wait_for(Completion &p_completion);
+
+	TaskID _add_task(Task *p_task, const TaskID *p_dependencies, uint32_t p_dependency_count, bool p_high_priority);
+	GroupID _add_group_task(Group *p_group, uint32_t p_elements, int p_tasks);
+
+public:
+	TaskID add_native_task(void (*p_func)(void *), void *p_userdata, const TaskID *p_dependencies = nullptr, uint32_t p_dependency_count = 0, bool p_high_priority = true);
+
+	// Calls `(p_instance->*p_method)(p_userdata)`. The task only starts once
+	// all of `p_dependencies` have completed. Low priority tasks only run on
+	// the workers, once they have no high priority work left.
+	template <class C, class M, class U>
+	TaskID add_template_task(C *p_instance, M p_method, U p_userdata, const TaskID *p_dependencies = nullptr, uint32_t p_dependency_count = 0, bool p_high_priority = true) {
+		Task *task = task_allocator.alloc();
+		TaskUserData<C, M, U> *ud = task->template_userdata.template alloc<TaskUserData<C, M, U>>();
+		ud->instance = p_instance;
+		ud->method = p_method;
+		ud->userdata = p_userdata;
+		return _add_task(task, p_dependencies, p_dependency_count, p_high_priority);
+	}
+
+	bool is_task_completed(TaskID p_task_id) const;
+	void wait_for_task_completion(TaskID p_task_id);
+
+	GroupID add_native_group_task(void (*p_func)(void *, uint32_t), void *p_userdata, uint32_t p_elements, int p_tasks = -1);
+
+	// Parallel for: calls `(p_instance->*p_method)(index, p_userdata)` for every
+	// index in [0, p_elements), spread over `p_tasks` tasks (one per worker by
+	// default). The thread waiting on the group also processes elements.
+	template <class C, class M, class U>
+	GroupID add_template_group_task(C *p_instance, M p_method, U p_userdata, uint32_t p_elements, int p_tasks = -1) {
+		Group *group = group_allocator.alloc();
+		GroupUserData<C, M, U> *ud = group->template_userdata.template alloc<GroupUserData<C, M, U>>();
+		ud->instance = p_instance;
+		ud->method = p_method;
+		ud->userdata = p_userdata;
+		return _add_group_task(group, p_elements, p_tasks);
+	}
+
+	uint32_t get_group_processed_element_count(GroupID p_group) const;
+	bool is_group_task_completed(GroupID p_group) const;
+	void wait_for_group_task_completion(GroupID p_group);
+
+	_FORCE_INLINE_ int get_thread_count() const { return MAX(thread_count, 1u); }
+	int get_thread_index() const; // Index of the calling worker, or -1 if not called from a worker.
+
+	static WorkerThreadPool *get_singleton() { return singleton; }
+
+	void init(int p_thread_count = -1);
+	void finish();
+
+	WorkerThreadPool();
+	~WorkerThreadPool();
+};
+
+#endif // WORKER_THREAD_POOL_H
@@ -72,6 +72,7 @@
 #include "core/object/undo_redo.h"
 #include "core/os/main_loop.h"
 #include "core/os/time.h"
+#include "core/os/worker_thread_pool.h"
 #include "core/string/optimized_translation.h"
 #include "core/string/translation.h"
 
@@ -106,6 +107,8 @@ extern void unregister_global_constants();
 
 static ResourceUID *resource_uid = nullptr;
 
+static WorkerThreadPool *worker_thread_pool = nullptr;
+
 void register_core_types() {
 	//consistency check
 	static_assert(sizeof(Callable) <= 16);
@@ -233,6 +236,8 @@ void register_core_types() {
 
 	resource_uid = memnew(ResourceUID);
 
+	worker_thread_pool = memnew(WorkerThreadPool);
+
 	native_extension_manager = memnew(NativeExtensionManager);
 
 	resource_loader_native_extension.instantiate();
@@ -261,6 +266,9 @@ void register_core_settings() {
 
 	GLOBAL_DEF("network/ssl/certificate_bundle_override", "");
 	ProjectSettings::get_singleton()->set_custom_property_info("network/ssl/certificate_bundle_override", PropertyInfo(Variant::STRING, "network/ssl/certificate_bundle_override", PROPERTY_HINT_FILE, "*.crt"));
+
+	GLOBAL_DEF_RST("threading/worker_pool/max_threads", -1);
+	ProjectSettings::get_singleton()->set_custom_property_info("threading/worker_pool/max_threads", PropertyInfo(Variant::INT, "threading/worker_pool/max_threads", PROPERTY_HINT_RANGE, "-1,256,1"));
 }
 
 void register_core_singletons() {
@@ -318,6 +326,8 @@ void unregister_core_types() {
 
 	memdelete(native_extension_manager);
 
+	memdelete(worker_thread_pool);
+
 	memdelete(resource_uid);
 	memdelete(_resource_loader);
 	memdelete(_resource_saver);
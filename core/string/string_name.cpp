@@ -32,6 +32,7 @@
 
 #include "core/os/os.h"
 #include "core/string/print_string.h"
+#include "core/templates/local_vector.h"
 
 StaticCString StaticCString::create(const char *p_ptr) {
 	StaticCString scs;
@@ -39,38 +40,248 @@ StaticCString StaticCString::create(const char *p_ptr) {
 	return scs;
 }
 
-StringName::_Data *StringName::_table[STRING_TABLE_LEN];
+struct alignas(64) StringName::Shard {
+	struct Table {
+		uint32_t mask = 0;
+		std::atomic<_Data *> *buckets = nullptr;
+	};
+
+	// Taken to add and remove names, existing names are looked up without it.
+	Mutex mutex;
+	std::atomic<Table *> table = { nullptr };
+	uint32_t count = 0;
+	// Changed when a name is added, so a lookup that missed only needs
+	// to look again if names were added or moved since it started.
+	std::atomic<uint32_t> version = { 0 };
+
+	// Lookups running without the lock. The names and tables they may still
+	// be reading are only freed once none of them is running.
+	std::atomic<uint32_t> readers = { 0 };
+	LocalVector<_Data *> retired_names;
+	LocalVector<Table *> retired_tables;
+
+	static Table *create_table(uint32_t p_size) {
+		Table *t = memnew(Table);
+		t->mask = p_size - 1;
+		t->buckets = memnew_arr(std::atomic<_Data *>, p_size);
+		for (uint32_t i = 0; i < p_size; i++) {
+			t->buckets[i].store(nullptr, std::memory_order_relaxed);
+		}
+		return t;
+	}
+
+	static void free_table(Table *p_table) {
+		memdelete_arr(p_table->buckets);
+		memdelete(p_table);
+	}
+
+	// Returns the first live name matching, referenced.
+	template <class T>
+	_Data *lookup(const T &p_name, uint32_t p_hash) const {
+		const Table *t = table.load();
+		for (_Data *data = t->buckets[p_hash & t->mask].load(); data; data = data->next.load()) {
+			if (data->hash == p_hash && data->is_named(p_name) && data->refcount.ref()) {
+				return data;
+			}
+		}
+		return nullptr;
+	}
+
+	void reclaim() {
+		if (readers.load() != 0) {
+			return;
+		}
+		for (uint32_t i = 0; i < retired_names.size(); i++) {
+			memdelete(retired_names[i]);
+		}
+		retired_names.clear();
+		for (uint32_t i = 0; i < retired_tables.size(); i++) {
+			free_table(retired_tables[i]);
+		}
+		retired_tables.clear();
+	}
+
+	void grow() {
+		Table *old_table = table.load();
+		Table *new_table = create_table((old_table->mask + 1) * 2);
+
+		// Readers still on the old table may miss names while they are moved,
+		// which is fine since they look again with the lock before adding one.
+		for (uint32_t i = 0; i <= old_table->mask; i++) {
+			_Data *data = old_table->buckets[i].load(std::memory_order_relaxed);
+			while (data) {
+				_Data *next = data->next.load(std::memory_order_relaxed);
+				std::atomic<_Data *> &bucket = new_table->buckets[data->hash & new_table->mask];
+				data->next.store(bucket.load(std::memory_order_relaxed));
+				bucket.store(data);
+				data = next;
+			}
+		}
+
+		table.store(new_table);
+		retired_tables.push_back(old_table);
+	}
+
+	void insert(_Data *p_data) {
+		count++;
+		if (count > table.load()->mask + 1) {
+			grow();
+		}
+
+		Table *t = table.load();
+		std::atomic<_Data *> &bucket = t->buckets[p_data->hash & t->mask];
+		p_data->next.store(bucket.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		bucket.store(p_data, std::memory_order_release);
+
+		// After linking, so a lookup that sees the new version also sees the name.
+		version.store(version.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	void remove(_Data *p_data) {
+		Table *t = table.load();
+		std::atomic<_Data *> *link = &t->buckets[p_data->hash & t->mask];
+		while (link->load() != p_data) {
+			ERR_FAIL_COND_MSG(link->load() == nullptr, "BUG: StringName not found in its table.");
+			link = &link->load()->next;
+		}
+		// The name keeps its next pointer, so readers on it can continue.
+		link->store(p_data->next.load());
+		count--;
+
+		if (readers.load() == 0) {
+			// No lookup can reach it anymore.
+			memdelete(p_data);
+			reclaim();
+		} else {
+			retired_names.push_back(p_data);
+		}
+	}
+};
+
+StringName::Shard StringName::shards[SHARD_COUNT];
 
 StringName _scs_create(const char *p_chr, bool p_static) {
 	return (p_chr[0] ? StringName(StaticCString::create(p_chr), p_static) : StringName());
 }
 
 bool StringName::configured = false;
-Mutex StringName::mutex;
 
 #ifdef DEBUG_ENABLED
 bool StringName::debug_stringname = false;
 #endif
 
+// Returns the first live name matching, referenced, and whether the shard was left locked.
+template <class T>
+StringName::_Data *StringName::_lookup(Shard &p_shard, const T &p_name, uint32_t p_hash, bool &r_locked) {
+	// Without contention, a single lookup under the lock is the cheapest.
+	// Otherwise, existing names are found without waiting for the lock.
+	r_locked = p_shard.mutex.try_lock() == OK;
+#ifdef DEBUG_ENABLED
+	if (!r_locked && unlikely(debug_stringname)) {
+		p_shard.mutex.lock();
+		r_locked = true;
+	}
+#endif
+	if (r_locked) {
+		return p_shard.lookup(p_name, p_hash);
+	}
+
+	const uint32_t version = p_shard.version.load(std::memory_order_acquire);
+	p_shard.readers.fetch_add(1);
+	_Data *data = p_shard.lookup(p_name, p_hash);
+	p_shard.readers.fetch_sub(1);
+	if (data) {
+		return data;
+	}
+
+	p_shard.mutex.lock();
+	r_locked = true;
+	// Look again only if names were added or moved since the first lookup.
+	if (p_shard.version.load(std::memory_order_relaxed) != version) {
+		data = p_shard.lookup(p_name, p_hash);
+	}
+	return data;
+}
+
+template <class T>
+StringName::_Data *StringName::_find(const T &p_name, uint32_t p_hash) {
+	Shard &shard = shards[p_hash >> (32 - SHARD_BITS)];
+	bool locked = false;
+	_Data *data = _lookup(shard, p_name, p_hash, locked);
+
+#ifdef DEBUG_ENABLED
+	if (data && unlikely(debug_stringname)) {
+		data->debug_references++;
+	}
+#endif
+	if (locked) {
+		shard.mutex.unlock();
+	}
+	return data;
+}
+
+template <class T>
+StringName::_Data *StringName::_intern(const T &p_name, uint32_t p_hash, bool p_static, const char *p_cname) {
+	Shard &shard = shards[p_hash >> (32 - SHARD_BITS)];
+	bool locked = false;
+	_Data *data = _lookup(shard, p_name, p_hash, locked);
+
+	if (data) {
+		// Exists.
+		if (p_static) {
+			data->static_count.increment();
+		}
+#ifdef DEBUG_ENABLED
+		if (unlikely(debug_stringname)) {
+			data->debug_references++;
+		}
+#endif
+	} else {
+		data = memnew(_Data);
+		if (p_cname) {
+			data->cname = p_cname;
+		} else {
+			data->name = p_name;
+		}
+		data->refcount.init();
+		data->static_count.set(p_static ? 1 : 0);
+		data->hash = p_hash;
+#ifdef DEBUG_ENABLED
+		if (unlikely(debug_stringname)) {
+			// Keep in memory, force static.
+			data->refcount.ref();
+			data->static_count.increment();
+		}
+#endif
+		shard.insert(data);
+	}
+
+	if (locked) {
+		shard.mutex.unlock();
+	}
+	return data;
+}
+
 void StringName::setup() {
 	ERR_FAIL_COND(configured);
-	for (int i = 0; i < STRING_TABLE_LEN; i++) {
-		_table[i] = nullptr;
+	for (int i = 0; i < SHARD_COUNT; i++) {
+		shards[i].table.store(Shard::create_table(256));
+		shards[i].count = 0;
 	}
 	configured = true;
 }
 
 void StringName::cleanup() {
-	MutexLock lock(mutex);
-
 #ifdef DEBUG_ENABLED
 	if (unlikely(debug_stringname)) {
 		Vector<_Data *> data;
-		for (int i = 0; i < STRING_TABLE_LEN; i++) {
-			_Data *d = _table[i];
-			while (d) {
-				data.push_back(d);
-				d = d->next;
+		for (int i = 0; i < SHARD_COUNT; i++) {
+			MutexLock lock(shards[i].mutex);
+			const Shard::Table *t = shards[i].table.load();
+			for (uint32_t j = 0; j <= t->mask; j++) {
+				for (_Data *d = t->buckets[j].load(); d; d = d->next.load()) {
+					data.push_back(d);
+				}
 			}
 		}
 		print_line("\nStringName Reference Ranking:\n");
@@ -81,21 +292,32 @@ void StringName::cleanup() {
 	}
 #endif
 	int lost_strings = 0;
-	for (int i = 0; i < STRING_TABLE_LEN; i++) {
-		while (_table[i]) {
-			_Data *d = _table[i];
-			lost_strings++;
-			if (d->static_count.get() != d->refcount.get() && OS::get_singleton()->is_stdout_verbose()) {
-				if (d->cname) {
-					print_line("Orphan StringName: " + String(d->cname));
-				} else {
-					print_line("Orphan StringName: " + String(d->name));
+	for (int i = 0; i < SHARD_COUNT; i++) {
+		Shard &shard = shards[i];
+		MutexLock lock(shard.mutex);
+
+		Shard::Table *t = shard.table.load();
+		for (uint32_t j = 0; j <= t->mask; j++) {
+			_Data *d = t->buckets[j].load();
+			while (d) {
+				_Data *next = d->next.load();
+				lost_strings++;
+				if (d->static_count.get() != d->refcount.get() && OS::get_singleton()->is_stdout_verbose()) {
+					if (d->cname) {
+						print_line("Orphan StringName: " + String(d->cname));
+					} else {
+						print_line("Orphan StringName: " + String(d->name));
+					}
 				}
+				memdelete(d);
+				d = next;
 			}
-
-			_table[i] = _table[i]->next;
-			memdelete(d);
 		}
+		Shard::free_table(t);
+		shard.table.store(nullptr);
+		shard.count = 0;
+
+		shard.reclaim();
 	}
 	if (lost_strings) {
 		print_verbose("StringName: " + itos(lost_strings) + " unclaimed string names at exit.");
@@ -107,7 +329,8 @@ void StringName::unref() {
 	ERR_FAIL_COND(!configured);
 
 	if (_data && _data->refcount.unref()) {
-		MutexLock lock(mutex);
+		Shard &shard = shards[_data->hash >> (32 - SHARD_BITS)];
+		MutexLock lock(shard.mutex);
 
 		if (_data->static_count.get() > 0) {
 			if (_data->cname) {
@@ -116,24 +339,11 @@ void StringName::unref() {
 				ERR_PRINT("BUG: Unreferenced static string to 0: " + String(_data->name));
 			}
 		}
-		if (_data->prev) {
-			_data->prev->next = _data->next;
-		} else {
-			if (_table[_data->idx] != _data) {
-				ERR_PRINT("BUG!");
-			}
-			_table[_data->idx] = _data->next;
-		}
-
-		if (_data->next) {
-			_data->next->prev = _data->prev;
-		}
-		memdelete(_data);
+		shard.remove(_data);
 	}
 
 	_data = nullptr;
 }
-
 bool StringName::operator==(const String &p_name) const {
 	if (!_data) {
 		return (p_name.length() == 0);
@@ -191,58 +401,7 @@ StringName::StringName(const char *p_name, bool p_static) {
 		return; //empty, ignore
 	}
 
-	MutexLock lock(mutex);
-
-	uint32_t hash = String::hash(p_name);
-
-	uint32_t idx = hash & STRING_TABLE_MASK;
-
-	_data = _table[idx];
-
-	while (_data) {
-		// compare hash first
-		if (_data->hash == hash && _data->get_name() == p_name) {
-			break;
-		}
-		_data = _data->next;
-	}
-
-	if (_data) {
-		if (_data->refcount.ref()) {
-			// exists
-			if (p_static) {
-				_data->static_count.increment();
-			}
-#ifdef DEBUG_ENABLED
-			if (unlikely(debug_stringname)) {
-				_data->debug_references++;
-			}
-#endif
-		}
-
-		return;
-	}
-
-	_data = memnew(_Data);
-	_data->name = p_name;
-	_data->refcount.init();
-	_data->static_count.set(p_static ? 1 : 0);
-	_data->hash = hash;
-	_data->idx = idx;
-	_data->cname = nullptr;
-	_data->next = _table[idx];
-	_data->prev = nullptr;
-#ifdef DEBUG_ENABLED
-	if (unlikely(debug_stringname)) {
-		// Keep in memory, force static.
-		_data->refcount.ref();
-		_data->static_count.increment();
-	}
-#endif
-	if (_table[idx]) {
-		_table[idx]->prev = _data;
-	}
-	_table[idx] = _data;
+	_data = _intern(p_name, String::hash(p_name), p_static, nullptr);
 }
 
 StringName::StringName(const StaticCString &p_static_string, bool p_static) {
@@ -252,57 +411,7 @@ StringName::StringName(const StaticCString &p_static_string, bool p_static) {
 
 	ERR_FAIL_COND(!p_static_string.ptr || !p_static_string.ptr[0]);
 
-	MutexLock lock(mutex);
-
-	uint32_t hash = String::hash(p_static_string.ptr);
-
-	uint32_t idx = hash & STRING_TABLE_MASK;
-
-	_data = _table[idx];
-
-	while (_data) {
-		// compare hash first
-		if (_data->hash == hash && _data->get_name() == p_static_string.ptr) {
-			break;
-		}
-		_data = _data->next;
-	}
-
-	if (_data) {
-		if (_data->refcount.ref()) {
-			// exists
-			if (p_static) {
-				_data->static_count.increment();
-			}
-#ifdef DEBUG_ENABLED
-			if (unlikely(debug_stringname)) {
-				_data->debug_references++;
-			}
-#endif
-			return;
-		}
-	}
-
-	_data = memnew(_Data);
-
-	_data->refcount.init();
-	_data->static_count.set(p_static ? 1 : 0);
-	_data->hash = hash;
-	_data->idx = idx;
-	_data->cname = p_static_string.ptr;
-	_data->next = _table[idx];
-	_data->prev = nullptr;
-#ifdef DEBUG_ENABLED
-	if (unlikely(debug_stringname)) {
-		// Keep in memory, force static.
-		_data->refcount.ref();
-		_data->static_count.increment();
-	}
-#endif
-	if (_table[idx]) {
-		_table[idx]->prev = _data;
-	}
-	_table[idx] = _data;
+	_data = _intern(p_static_string.ptr, String::hash(p_static_string.ptr), p_static, p_static_string.ptr);
 }
 
 StringName::StringName(const String &p_name, bool p_static) {
@@ -314,56 +423,7 @@ StringName::StringName(const String &p_name, bool p_static) {
 		return;
 	}
 
-	MutexLock lock(mutex);
-
-	uint32_t hash = p_name.hash();
-	uint32_t idx = hash & STRING_TABLE_MASK;
-
-	_data = _table[idx];
-
-	while (_data) {
-		if (_data->hash == hash && _data->get_name() == p_name) {
-			break;
-		}
-		_data = _data->next;
-	}
-
-	if (_data) {
-		if (_data->refcount.ref()) {
-			// exists
-			if (p_static) {
-				_data->static_count.increment();
-			}
-#ifdef DEBUG_ENABLED
-			if (unlikely(debug_stringname)) {
-				_data->debug_references++;
-			}
-#endif
-			return;
-		}
-	}
-
-	_data = memnew(_Data);
-	_data->name = p_name;
-	_data->refcount.init();
-	_data->static_count.set(p_static ? 1 : 0);
-	_data->hash = hash;
-	_data->idx = idx;
-	_data->cname = nullptr;
-	_data->next = _table[idx];
-	_data->prev = nullptr;
-#ifdef DEBUG_ENABLED
-	if (unlikely(debug_stringname)) {
-		// Keep in memory, force static.
-		_data->refcount.ref();
-		_data->static_count.increment();
-	}
-#endif
-
-	if (_table[idx]) {
-		_table[idx]->prev = _data;
-	}
-	_table[idx] = _data;
+	_data = _intern(p_name, p_name.hash(), p_static, nullptr);
 }
 
 StringName StringName::search(const char *p_name) {
@@ -374,29 +434,9 @@ StringName StringName::search(const char *p_name) {
 		return StringName();
 	}
 
-	MutexLock lock(mutex);
-
-	uint32_t hash = String::hash(p_name);
-	uint32_t idx = hash & STRING_TABLE_MASK;
-
-	_Data *_data = _table[idx];
-
-	while (_data) {
-		// compare hash first
-		if (_data->hash == hash && _data->get_name() == p_name) {
-			break;
-		}
-		_data = _data->next;
-	}
-
-	if (_data && _data->refcount.ref()) {
-#ifdef DEBUG_ENABLED
-		if (unlikely(debug_stringname)) {
-			_data->debug_references++;
-		}
-#endif
-
-		return StringName(_data);
+	_Data *data = _find(p_name, String::hash(p_name));
+	if (data) {
+		return StringName(data);
 	}
 
 	return StringName(); //does not exist
@@ -410,55 +450,22 @@ StringName StringName::search(const char32_t *p_name) {
 		return StringName();
 	}
 
-	MutexLock lock(mutex);
-
-	uint32_t hash = String::hash(p_name);
-
-	uint32_t idx = hash & STRING_TABLE_MASK;
-
-	_Data *_data = _table[idx];
-
-	while (_data) {
-		// compare hash first
-		if (_data->hash == hash && _data->get_name() == p_name) {
-			break;
-		}
-		_data = _data->next;
-	}
-
-	if (_data && _data->refcount.ref()) {
-		return StringName(_data);
+	_Data *data = _find(p_name, String::hash(p_name));
+	if (data) {
+		return StringName(data);
 	}
 
 	return StringName(); //does not exist
 }
 
 StringName StringName::search(const String &p_name) {
-	ERR_FAIL_COND_V(p_name == "", StringName());
-
-	MutexLock lock(mutex);
-
-	uint32_t hash = p_name.hash();
-
-	uint32_t idx = hash & STRING_TABLE_MASK;
-
-	_Data *_data = _table[idx];
+	ERR_FAIL_COND_V(!configured, StringName());
 
-	while (_data) {
-		// compare hash first
-		if (_data->hash == hash && p_name == _data->get_name()) {
-			break;
-		}
-		_data = _data->next;
-	}
+	ERR_FAIL_COND_V(p_name == "", StringName());
 
-	if (_data && _data->refcount.ref()) {
-#ifdef DEBUG_ENABLED
-		if (unlikely(debug_stringname)) {
-			_data->debug_references++;
-		}
-#endif
-		return StringName(_data);
+	_Data *data = _find(p_name, p_name.hash());
+	if (data) {
+		return StringName(data);
 	}
 
 	return StringName(); //does not exist
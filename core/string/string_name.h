@@ -35,6 +35,8 @@
 #include "core/string/ustring.h"
 #include "core/templates/safe_refcount.h"
 
+#include <atomic>
+
 class Main;
 
 struct StaticCString {
@@ -43,10 +45,11 @@ struct StaticCString {
 };
 
 class StringName {
+	// The names are split in shards by hash, each with its own lock and table,
+	// so threads creating names rarely wait for each other.
 	enum {
-		STRING_TABLE_BITS = 16,
-		STRING_TABLE_LEN = 1 << STRING_TABLE_BITS,
-		STRING_TABLE_MASK = STRING_TABLE_LEN - 1
+		SHARD_BITS = 6,
+		SHARD_COUNT = 1 << SHARD_BITS,
 	};
 
 	struct _Data {
@@ -58,14 +61,17 @@ class StringName {
 		uint32_t debug_references = 0;
 #endif
 		String get_name() const { return cname ? String(cname) : name; }
-		int idx = 0;
+		// Compares without copying the name.
+		bool is_named(const String &p_name) const { return cname ? p_name == cname : name == p_name; }
+		bool is_named(const char *p_name) const { return cname ? strcmp(cname, p_name) == 0 : name == p_name; }
 		uint32_t hash = 0;
-		_Data *prev = nullptr;
-		_Data *next = nullptr;
+		// Read without locking when looking up existing names.
+		std::atomic<_Data *> next = { nullptr };
 		_Data() {}
 	};
 
-	static _Data *_table[STRING_TABLE_LEN];
+	struct Shard;
+	static Shard shards[SHARD_COUNT];
 
 	_Data *_data = nullptr;
 
@@ -78,7 +84,12 @@ class StringName {
 	friend void register_core_types();
 	friend void unregister_core_types();
 	friend class Main;
-	static Mutex mutex;
+	template <class T>
+	static _Data *_lookup(Shard &p_shard, const T &p_name, uint32_t p_hash, bool &r_locked);
+	template <class T>
+	static _Data *_find(const T &p_name, uint32_t p_hash);
+	template <class T>
+	static _Data *_intern(const T &p_name, uint32_t p_hash, bool p_static, const char *p_cname);
 	static void setup();
 	static void cleanup();
 	static bool configured;
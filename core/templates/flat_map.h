@@ -0,0 +1,146 @@
+/*************************************************************************/
+/*  flat_map.h                                                           */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef FLAT_MAP_H
+#define FLAT_MAP_H
+
+#include "core/templates/small_vector.h"
+#include "core/typedefs.h"
+
+// Map stored as an array of pairs sorted by key, with the first INLINE_CAPACITY
+// pairs inside the object. See FlatSet: it's meant to replace Map for small maps
+// of trivially copyable keys. Inserting and erasing move the following pairs, and
+// invalidate pointers to them.
+template <class K, class V, uint32_t INLINE_CAPACITY = 4, class C = Comparator<K>>
+class FlatMap {
+public:
+	struct Pair {
+		K key;
+		V value;
+
+		_FORCE_INLINE_ Pair(const K &p_key, const V &p_value) :
+				key(p_key),
+				value(p_value) {}
+	};
+
+private:
+	SmallVector<Pair, INLINE_CAPACITY> data;
+
+	_FORCE_INLINE_ uint32_t _lower_bound(const K &p_key) const {
+		const Pair *a = data.ptr();
+		uint32_t low = 0;
+		uint32_t high = data.size();
+		C less;
+		while (low < high) {
+			const uint32_t middle = (low + high) / 2;
+			if (less(a[middle].key, p_key)) {
+				low = middle + 1;
+			} else {
+				high = middle;
+			}
+		}
+		return low;
+	}
+
+	_FORCE_INLINE_ bool _is_at(uint32_t p_index, const K &p_key) const {
+		return p_index < data.size() && !C()(p_key, data.ptr()[p_index].key);
+	}
+
+public:
+	/// Inserts or replaces the value of the key, and returns its index.
+	uint32_t insert(const K &p_key, const V &p_value) {
+		const uint32_t pos = _lower_bound(p_key);
+		if (_is_at(pos, p_key)) {
+			data[pos].value = p_value;
+		} else {
+			data.insert(pos, Pair(p_key, p_value));
+		}
+		return pos;
+	}
+
+	/// Returns false if the key wasn't in the map.
+	bool erase(const K &p_key) {
+		const uint32_t pos = _lower_bound(p_key);
+		if (!_is_at(pos, p_key)) {
+			return false;
+		}
+		data.remove(pos);
+		return true;
+	}
+
+	_FORCE_INLINE_ bool has(const K &p_key) const {
+		return _is_at(_lower_bound(p_key), p_key);
+	}
+
+	/// Returns the index of the key, or -1 if it isn't in the map.
+	int find(const K &p_key) const {
+		const uint32_t pos = _lower_bound(p_key);
+		return _is_at(pos, p_key) ? int(pos) : -1;
+	}
+
+	V *getptr(const K &p_key) {
+		const uint32_t pos = _lower_bound(p_key);
+		return _is_at(pos, p_key) ? &data[pos].value : nullptr;
+	}
+
+	const V *getptr(const K &p_key) const {
+		const uint32_t pos = _lower_bound(p_key);
+		return _is_at(pos, p_key) ? &data[pos].value : nullptr;
+	}
+
+	_FORCE_INLINE_ const K &getk(uint32_t p_index) const { return data[p_index].key; }
+	_FORCE_INLINE_ const V &getv(uint32_t p_index) const { return data[p_index].value; }
+	_FORCE_INLINE_ V &getv(uint32_t p_index) { return data[p_index].value; }
+
+	const V &operator[](const K &p_key) const {
+		const V *value = getptr(p_key);
+		CRASH_COND(!value);
+		return *value;
+	}
+
+	V &operator[](const K &p_key) {
+		uint32_t pos = _lower_bound(p_key);
+		if (!_is_at(pos, p_key)) {
+			data.insert(pos, Pair(p_key, V()));
+		}
+		return data[pos].value;
+	}
+
+	_FORCE_INLINE_ uint32_t size() const { return data.size(); }
+	_FORCE_INLINE_ bool is_empty() const { return data.is_empty(); }
+	_FORCE_INLINE_ void clear() { data.clear(); }
+	_FORCE_INLINE_ void reset() { data.reset(); }
+
+	// Keys can't be changed in place, as that could break the order.
+	_FORCE_INLINE_ const Pair *begin() const { return data.begin(); }
+	_FORCE_INLINE_ const Pair *end() const { return data.end(); }
+};
+
+#endif // FLAT_MAP_H
@@ -0,0 +1,108 @@
+/*************************************************************************/
+/*  flat_set.h                                                           */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef FLAT_SET_H
+#define FLAT_SET_H
+
+#include "core/templates/small_vector.h"
+#include "core/typedefs.h"
+
+// Set stored as a sorted array, with the first INLINE_CAPACITY elements inside
+// the object. Lookups are binary searches and iteration is linear, so it's much
+// more cache friendly than Set for small sets of trivially copyable values,
+// like pointers. Inserting and erasing move the following elements, and
+// invalidate pointers to them.
+template <class T, uint32_t INLINE_CAPACITY = 4, class C = Comparator<T>>
+class FlatSet {
+	SmallVector<T, INLINE_CAPACITY> data;
+
+	_FORCE_INLINE_ uint32_t _lower_bound(const T &p_value) const {
+		const T *a = data.ptr();
+		uint32_t low = 0;
+		uint32_t high = data.size();
+		C less;
+		while (low < high) {
+			const uint32_t middle = (low + high) / 2;
+			if (less(a[middle], p_value)) {
+				low = middle + 1;
+			} else {
+				high = middle;
+			}
+		}
+		return low;
+	}
+
+	_FORCE_INLINE_ bool _is_at(uint32_t p_index, const T &p_value) const {
+		return p_index < data.size() && !C()(p_value, data.ptr()[p_index]);
+	}
+
+public:
+	/// Returns false if the value was already in the set.
+	bool insert(const T &p_value) {
+		const uint32_t pos = _lower_bound(p_value);
+		if (_is_at(pos, p_value)) {
+			return false;
+		}
+		data.insert(pos, p_value);
+		return true;
+	}
+
+	/// Returns false if the value wasn't in the set.
+	bool erase(const T &p_value) {
+		const uint32_t pos = _lower_bound(p_value);
+		if (!_is_at(pos, p_value)) {
+			return false;
+		}
+		data.remove(pos);
+		return true;
+	}
+
+	_FORCE_INLINE_ bool has(const T &p_value) const {
+		return _is_at(_lower_bound(p_value), p_value);
+	}
+
+	/// Returns the index of the value, or -1 if it isn't in the set.
+	int find(const T &p_value) const {
+		const uint32_t pos = _lower_bound(p_value);
+		return _is_at(pos, p_value) ? int(pos) : -1;
+	}
+
+	_FORCE_INLINE_ uint32_t size() const { return data.size(); }
+	_FORCE_INLINE_ bool is_empty() const { return data.is_empty(); }
+	_FORCE_INLINE_ void clear() { data.clear(); }
+	_FORCE_INLINE_ void reset() { data.reset(); }
+
+	_FORCE_INLINE_ const T &operator[](uint32_t p_index) const { return data[p_index]; }
+
+	_FORCE_INLINE_ const T *begin() const { return data.begin(); }
+	_FORCE_INLINE_ const T *end() const { return data.end(); }
+};
+
+#endif // FLAT_SET_H
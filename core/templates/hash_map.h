@@ -45,13 +45,21 @@
  * Implementation of a standard Hashing HashMap, for quick lookups of Data associated with a Key.
  * The implementation provides hashers for the default types, if you need a special kind of hasher, provide
  * your own.
+ *
+ * The table uses open addressing with Robin Hood hashing and backward shift deletion. Each slot of the
+ * table holds the hash next to the element pointer, so probing only reads contiguous memory and an
+ * element is only accessed when its hash matches. Elements are never moved, so pointers to keys and
+ * values stay valid when the table grows. They are allocated in blocks, each as large as all the
+ * previous ones, so they are mostly contiguous and inserting doesn't allocate each time. Erased
+ * elements are reused, the blocks are only freed when the map is cleared or empty. Iterating with
+ * next() follows the insertion order.
+ *
  * @param TKey  Key, search is based on it, needs to be hasheable. It is unique in this container.
  * @param TData Data, data associated with the key
  * @param Hasher Hasher object, needs to provide a valid static hash function for TKey
  * @param Comparator comparator object, needs to be able to safely compare two TKey values. It needs to ensure that x == x for any items inserted in the map. Bear in mind that nan != nan when implementing an equality check.
  * @param MIN_HASH_TABLE_POWER Miminum size of the hash table, as a power of two. You rarely need to change this parameter.
- * @param RELATIONSHIP Relationship at which the hash table is resized. if amount of elements is RELATIONSHIP
- * times bigger than the hash table, table is resized to solve this condition. if RELATIONSHIP is zero, table is always MIN_HASH_TABLE_POWER.
+ * @param RELATIONSHIP Unused, the table grows when it is three quarters full. Kept so existing declarations don't change.
  *
 */
 
@@ -74,7 +82,9 @@ public:
 		friend class HashMap;
 
 		uint32_t hash = 0;
+		// Insertion order.
 		Element *next = nullptr;
+		Element *prev = nullptr;
 		Element() {}
 		Pair pair;
 
@@ -88,120 +98,208 @@ public:
 		}
 
 		const TData &value() const {
-			return pair.value();
+			return pair.data;
 		}
 	};
 
 private:
-	Element **hash_table = nullptr;
+	static const uint32_t EMPTY_HASH = 0;
+
+	struct Slot {
+		uint32_t hash;
+		Element *element;
+	};
+
+	Slot *hash_table = nullptr;
 	uint8_t hash_table_power = 0;
 	uint32_t elements = 0;
 
-	void make_hash_table() {
-		ERR_FAIL_COND(hash_table);
+	Element *head_element = nullptr;
+	Element *tail_element = nullptr;
 
-		hash_table = memnew_arr(Element *, (1 << MIN_HASH_TABLE_POWER));
+	// Storage of the elements, the elements of a block follow its header.
+	struct Block {
+		Block *prev = nullptr;
+		uint32_t capacity = 0;
+		uint32_t used = 0;
+	};
+	struct FreeElement {
+		FreeElement *next = nullptr;
+	};
+	static const size_t BLOCK_HEADER_SIZE = (sizeof(Block) + alignof(Element) - 1) / alignof(Element) * alignof(Element);
 
-		hash_table_power = MIN_HASH_TABLE_POWER;
-		elements = 0;
-		for (int i = 0; i < (1 << MIN_HASH_TABLE_POWER); i++) {
-			hash_table[i] = nullptr;
-		}
+	Block *last_block = nullptr;
+	uint32_t block_capacity = 0;
+	FreeElement *free_elements = nullptr;
+
+	_FORCE_INLINE_ static Element *_get_block_elements(Block *p_block) {
+		return reinterpret_cast<Element *>(reinterpret_cast<uint8_t *>(p_block) + BLOCK_HEADER_SIZE);
 	}
 
-	void erase_hash_table() {
-		ERR_FAIL_COND_MSG(elements, "Cannot erase hash table if there are still elements inside.");
+	void _add_block(uint32_t p_capacity) {
+		Block *block = memnew_placement(Memory::alloc_static(BLOCK_HEADER_SIZE + sizeof(Element) * p_capacity), Block);
+		block->prev = last_block;
+		block->capacity = p_capacity;
+		last_block = block;
+		block_capacity += p_capacity;
+	}
 
-		memdelete_arr(hash_table);
-		hash_table = nullptr;
-		hash_table_power = 0;
-		elements = 0;
+	Element *_alloc_element() {
+		if (free_elements) {
+			FreeElement *free_element = free_elements;
+			free_elements = free_element->next;
+			free_element->~FreeElement();
+			return memnew_placement(free_element, Element);
+		}
+
+		if (!last_block || last_block->used == last_block->capacity) {
+			// Doubles the capacity of the map, like the table.
+			_add_block(MAX(block_capacity, 2u));
+		}
+
+		return memnew_placement(&_get_block_elements(last_block)[last_block->used++], Element);
 	}
 
-	void check_hash_table() {
-		int new_hash_table_power = -1;
+	void _free_element(Element *p_element) {
+		p_element->~Element();
+		FreeElement *free_element = memnew_placement(p_element, FreeElement);
+		free_element->next = free_elements;
+		free_elements = free_element;
+	}
 
-		if ((int)elements > ((1 << hash_table_power) * RELATIONSHIP)) {
-			/* rehash up */
-			new_hash_table_power = hash_table_power + 1;
+	void _free_blocks() {
+		while (last_block) {
+			Block *prev = last_block->prev;
+			Memory::free_static(last_block);
+			last_block = prev;
+		}
+		block_capacity = 0;
+		free_elements = nullptr;
+	}
 
-			while ((int)elements > ((1 << new_hash_table_power) * RELATIONSHIP)) {
-				new_hash_table_power++;
-			}
+	template <class K>
+	static _FORCE_INLINE_ uint32_t _hash(const K &p_key) {
+		uint32_t hash = Hasher::hash(p_key);
+		return hash == EMPTY_HASH ? EMPTY_HASH + 1 : hash;
+	}
 
-		} else if ((hash_table_power > (int)MIN_HASH_TABLE_POWER) && ((int)elements < ((1 << (hash_table_power - 1)) * RELATIONSHIP))) {
-			/* rehash down */
-			new_hash_table_power = hash_table_power - 1;
+	_FORCE_INLINE_ uint32_t _get_probe_length(uint32_t p_pos, uint32_t p_hash, uint32_t p_mask) const {
+		return (p_pos - p_hash) & p_mask;
+	}
 
-			while ((int)elements < ((1 << (new_hash_table_power - 1)) * RELATIONSHIP)) {
-				new_hash_table_power--;
-			}
+	void _resize_hash_table(uint8_t p_power) {
+		const uint32_t capacity = 1 << p_power;
 
-			if (new_hash_table_power < (int)MIN_HASH_TABLE_POWER) {
-				new_hash_table_power = MIN_HASH_TABLE_POWER;
-			}
+		if (hash_table) {
+			Memory::free_static(hash_table);
 		}
+		hash_table = static_cast<Slot *>(Memory::alloc_static(sizeof(Slot) * capacity));
+		hash_table_power = p_power;
 
-		if (new_hash_table_power == -1) {
-			return;
+		for (uint32_t i = 0; i < capacity; i++) {
+			hash_table[i].hash = EMPTY_HASH;
 		}
 
-		Element **new_hash_table = memnew_arr(Element *, ((uint64_t)1 << new_hash_table_power));
-		ERR_FAIL_COND_MSG(!new_hash_table, "Out of memory.");
-
-		for (int i = 0; i < (1 << new_hash_table_power); i++) {
-			new_hash_table[i] = nullptr;
+		// The elements are already linked in insertion order, no need to read the old table.
+		for (Element *e = head_element; e; e = e->next) {
+			_insert_in_table(e);
 		}
+	}
 
-		if (hash_table) {
-			for (int i = 0; i < (1 << hash_table_power); i++) {
-				while (hash_table[i]) {
-					Element *se = hash_table[i];
-					hash_table[i] = se->next;
-					int new_pos = se->hash & ((1 << new_hash_table_power) - 1);
-					se->next = new_hash_table[new_pos];
-					new_hash_table[new_pos] = se;
-				}
+	void _insert_in_table(Element *p_element) {
+		const uint32_t mask = (1 << hash_table_power) - 1;
+		uint32_t hash = p_element->hash;
+		Element *element = p_element;
+		uint32_t pos = hash & mask;
+		uint32_t distance = 0;
+
+		while (true) {
+			Slot &slot = hash_table[pos];
+			if (slot.hash == EMPTY_HASH) {
+				slot.hash = hash;
+				slot.element = element;
+				return;
+			}
+
+			// Take the place of elements closer to their ideal position, so all probes stay short.
+			uint32_t existing_probe_length = _get_probe_length(pos, slot.hash, mask);
+			if (existing_probe_length < distance) {
+				SWAP(hash, slot.hash);
+				SWAP(element, slot.element);
+				distance = existing_probe_length;
 			}
 
-			memdelete_arr(hash_table);
+			pos = (pos + 1) & mask;
+			distance++;
 		}
-		hash_table = new_hash_table;
-		hash_table_power = new_hash_table_power;
 	}
 
-	/* I want to have only one function.. */
-	_FORCE_INLINE_ const Element *get_element(const TKey &p_key) const {
-		uint32_t hash = Hasher::hash(p_key);
-		uint32_t index = hash & ((1 << hash_table_power) - 1);
+	template <class K, bool CUSTOM>
+	static _FORCE_INLINE_ bool _compare(const TKey &p_key, const K &p_other) {
+		if constexpr (CUSTOM) {
+			return p_key == p_other;
+		} else {
+			return Comparator::compare(p_key, p_other);
+		}
+	}
 
-		Element *e = hash_table[index];
+	template <class K, bool CUSTOM>
+	_FORCE_INLINE_ bool _lookup_pos(const K &p_key, uint32_t p_hash, uint32_t &r_pos) const {
+		if (unlikely(!hash_table)) {
+			return false;
+		}
+
+		const uint32_t mask = (1 << hash_table_power) - 1;
+		uint32_t pos = p_hash & mask;
+		uint32_t distance = 0;
+
+		while (true) {
+			const uint32_t hash = hash_table[pos].hash;
+			// Stop at the first element closer to its ideal position than this key would be.
+			if (hash == EMPTY_HASH || distance > _get_probe_length(pos, hash, mask)) {
+				return false;
+			}
 
-		while (e) {
 			/* checking hash first avoids comparing key, which may take longer */
-			if (e->hash == hash && Comparator::compare(e->pair.key, p_key)) {
-				/* the pair exists in this hashtable, so just update data */
-				return e;
+			if (hash == p_hash && _compare<K, CUSTOM>(hash_table[pos].element->pair.key, p_key)) {
+				r_pos = pos;
+				return true;
 			}
 
-			e = e->next;
+			pos = (pos + 1) & mask;
+			distance++;
 		}
+	}
 
+	_FORCE_INLINE_ Element *get_element(const TKey &p_key) const {
+		uint32_t pos = 0;
+		if (_lookup_pos<TKey, false>(p_key, _hash(p_key), pos)) {
+			return hash_table[pos].element;
+		}
 		return nullptr;
 	}
 
 	Element *create_element(const TKey &p_key) {
+		if (!hash_table) {
+			_resize_hash_table(MIN_HASH_TABLE_POWER);
+		} else if ((elements + 1) * 4 > (3u << hash_table_power)) {
+			_resize_hash_table(hash_table_power + 1);
+		}
+
 		/* if element doesn't exist, create it */
-		Element *e = memnew(Element);
-		ERR_FAIL_COND_V_MSG(!e, nullptr, "Out of memory.");
-		uint32_t hash = Hasher::hash(p_key);
-		uint32_t index = hash & ((1 << hash_table_power) - 1);
-		e->next = hash_table[index];
-		e->hash = hash;
+		Element *e = _alloc_element();
+		e->hash = _hash(p_key);
 		e->pair.key = p_key;
-		e->pair.data = TData();
 
-		hash_table[index] = e;
+		e->prev = tail_element;
+		if (tail_element) {
+			tail_element->next = e;
+		} else {
+			head_element = e;
+		}
+		tail_element = e;
+
+		_insert_in_table(e);
 		elements++;
 
 		return e;
@@ -214,31 +312,27 @@ private:
 
 		clear();
 
-		if (!p_t.hash_table || p_t.hash_table_power == 0) {
+		if (!p_t.hash_table) {
 			return; /* not copying from empty table */
 		}
 
-		hash_table = memnew_arr(Element *, (uint64_t)1 << p_t.hash_table_power);
-		hash_table_power = p_t.hash_table_power;
-		elements = p_t.elements;
-
-		for (int i = 0; i < (1 << p_t.hash_table_power); i++) {
-			hash_table[i] = nullptr;
-
-			const Element *e = p_t.hash_table[i];
+		_add_block(p_t.elements);
+		for (const Element *e = p_t.head_element; e; e = e->next) {
+			Element *le = _alloc_element(); /* local element */
+			le->hash = e->hash;
+			le->pair = e->pair;
 
-			while (e) {
-				Element *le = memnew(Element); /* local element */
-
-				*le = *e; /* copy data */
-
-				/* add to list and reassign pointers */
-				le->next = hash_table[i];
-				hash_table[i] = le;
-
-				e = e->next;
+			le->prev = tail_element;
+			if (tail_element) {
+				tail_element->next = le;
+			} else {
+				head_element = le;
 			}
+			tail_element = le;
 		}
+		elements = p_t.elements;
+
+		_resize_hash_table(p_t.hash_table_power);
 	}
 
 public:
@@ -247,12 +341,7 @@ public:
 	}
 
 	Element *set(const Pair &p_pair) {
-		Element *e = nullptr;
-		if (!hash_table) {
-			make_hash_table(); // if no table, make one
-		} else {
-			e = const_cast<Element *>(get_element(p_pair.key));
-		}
+		Element *e = get_element(p_pair.key);
 
 		/* if we made it up to here, the pair doesn't exist, create and assign */
 
@@ -261,7 +350,6 @@ public:
 			if (!e) {
 				return nullptr;
 			}
-			check_hash_table(); // perform mantenience routine
 		}
 
 		e->pair.data = p_pair.data;
@@ -296,11 +384,7 @@ public:
 	 */
 
 	_FORCE_INLINE_ TData *getptr(const TKey &p_key) {
-		if (unlikely(!hash_table)) {
-			return nullptr;
-		}
-
-		Element *e = const_cast<Element *>(get_element(p_key));
+		Element *e = get_element(p_key);
 
 		if (e) {
 			return &e->pair.data;
@@ -310,11 +394,7 @@ public:
 	}
 
 	_FORCE_INLINE_ const TData *getptr(const TKey &p_key) const {
-		if (unlikely(!hash_table)) {
-			return nullptr;
-		}
-
-		const Element *e = const_cast<Element *>(get_element(p_key));
+		const Element *e = get_element(p_key);
 
 		if (e) {
 			return &e->pair.data;
@@ -324,55 +404,49 @@ public:
 	}
 
 	/**
-	 * Same as get, except it can return nullptr when item was not found.
-	 * This version is custom, will take a hash and a custom key (that should support operator==()
+	 * Same as getptr, but takes a key of another type, compared to the keys with operator==(),
+	 * so it doesn't need to be converted to TKey (like a String for StringName keys).
+	 * The Hasher must give it the same hash as the equivalent TKey.
 	 */
 
-	template <class C>
-	_FORCE_INLINE_ TData *custom_getptr(C p_custom_key, uint32_t p_custom_hash) {
-		if (unlikely(!hash_table)) {
-			return nullptr;
+	template <class K>
+	_FORCE_INLINE_ TData *getptr_as(const K &p_key) {
+		uint32_t pos = 0;
+		if (_lookup_pos<K, true>(p_key, _hash(p_key), pos)) {
+			return &hash_table[pos].element->pair.data;
 		}
+		return nullptr;
+	}
 
-		uint32_t hash = p_custom_hash;
-		uint32_t index = hash & ((1 << hash_table_power) - 1);
-
-		Element *e = hash_table[index];
+	template <class K>
+	_FORCE_INLINE_ const TData *getptr_as(const K &p_key) const {
+		uint32_t pos = 0;
+		if (_lookup_pos<K, true>(p_key, _hash(p_key), pos)) {
+			return &hash_table[pos].element->pair.data;
+		}
+		return nullptr;
+	}
 
-		while (e) {
-			/* checking hash first avoids comparing key, which may take longer */
-			if (e->hash == hash && Comparator::compare(e->pair.key, p_custom_key)) {
-				/* the pair exists in this hashtable, so just update data */
-				return &e->pair.data;
-			}
+	/**
+	 * Same as get, except it can return nullptr when item was not found.
+	 * This version is custom, will take a hash and a custom key (that should support operator==()
+	 */
 
-			e = e->next;
+	template <class C>
+	_FORCE_INLINE_ TData *custom_getptr(C p_custom_key, uint32_t p_custom_hash) {
+		uint32_t pos = 0;
+		if (_lookup_pos<C, true>(p_custom_key, p_custom_hash == EMPTY_HASH ? EMPTY_HASH + 1 : p_custom_hash, pos)) {
+			return &hash_table[pos].element->pair.data;
 		}
-
 		return nullptr;
 	}
 
 	template <class C>
 	_FORCE_INLINE_ const TData *custom_getptr(C p_custom_key, uint32_t p_custom_hash) const {
-		if (unlikely(!hash_table)) {
-			return nullptr;
+		uint32_t pos = 0;
+		if (_lookup_pos<C, true>(p_custom_key, p_custom_hash == EMPTY_HASH ? EMPTY_HASH + 1 : p_custom_hash, pos)) {
+			return &hash_table[pos].element->pair.data;
 		}
-
-		uint32_t hash = p_custom_hash;
-		uint32_t index = hash & ((1 << hash_table_power) - 1);
-
-		const Element *e = hash_table[index];
-
-		while (e) {
-			/* checking hash first avoids comparing key, which may take longer */
-			if (e->hash == hash && Comparator::compare(e->pair.key, p_custom_key)) {
-				/* the pair exists in this hashtable, so just update data */
-				return &e->pair.data;
-			}
-
-			e = e->next;
-		}
-
 		return nullptr;
 	}
 
@@ -381,41 +455,41 @@ public:
 	 */
 
 	bool erase(const TKey &p_key) {
-		if (unlikely(!hash_table)) {
+		uint32_t pos = 0;
+		if (!_lookup_pos<TKey, false>(p_key, _hash(p_key), pos)) {
 			return false;
 		}
 
-		uint32_t hash = Hasher::hash(p_key);
-		uint32_t index = hash & ((1 << hash_table_power) - 1);
+		Element *e = hash_table[pos].element;
 
-		Element *e = hash_table[index];
-		Element *p = nullptr;
-		while (e) {
-			/* checking hash first avoids comparing key, which may take longer */
-			if (e->hash == hash && Comparator::compare(e->pair.key, p_key)) {
-				if (p) {
-					p->next = e->next;
-				} else {
-					//begin of list
-					hash_table[index] = e->next;
-				}
-
-				memdelete(e);
-				elements--;
-
-				if (elements == 0) {
-					erase_hash_table();
-				} else {
-					check_hash_table();
-				}
-				return true;
-			}
+		// Shift back the following elements until one is at its ideal position, instead of leaving a tombstone.
+		const uint32_t mask = (1 << hash_table_power) - 1;
+		uint32_t next_pos = (pos + 1) & mask;
+		while (hash_table[next_pos].hash != EMPTY_HASH && _get_probe_length(next_pos, hash_table[next_pos].hash, mask) != 0) {
+			hash_table[pos] = hash_table[next_pos];
+			pos = next_pos;
+			next_pos = (pos + 1) & mask;
+		}
+		hash_table[pos].hash = EMPTY_HASH;
 
-			p = e;
-			e = e->next;
+		if (e->prev) {
+			e->prev->next = e->next;
+		} else {
+			head_element = e->next;
+		}
+		if (e->next) {
+			e->next->prev = e->prev;
+		} else {
+			tail_element = e->prev;
 		}
 
-		return false;
+		_free_element(e);
+		elements--;
+
+		if (elements == 0) {
+			clear();
+		}
+		return true;
 	}
 
 	inline const TData &operator[](const TKey &p_key) const { //constref
@@ -424,18 +498,12 @@ public:
 	}
 	inline TData &operator[](const TKey &p_key) { //assignment
 
-		Element *e = nullptr;
-		if (!hash_table) {
-			make_hash_table(); // if no table, make one
-		} else {
-			e = const_cast<Element *>(get_element(p_key));
-		}
+		Element *e = get_element(p_key);
 
 		/* if we made it up to here, the pair doesn't exist, create */
 		if (!e) {
 			e = create_element(p_key);
 			CRASH_COND(!e);
-			check_hash_table(); // perform mantenience routine
 		}
 
 		return e->pair.data;
@@ -444,6 +512,7 @@ public:
 	/**
 	 * Get the next key to p_key, and the first key if p_key is null.
 	 * Returns a pointer to the next key if found, nullptr otherwise.
+	 * Keys are returned in insertion order.
 	 * Adding/Removing elements while iterating will, of course, have unexpected results, don't do it.
 	 *
 	 * Example:
@@ -454,7 +523,7 @@ public:
 	 *
 	 * 		print( *k );
 	 * 	}
-         *
+	 *
 	*/
 	const TKey *next(const TKey *p_key) const {
 		if (unlikely(!hash_table)) {
@@ -462,35 +531,16 @@ public:
 		}
 
 		if (!p_key) { /* get the first key */
+			return &head_element->pair.key;
+		}
 
-			for (int i = 0; i < (1 << hash_table_power); i++) {
-				if (hash_table[i]) {
-					return &hash_table[i]->pair.key;
-				}
-			}
-
-		} else { /* get the next key */
-
-			const Element *e = get_element(*p_key);
-			ERR_FAIL_COND_V_MSG(!e, nullptr, "Invalid key supplied.");
-			if (e->next) {
-				/* if there is a "next" in the list, return that */
-				return &e->next->pair.key;
-			} else {
-				/* go to next elements */
-				uint32_t index = e->hash & ((1 << hash_table_power) - 1);
-				index++;
-				for (int i = index; i < (1 << hash_table_power); i++) {
-					if (hash_table[i]) {
-						return &hash_table[i]->pair.key;
-					}
-				}
-			}
-
-			/* nothing found, was at end */
+		const Element *e = get_element(*p_key);
+		ERR_FAIL_COND_V_MSG(!e, nullptr, "Invalid key supplied.");
+		if (e->next) {
+			return &e->next->pair.key;
 		}
 
-		return nullptr; /* nothing found */
+		return nullptr; /* nothing found, was at end */
 	}
 
 	inline unsigned int size() const {
@@ -503,21 +553,23 @@ public:
 
 	void clear() {
 		/* clean up */
-		if (hash_table) {
-			for (int i = 0; i < (1 << hash_table_power); i++) {
-				while (hash_table[i]) {
-					Element *e = hash_table[i];
-					hash_table[i] = e->next;
-					memdelete(e);
-				}
-			}
+		Element *e = head_element;
+		while (e) {
+			Element *next = e->next;
+			e->~Element();
+			e = next;
+		}
+		_free_blocks();
 
-			memdelete_arr(hash_table);
+		if (hash_table) {
+			Memory::free_static(hash_table);
 		}
 
 		hash_table = nullptr;
 		hash_table_power = 0;
 		elements = 0;
+		head_element = nullptr;
+		tail_element = nullptr;
 	}
 
 	void operator=(const HashMap &p_table) {
@@ -525,15 +577,8 @@ public:
 	}
 
 	void get_key_list(List<TKey> *r_keys) const {
-		if (unlikely(!hash_table)) {
-			return;
-		}
-		for (int i = 0; i < (1 << hash_table_power); i++) {
-			Element *e = hash_table[i];
-			while (e) {
-				r_keys->push_back(e->pair.key);
-				e = e->next;
-			}
+		for (const Element *e = head_element; e; e = e->next) {
+			r_keys->push_back(e->pair.key);
 		}
 	}
 
@@ -0,0 +1,178 @@
+/*************************************************************************/
+/*  small_vector.h                                                       */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef SMALL_VECTOR_H
+#define SMALL_VECTOR_H
+
+#include "core/error/error_macros.h"
+#include "core/os/memory.h"
+
+#include <string.h>
+
+// Vector storing up to INLINE_CAPACITY elements inside the object, and only
+// allocating when it grows past that. Like LocalVector, elements are moved with
+// memcpy, so they must not point to themselves. The vector itself holds no
+// pointer to its inline storage, so it can be moved with memcpy too.
+template <class T, uint32_t INLINE_CAPACITY = 4>
+class SmallVector {
+	static_assert(INLINE_CAPACITY > 0, "Use LocalVector for vectors without inline storage.");
+
+	uint32_t count = 0;
+	uint32_t capacity = INLINE_CAPACITY;
+	union {
+		T *heap_data;
+		alignas(T) uint8_t inline_data[INLINE_CAPACITY * sizeof(T)];
+	};
+
+	_FORCE_INLINE_ bool _is_inline() const { return capacity == INLINE_CAPACITY; }
+
+	void _grow(uint32_t p_capacity) {
+		uint32_t new_capacity = capacity;
+		while (new_capacity < p_capacity) {
+			new_capacity <<= 1;
+		}
+		if (_is_inline()) {
+			T *data = (T *)memalloc(new_capacity * sizeof(T));
+			CRASH_COND_MSG(!data, "Out of memory");
+			memcpy((void *)data, inline_data, count * sizeof(T));
+			heap_data = data;
+		} else {
+			heap_data = (T *)memrealloc(heap_data, new_capacity * sizeof(T));
+			CRASH_COND_MSG(!heap_data, "Out of memory");
+		}
+		capacity = new_capacity;
+	}
+
+	_FORCE_INLINE_ void _insert(uint32_t p_pos, const T &p_elem) {
+		if (unlikely(count == capacity)) {
+			_grow(count + 1);
+		}
+		T *data = ptr();
+		memmove((void *)(data + p_pos + 1), (void *)(data + p_pos), (count - p_pos) * sizeof(T));
+		memnew_placement(&data[p_pos], T(p_elem));
+		count++;
+	}
+
+public:
+	_FORCE_INLINE_ T *ptr() { return _is_inline() ? (T *)inline_data : heap_data; }
+	_FORCE_INLINE_ const T *ptr() const { return _is_inline() ? (const T *)inline_data : heap_data; }
+
+	_FORCE_INLINE_ uint32_t size() const { return count; }
+	_FORCE_INLINE_ bool is_empty() const { return count == 0; }
+	_FORCE_INLINE_ uint32_t get_capacity() const { return capacity; }
+
+	_FORCE_INLINE_ T *begin() { return ptr(); }
+	_FORCE_INLINE_ T *end() { return ptr() + count; }
+	_FORCE_INLINE_ const T *begin() const { return ptr(); }
+	_FORCE_INLINE_ const T *end() const { return ptr() + count; }
+
+	_FORCE_INLINE_ const T &operator[](uint32_t p_index) const {
+		CRASH_BAD_UNSIGNED_INDEX(p_index, count);
+		return ptr()[p_index];
+	}
+	_FORCE_INLINE_ T &operator[](uint32_t p_index) {
+		CRASH_BAD_UNSIGNED_INDEX(p_index, count);
+		return ptr()[p_index];
+	}
+
+	void reserve(uint32_t p_capacity) {
+		if (p_capacity > capacity) {
+			_grow(p_capacity);
+		}
+	}
+
+	_FORCE_INLINE_ void push_back(const T &p_elem) {
+		insert(count, p_elem);
+	}
+
+	void insert(uint32_t p_pos, const T &p_elem) {
+		ERR_FAIL_UNSIGNED_INDEX(p_pos, count + 1);
+		if (unlikely(&p_elem >= ptr() && &p_elem < ptr() + count)) {
+			// The element would move while making room for it.
+			T elem = p_elem;
+			_insert(p_pos, elem);
+		} else {
+			_insert(p_pos, p_elem);
+		}
+	}
+
+	void remove(uint32_t p_index) {
+		ERR_FAIL_UNSIGNED_INDEX(p_index, count);
+		T *data = ptr();
+		if (!__has_trivial_destructor(T)) {
+			data[p_index].~T();
+		}
+		count--;
+		memmove((void *)(data + p_index), (void *)(data + p_index + 1), (count - p_index) * sizeof(T));
+	}
+
+	void clear() {
+		if (!__has_trivial_destructor(T)) {
+			T *data = ptr();
+			for (uint32_t i = 0; i < count; i++) {
+				data[i].~T();
+			}
+		}
+		count = 0;
+	}
+
+	/// Clears the vector and frees its memory, going back to the inline storage.
+	void reset() {
+		clear();
+		if (!_is_inline()) {
+			memfree(heap_data);
+			capacity = INLINE_CAPACITY;
+		}
+	}
+
+	SmallVector() {}
+	SmallVector(const SmallVector &p_from) {
+		*this = p_from;
+	}
+	SmallVector &operator=(const SmallVector &p_from) {
+		if (this == &p_from) {
+			return *this;
+		}
+		clear();
+		reserve(p_from.count);
+		T *data = ptr();
+		const T *from = p_from.ptr();
+		for (uint32_t i = 0; i < p_from.count; i++) {
+			memnew_placement(&data[i], T(from[i]));
+		}
+		count = p_from.count;
+		return *this;
+	}
+	~SmallVector() {
+		reset();
+	}
+};
+
+#endif // SMALL_VECTOR_H
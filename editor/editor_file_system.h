@@ -36,7 +36,6 @@
 #include "core/os/thread_safe.h"
 #include "core/templates/safe_refcount.h"
 #include "core/templates/set.h"
-#include "core/templates/thread_work_pool.h"
 #include "scene/main/node.h"
 
 class FileAccess;
@@ -243,8 +242,6 @@ class EditorFileSystem : public Node {
 
 	Set<String> group_file_cache;
 
-	ThreadWorkPool import_threads;
-
 	struct ImportThreadData {
 		const ImportFile *reimport_files;
 		int reimport_from;
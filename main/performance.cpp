@@ -32,6 +32,7 @@
 
 #include "core/object/message_queue.h"
 #include "core/os/os.h"
+#include "core/os/small_object_allocator.h"
 #include "scene/main/node.h"
 #include "scene/main/scene_tree.h"
 #include "servers/audio_server.h"
@@ -49,6 +50,7 @@ void Performance::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("get_custom_monitor", "id"), &Performance::get_custom_monitor);
 	ClassDB::bind_method(D_METHOD("get_monitor_modification_time"), &Performance::get_monitor_modification_time);
 	ClassDB::bind_method(D_METHOD("get_custom_monitor_names"), &Performance::get_custom_monitor_names);
+	ClassDB::bind_method(D_METHOD("get_small_object_usage"), &Performance::get_small_object_usage);
 
 	BIND_ENUM_CONSTANT(TIME_FPS);
 	BIND_ENUM_CONSTANT(TIME_PROCESS);
@@ -73,6 +75,8 @@ void Performance::_bind_methods() {
 	BIND_ENUM_CONSTANT(PHYSICS_3D_COLLISION_PAIRS);
 	BIND_ENUM_CONSTANT(PHYSICS_3D_ISLAND_COUNT);
 	BIND_ENUM_CONSTANT(AUDIO_OUTPUT_LATENCY);
+	BIND_ENUM_CONSTANT(MEMORY_SMALL_OBJECTS);
+	BIND_ENUM_CONSTANT(MEMORY_SMALL_OBJECT_CACHE_HIT_RATE);
 
 	BIND_ENUM_CONSTANT(MONITOR_MAX);
 }
@@ -112,6 +116,8 @@ String Performance::get_monitor_name(Monitor p_monitor) const {
 		"physics_3d/collision_pairs",
 		"physics_3d/islands",
 		"audio/driver/output_latency",
+		"memory/small_objects",
+		"memory/small_object_cache_hit_rate",
 
 	};
 
@@ -166,6 +172,21 @@ double Performance::get_monitor(Monitor p_monitor) const {
 			return PhysicsServer3D::get_singleton()->get_process_info(PhysicsServer3D::INFO_ISLAND_COUNT);
 		case AUDIO_OUTPUT_LATENCY:
 			return AudioServer::get_singleton()->get_output_latency();
+		case MEMORY_SMALL_OBJECTS: {
+			SmallObjectAllocator::Stats stats;
+			SmallObjectAllocator::get_stats(stats);
+			uint64_t bytes = 0;
+			for (int i = 0; i < SmallObjectAllocator::SIZE_CLASS_COUNT; i++) {
+				bytes += stats.bytes[i];
+			}
+			return bytes;
+		}
+		case MEMORY_SMALL_OBJECT_CACHE_HIT_RATE: {
+			SmallObjectAllocator::Stats stats;
+			SmallObjectAllocator::get_stats(stats);
+			const uint64_t total = stats.cache_hits + stats.cache_misses;
+			return total ? 100.0 * stats.cache_hits / total : 0.0;
+		}
 
 		default: {
 		}
@@ -201,12 +222,25 @@ Performance::MonitorType Performance::get_monitor_type(Monitor p_monitor) const
 		MONITOR_TYPE_QUANTITY,
 		MONITOR_TYPE_QUANTITY,
 		MONITOR_TYPE_TIME,
+		MONITOR_TYPE_MEMORY,
+		MONITOR_TYPE_QUANTITY,
 
 	};
 
 	return types[p_monitor];
 }
 
+Dictionary Performance::get_small_object_usage() const {
+	SmallObjectAllocator::Stats stats;
+	SmallObjectAllocator::get_stats(stats);
+
+	Dictionary usage;
+	for (int i = 0; i < SmallObjectAllocator::SIZE_CLASS_COUNT; i++) {
+		usage[(int64_t)SmallObjectAllocator::get_size_class_size(i)] = stats.bytes[i];
+	}
+	return usage;
+}
+
 void Performance::set_process_time(double p_pt) {
 	_process_time = p_pt;
 }
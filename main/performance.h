@@ -87,6 +87,8 @@ public:
 		PHYSICS_3D_ISLAND_COUNT,
 		//physics
 		AUDIO_OUTPUT_LATENCY,
+		MEMORY_SMALL_OBJECTS,
+		MEMORY_SMALL_OBJECT_CACHE_HIT_RATE,
 		MONITOR_MAX
 	};
 
@@ -101,6 +103,8 @@ public:
 
 	MonitorType get_monitor_type(Monitor p_monitor) const;
 
+	Dictionary get_small_object_usage() const;
+
 	void set_process_time(double p_pt);
 	void set_physics_process_time(double p_pt);
 
@@ -40,9 +40,11 @@
 #include "core/io/file_access_encrypted.h"
 #include "core/os/os.h"
 #include "gdscript_analyzer.h"
+#include "gdscript_bytecode_cache.h"
 #include "gdscript_cache.h"
 #include "gdscript_compiler.h"
 #include "gdscript_parser.h"
+#include "gdscript_sampling_profiler.h"
 #include "gdscript_warning.h"
 
 #ifdef TESTS_ENABLED
@@ -813,8 +815,11 @@ Error GDScript::reload(bool p_keep_state) {
 	}
 
 	valid = false;
-	GDScriptParser parser;
-	Error err = parser.parse(source, path, false);
+	// Reuse the tree if `GDScriptCache::compile_scripts()` already parsed this script.
+	Ref<GDScriptParserRef> parsed = GDScriptCache::take_parsed_script(path, source);
+	GDScriptParser local_parser;
+	GDScriptParser &parser = parsed.is_valid() ? *parsed->get_parser() : local_parser;
+	Error err = parsed.is_valid() ? OK : parser.parse(source, path, false);
 	if (err) {
 		if (EngineDebugger::is_active()) {
 			GDScriptLanguage::get_singleton()->debug_break_parse(get_path(), parser.get_errors().front()->get().line, "Parser Error: " + parser.get_errors().front()->get().message);
@@ -974,12 +979,41 @@ void GDScript::_bind_methods() {
 }
 
 Vector<uint8_t> GDScript::get_as_byte_code() const {
-	return Vector<uint8_t>();
+	return GDScriptBytecodeCache::serialize(this);
 };
 
-// TODO: Fully remove this. There's not this kind of "bytecode" anymore.
 Error GDScript::load_byte_code(const String &p_path) {
-	return ERR_COMPILATION_FAILED;
+	{
+		MutexLock lock(GDScriptLanguage::singleton->lock);
+		ERR_FAIL_COND_V(!instances.is_empty(), ERR_ALREADY_IN_USE);
+	}
+
+	Error err;
+	Vector<uint8_t> bytecode = FileAccess::get_file_as_array(p_path, &err);
+	if (err) {
+		return err;
+	}
+
+	String source_path = path;
+	if (source_path.is_empty()) {
+		source_path = get_path();
+	}
+	if (!source_path.is_empty()) {
+		MutexLock lock(GDScriptCache::singleton->lock);
+		if (!GDScriptCache::singleton->shallow_gdscript_cache.has(source_path)) {
+			GDScriptCache::singleton->shallow_gdscript_cache[source_path] = this;
+		}
+	}
+
+	err = GDScriptBytecodeCache::deserialize(this, bytecode);
+	if (err) {
+		return err;
+	}
+
+	if (source_path.is_empty()) {
+		return OK;
+	}
+	return GDScriptCache::finish_compiling(source_path);
 }
 
 Error GDScript::load_source_code(const String &p_path) {
@@ -1203,6 +1237,7 @@ GDScript::~GDScript() {
 	for (Map<StringName, GDScriptFunction *>::Element *E = member_functions.front(); E; E = E->next()) {
 		memdelete(E->get());
 	}
+	GDScriptLanguage::get_singleton()->invalidate_inline_caches();
 
 	if (GDScriptCache::singleton) { // Cache may have been already destroyed at engine shutdown.
 		GDScriptCache::remove_script(get_path());
@@ -1664,6 +1699,11 @@ void GDScriptLanguage::init() {
 		_add_global(E.name, E.ptr);
 	}
 
+	GDScriptSamplingProfiler::register_profiler();
+	if (GLOBAL_GET("debug/gdscript/sampling_profiler/enabled") && !Engine::get_singleton()->is_editor_hint()) {
+		GDScriptSamplingProfiler::start(GLOBAL_GET("debug/gdscript/sampling_profiler/interval_usec"));
+	}
+
 #ifdef TESTS_ENABLED
 	GDScriptTests::GDScriptTestRunner::handle_cmdline();
 #endif
@@ -1683,6 +1723,10 @@ Error GDScriptLanguage::execute_file(const String &p_path) {
 }
 
 void GDScriptLanguage::finish() {
+	GDScriptSamplingProfiler::unregister_profiler();
+	if (GLOBAL_GET("debug/gdscript/sampling_profiler/enabled") && !Engine::get_singleton()->is_editor_hint()) {
+		GDScriptSamplingProfiler::save_folded_stacks(GLOBAL_GET("debug/gdscript/sampling_profiler/output_path"));
+	}
 }
 
 void GDScriptLanguage::profiling_start() {
@@ -2172,6 +2216,14 @@ GDScriptLanguage::GDScriptLanguage() {
 		_call_stack = nullptr;
 	}
 
+	GLOBAL_DEF("debug/gdscript/compiler/optimize_bytecode", false);
+	GLOBAL_DEF("debug/gdscript/compiler/enable_jit", false);
+
+	GLOBAL_DEF("debug/gdscript/sampling_profiler/enabled", false);
+	GLOBAL_DEF("debug/gdscript/sampling_profiler/interval_usec", 1000);
+	ProjectSettings::get_singleton()->set_custom_property_info("debug/gdscript/sampling_profiler/interval_usec", PropertyInfo(Variant::INT, "debug/gdscript/sampling_profiler/interval_usec", PROPERTY_HINT_RANGE, "50,100000,1,or_greater"));
+	GLOBAL_DEF("debug/gdscript/sampling_profiler/output_path", "user://gdscript_samples.folded");
+
 #ifdef DEBUG_ENABLED
 	GLOBAL_DEF("debug/gdscript/warnings/enable", true);
 	GLOBAL_DEF("debug/gdscript/warnings/treat_warnings_as_errors", false);
@@ -2238,15 +2290,37 @@ Ref<GDScript> GDScriptLanguage::get_orphan_subclass(const String &p_qualified_na
 
 /*************** RESOURCE ***************/
 
+Ref<GDScript> ResourceFormatLoaderGDScript::load_script(const String &p_path, Error &r_error, const String &p_owner) {
+	// Exported projects ship the compiled scripts, which are used as long as they
+	// match the source code. Compile from source when debugging, since they have
+	// no debug info for the local variables.
+	String byte_code_path = GDScriptBytecodeCache::get_cache_path(p_path);
+	if (!EngineDebugger::is_active() && FileAccess::exists(byte_code_path)) {
+		Ref<GDScript> script = GDScriptCache::get_byte_code_script(p_path, byte_code_path, p_owner);
+		if (script.is_valid()) {
+			r_error = OK;
+			return script;
+		}
+	}
+
+	return GDScriptCache::get_full_script(p_path, r_error, p_owner);
+}
+
 RES ResourceFormatLoaderGDScript::load(const String &p_path, const String &p_original_path, Error *r_error, bool p_use_sub_threads, float *r_progress, CacheMode p_cache_mode) {
 	if (r_error) {
 		*r_error = ERR_FILE_CANT_OPEN;
 	}
 
+	if (!Engine::get_singleton()->is_editor_hint()) {
+		// The game loads the autoloads one after the other, compile them
+		// all at once instead, so they are parsed in parallel.
+		GDScriptCache::compile_autoloads(p_path);
+	}
+
 	Error err;
-	Ref<GDScript> script = GDScriptCache::get_full_script(p_path, err);
+	Ref<GDScript> script = load_script(p_path, err);
 
-	// TODO: Reintroduce binary and encrypted scripts.
+	// TODO: Reintroduce encrypted scripts.
 
 	if (script.is_null()) {
 		// Don't fail loading because of parsing error.
@@ -71,6 +71,7 @@ class GDScript : public Script {
 	friend class GDScriptFunction;
 	friend class GDScriptAnalyzer;
 	friend class GDScriptCompiler;
+	friend class GDScriptBytecodeCache;
 	friend class GDScriptLanguage;
 	friend struct GDScriptUtilityFunctionsDefinitions;
 
@@ -165,6 +166,7 @@ protected:
 	void _get_property_list(List<PropertyInfo> *p_properties) const;
 
 	Variant call(const StringName &p_method, const Variant **p_args, int p_argcount, Callable::CallError &r_error) override;
+	bool has_custom_call() const override { return true; }
 
 	static void _bind_methods();
 
@@ -342,6 +344,8 @@ class GDScriptLanguage : public ScriptLanguage {
 
 	SelfList<GDScriptFunction>::List function_list;
 	bool profiling;
+
+	SafeNumeric<uint32_t> inline_cache_generation;
 	uint64_t script_frame_time;
 
 	Map<String, ObjectID> orphan_subclasses;
@@ -428,6 +432,10 @@ public:
 
 	_FORCE_INLINE_ static GDScriptLanguage *get_singleton() { return singleton; }
 
+	// Must be called when script functions or members are deleted, so the VM inline caches don't use them.
+	_FORCE_INLINE_ void invalidate_inline_caches() { inline_cache_generation.increment(); }
+	_FORCE_INLINE_ uint32_t get_inline_cache_generation() const { return inline_cache_generation.get(); }
+
 	virtual String get_name() const;
 
 	/* LANGUAGE FUNCTIONS */
@@ -509,6 +517,8 @@ public:
 
 class ResourceFormatLoaderGDScript : public ResourceFormatLoader {
 public:
+	static Ref<GDScript> load_script(const String &p_path, Error &r_error, const String &p_owner = String());
+
 	virtual RES load(const String &p_path, const String &p_original_path = "", Error *r_error = nullptr, bool p_use_sub_threads = false, float *r_progress = nullptr, CacheMode p_cache_mode = CACHE_MODE_REUSE);
 	virtual void get_recognized_extensions(List<String> *p_extensions) const;
 	virtual bool handles_type(const String &p_type) const;
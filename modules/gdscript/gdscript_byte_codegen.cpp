@@ -30,6 +30,7 @@
 
 #include "gdscript_byte_codegen.h"
 
+#include "core/config/project_settings.h"
 #include "core/debugger/engine_debugger.h"
 #include "gdscript.h"
 
@@ -139,6 +140,7 @@ uint32_t GDScriptByteCodeGenerator::add_temporary(const GDScriptDataType &p_type
 void GDScriptByteCodeGenerator::pop_temporary() {
 	ERR_FAIL_COND(used_temporaries.is_empty());
 	int slot_idx = used_temporaries.back()->get();
+	_try_remove_copy(slot_idx);
 	const StackSlot &slot = temporaries[slot_idx];
 	temporaries_pool[slot.type].push_back(slot_idx);
 	used_temporaries.pop_back();
@@ -148,6 +150,7 @@ void GDScriptByteCodeGenerator::start_parameters() {
 	if (function->_default_arg_count > 0) {
 		append(GDScriptFunction::OPCODE_JUMP_TO_DEF_ARGUMENT);
 		function->default_arguments.push_back(opcodes.size());
+		mark_jump_target(opcodes.size());
 	}
 }
 
@@ -155,9 +158,157 @@ void GDScriptByteCodeGenerator::end_parameters() {
 	function->default_arguments.reverse();
 }
 
+bool GDScriptByteCodeGenerator::_is_copy_producer(int p_instruction) const {
+	// Instructions that fully overwrite their last address argument as a Variant,
+	// so they can write into any local. The validated ones are excluded since
+	// they expect the destination to already have the result type.
+	switch (opcodes[p_instruction] & GDScriptFunction::INSTR_MASK) {
+		case GDScriptFunction::OPCODE_OPERATOR:
+		case GDScriptFunction::OPCODE_GET_KEYED:
+		case GDScriptFunction::OPCODE_GET_NAMED:
+		case GDScriptFunction::OPCODE_GET_MEMBER:
+		case GDScriptFunction::OPCODE_CONSTRUCT:
+		case GDScriptFunction::OPCODE_CONSTRUCT_ARRAY:
+		case GDScriptFunction::OPCODE_CONSTRUCT_DICTIONARY:
+		case GDScriptFunction::OPCODE_CALL_RETURN:
+		case GDScriptFunction::OPCODE_CALL_METHOD_BIND_RET:
+		case GDScriptFunction::OPCODE_CALL_UTILITY:
+		case GDScriptFunction::OPCODE_CALL_GDSCRIPT_UTILITY:
+			return true;
+		default:
+			return false;
+	}
+}
+
+void GDScriptByteCodeGenerator::_record_copy(const Address &p_target, const Address &p_source, int p_producer) {
+	if (!optimize || p_source.mode != Address::TEMPORARY || p_producer < 0) {
+		return;
+	}
+	// Only locals, since members and globals can be read by the producer itself (e.g. a call).
+	if (p_target.mode != Address::LOCAL_VARIABLE && p_target.mode != Address::FUNCTION_PARAMETER) {
+		return;
+	}
+	if (last_jump_target > p_producer || !_is_copy_producer(p_producer)) {
+		return;
+	}
+
+	int assign = opcodes.size() - 3;
+	int arg_count = (opcodes[p_producer] & GDScriptFunction::INSTR_ARGS_MASK) >> GDScriptFunction::INSTR_BITS;
+	const Vector<int> &indices = temporaries[p_source.address].bytecode_indices;
+	if (arg_count < 1 || indices.size() < 2 || indices[indices.size() - 2] != p_producer + arg_count || indices[indices.size() - 1] != assign + 2) {
+		return; // The temporary is not what the producer wrote.
+	}
+
+	// The VM may initialize the destination before reading the arguments.
+	int target = opcodes[assign + 1];
+	for (int i = 1; i < arg_count; i++) {
+		if (opcodes[p_producer + i] == target) {
+			return;
+		}
+	}
+
+	pending_copy.producer = p_producer;
+	pending_copy.temporary = p_source.address;
+	pending_copy.assign = assign;
+	pending_copy.target = target;
+}
+
+void GDScriptByteCodeGenerator::_try_remove_copy(int p_temporary) {
+	if (pending_copy.temporary != p_temporary) {
+		return;
+	}
+	int assign = pending_copy.assign;
+	pending_copy.temporary = -1;
+
+	// The temporary dies right after being copied, so the producer can write into the local directly.
+	// Nothing can be written in between, nor jump after the producer.
+	if (opcodes.size() != assign + 3 || last_jump_target > pending_copy.producer) {
+		return;
+	}
+	Vector<int> &indices = temporaries.write[p_temporary].bytecode_indices;
+	ERR_FAIL_COND(indices.size() < 2 || indices[indices.size() - 1] != assign + 2);
+
+	opcodes.write[indices[indices.size() - 2]] = pending_copy.target;
+	indices.resize(indices.size() - 2);
+	opcodes.resize(assign);
+	last_instruction = pending_copy.producer;
+}
+
+bool GDScriptByteCodeGenerator::_try_fuse_jump_if_not(const Address &p_condition) {
+	if (!optimize || p_condition.mode != Address::TEMPORARY || last_instruction < 0 || last_jump_target > last_instruction) {
+		return false;
+	}
+	if ((opcodes[last_instruction] & GDScriptFunction::INSTR_MASK) != GDScriptFunction::OPCODE_OPERATOR_VALIDATED || opcodes.size() != last_instruction + 5) {
+		return false;
+	}
+	const Vector<int> &indices = temporaries[p_condition.address].bytecode_indices;
+	if (indices.is_empty() || indices[indices.size() - 1] != last_instruction + 3) {
+		return false; // The condition is not the operator result.
+	}
+
+	// The operator result is still written to the condition, the jump target is appended by the caller.
+	opcodes.write[last_instruction] = (GDScriptFunction::OPCODE_OPERATOR_VALIDATED_JUMP_IF_NOT & GDScriptFunction::INSTR_MASK) | (3 << GDScriptFunction::INSTR_BITS);
+	return true;
+}
+
+bool GDScriptByteCodeGenerator::_is_same_address(const Address &p_a, const Address &p_b) {
+	// Parameters and locals are both indices in the stack.
+	Address::AddressMode mode_a = p_a.mode == Address::FUNCTION_PARAMETER ? Address::LOCAL_VARIABLE : p_a.mode;
+	Address::AddressMode mode_b = p_b.mode == Address::FUNCTION_PARAMETER ? Address::LOCAL_VARIABLE : p_b.mode;
+	return mode_a == mode_b && p_a.address == p_b.address;
+}
+
+void GDScriptByteCodeGenerator::_forget_known_reads(const Address &p_written) {
+	if (p_written.mode == Address::NIL) {
+		return;
+	}
+	for (uint32_t i = 0; i < known_reads.size(); i++) {
+		const KnownRead &read = known_reads[i];
+		if (_is_same_address(read.base, p_written) || _is_same_address(read.index, p_written) || _is_same_address(read.target, p_written)) {
+			known_reads.remove_unordered(i);
+			i--;
+		}
+	}
+}
+
+bool GDScriptByteCodeGenerator::_reuse_known_read(GDScriptFunction::Opcode p_opcode, const Address &p_base, const Address &p_index, int p_getter, const Address &p_target) {
+	if (!optimize) {
+		return false;
+	}
+	for (uint32_t i = 0; i < known_reads.size(); i++) {
+		const KnownRead &read = known_reads[i];
+		if (read.opcode != p_opcode || read.getter != p_getter || !_is_same_address(read.base, p_base) || !_is_same_address(read.index, p_index)) {
+			continue;
+		}
+		// The target is often the same temporary, popped and taken again, which still holds the value.
+		if (!_is_same_address(read.target, p_target)) {
+			Address source = read.target;
+			append_pure(GDScriptFunction::OPCODE_ASSIGN, 2, p_target);
+			append(p_target);
+			append(source);
+		}
+		return true;
+	}
+	return false;
+}
+
+void GDScriptByteCodeGenerator::_record_known_read(GDScriptFunction::Opcode p_opcode, const Address &p_base, const Address &p_index, int p_getter, const Address &p_target) {
+	if (!optimize || p_target.mode == Address::NIL || _is_same_address(p_target, p_base) || _is_same_address(p_target, p_index)) {
+		return;
+	}
+	KnownRead read;
+	read.opcode = p_opcode;
+	read.base = p_base;
+	read.index = p_index;
+	read.getter = p_getter;
+	read.target = p_target;
+	known_reads.push_back(read);
+}
+
 void GDScriptByteCodeGenerator::write_start(GDScript *p_script, const StringName &p_function_name, bool p_static, MultiplayerAPI::RPCConfig p_rpc_config, const GDScriptDataType &p_return_type) {
 	function = memnew(GDScriptFunction);
 	debug_stack = EngineDebugger::is_active();
+	optimize = GLOBAL_GET("debug/gdscript/compiler/optimize_bytecode");
 
 	function->name = p_function_name;
 	function->_script = p_script;
@@ -399,6 +550,11 @@ GDScriptFunction *GDScriptByteCodeGenerator::write_end() {
 	function->_stack_size = RESERVED_STACK + max_locals + temporaries.size();
 	function->_instruction_args_size = instr_args_max;
 	function->_ptrcall_args_size = ptrcall_max;
+	function->inline_caches.resize(inline_cache_count);
+
+	if (GDScriptJIT::is_enabled()) {
+		GDScriptJIT::compile(function);
+	}
 
 	ended = true;
 	return function;
@@ -536,7 +692,7 @@ void GDScriptByteCodeGenerator::write_unary_operator(const Address &p_target, Va
 		// Gather specific operator.
 		Variant::ValidatedOperatorEvaluator op_func = Variant::get_validated_operator_evaluator(p_operator, p_left_operand.type.builtin_type, Variant::NIL);
 
-		append(GDScriptFunction::OPCODE_OPERATOR_VALIDATED, 3);
+		append_pure(GDScriptFunction::OPCODE_OPERATOR_VALIDATED, 3, p_target);
 		append(p_left_operand);
 		append(Address());
 		append(p_target);
@@ -565,7 +721,7 @@ void GDScriptByteCodeGenerator::write_binary_operator(const Address &p_target, V
 		// Gather specific operator.
 		Variant::ValidatedOperatorEvaluator op_func = Variant::get_validated_operator_evaluator(p_operator, p_left_operand.type.builtin_type, p_right_operand.type.builtin_type);
 
-		append(GDScriptFunction::OPCODE_OPERATOR_VALIDATED, 3);
+		append_pure(GDScriptFunction::OPCODE_OPERATOR_VALIDATED, 3, p_target);
 		append(p_left_operand);
 		append(p_right_operand);
 		append(p_target);
@@ -623,6 +779,7 @@ void GDScriptByteCodeGenerator::write_end_and(const Address &p_target) {
 	logic_op_jump_pos2.pop_back();
 	append(GDScriptFunction::OPCODE_ASSIGN_FALSE, 1);
 	append(p_target);
+	mark_jump_target(opcodes.size()); // From the jump away above.
 }
 
 void GDScriptByteCodeGenerator::write_or_left_operand(const Address &p_left_operand) {
@@ -653,6 +810,7 @@ void GDScriptByteCodeGenerator::write_end_or(const Address &p_target) {
 	logic_op_jump_pos2.pop_back();
 	append(GDScriptFunction::OPCODE_ASSIGN_TRUE, 1);
 	append(p_target);
+	mark_jump_target(opcodes.size()); // From the jump away above.
 }
 
 void GDScriptByteCodeGenerator::write_start_ternary(const Address &p_target) {
@@ -723,11 +881,16 @@ void GDScriptByteCodeGenerator::write_get(const Address &p_target, const Address
 		if (IS_BUILTIN_TYPE(p_index, Variant::INT) && Variant::get_member_validated_indexed_getter(p_source.type.builtin_type)) {
 			// Use indexed getter instead.
 			Variant::ValidatedIndexedGetter getter = Variant::get_member_validated_indexed_getter(p_source.type.builtin_type);
-			append(GDScriptFunction::OPCODE_GET_INDEXED_VALIDATED, 3);
+			int getter_pos = get_indexed_getter_pos(getter);
+			if (_reuse_known_read(GDScriptFunction::OPCODE_GET_INDEXED_VALIDATED, p_source, p_index, getter_pos, p_target)) {
+				return;
+			}
+			append_pure(GDScriptFunction::OPCODE_GET_INDEXED_VALIDATED, 3, p_target);
 			append(p_source);
 			append(p_index);
 			append(p_target);
-			append(getter);
+			append(getter_pos);
+			_record_known_read(GDScriptFunction::OPCODE_GET_INDEXED_VALIDATED, p_source, p_index, getter_pos, p_target);
 			return;
 		} else if (Variant::get_member_validated_keyed_getter(p_source.type.builtin_type)) {
 			Variant::ValidatedKeyedGetter getter = Variant::get_member_validated_keyed_getter(p_source.type.builtin_type);
@@ -758,21 +921,28 @@ void GDScriptByteCodeGenerator::write_set_named(const Address &p_target, const S
 	append(p_target);
 	append(p_source);
 	append(p_name);
+	append(add_inline_cache());
 }
 
 void GDScriptByteCodeGenerator::write_get_named(const Address &p_target, const StringName &p_name, const Address &p_source) {
 	if (HAS_BUILTIN_TYPE(p_source) && Variant::get_member_validated_getter(p_source.type.builtin_type, p_name)) {
 		Variant::ValidatedGetter getter = Variant::get_member_validated_getter(p_source.type.builtin_type, p_name);
-		append(GDScriptFunction::OPCODE_GET_NAMED_VALIDATED, 2);
+		int getter_pos = get_getter_pos(getter);
+		if (_reuse_known_read(GDScriptFunction::OPCODE_GET_NAMED_VALIDATED, p_source, Address(), getter_pos, p_target)) {
+			return;
+		}
+		append_pure(GDScriptFunction::OPCODE_GET_NAMED_VALIDATED, 2, p_target);
 		append(p_source);
 		append(p_target);
-		append(getter);
+		append(getter_pos);
+		_record_known_read(GDScriptFunction::OPCODE_GET_NAMED_VALIDATED, p_source, Address(), getter_pos, p_target);
 		return;
 	}
 	append(GDScriptFunction::OPCODE_GET_NAMED, 2);
 	append(p_source);
 	append(p_target);
 	append(p_name);
+	append(add_inline_cache());
 }
 
 void GDScriptByteCodeGenerator::write_set_member(const Address &p_value, const StringName &p_name) {
@@ -838,14 +1008,16 @@ void GDScriptByteCodeGenerator::write_assign(const Address &p_target, const Addr
 		append(p_source);
 	} else if (p_target.type.kind == GDScriptDataType::BUILTIN && p_source.type.kind == GDScriptDataType::BUILTIN && p_target.type.builtin_type != p_source.type.builtin_type) {
 		// Need conversion.
-		append(GDScriptFunction::OPCODE_ASSIGN_TYPED_BUILTIN, 2);
+		append_pure(GDScriptFunction::OPCODE_ASSIGN_TYPED_BUILTIN, 2, p_target);
 		append(p_target);
 		append(p_source);
 		append(p_target.type.builtin_type);
 	} else {
-		append(GDScriptFunction::OPCODE_ASSIGN, 2);
+		int producer = last_instruction;
+		append_pure(GDScriptFunction::OPCODE_ASSIGN, 2, p_target);
 		append(p_target);
 		append(p_source);
+		_record_copy(p_target, p_source, producer);
 	}
 }
 
@@ -862,6 +1034,7 @@ void GDScriptByteCodeGenerator::write_assign_false(const Address &p_target) {
 void GDScriptByteCodeGenerator::write_assign_default_parameter(const Address &p_dst, const Address &p_src) {
 	write_assign(p_dst, p_src);
 	function->default_arguments.push_back(opcodes.size());
+	mark_jump_target(opcodes.size());
 }
 
 void GDScriptByteCodeGenerator::write_store_named_global(const Address &p_dst, const StringName &p_global) {
@@ -910,6 +1083,7 @@ void GDScriptByteCodeGenerator::write_call(const Address &p_target, const Addres
 	append(p_target);
 	append(p_arguments.size());
 	append(p_function_name);
+	append(add_inline_cache());
 }
 
 void GDScriptByteCodeGenerator::write_super_call(const Address &p_target, const StringName &p_function_name, const Vector<Address> &p_arguments) {
@@ -931,6 +1105,7 @@ void GDScriptByteCodeGenerator::write_call_async(const Address &p_target, const
 	append(p_target);
 	append(p_arguments.size());
 	append(p_function_name);
+	append(add_inline_cache());
 }
 
 void GDScriptByteCodeGenerator::write_call_gdscript_utility(const Address &p_target, GDScriptUtilityFunctions::FunctionPtr p_function, const Vector<Address> &p_arguments) {
@@ -1160,6 +1335,7 @@ void GDScriptByteCodeGenerator::write_call_self(const Address &p_target, const S
 	append(p_target);
 	append(p_arguments.size());
 	append(p_function_name);
+	append(add_inline_cache());
 }
 
 void GDScriptByteCodeGenerator::write_call_self_async(const Address &p_target, const StringName &p_function_name, const Vector<Address> &p_arguments) {
@@ -1171,6 +1347,7 @@ void GDScriptByteCodeGenerator::write_call_self_async(const Address &p_target, c
 	append(p_target);
 	append(p_arguments.size());
 	append(p_function_name);
+	append(add_inline_cache());
 }
 
 void GDScriptByteCodeGenerator::write_call_script_function(const Address &p_target, const Address &p_base, const StringName &p_function_name, const Vector<Address> &p_arguments) {
@@ -1182,6 +1359,7 @@ void GDScriptByteCodeGenerator::write_call_script_function(const Address &p_targ
 	append(p_target);
 	append(p_arguments.size());
 	append(p_function_name);
+	append(add_inline_cache());
 }
 
 void GDScriptByteCodeGenerator::write_lambda(const Address &p_target, GDScriptFunction *p_function, const Vector<Address> &p_captures) {
@@ -1290,8 +1468,10 @@ void GDScriptByteCodeGenerator::write_await(const Address &p_target, const Addre
 }
 
 void GDScriptByteCodeGenerator::write_if(const Address &p_condition) {
-	append(GDScriptFunction::OPCODE_JUMP_IF_NOT, 1);
-	append(p_condition);
+	if (!_try_fuse_jump_if_not(p_condition)) {
+		append(GDScriptFunction::OPCODE_JUMP_IF_NOT, 1);
+		append(p_condition);
+	}
 	if_jmp_addrs.push_back(opcodes.size());
 	append(0); // Jump destination, will be patched.
 }
@@ -1438,12 +1618,14 @@ void GDScriptByteCodeGenerator::write_for() {
 	// Next iteration.
 	int continue_addr = opcodes.size();
 	continue_addrs.push_back(continue_addr);
+	mark_jump_target(continue_addr);
 	append(iterate_opcode, 3);
 	append(counter);
 	append(container);
 	append(iterator);
 	for_jmp_addrs.push_back(opcodes.size());
 	append(0); // Jump destination, will be patched.
+	mark_jump_target(opcodes.size()); // From the skip over 'continue' code.
 }
 
 void GDScriptByteCodeGenerator::write_endfor() {
@@ -1473,12 +1655,15 @@ void GDScriptByteCodeGenerator::write_endfor() {
 void GDScriptByteCodeGenerator::start_while_condition() {
 	current_breaks_to_patch.push_back(List<int>());
 	continue_addrs.push_back(opcodes.size());
+	mark_jump_target(opcodes.size());
 }
 
 void GDScriptByteCodeGenerator::write_while(const Address &p_condition) {
 	// Condition check.
-	append(GDScriptFunction::OPCODE_JUMP_IF_NOT, 1);
-	append(p_condition);
+	if (!_try_fuse_jump_if_not(p_condition)) {
+		append(GDScriptFunction::OPCODE_JUMP_IF_NOT, 1);
+		append(p_condition);
+	}
 	while_jmp_addrs.push_back(opcodes.size());
 	append(0); // End of loop address, will be patched.
 }
@@ -1544,7 +1729,7 @@ void GDScriptByteCodeGenerator::write_breakpoint() {
 }
 
 void GDScriptByteCodeGenerator::write_newline(int p_line) {
-	append(GDScriptFunction::OPCODE_LINE, 0);
+	append_pure(GDScriptFunction::OPCODE_LINE, 0, Address());
 	append(p_line);
 	current_line = p_line;
 }
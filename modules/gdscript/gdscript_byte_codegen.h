@@ -71,6 +71,7 @@ class GDScriptByteCodeGenerator : public GDScriptCodeGenerator {
 	int current_line = 0;
 	int instr_args_max = 0;
 	int ptrcall_max = 0;
+	int inline_cache_count = 0;
 
 #ifdef DEBUG_ENABLED
 	List<int> temp_stack;
@@ -115,6 +116,38 @@ class GDScriptByteCodeGenerator : public GDScriptCodeGenerator {
 	List<List<int>> current_breaks_to_patch;
 	List<List<int>> match_continues_to_patch;
 
+	// Peephole optimizations, done while the code is written.
+	bool optimize = false;
+	int last_instruction = -1; // Start of the last instruction written.
+	int last_jump_target = -1; // Highest address a jump can land on so far.
+
+	// Copy of a temporary into a local, removed when the temporary is popped.
+	struct PendingCopy {
+		int producer = -1;
+		int temporary = -1;
+		int assign = -1;
+		int target = 0;
+	} pending_copy;
+
+	// Validated reads of builtin values still held by their target, reused instead of read again.
+	struct KnownRead {
+		GDScriptFunction::Opcode opcode = GDScriptFunction::OPCODE_END;
+		Address base;
+		Address index;
+		int getter = -1;
+		Address target;
+	};
+	LocalVector<KnownRead> known_reads;
+
+	bool _is_copy_producer(int p_instruction) const;
+	void _record_copy(const Address &p_target, const Address &p_source, int p_producer);
+	void _try_remove_copy(int p_temporary);
+	bool _try_fuse_jump_if_not(const Address &p_condition);
+	static bool _is_same_address(const Address &p_a, const Address &p_b);
+	void _forget_known_reads(const Address &p_written);
+	bool _reuse_known_read(GDScriptFunction::Opcode p_opcode, const Address &p_base, const Address &p_index, int p_getter, const Address &p_target);
+	void _record_known_read(GDScriptFunction::Opcode p_opcode, const Address &p_base, const Address &p_index, int p_getter, const Address &p_target);
+
 	void add_stack_identifier(const StringName &p_id, int p_stackpos) {
 		if (locals.size() > max_locals) {
 			max_locals = locals.size();
@@ -303,6 +336,10 @@ class GDScriptByteCodeGenerator : public GDScriptCodeGenerator {
 		return pos;
 	}
 
+	int add_inline_cache() {
+		return inline_cache_count++;
+	}
+
 	void alloc_ptrcall(int p_params) {
 		if (p_params >= ptrcall_max) {
 			ptrcall_max = p_params;
@@ -332,6 +369,16 @@ class GDScriptByteCodeGenerator : public GDScriptCodeGenerator {
 	}
 
 	void append(GDScriptFunction::Opcode p_code, int p_argument_count) {
+		// Anything could be written, so no read is known anymore.
+		known_reads.clear();
+		append_pure(p_code, p_argument_count, Address());
+	}
+
+	// For instructions without side effects, which write at most to `p_written`.
+	void append_pure(GDScriptFunction::Opcode p_code, int p_argument_count, const Address &p_written) {
+		_forget_known_reads(p_written);
+		last_instruction = opcodes.size();
+		pending_copy.temporary = -1;
 		opcodes.push_back((p_code & GDScriptFunction::INSTR_MASK) | (p_argument_count << GDScriptFunction::INSTR_BITS));
 		instr_args_max = MAX(instr_args_max, p_argument_count);
 	}
@@ -400,8 +447,15 @@ class GDScriptByteCodeGenerator : public GDScriptCodeGenerator {
 		opcodes.push_back(get_lambda_function_pos(p_lambda_function));
 	}
 
+	void mark_jump_target(int p_address) {
+		last_jump_target = MAX(last_jump_target, p_address);
+		// The values read before may not be the ones of the path that jumps here.
+		known_reads.clear();
+	}
+
 	void patch_jump(int p_address) {
 		opcodes.write[p_address] = opcodes.size();
+		mark_jump_target(opcodes.size());
 	}
 
 public:
@@ -421,6 +475,7 @@ public:
 
 	virtual void write_start(GDScript *p_script, const StringName &p_function_name, bool p_static, MultiplayerAPI::RPCConfig p_rpc_config, const GDScriptDataType &p_return_type) override;
 	virtual GDScriptFunction *write_end() override;
+	virtual bool is_optimizing() const override { return optimize; }
 
 #ifdef DEBUG_ENABLED
 	virtual void set_signature(const String &p_signature) override;
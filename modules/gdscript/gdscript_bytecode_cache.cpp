@@ -0,0 +1,1566 @@
+/*************************************************************************/
+/*  gdscript_bytecode_cache.cpp                                          */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+
+#include "gdscript_bytecode_cache.h"
+
+#include "core/io/marshalls.h"
+#include "core/io/resource_loader.h"
+#include "core/object/class_db.h"
+#include "core/version.h"
+#include "core/version_hash.gen.h"
+#include "gdscript.h"
+#include "gdscript_cache.h"
+#include "gdscript_function.h"
+#include "gdscript_utility_functions.h"
+
+#define BYTECODE_MAGIC "GDBC"
+
+enum ReferenceKind {
+	REFERENCE_NULL,
+	REFERENCE_LOCAL_CLASS, // The script itself or one of its inner classes.
+	REFERENCE_SCRIPT_CLASS, // Another script file or one of its inner classes.
+	REFERENCE_RESOURCE,
+	REFERENCE_NATIVE_CLASS,
+	REFERENCE_GLOBAL, // Global constants of the language, like engine singletons.
+};
+
+enum ConstantKind {
+	CONSTANT_VALUE,
+	CONSTANT_OBJECT,
+};
+
+// Engine function pointers are stored as the arguments needed to get them back
+// from Variant, ClassDB or the utility functions.
+struct FunctionKey {
+	uint32_t a = 0;
+	uint32_t b = 0;
+	uint32_t c = 0;
+	StringName name;
+};
+
+static String _get_engine_build() {
+	return String(VERSION_FULL_BUILD) + "." + VERSION_HASH;
+}
+
+static FunctionKey _make_key(uint32_t p_a, uint32_t p_b = 0, uint32_t p_c = 0, const StringName &p_name = StringName()) {
+	FunctionKey key;
+	key.a = p_a;
+	key.b = p_b;
+	key.c = p_c;
+	key.name = p_name;
+	return key;
+}
+
+// Values which can be stored with `encode_variant()` and read back unchanged.
+static bool _is_plain_value(const Variant &p_value) {
+	switch (p_value.get_type()) {
+		case Variant::OBJECT:
+		case Variant::RID:
+		case Variant::CALLABLE:
+		case Variant::SIGNAL: {
+			return false;
+		} break;
+		case Variant::ARRAY: {
+			const Array array = p_value;
+			if (array.is_typed()) {
+				return false;
+			}
+			for (int i = 0; i < array.size(); i++) {
+				if (!_is_plain_value(array[i])) {
+					return false;
+				}
+			}
+		} break;
+		case Variant::DICTIONARY: {
+			const Dictionary dictionary = p_value;
+			List<Variant> keys;
+			dictionary.get_key_list(&keys);
+			for (const Variant &key : keys) {
+				if (!_is_plain_value(key) || !_is_plain_value(dictionary[key])) {
+					return false;
+				}
+			}
+		} break;
+		default: {
+		} break;
+	}
+	return true;
+}
+
+void GDScriptBytecodeCache::_clear_class(GDScript *p_script) {
+	for (Map<StringName, Ref<GDScript>>::Element *E = p_script->subclasses.front(); E; E = E->next()) {
+		_clear_class(E->get().ptr());
+	}
+	for (Map<StringName, GDScriptFunction *>::Element *E = p_script->member_functions.front(); E; E = E->next()) {
+		memdelete(E->get());
+	}
+	p_script->member_functions.clear();
+	p_script->initializer = nullptr;
+	p_script->implicit_initializer = nullptr;
+	p_script->native = Ref<GDScriptNativeClass>();
+	p_script->base = Ref<GDScript>();
+	p_script->_base = nullptr;
+	p_script->members.clear();
+	p_script->constants.clear();
+	p_script->member_indices.clear();
+	p_script->member_info.clear();
+	p_script->_signals.clear();
+	GDScriptLanguage::get_singleton()->invalidate_inline_caches();
+	p_script->subclasses.clear();
+	p_script->valid = false;
+}
+
+/* WRITER */
+
+class GDScriptBytecodeCache::Writer {
+	Map<Variant::ValidatedOperatorEvaluator, FunctionKey> operator_keys;
+	Map<Variant::ValidatedSetter, FunctionKey> setter_keys;
+	Map<Variant::ValidatedGetter, FunctionKey> getter_keys;
+	Map<Variant::ValidatedKeyedSetter, FunctionKey> keyed_setter_keys;
+	Map<Variant::ValidatedKeyedGetter, FunctionKey> keyed_getter_keys;
+	Map<Variant::ValidatedIndexedSetter, FunctionKey> indexed_setter_keys;
+	Map<Variant::ValidatedIndexedGetter, FunctionKey> indexed_getter_keys;
+	Map<Variant::ValidatedBuiltInMethod, FunctionKey> builtin_method_keys;
+	Map<Variant::ValidatedConstructor, FunctionKey> constructor_keys;
+	Map<Variant::ValidatedUtilityFunction, FunctionKey> utility_keys;
+	Map<GDScriptUtilityFunctions::FunctionPtr, FunctionKey> gds_utility_keys;
+
+	void _build_keys();
+
+	template <class T>
+	bool _put_functions(const Vector<T> &p_functions, const Map<T, FunctionKey> &p_keys, const char *p_kind) {
+		put_u32(p_functions.size());
+		for (int i = 0; i < p_functions.size(); i++) {
+			const typename Map<T, FunctionKey>::Element *E = p_keys.find(p_functions[i]);
+			if (!E) {
+				return fail(vformat("Unknown %s function.", p_kind));
+			}
+			put_u32(E->get().a);
+			put_u32(E->get().b);
+			put_u32(E->get().c);
+			put_string(E->get().name);
+		}
+		return true;
+	}
+
+public:
+	const GDScript *root = nullptr;
+	Vector<uint8_t> data;
+	String error;
+
+	bool fail(const String &p_error) {
+		if (error.is_empty()) {
+			error = p_error;
+		}
+		return false;
+	}
+
+	void put_data(const uint8_t *p_data, int p_size) {
+		int position = data.size();
+		data.resize(position + p_size);
+		memcpy(data.ptrw() + position, p_data, p_size);
+	}
+
+	void put_u8(uint8_t p_value) {
+		put_data(&p_value, 1);
+	}
+
+	void put_u32(uint32_t p_value) {
+		uint8_t buffer[4];
+		encode_uint32(p_value, buffer);
+		put_data(buffer, 4);
+	}
+
+	void put_string(const String &p_string) {
+		CharString utf8 = p_string.utf8();
+		put_u32(utf8.length());
+		put_data((const uint8_t *)utf8.get_data(), utf8.length());
+	}
+
+	bool put_reference(const Object *p_object);
+	bool put_constant(const Variant &p_constant);
+	bool put_data_type(const GDScriptDataType &p_type);
+	bool put_function(const GDScriptFunction *p_function);
+	void put_class_tree(const GDScript *p_script);
+	bool put_class(const GDScript *p_script);
+
+	Writer() {
+		_build_keys();
+	}
+};
+
+void GDScriptBytecodeCache::Writer::_build_keys() {
+	for (int op = 0; op < Variant::OP_MAX; op++) {
+		for (int type_a = 0; type_a < Variant::VARIANT_MAX; type_a++) {
+			for (int type_b = 0; type_b < Variant::VARIANT_MAX; type_b++) {
+				Variant::ValidatedOperatorEvaluator evaluator = Variant::get_validated_operator_evaluator(Variant::Operator(op), Variant::Type(type_a), Variant::Type(type_b));
+				if (evaluator && !operator_keys.has(evaluator)) {
+					operator_keys.insert(evaluator, _make_key(op, type_a, type_b));
+				}
+			}
+		}
+	}
+
+	for (int i = 0; i < Variant::VARIANT_MAX; i++) {
+		Variant::Type type = Variant::Type(i);
+
+		List<StringName> members;
+		Variant::get_member_list(type, &members);
+		for (const StringName &member : members) {
+			Variant::ValidatedSetter setter = Variant::get_member_validated_setter(type, member);
+			if (setter && !setter_keys.has(setter)) {
+				setter_keys.insert(setter, _make_key(type, 0, 0, member));
+			}
+			Variant::ValidatedGetter getter = Variant::get_member_validated_getter(type, member);
+			if (getter && !getter_keys.has(getter)) {
+				getter_keys.insert(getter, _make_key(type, 0, 0, member));
+			}
+		}
+
+		Variant::ValidatedKeyedSetter keyed_setter = Variant::get_member_validated_keyed_setter(type);
+		if (keyed_setter && !keyed_setter_keys.has(keyed_setter)) {
+			keyed_setter_keys.insert(keyed_setter, _make_key(type));
+		}
+		Variant::ValidatedKeyedGetter keyed_getter = Variant::get_member_validated_keyed_getter(type);
+		if (keyed_getter && !keyed_getter_keys.has(keyed_getter)) {
+			keyed_getter_keys.insert(keyed_getter, _make_key(type));
+		}
+		Variant::ValidatedIndexedSetter indexed_setter = Variant::get_member_validated_indexed_setter(type);
+		if (indexed_setter && !indexed_setter_keys.has(indexed_setter)) {
+			indexed_setter_keys.insert(indexed_setter, _make_key(type));
+		}
+		Variant::ValidatedIndexedGetter indexed_getter = Variant::get_member_validated_indexed_getter(type);
+		if (indexed_getter && !indexed_getter_keys.has(indexed_getter)) {
+			indexed_getter_keys.insert(indexed_getter, _make_key(type));
+		}
+
+		List<StringName> methods;
+		Variant::get_builtin_method_list(type, &methods);
+		for (const StringName &method : methods) {
+			Variant::ValidatedBuiltInMethod builtin_method = Variant::get_validated_builtin_method(type, method);
+			if (builtin_method && !builtin_method_keys.has(builtin_method)) {
+				builtin_method_keys.insert(builtin_method, _make_key(type, 0, 0, method));
+			}
+		}
+
+		for (int j = 0; j < Variant::get_constructor_count(type); j++) {
+			Variant::ValidatedConstructor constructor = Variant::get_validated_constructor(type, j);
+			if (constructor && !constructor_keys.has(constructor)) {
+				constructor_keys.insert(constructor, _make_key(type, j));
+			}
+		}
+	}
+
+	List<StringName> utilities;
+	Variant::get_utility_function_list(&utilities);
+	for (const StringName &utility_name : utilities) {
+		Variant::ValidatedUtilityFunction utility = Variant::get_validated_utility_function(utility_name);
+		if (utility && !utility_keys.has(utility)) {
+			utility_keys.insert(utility, _make_key(0, 0, 0, utility_name));
+		}
+	}
+
+	List<StringName> gds_utilities;
+	GDScriptUtilityFunctions::get_function_list(&gds_utilities);
+	for (const StringName &utility_name : gds_utilities) {
+		GDScriptUtilityFunctions::FunctionPtr utility = GDScriptUtilityFunctions::get_function(utility_name);
+		if (utility && !gds_utility_keys.has(utility)) {
+			gds_utility_keys.insert(utility, _make_key(0, 0, 0, utility_name));
+		}
+	}
+}
+
+bool GDScriptBytecodeCache::Writer::put_reference(const Object *p_object) {
+	if (!p_object) {
+		put_u8(REFERENCE_NULL);
+		return true;
+	}
+
+	const GDScript *script = Object::cast_to<GDScript>(p_object);
+	if (script) {
+		// Inner classes are stored as the path from their outermost class.
+		Vector<StringName> classes;
+		while (script->_owner) {
+			classes.push_back(script->name);
+			script = script->_owner;
+		}
+		if (script == root) {
+			put_u8(REFERENCE_LOCAL_CLASS);
+		} else {
+			if (!script->get_path().is_resource_file()) {
+				return fail("Uses a built-in script.");
+			}
+			put_u8(REFERENCE_SCRIPT_CLASS);
+			put_string(script->get_path());
+		}
+		put_u32(classes.size());
+		for (int i = classes.size() - 1; i >= 0; i--) {
+			put_string(classes[i]);
+		}
+		return true;
+	}
+
+	const GDScriptNativeClass *native_class = Object::cast_to<GDScriptNativeClass>(p_object);
+	if (native_class) {
+		put_u8(REFERENCE_NATIVE_CLASS);
+		put_string(native_class->get_name());
+		return true;
+	}
+
+	GDScriptLanguage *language = GDScriptLanguage::get_singleton();
+	for (const Map<StringName, int>::Element *E = language->get_global_map().front(); E; E = E->next()) {
+		if (language->get_global_array()[E->get()].get_validated_object() == p_object) {
+			put_u8(REFERENCE_GLOBAL);
+			put_string(E->key());
+			return true;
+		}
+	}
+
+	const Resource *resource = Object::cast_to<Resource>(p_object);
+	if (resource && resource->get_path().is_resource_file()) {
+		put_u8(REFERENCE_RESOURCE);
+		put_string(resource->get_path());
+		return true;
+	}
+
+	return fail(vformat("Uses an object of class '%s' as constant.", p_object->get_class()));
+}
+
+bool GDScriptBytecodeCache::Writer::put_constant(const Variant &p_constant) {
+	if (p_constant.get_type() == Variant::OBJECT) {
+		put_u8(CONSTANT_OBJECT);
+		return put_reference(p_constant.get_validated_object());
+	}
+
+	if (!_is_plain_value(p_constant)) {
+		return fail(vformat("Uses a constant of type '%s' which can't be stored.", Variant::get_type_name(p_constant.get_type())));
+	}
+
+	int length = 0;
+	Error err = encode_variant(p_constant, nullptr, length, false);
+	if (err) {
+		return fail("Can't encode a constant.");
+	}
+	put_u8(CONSTANT_VALUE);
+	int position = data.size();
+	data.resize(position + length);
+	encode_variant(p_constant, data.ptrw() + position, length, false);
+	return true;
+}
+
+bool GDScriptBytecodeCache::Writer::put_data_type(const GDScriptDataType &p_type) {
+	put_u8(p_type.has_type);
+	put_u8(p_type.kind);
+	put_u32(p_type.builtin_type);
+	put_string(p_type.native_type);
+	if (p_type.kind == GDScriptDataType::SCRIPT || p_type.kind == GDScriptDataType::GDSCRIPT) {
+		if (!put_reference(p_type.script_type)) {
+			return false;
+		}
+	}
+	put_u8(p_type.has_container_element_type());
+	if (p_type.has_container_element_type()) {
+		return put_data_type(p_type.get_container_element_type());
+	}
+	return true;
+}
+
+bool GDScriptBytecodeCache::Writer::put_function(const GDScriptFunction *p_function) {
+	put_string(p_function->name);
+	put_string(p_function->source);
+	put_u8(p_function->_static);
+	put_u32(p_function->_initial_line);
+
+	put_string(p_function->rpc_config.name);
+	put_u32(p_function->rpc_config.rpc_mode);
+	put_u8(p_function->rpc_config.sync);
+	put_u32(p_function->rpc_config.transfer_mode);
+	put_u32(p_function->rpc_config.channel);
+
+	if (!put_data_type(p_function->return_type)) {
+		return false;
+	}
+
+	put_u32(p_function->argument_types.size());
+	for (int i = 0; i < p_function->argument_types.size(); i++) {
+#ifdef TOOLS_ENABLED
+		put_string(p_function->arg_names[i]);
+#else
+		put_string(String());
+#endif
+		if (!put_data_type(p_function->argument_types[i])) {
+			return false;
+		}
+	}
+
+	put_u32(p_function->default_arguments.size());
+	for (int i = 0; i < p_function->default_arguments.size(); i++) {
+		put_u32(p_function->default_arguments[i]);
+	}
+
+	put_u32(p_function->_stack_size);
+	put_u32(p_function->_instruction_args_size);
+	put_u32(p_function->_ptrcall_args_size);
+	put_u32(p_function->inline_caches.size());
+
+	put_u32(p_function->temporary_slots.size());
+	for (const Map<int, Variant::Type>::Element *E = p_function->temporary_slots.front(); E; E = E->next()) {
+		put_u32(E->key());
+		put_u32(E->get());
+	}
+
+	put_u32(p_function->code.size());
+	for (int i = 0; i < p_function->code.size(); i++) {
+		put_u32(p_function->code[i]);
+	}
+
+	put_u32(p_function->constants.size());
+	for (int i = 0; i < p_function->constants.size(); i++) {
+		if (!put_constant(p_function->constants[i])) {
+			return false;
+		}
+	}
+
+	put_u32(p_function->global_names.size());
+	for (int i = 0; i < p_function->global_names.size(); i++) {
+		// The editor looks up autoloads by name, while exported projects have
+		// them as global constants instead.
+		if (GDScriptLanguage::get_singleton()->get_named_globals_map().has(p_function->global_names[i])) {
+			return fail(vformat("Uses the named global '%s'.", p_function->global_names[i]));
+		}
+		put_string(p_function->global_names[i]);
+	}
+
+	if (!_put_functions(p_function->operator_funcs, operator_keys, "operator") ||
+			!_put_functions(p_function->setters, setter_keys, "setter") ||
+			!_put_functions(p_function->getters, getter_keys, "getter") ||
+			!_put_functions(p_function->keyed_setters, keyed_setter_keys, "keyed setter") ||
+			!_put_functions(p_function->keyed_getters, keyed_getter_keys, "keyed getter") ||
+			!_put_functions(p_function->indexed_setters, indexed_setter_keys, "indexed setter") ||
+			!_put_functions(p_function->indexed_getters, indexed_getter_keys, "indexed getter") ||
+			!_put_functions(p_function->builtin_methods, builtin_method_keys, "built-in method") ||
+			!_put_functions(p_function->constructors, constructor_keys, "constructor") ||
+			!_put_functions(p_function->utilities, utility_keys, "utility") ||
+			!_put_functions(p_function->gds_utilities, gds_utility_keys, "GDScript utility")) {
+		return false;
+	}
+
+	put_u32(p_function->methods.size());
+	for (int i = 0; i < p_function->methods.size(); i++) {
+		put_string(p_function->methods[i]->get_instance_class());
+		put_string(p_function->methods[i]->get_name());
+	}
+
+	put_u32(p_function->lambdas.size());
+	for (int i = 0; i < p_function->lambdas.size(); i++) {
+		if (!put_function(p_function->lambdas[i])) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void GDScriptBytecodeCache::Writer::put_class_tree(const GDScript *p_script) {
+	put_u32(p_script->subclasses.size());
+	for (const Map<StringName, Ref<GDScript>>::Element *E = p_script->subclasses.front(); E; E = E->next()) {
+		put_string(E->key());
+		put_class_tree(E->get().ptr());
+	}
+}
+
+bool GDScriptBytecodeCache::Writer::put_class(const GDScript *p_script) {
+	if (!p_script->valid) {
+		return fail("The script is not compiled.");
+	}
+
+	put_u8(p_script->tool);
+	put_string(p_script->name);
+	if (!put_reference(p_script->native.ptr()) || !put_reference(p_script->base.ptr())) {
+		return false;
+	}
+
+	put_u32(p_script->member_indices.size());
+	for (const Map<StringName, GDScript::MemberInfo>::Element *E = p_script->member_indices.front(); E; E = E->next()) {
+		put_string(E->key());
+		put_u32(E->get().index);
+		put_string(E->get().setter);
+		put_string(E->get().getter);
+		if (!put_data_type(E->get().data_type)) {
+			return false;
+		}
+	}
+
+	put_u32(p_script->members.size());
+	for (const Set<StringName>::Element *E = p_script->members.front(); E; E = E->next()) {
+		put_string(E->get());
+	}
+
+	put_u32(p_script->member_info.size());
+	for (const Map<StringName, PropertyInfo>::Element *E = p_script->member_info.front(); E; E = E->next()) {
+		put_string(E->key());
+		put_u32(E->get().type);
+		put_string(E->get().name);
+		put_string(E->get().class_name);
+		put_u32(E->get().hint);
+		put_string(E->get().hint_string);
+		put_u32(E->get().usage);
+	}
+
+	put_u32(p_script->_signals.size());
+	for (const Map<StringName, Vector<StringName>>::Element *E = p_script->_signals.front(); E; E = E->next()) {
+		put_string(E->key());
+		put_u32(E->get().size());
+		for (int i = 0; i < E->get().size(); i++) {
+			put_string(E->get()[i]);
+		}
+	}
+
+	put_u32(p_script->constants.size());
+	for (const Map<StringName, Variant>::Element *E = p_script->constants.front(); E; E = E->next()) {
+		put_string(E->key());
+		if (!put_constant(E->get())) {
+			return false;
+		}
+	}
+
+	put_u32(p_script->member_functions.size());
+	for (const Map<StringName, GDScriptFunction *>::Element *E = p_script->member_functions.front(); E; E = E->next()) {
+		put_string(E->key());
+		if (!put_function(E->get())) {
+			return false;
+		}
+	}
+
+	for (const Map<StringName, Ref<GDScript>>::Element *E = p_script->subclasses.front(); E; E = E->next()) {
+		if (!put_class(E->get().ptr())) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* READER */
+
+static Variant::ValidatedOperatorEvaluator _resolve_operator(const FunctionKey &p_key) {
+	if (p_key.a >= Variant::OP_MAX || p_key.b >= Variant::VARIANT_MAX || p_key.c >= Variant::VARIANT_MAX) {
+		return nullptr;
+	}
+	return Variant::get_validated_operator_evaluator(Variant::Operator(p_key.a), Variant::Type(p_key.b), Variant::Type(p_key.c));
+}
+
+static Variant::ValidatedSetter _resolve_setter(const FunctionKey &p_key) {
+	return p_key.a < Variant::VARIANT_MAX ? Variant::get_member_validated_setter(Variant::Type(p_key.a), p_key.name) : nullptr;
+}
+
+static Variant::ValidatedGetter _resolve_getter(const FunctionKey &p_key) {
+	return p_key.a < Variant::VARIANT_MAX ? Variant::get_member_validated_getter(Variant::Type(p_key.a), p_key.name) : nullptr;
+}
+
+static Variant::ValidatedKeyedSetter _resolve_keyed_setter(const FunctionKey &p_key) {
+	return p_key.a < Variant::VARIANT_MAX ? Variant::get_member_validated_keyed_setter(Variant::Type(p_key.a)) : nullptr;
+}
+
+static Variant::ValidatedKeyedGetter _resolve_keyed_getter(const FunctionKey &p_key) {
+	return p_key.a < Variant::VARIANT_MAX ? Variant::get_member_validated_keyed_getter(Variant::Type(p_key.a)) : nullptr;
+}
+
+static Variant::ValidatedIndexedSetter _resolve_indexed_setter(const FunctionKey &p_key) {
+	return p_key.a < Variant::VARIANT_MAX ? Variant::get_member_validated_indexed_setter(Variant::Type(p_key.a)) : nullptr;
+}
+
+static Variant::ValidatedIndexedGetter _resolve_indexed_getter(const FunctionKey &p_key) {
+	return p_key.a < Variant::VARIANT_MAX ? Variant::get_member_validated_indexed_getter(Variant::Type(p_key.a)) : nullptr;
+}
+
+static Variant::ValidatedBuiltInMethod _resolve_builtin_method(const FunctionKey &p_key) {
+	return p_key.a < Variant::VARIANT_MAX ? Variant::get_validated_builtin_method(Variant::Type(p_key.a), p_key.name) : nullptr;
+}
+
+static Variant::ValidatedConstructor _resolve_constructor(const FunctionKey &p_key) {
+	if (p_key.a >= Variant::VARIANT_MAX || int(p_key.b) >= Variant::get_constructor_count(Variant::Type(p_key.a))) {
+		return nullptr;
+	}
+	return Variant::get_validated_constructor(Variant::Type(p_key.a), p_key.b);
+}
+
+static Variant::ValidatedUtilityFunction _resolve_utility(const FunctionKey &p_key) {
+	return Variant::get_validated_utility_function(p_key.name);
+}
+
+static GDScriptUtilityFunctions::FunctionPtr _resolve_gds_utility(const FunctionKey &p_key) {
+	return GDScriptUtilityFunctions::get_function(p_key.name);
+}
+
+class GDScriptBytecodeCache::Reader {
+	const uint8_t *data = nullptr;
+	int length = 0;
+	int position = 0;
+
+	template <class T>
+	bool _get_functions(Vector<T> &r_functions, T (*p_resolve)(const FunctionKey &)) {
+		uint32_t count = get_count();
+		r_functions.resize(count);
+		for (uint32_t i = 0; i < count; i++) {
+			FunctionKey key;
+			key.a = get_u32();
+			key.b = get_u32();
+			key.c = get_u32();
+			key.name = get_string();
+			if (error) {
+				return false;
+			}
+			r_functions.write[i] = p_resolve(key);
+			if (!r_functions[i]) {
+				return fail(ERR_INVALID_DATA);
+			}
+		}
+		return error == OK;
+	}
+
+	bool _get_function(GDScriptFunction *p_function, GDScript *p_script);
+	bool _is_valid_address(const GDScriptFunction *p_function, int p_address, int p_member_count) const;
+	bool _validate_code(const GDScriptFunction *p_function, int p_member_count) const;
+
+public:
+	GDScript *root = nullptr;
+	Error error = OK;
+
+	bool fail(Error p_error) {
+		if (error == OK) {
+			error = p_error;
+		}
+		return false;
+	}
+
+	bool is_at_end() const {
+		return position == length;
+	}
+
+	bool get_data(uint8_t *r_data, int p_size) {
+		if (p_size < 0 || p_size > length - position) {
+			return fail(ERR_FILE_CORRUPT);
+		}
+		memcpy(r_data, data + position, p_size);
+		position += p_size;
+		return true;
+	}
+
+	uint8_t get_u8() {
+		uint8_t value = 0;
+		get_data(&value, 1);
+		return value;
+	}
+
+	uint32_t get_u32() {
+		uint8_t buffer[4] = {};
+		get_data(buffer, 4);
+		return decode_uint32(buffer);
+	}
+
+	// Element counts, checked against the remaining data so a corrupted count
+	// doesn't make us allocate huge buffers.
+	uint32_t get_count() {
+		uint32_t count = get_u32();
+		if (count > uint32_t(length - position)) {
+			fail(ERR_FILE_CORRUPT);
+			return 0;
+		}
+		return count;
+	}
+
+	String get_string() {
+		uint32_t size = get_count();
+		String string;
+		if (size > 0 && error == OK) {
+			string.parse_utf8((const char *)data + position, size);
+			position += size;
+		}
+		return string;
+	}
+
+	bool get_reference(Variant &r_object, bool p_full_script);
+	bool get_constant(Variant &r_constant);
+	bool get_data_type(GDScriptDataType &r_type, GDScript *p_owner);
+	GDScriptFunction *get_function(GDScript *p_script);
+	bool get_class_tree(GDScript *p_script);
+	bool get_class(GDScript *p_script);
+
+	Reader(const Vector<uint8_t> &p_data) {
+		data = p_data.ptr();
+		length = p_data.size();
+	}
+};
+
+bool GDScriptBytecodeCache::Reader::get_reference(Variant &r_object, bool p_full_script) {
+	uint8_t kind = get_u8();
+	if (error) {
+		return false;
+	}
+
+	switch (kind) {
+		case REFERENCE_NULL: {
+			r_object = Variant((Object *)nullptr);
+		} break;
+		case REFERENCE_LOCAL_CLASS:
+		case REFERENCE_SCRIPT_CLASS: {
+			String path;
+			if (kind == REFERENCE_SCRIPT_CLASS) {
+				path = get_string();
+				if (error || !path.is_resource_file()) {
+					return fail(ERR_FILE_CORRUPT);
+				}
+			}
+			uint32_t class_count = get_count();
+			if (error) {
+				return false;
+			}
+
+			Ref<GDScript> script;
+			if (kind == REFERENCE_LOCAL_CLASS) {
+				script = Ref<GDScript>(root);
+			} else if (p_full_script || class_count > 0) {
+				// Inner classes only exist once the script is compiled.
+				Error err = OK;
+				script = ResourceFormatLoaderGDScript::load_script(path, err, root->path);
+				if (err) {
+					return fail(ERR_FILE_MISSING_DEPENDENCIES);
+				}
+			} else {
+				// Like the compiler, the script is compiled later by `GDScriptCache::finish_compiling()`.
+				script = GDScriptCache::get_shallow_script(path, root->path);
+			}
+			if (script.is_null()) {
+				return fail(ERR_FILE_MISSING_DEPENDENCIES);
+			}
+
+			for (uint32_t i = 0; i < class_count; i++) {
+				StringName name = get_string();
+				const Map<StringName, Ref<GDScript>>::Element *E = script->subclasses.find(name);
+				if (error || !E) {
+					return fail(ERR_INVALID_DATA);
+				}
+				script = E->get();
+			}
+			r_object = script;
+		} break;
+		case REFERENCE_RESOURCE: {
+			String path = get_string();
+			if (error || !path.is_resource_file()) {
+				return fail(ERR_FILE_CORRUPT);
+			}
+			RES resource = ResourceLoader::load(path);
+			if (resource.is_null()) {
+				return fail(ERR_FILE_MISSING_DEPENDENCIES);
+			}
+			r_object = resource;
+		} break;
+		case REFERENCE_NATIVE_CLASS:
+		case REFERENCE_GLOBAL: {
+			StringName name = get_string();
+			GDScriptLanguage *language = GDScriptLanguage::get_singleton();
+			const Map<StringName, int>::Element *E = language->get_global_map().find(name);
+			if (error || !E) {
+				return fail(ERR_INVALID_DATA);
+			}
+			r_object = language->get_global_array()[E->get()];
+			if (kind == REFERENCE_NATIVE_CLASS && !Object::cast_to<GDScriptNativeClass>(r_object.get_validated_object())) {
+				return fail(ERR_INVALID_DATA);
+			}
+		} break;
+		default: {
+			return fail(ERR_FILE_CORRUPT);
+		} break;
+	}
+
+	return true;
+}
+
+bool GDScriptBytecodeCache::Reader::get_constant(Variant &r_constant) {
+	uint8_t kind = get_u8();
+	if (error) {
+		return false;
+	}
+
+	if (kind == CONSTANT_OBJECT) {
+		return get_reference(r_constant, false);
+	} else if (kind != CONSTANT_VALUE) {
+		return fail(ERR_FILE_CORRUPT);
+	}
+
+	int size = 0;
+	Error err = decode_variant(r_constant, data + position, length - position, &size, false);
+	if (err) {
+		return fail(ERR_FILE_CORRUPT);
+	}
+	position += size;
+	return true;
+}
+
+bool GDScriptBytecodeCache::Reader::get_data_type(GDScriptDataType &r_type, GDScript *p_owner) {
+	r_type.has_type = get_u8();
+	uint8_t kind = get_u8();
+	uint32_t builtin_type = get_u32();
+	r_type.native_type = get_string();
+	if (error || kind > GDScriptDataType::GDSCRIPT || builtin_type >= Variant::VARIANT_MAX) {
+		return fail(ERR_FILE_CORRUPT);
+	}
+	r_type.kind = GDScriptDataType::Kind(kind);
+	r_type.builtin_type = Variant::Type(builtin_type);
+
+	if (r_type.kind == GDScriptDataType::SCRIPT || r_type.kind == GDScriptDataType::GDSCRIPT) {
+		Variant script;
+		if (!get_reference(script, false)) {
+			return false;
+		}
+		r_type.script_type_ref = Ref<Script>(script);
+		r_type.script_type = r_type.script_type_ref.ptr();
+		// Same as the compiler, to avoid cyclic references.
+		if (r_type.script_type == p_owner) {
+			r_type.script_type_ref = Ref<Script>();
+		}
+	}
+
+	if (get_u8()) {
+		GDScriptDataType element_type;
+		if (!get_data_type(element_type, p_owner)) {
+			return false;
+		}
+		r_type.set_container_element_type(element_type);
+	}
+
+	return error == OK;
+}
+
+GDScriptFunction *GDScriptBytecodeCache::Reader::get_function(GDScript *p_script) {
+	GDScriptFunction *function = memnew(GDScriptFunction);
+	if (!_get_function(function, p_script)) {
+		memdelete(function);
+		return nullptr;
+	}
+	return function;
+}
+
+bool GDScriptBytecodeCache::Reader::_get_function(GDScriptFunction *p_function, GDScript *p_script) {
+	p_function->name = get_string();
+	p_function->source = get_string();
+	p_function->_script = p_script;
+#ifdef DEBUG_ENABLED
+	p_function->func_cname = (String(p_function->source) + " - " + String(p_function->name)).utf8();
+	p_function->_func_cname = p_function->func_cname.get_data();
+#endif
+	p_function->_static = get_u8();
+	p_function->_initial_line = get_u32();
+
+	p_function->rpc_config.name = get_string();
+	p_function->rpc_config.rpc_mode = MultiplayerAPI::RPCMode(get_u32());
+	p_function->rpc_config.sync = get_u8();
+	p_function->rpc_config.transfer_mode = MultiplayerPeer::TransferMode(get_u32());
+	p_function->rpc_config.channel = get_u32();
+
+	if (!get_data_type(p_function->return_type, p_script)) {
+		return false;
+	}
+
+	uint32_t argument_count = get_count();
+	for (uint32_t i = 0; i < argument_count; i++) {
+		StringName argument_name = get_string();
+#ifdef TOOLS_ENABLED
+		p_function->arg_names.push_back(argument_name);
+#endif
+		GDScriptDataType argument_type;
+		if (!get_data_type(argument_type, p_script)) {
+			return false;
+		}
+		p_function->argument_types.push_back(argument_type);
+	}
+	p_function->_argument_count = argument_count;
+
+	uint32_t default_argument_count = get_count();
+	p_function->default_arguments.resize(default_argument_count);
+	for (uint32_t i = 0; i < default_argument_count; i++) {
+		p_function->default_arguments.write[i] = get_u32();
+	}
+
+	p_function->_stack_size = get_u32();
+	p_function->_instruction_args_size = get_u32();
+	p_function->_ptrcall_args_size = get_u32();
+	p_function->inline_caches.resize(get_count());
+
+	uint32_t temporary_count = get_count();
+	for (uint32_t i = 0; i < temporary_count; i++) {
+		int slot = get_u32();
+		uint32_t type = get_u32();
+		if (type >= Variant::VARIANT_MAX) {
+			return fail(ERR_FILE_CORRUPT);
+		}
+		p_function->temporary_slots[slot] = Variant::Type(type);
+	}
+
+	uint32_t code_size = get_count();
+	p_function->code.resize(code_size);
+	for (uint32_t i = 0; i < code_size; i++) {
+		p_function->code.write[i] = get_u32();
+	}
+
+	uint32_t constant_count = get_count();
+	p_function->constants.resize(constant_count);
+	for (uint32_t i = 0; i < constant_count; i++) {
+		if (!get_constant(p_function->constants.write[i])) {
+			return false;
+		}
+	}
+
+	uint32_t global_name_count = get_count();
+	p_function->global_names.resize(global_name_count);
+	for (uint32_t i = 0; i < global_name_count; i++) {
+		p_function->global_names.write[i] = get_string();
+	}
+
+	if (!_get_functions(p_function->operator_funcs, _resolve_operator) ||
+			!_get_functions(p_function->setters, _resolve_setter) ||
+			!_get_functions(p_function->getters, _resolve_getter) ||
+			!_get_functions(p_function->keyed_setters, _resolve_keyed_setter) ||
+			!_get_functions(p_function->keyed_getters, _resolve_keyed_getter) ||
+			!_get_functions(p_function->indexed_setters, _resolve_indexed_setter) ||
+			!_get_functions(p_function->indexed_getters, _resolve_indexed_getter) ||
+			!_get_functions(p_function->builtin_methods, _resolve_builtin_method) ||
+			!_get_functions(p_function->constructors, _resolve_constructor) ||
+			!_get_functions(p_function->utilities, _resolve_utility) ||
+			!_get_functions(p_function->gds_utilities, _resolve_gds_utility)) {
+		return false;
+	}
+
+	uint32_t method_count = get_count();
+	p_function->methods.resize(method_count);
+	for (uint32_t i = 0; i < method_count; i++) {
+		StringName class_name = get_string();
+		StringName method_name = get_string();
+		MethodBind *method = error ? nullptr : ClassDB::get_method(class_name, method_name);
+		if (!method) {
+			return fail(ERR_INVALID_DATA);
+		}
+		p_function->methods.write[i] = method;
+	}
+
+	uint32_t lambda_count = get_count();
+	for (uint32_t i = 0; i < lambda_count; i++) {
+		GDScriptFunction *lambda = get_function(p_script);
+		if (!lambda) {
+			return false;
+		}
+		p_function->lambdas.push_back(lambda);
+	}
+
+	if (error) {
+		return false;
+	}
+	// Static functions have no instance, so no members.
+	if (!_validate_code(p_function, p_function->_static ? 0 : p_script->member_indices.size())) {
+		return fail(ERR_FILE_CORRUPT);
+	}
+
+	// Same as `GDScriptByteCodeGenerator::write_end()`.
+	p_function->_constant_count = p_function->constants.size();
+	p_function->_constants_ptr = p_function->constants.ptrw();
+	p_function->_global_names_count = p_function->global_names.size();
+	p_function->_global_names_ptr = p_function->global_names.ptr();
+	p_function->_code_size = p_function->code.size();
+	p_function->_code_ptr = p_function->code.ptr();
+	p_function->_default_arg_count = p_function->default_arguments.is_empty() ? 0 : p_function->default_arguments.size() - 1;
+	p_function->_default_arg_ptr = p_function->default_arguments.ptr();
+	p_function->_operator_funcs_count = p_function->operator_funcs.size();
+	p_function->_operator_funcs_ptr = p_function->operator_funcs.ptr();
+	p_function->_setters_count = p_function->setters.size();
+	p_function->_setters_ptr = p_function->setters.ptr();
+	p_function->_getters_count = p_function->getters.size();
+	p_function->_getters_ptr = p_function->getters.ptr();
+	p_function->_keyed_setters_count = p_function->keyed_setters.size();
+	p_function->_keyed_setters_ptr = p_function->keyed_setters.ptr();
+	p_function->_keyed_getters_count = p_function->keyed_getters.size();
+	p_function->_keyed_getters_ptr = p_function->keyed_getters.ptr();
+	p_function->_indexed_setters_count = p_function->indexed_setters.size();
+	p_function->_indexed_setters_ptr = p_function->indexed_setters.ptr();
+	p_function->_indexed_getters_count = p_function->indexed_getters.size();
+	p_function->_indexed_getters_ptr = p_function->indexed_getters.ptr();
+	p_function->_builtin_methods_count = p_function->builtin_methods.size();
+	p_function->_builtin_methods_ptr = p_function->builtin_methods.ptr();
+	p_function->_constructors_count = p_function->constructors.size();
+	p_function->_constructors_ptr = p_function->constructors.ptr();
+	p_function->_utilities_count = p_function->utilities.size();
+	p_function->_utilities_ptr = p_function->utilities.ptr();
+	p_function->_gds_utilities_count = p_function->gds_utilities.size();
+	p_function->_gds_utilities_ptr = p_function->gds_utilities.ptr();
+	p_function->_methods_count = p_function->methods.size();
+	p_function->_methods_ptr = p_function->methods.ptrw();
+	p_function->_lambdas_count = p_function->lambdas.size();
+	p_function->_lambdas_ptr = p_function->lambdas.ptrw();
+
+	if (GDScriptJIT::is_enabled()) {
+		GDScriptJIT::compile(p_function);
+	}
+
+	return true;
+}
+
+bool GDScriptBytecodeCache::Reader::_is_valid_address(const GDScriptFunction *p_function, int p_address, int p_member_count) const {
+	int index = p_address & GDScriptFunction::ADDR_MASK;
+	switch (uint32_t(p_address) >> GDScriptFunction::ADDR_BITS) {
+		case GDScriptFunction::ADDR_TYPE_STACK:
+			return index < p_function->_stack_size;
+		case GDScriptFunction::ADDR_TYPE_CONSTANT:
+			return index < p_function->constants.size();
+		case GDScriptFunction::ADDR_TYPE_MEMBER:
+			return index < p_member_count;
+	}
+	return false;
+}
+
+// The VM trusts the code it runs, release builds don't check any index. Check
+// that every instruction and its operands are in bounds before running it, and
+// that the jumps land on instructions.
+bool GDScriptBytecodeCache::Reader::_validate_code(const GDScriptFunction *p_function, int p_member_count) const {
+	const int *code = p_function->code.ptr();
+	const int code_size = p_function->code.size();
+
+	// Self, class and nil, then the arguments.
+	if (p_function->_stack_size < GDScriptFunction::ADDR_STACK_NIL + 1 + p_function->_argument_count || p_function->_stack_size > GDScriptFunction::ADDR_MASK) {
+		return false;
+	}
+	if (p_function->_instruction_args_size < 0 || p_function->_ptrcall_args_size < 0 || p_function->default_arguments.size() > p_function->_argument_count + 1) {
+		return false;
+	}
+	for (const Map<int, Variant::Type>::Element *E = p_function->temporary_slots.front(); E; E = E->next()) {
+		if (E->key() <= GDScriptFunction::ADDR_STACK_NIL || E->key() >= p_function->_stack_size) {
+			return false;
+		}
+	}
+	LocalVector<bool> instruction_starts;
+	instruction_starts.resize(code_size);
+	for (int i = 0; i < code_size; i++) {
+		instruction_starts[i] = false;
+	}
+	LocalVector<int> jump_targets;
+	for (int i = 0; i < p_function->default_arguments.size(); i++) {
+		jump_targets.push_back(p_function->default_arguments[i]);
+	}
+
+	int ip = 0;
+	int opcode = -1;
+	while (ip < code_size) {
+		instruction_starts[ip] = true;
+		opcode = code[ip] & GDScriptFunction::INSTR_MASK;
+		const int instr_arg_count = (code[ip] & GDScriptFunction::INSTR_ARGS_MASK) >> GDScriptFunction::INSTR_BITS;
+		if (instr_arg_count < 0 || instr_arg_count > p_function->_instruction_args_size || instr_arg_count >= code_size - ip) {
+			return false;
+		}
+		for (int i = 0; i < instr_arg_count; i++) {
+			if (!_is_valid_address(p_function, code[ip + 1 + i], p_member_count)) {
+				return false;
+			}
+		}
+
+		// The operands follow the addresses. The VM reads those of the fixed size
+		// instructions at fixed offsets, so their address count must match.
+		int fixed_arg_count = -1;
+		int operand_length = 0;
+		const int *operands = &code[ip + 1 + instr_arg_count];
+		const int operand_count = code_size - (ip + 1 + instr_arg_count);
+
+#define OPERANDS(m_count)                 \
+	operand_length = (m_count);           \
+	if (operand_count < operand_length) { \
+		return false;                     \
+	}
+#define CHECK_INDEX(m_index, m_size)                 \
+	if ((m_index) < 0 || (m_index) >= int(m_size)) { \
+		return false;                                \
+	}
+
+		switch (opcode) {
+			case GDScriptFunction::OPCODE_OPERATOR: {
+				fixed_arg_count = 3;
+				OPERANDS(1);
+				CHECK_INDEX(operands[0], Variant::OP_MAX);
+			} break;
+			case GDScriptFunction::OPCODE_OPERATOR_VALIDATED: {
+				fixed_arg_count = 3;
+				OPERANDS(1);
+				CHECK_INDEX(operands[0], p_function->operator_funcs.size());
+			} break;
+			case GDScriptFunction::OPCODE_OPERATOR_VALIDATED_JUMP_IF_NOT: {
+				fixed_arg_count = 3;
+				OPERANDS(2);
+				CHECK_INDEX(operands[0], p_function->operator_funcs.size());
+				jump_targets.push_back(operands[1]);
+			} break;
+			case GDScriptFunction::OPCODE_IS_BUILTIN:
+			case GDScriptFunction::OPCODE_ASSIGN_TYPED_BUILTIN:
+			case GDScriptFunction::OPCODE_CAST_TO_BUILTIN: {
+				fixed_arg_count = 2;
+				OPERANDS(1);
+				CHECK_INDEX(operands[0], Variant::VARIANT_MAX);
+			} break;
+			case GDScriptFunction::OPCODE_EXTENDS_TEST:
+			case GDScriptFunction::OPCODE_SET_KEYED:
+			case GDScriptFunction::OPCODE_GET_KEYED:
+			case GDScriptFunction::OPCODE_ASSIGN_TYPED_NATIVE:
+			case GDScriptFunction::OPCODE_ASSIGN_TYPED_SCRIPT:
+			case GDScriptFunction::OPCODE_CAST_TO_NATIVE:
+			case GDScriptFunction::OPCODE_CAST_TO_SCRIPT: {
+				fixed_arg_count = 3;
+			} break;
+			case GDScriptFunction::OPCODE_SET_KEYED_VALIDATED: {
+				fixed_arg_count = 3;
+				OPERANDS(1);
+				CHECK_INDEX(operands[0], p_function->keyed_setters.size());
+			} break;
+			case GDScriptFunction::OPCODE_GET_KEYED_VALIDATED: {
+				fixed_arg_count = 3;
+				OPERANDS(1);
+				CHECK_INDEX(operands[0], p_function->keyed_getters.size());
+			} break;
+			case GDScriptFunction::OPCODE_SET_INDEXED_VALIDATED: {
+				fixed_arg_count = 3;
+				OPERANDS(1);
+				CHECK_INDEX(operands[0], p_function->indexed_setters.size());
+			} break;
+			case GDScriptFunction::OPCODE_GET_INDEXED_VALIDATED: {
+				fixed_arg_count = 3;
+				OPERANDS(1);
+				CHECK_INDEX(operands[0], p_function->indexed_getters.size());
+			} break;
+			case GDScriptFunction::OPCODE_SET_NAMED:
+			case GDScriptFunction::OPCODE_GET_NAMED: {
+				fixed_arg_count = 2;
+				OPERANDS(2);
+				CHECK_INDEX(operands[0], p_function->global_names.size());
+				CHECK_INDEX(operands[1], p_function->inline_caches.size());
+			} break;
+			case GDScriptFunction::OPCODE_SET_NAMED_VALIDATED: {
+				fixed_arg_count = 2;
+				OPERANDS(1);
+				CHECK_INDEX(operands[0], p_function->setters.size());
+			} break;
+			case GDScriptFunction::OPCODE_GET_NAMED_VALIDATED: {
+				fixed_arg_count = 2;
+				OPERANDS(1);
+				CHECK_INDEX(operands[0], p_function->getters.size());
+			} break;
+			case GDScriptFunction::OPCODE_SET_MEMBER:
+			case GDScriptFunction::OPCODE_GET_MEMBER:
+			case GDScriptFunction::OPCODE_STORE_NAMED_GLOBAL: {
+				fixed_arg_count = 1;
+				OPERANDS(1);
+				CHECK_INDEX(operands[0], p_function->global_names.size());
+			} break;
+			case GDScriptFunction::OPCODE_ASSIGN:
+			case GDScriptFunction::OPCODE_ASSIGN_TYPED_ARRAY:
+			case GDScriptFunction::OPCODE_ASSERT: {
+				fixed_arg_count = 2;
+			} break;
+			case GDScriptFunction::OPCODE_ASSIGN_TRUE:
+			case GDScriptFunction::OPCODE_ASSIGN_FALSE:
+			case GDScriptFunction::OPCODE_AWAIT_RESUME:
+			case GDScriptFunction::OPCODE_RETURN: {
+				fixed_arg_count = 1;
+			} break;
+			case GDScriptFunction::OPCODE_AWAIT: {
+				// Resumed at the next instruction, which gets the result.
+				fixed_arg_count = 1;
+				if (operand_count < 1 || (operands[0] & GDScriptFunction::INSTR_MASK) != GDScriptFunction::OPCODE_AWAIT_RESUME) {
+					return false;
+				}
+			} break;
+			case GDScriptFunction::OPCODE_CONSTRUCT: {
+				OPERANDS(2);
+				if (operands[0] + 1 != instr_arg_count) {
+					return false;
+				}
+				CHECK_INDEX(operands[1], Variant::VARIANT_MAX);
+			} break;
+			case GDScriptFunction::OPCODE_CONSTRUCT_VALIDATED: {
+				OPERANDS(2);
+				if (operands[0] + 1 != instr_arg_count) {
+					return false;
+				}
+				CHECK_INDEX(operands[1], p_function->constructors.size());
+			} break;
+			case GDScriptFunction::OPCODE_CONSTRUCT_ARRAY: {
+				OPERANDS(1);
+				if (operands[0] + 1 != instr_arg_count) {
+					return false;
+				}
+			} break;
+			case GDScriptFunction::OPCODE_CONSTRUCT_TYPED_ARRAY: {
+				OPERANDS(3);
+				if (operands[0] + 2 != instr_arg_count) {
+					return false;
+				}
+				CHECK_INDEX(operands[1], Variant::VARIANT_MAX);
+				CHECK_INDEX(operands[2], p_function->global_names.size());
+			} break;
+			case GDScriptFunction::OPCODE_CONSTRUCT_DICTIONARY: {
+				OPERANDS(1);
+				if (operands[0] < 0 || operands[0] * 2 + 1 != instr_arg_count) {
+					return false;
+				}
+			} break;
+			case GDScriptFunction::OPCODE_CALL:
+			case GDScriptFunction::OPCODE_CALL_RETURN:
+			case GDScriptFunction::OPCODE_CALL_ASYNC: {
+				OPERANDS(3);
+				if (operands[0] + (opcode == GDScriptFunction::OPCODE_CALL ? 1 : 2) != instr_arg_count) {
+					return false;
+				}
+				CHECK_INDEX(operands[1], p_function->global_names.size());
+				CHECK_INDEX(operands[2], p_function->inline_caches.size());
+			} break;
+			case GDScriptFunction::OPCODE_CALL_METHOD_BIND:
+			case GDScriptFunction::OPCODE_CALL_METHOD_BIND_RET: {
+				OPERANDS(2);
+				if (operands[0] + (opcode == GDScriptFunction::OPCODE_CALL_METHOD_BIND ? 1 : 2) != instr_arg_count) {
+					return false;
+				}
+				CHECK_INDEX(operands[1], p_function->methods.size());
+			} break;
+			case GDScriptFunction::OPCODE_CALL_BUILTIN_STATIC: {
+				OPERANDS(3);
+				CHECK_INDEX(operands[0], Variant::VARIANT_MAX);
+				CHECK_INDEX(operands[1], p_function->global_names.size());
+				if (operands[2] + 1 != instr_arg_count) {
+					return false;
+				}
+			} break;
+			case GDScriptFunction::OPCODE_CALL_BUILTIN_TYPE_VALIDATED: {
+				OPERANDS(2);
+				if (operands[0] + 2 != instr_arg_count) {
+					return false;
+				}
+				CHECK_INDEX(operands[1], p_function->builtin_methods.size());
+			} break;
+			case GDScriptFunction::OPCODE_CALL_UTILITY:
+			case GDScriptFunction::OPCODE_CALL_SELF_BASE: {
+				OPERANDS(2);
+				if (operands[0] + 1 != instr_arg_count) {
+					return false;
+				}
+				CHECK_INDEX(operands[1], p_function->global_names.size());
+			} break;
+			case GDScriptFunction::OPCODE_CALL_UTILITY_VALIDATED: {
+				OPERANDS(2);
+				if (operands[0] + 1 != instr_arg_count) {
+					return false;
+				}
+				CHECK_INDEX(operands[1], p_function->utilities.size());
+			} break;
+			case GDScriptFunction::OPCODE_CALL_GDSCRIPT_UTILITY: {
+				OPERANDS(2);
+				if (operands[0] + 1 != instr_arg_count) {
+					return false;
+				}
+				CHECK_INDEX(operands[1], p_function->gds_utilities.size());
+			} break;
+			case GDScriptFunction::OPCODE_CREATE_LAMBDA: {
+				OPERANDS(2);
+				if (operands[0] + 1 != instr_arg_count) {
+					return false;
+				}
+				CHECK_INDEX(operands[1], p_function->lambdas.size());
+			} break;
+			case GDScriptFunction::OPCODE_JUMP: {
+				fixed_arg_count = 0;
+				OPERANDS(1);
+				jump_targets.push_back(operands[0]);
+			} break;
+			case GDScriptFunction::OPCODE_JUMP_IF:
+			case GDScriptFunction::OPCODE_JUMP_IF_NOT: {
+				fixed_arg_count = 1;
+				OPERANDS(1);
+				jump_targets.push_back(operands[0]);
+			} break;
+			case GDScriptFunction::OPCODE_JUMP_TO_DEF_ARGUMENT: {
+				fixed_arg_count = 0;
+				if (p_function->default_arguments.is_empty()) {
+					return false;
+				}
+			} break;
+			case GDScriptFunction::OPCODE_BREAKPOINT:
+			case GDScriptFunction::OPCODE_END: {
+				fixed_arg_count = 0;
+			} break;
+			case GDScriptFunction::OPCODE_LINE: {
+				fixed_arg_count = 0;
+				OPERANDS(1);
+			} break;
+			case GDScriptFunction::OPCODE_RETURN_TYPED_BUILTIN: {
+				fixed_arg_count = 1;
+				OPERANDS(1);
+				CHECK_INDEX(operands[0], Variant::VARIANT_MAX);
+			} break;
+			case GDScriptFunction::OPCODE_RETURN_TYPED_NATIVE:
+			case GDScriptFunction::OPCODE_RETURN_TYPED_SCRIPT: {
+				fixed_arg_count = 2;
+			} break;
+			case GDScriptFunction::OPCODE_RETURN_TYPED_ARRAY: {
+				fixed_arg_count = 2;
+				OPERANDS(2);
+				CHECK_INDEX(operands[0], Variant::VARIANT_MAX);
+				CHECK_INDEX(operands[1], p_function->global_names.size());
+			} break;
+			default: {
+				if (opcode >= GDScriptFunction::OPCODE_CALL_PTRCALL_NO_RETURN && opcode <= GDScriptFunction::OPCODE_CALL_PTRCALL_PACKED_COLOR_ARRAY) {
+					OPERANDS(2);
+					if (operands[0] + (opcode == GDScriptFunction::OPCODE_CALL_PTRCALL_NO_RETURN ? 1 : 2) != instr_arg_count || operands[0] > p_function->_ptrcall_args_size) {
+						return false;
+					}
+					CHECK_INDEX(operands[1], p_function->methods.size());
+				} else if (opcode >= GDScriptFunction::OPCODE_ITERATE_BEGIN && opcode <= GDScriptFunction::OPCODE_ITERATE_OBJECT) {
+					fixed_arg_count = 3;
+					OPERANDS(1);
+					jump_targets.push_back(operands[0]);
+				} else if (opcode >= GDScriptFunction::OPCODE_TYPE_ADJUST_BOOL && opcode <= GDScriptFunction::OPCODE_TYPE_ADJUST_PACKED_COLOR_ARRAY) {
+					fixed_arg_count = 1;
+				} else {
+					return false;
+				}
+			} break;
+		}
+
+#undef OPERANDS
+#undef CHECK_INDEX
+
+		if (fixed_arg_count >= 0 && instr_arg_count != fixed_arg_count) {
+			return false;
+		}
+		ip += 1 + instr_arg_count + operand_length;
+	}
+
+	// Running past the end is only checked by debug builds.
+	if (ip != code_size || opcode != GDScriptFunction::OPCODE_END) {
+		return false;
+	}
+	for (uint32_t i = 0; i < jump_targets.size(); i++) {
+		if (jump_targets[i] < 0 || jump_targets[i] >= code_size || !instruction_starts[jump_targets[i]]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool GDScriptBytecodeCache::Reader::get_class_tree(GDScript *p_script) {
+	// Like `GDScriptCompiler::_make_scripts()`, create all the classes first
+	// so they can be referenced.
+	uint32_t subclass_count = get_count();
+	for (uint32_t i = 0; i < subclass_count; i++) {
+		StringName name = get_string();
+		if (error) {
+			return false;
+		}
+
+		String fully_qualified_name = p_script->fully_qualified_name + "::" + name;
+		Ref<GDScript> subclass = GDScriptLanguage::get_singleton()->get_orphan_subclass(fully_qualified_name);
+		if (subclass.is_null()) {
+			subclass.instantiate();
+		}
+		subclass->_owner = p_script;
+		subclass->fully_qualified_name = fully_qualified_name;
+		p_script->subclasses.insert(name, subclass);
+
+		if (!get_class_tree(subclass.ptr())) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool GDScriptBytecodeCache::Reader::get_class(GDScript *p_script) {
+	p_script->tool = get_u8();
+	p_script->name = get_string();
+
+	Variant native;
+	Variant base;
+	if (!get_reference(native, false) || !get_reference(base, true)) {
+		return false;
+	}
+	p_script->native = Ref<GDScriptNativeClass>(native);
+	p_script->base = Ref<GDScript>(base);
+	p_script->_base = p_script->base.ptr();
+
+	uint32_t member_count = get_count();
+	for (uint32_t i = 0; i < member_count; i++) {
+		StringName name = get_string();
+		GDScript::MemberInfo info;
+		info.index = get_u32();
+		info.setter = get_string();
+		info.getter = get_string();
+		if (!get_data_type(info.data_type, p_script)) {
+			return false;
+		}
+		p_script->member_indices[name] = info;
+	}
+
+	uint32_t own_member_count = get_count();
+	for (uint32_t i = 0; i < own_member_count; i++) {
+		p_script->members.insert(get_string());
+	}
+
+	uint32_t member_info_count = get_count();
+	for (uint32_t i = 0; i < member_info_count; i++) {
+		StringName name = get_string();
+		PropertyInfo info;
+		info.type = Variant::Type(get_u32());
+		info.name = get_string();
+		info.class_name = get_string();
+		info.hint = PropertyHint(get_u32());
+		info.hint_string = get_string();
+		info.usage = get_u32();
+		if (info.type >= Variant::VARIANT_MAX) {
+			return fail(ERR_FILE_CORRUPT);
+		}
+		p_script->member_info[name] = info;
+	}
+
+	uint32_t signal_count = get_count();
+	for (uint32_t i = 0; i < signal_count; i++) {
+		StringName name = get_string();
+		Vector<StringName> parameters;
+		uint32_t parameter_count = get_count();
+		for (uint32_t j = 0; j < parameter_count; j++) {
+			parameters.push_back(get_string());
+		}
+		p_script->_signals[name] = parameters;
+	}
+
+	uint32_t constant_count = get_count();
+	for (uint32_t i = 0; i < constant_count; i++) {
+		StringName name = get_string();
+		Variant constant;
+		if (!get_constant(constant)) {
+			return false;
+		}
+		p_script->constants.insert(name, constant);
+	}
+
+	uint32_t function_count = get_count();
+	for (uint32_t i = 0; i < function_count; i++) {
+		StringName name = get_string();
+		GDScriptFunction *function = error ? nullptr : get_function(p_script);
+		if (!function) {
+			return fail(ERR_FILE_CORRUPT);
+		}
+		p_script->member_functions[name] = function;
+	}
+
+	const Map<StringName, GDScriptFunction *>::Element *initializer = p_script->member_functions.find(GDScriptLanguage::get_singleton()->strings._init);
+	p_script->initializer = initializer ? initializer->get() : nullptr;
+	const Map<StringName, GDScriptFunction *>::Element *implicit_initializer = p_script->member_functions.find("@implicit_new");
+	p_script->implicit_initializer = implicit_initializer ? implicit_initializer->get() : nullptr;
+
+	for (Map<StringName, Ref<GDScript>>::Element *E = p_script->subclasses.front(); E; E = E->next()) {
+		if (!get_class(E->get().ptr())) {
+			return false;
+		}
+	}
+
+	if (error) {
+		return false;
+	}
+	p_script->valid = true;
+	return true;
+}
+
+/* CACHE */
+
+Vector<uint8_t> GDScriptBytecodeCache::serialize(const GDScript *p_script, String *r_error) {
+	ERR_FAIL_NULL_V(p_script, Vector<uint8_t>());
+
+	Writer writer;
+	writer.root = p_script;
+
+	writer.put_data((const uint8_t *)BYTECODE_MAGIC, 4);
+	writer.put_u32(FORMAT_VERSION);
+	writer.put_string(_get_engine_build());
+	Vector<uint8_t> source_md5 = p_script->source.md5_buffer();
+	writer.put_data(source_md5.ptr(), source_md5.size());
+
+	writer.put_class_tree(p_script);
+	if (!writer.put_class(p_script)) {
+		if (r_error) {
+			*r_error = writer.error;
+		}
+		return Vector<uint8_t>();
+	}
+
+	return writer.data;
+}
+
+Error GDScriptBytecodeCache::deserialize(GDScript *p_script, const Vector<uint8_t> &p_data) {
+	ERR_FAIL_NULL_V(p_script, ERR_INVALID_PARAMETER);
+
+	Reader reader(p_data);
+	reader.root = p_script;
+
+	uint8_t magic[4] = {};
+	reader.get_data(magic, 4);
+	uint32_t format_version = reader.get_u32();
+	String engine_build = reader.get_string();
+	uint8_t source_md5[16] = {};
+	reader.get_data(source_md5, 16);
+	if (reader.error || memcmp(magic, BYTECODE_MAGIC, 4) != 0 || format_version != FORMAT_VERSION || engine_build != _get_engine_build()) {
+		return ERR_FILE_UNRECOGNIZED;
+	}
+	if (memcmp(source_md5, p_script->source.md5_buffer().ptr(), 16) != 0) {
+		// The source code was changed, the data is outdated.
+		return ERR_FILE_UNRECOGNIZED;
+	}
+
+	_clear_class(p_script);
+	p_script->fully_qualified_name = p_script->path;
+	p_script->_owner = nullptr;
+
+	if (!reader.get_class_tree(p_script) || !reader.get_class(p_script) || !reader.is_at_end()) {
+		_clear_class(p_script);
+		return reader.error ? reader.error : ERR_FILE_CORRUPT;
+	}
+
+	for (Map<StringName, Ref<GDScript>>::Element *E = p_script->subclasses.front(); E; E = E->next()) {
+		p_script->_set_subclass_path(E->get(), p_script->path);
+	}
+	p_script->_init_rpc_methods_properties();
+
+	return OK;
+}
+
+String GDScriptBytecodeCache::get_cache_path(const String &p_script_path) {
+	return p_script_path.get_basename() + ".gdc";
+}
@@ -0,0 +1,69 @@
+/*************************************************************************/
+/*  gdscript_bytecode_cache.h                                            */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+
+#ifndef GDSCRIPT_BYTECODE_CACHE_H
+#define GDSCRIPT_BYTECODE_CACHE_H
+
+#include "core/string/ustring.h"
+#include "core/templates/vector.h"
+
+class GDScript;
+
+// Serialized form of a compiled script, so exported projects can load scripts
+// without parsing and compiling them. Engine functions are stored by name and
+// resolved again when loading, so the data only depends on the engine build and
+// on the source code it was compiled from. Loading fails on any mismatch, in
+// which case the script must be compiled from its source code.
+class GDScriptBytecodeCache {
+	class Writer;
+	class Reader;
+
+	static void _clear_class(GDScript *p_script);
+
+public:
+	enum {
+		FORMAT_VERSION = 3,
+	};
+
+	// Returns an empty buffer if the script uses values which can't be
+	// serialized, with the reason in `r_error`.
+	static Vector<uint8_t> serialize(const GDScript *p_script, String *r_error = nullptr);
+
+	// The source code of the script must be set already, it's used to check
+	// the data is up to date. Returns ERR_FILE_UNRECOGNIZED if the data was
+	// made by another engine build or from another source code.
+	static Error deserialize(GDScript *p_script, const Vector<uint8_t> &p_data);
+
+	// Path of the compiled script shipped next to the script source.
+	static String get_cache_path(const String &p_script_path);
+};
+
+#endif // GDSCRIPT_BYTECODE_CACHE_H
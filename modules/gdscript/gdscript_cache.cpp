@@ -30,10 +30,16 @@
 
 #include "gdscript_cache.h"
 
+#include "core/config/engine.h"
+#include "core/config/project_settings.h"
+#include "core/debugger/engine_debugger.h"
 #include "core/io/file_access.h"
+#include "core/object/script_language.h"
+#include "core/os/worker_thread_pool.h"
 #include "core/templates/vector.h"
 #include "gdscript.h"
 #include "gdscript_analyzer.h"
+#include "gdscript_bytecode_cache.h"
 #include "gdscript_parser.h"
 
 bool GDScriptParserRef::is_valid() const {
@@ -49,6 +55,18 @@ GDScriptParser *GDScriptParserRef::get_parser() const {
 }
 
 Error GDScriptParserRef::raise_status(Status p_new_status) {
+	if (p_new_status > PARSED) {
+		// The analyzer gets the other scripts from the cache, so lock it before
+		// this parser like they do. Parsing alone doesn't need it, which allows
+		// `GDScriptCache::compile_scripts()` to parse on multiple threads.
+		MutexLock cache_lock(GDScriptCache::singleton->lock);
+		return _raise_status(p_new_status);
+	}
+	return _raise_status(p_new_status);
+}
+
+Error GDScriptParserRef::_raise_status(Status p_new_status) {
+	MutexLock lock(mutex);
 	ERR_FAIL_COND_V(parser == nullptr, ERR_INVALID_DATA);
 
 	Error result = OK;
@@ -56,7 +74,8 @@ Error GDScriptParserRef::raise_status(Status p_new_status) {
 	while (p_new_status > status) {
 		switch (status) {
 			case EMPTY:
-				result = parser->parse(GDScriptCache::get_source_code(path), path, false);
+				source = GDScriptCache::get_source_code(path);
+				result = parser->parse(source, path, false);
 				status = PARSED;
 				break;
 			case PARSED: {
@@ -109,7 +128,11 @@ GDScriptParserRef::~GDScriptParserRef() {
 		memdelete(analyzer);
 	}
 	MutexLock lock(GDScriptCache::singleton->lock);
-	GDScriptCache::singleton->parser_map.erase(path);
+	// A new parser may already replace this one if it was requested while this one was being freed.
+	GDScriptParserRef **current = GDScriptCache::singleton->parser_map.getptr(path);
+	if (current && *current == this) {
+		GDScriptCache::singleton->parser_map.erase(path);
+	}
 }
 
 GDScriptCache *GDScriptCache::singleton = nullptr;
@@ -121,23 +144,27 @@ void GDScriptCache::remove_script(const String &p_path) {
 }
 
 Ref<GDScriptParserRef> GDScriptCache::get_parser(const String &p_path, GDScriptParserRef::Status p_status, Error &r_error, const String &p_owner) {
-	MutexLock lock(singleton->lock);
 	Ref<GDScriptParserRef> ref;
-	if (p_owner != String()) {
-		singleton->dependencies[p_owner].insert(p_path);
-	}
-	if (singleton->parser_map.has(p_path)) {
-		ref = Ref<GDScriptParserRef>(singleton->parser_map[p_path]);
-	} else {
-		if (!FileAccess::exists(p_path)) {
-			r_error = ERR_FILE_NOT_FOUND;
-			return ref;
+	{
+		MutexLock lock(singleton->lock);
+		if (p_owner != String()) {
+			singleton->dependencies[p_owner].insert(p_path);
+		}
+		if (singleton->parser_map.has(p_path)) {
+			// Stays null if the parser is being freed on another thread.
+			ref = Ref<GDScriptParserRef>(singleton->parser_map[p_path]);
+		}
+		if (ref.is_null()) {
+			if (!FileAccess::exists(p_path)) {
+				r_error = ERR_FILE_NOT_FOUND;
+				return ref;
+			}
+			GDScriptParser *parser = memnew(GDScriptParser);
+			ref.instantiate();
+			ref->parser = parser;
+			ref->path = p_path;
+			singleton->parser_map[p_path] = ref.ptr();
 		}
-		GDScriptParser *parser = memnew(GDScriptParser);
-		ref.instantiate();
-		ref->parser = parser;
-		ref->path = p_path;
-		singleton->parser_map[p_path] = ref.ptr();
 	}
 
 	r_error = ref->raise_status(p_status);
@@ -198,7 +225,9 @@ Ref<GDScript> GDScriptCache::get_full_script(const String &p_path, Error &r_erro
 
 	r_error = OK;
 	if (singleton->full_gdscript_cache.has(p_path)) {
-		return singleton->full_gdscript_cache[p_path];
+		Ref<GDScript> script = singleton->full_gdscript_cache[p_path];
+		singleton->_release_precompiled_scripts(p_path);
+		return script;
 	}
 	Ref<GDScript> script = get_shallow_script(p_path);
 
@@ -219,6 +248,31 @@ Ref<GDScript> GDScriptCache::get_full_script(const String &p_path, Error &r_erro
 	return script;
 }
 
+Ref<GDScript> GDScriptCache::get_byte_code_script(const String &p_path, const String &p_byte_code_path, const String &p_owner) {
+	MutexLock lock(singleton->lock);
+
+	if (p_owner != String()) {
+		singleton->dependencies[p_owner].insert(p_path);
+	}
+
+	if (singleton->full_gdscript_cache.has(p_path)) {
+		Ref<GDScript> script = singleton->full_gdscript_cache[p_path];
+		singleton->_release_precompiled_scripts(p_path);
+		return script;
+	}
+	Ref<GDScript> script = get_shallow_script(p_path);
+
+	// The source code is still needed, the bytecode is only used if it matches it.
+	if (script->load_source_code(p_path) != OK || script->load_byte_code(p_byte_code_path) != OK) {
+		return Ref<GDScript>();
+	}
+
+	singleton->full_gdscript_cache[p_path] = script.ptr();
+	singleton->shallow_gdscript_cache.erase(p_path);
+
+	return script;
+}
+
 Error GDScriptCache::finish_compiling(const String &p_owner) {
 	// Mark this as compiled.
 	Ref<GDScript> script = get_shallow_script(p_owner);
@@ -231,7 +285,7 @@ Error GDScriptCache::finish_compiling(const String &p_owner) {
 	for (const Set<String>::Element *E = depends.front(); E != nullptr; E = E->next()) {
 		Error this_err = OK;
 		// No need to save the script. We assume it's already referenced in the owner.
-		get_full_script(E->get(), this_err);
+		ResourceFormatLoaderGDScript::load_script(E->get(), this_err);
 
 		if (this_err != OK) {
 			err = this_err;
@@ -243,11 +297,192 @@ Error GDScriptCache::finish_compiling(const String &p_owner) {
 	return err;
 }
 
+Ref<GDScriptParserRef> GDScriptCache::take_parsed_script(const String &p_path, const String &p_source) {
+	MutexLock lock(singleton->lock);
+	Ref<GDScriptParserRef> ref;
+	if (!singleton->parsed_scripts.has(p_path)) {
+		return ref;
+	}
+	ref = singleton->parsed_scripts[p_path];
+	singleton->parsed_scripts.erase(p_path);
+
+	// Only reuse trees no analyzer touched yet, which match the source being compiled.
+	if (!ref->is_valid() || ref->get_status() != GDScriptParserRef::PARSED || ref->source != p_source) {
+		return Ref<GDScriptParserRef>();
+	}
+
+	// The tree now belongs to the caller, other scripts depending on this one get their own.
+	GDScriptParserRef **current = singleton->parser_map.getptr(p_path);
+	if (current && *current == ref.ptr()) {
+		singleton->parser_map.erase(p_path);
+	}
+	return ref;
+}
+
+void GDScriptCache::_parse_script(uint32_t p_index, Ref<GDScriptParserRef> *p_parsers) {
+	p_parsers[p_index]->raise_status(GDScriptParserRef::PARSED);
+}
+
+void GDScriptCache::_release_precompiled_scripts(const String &p_path) {
+	if (precompiled_scripts.is_empty()) {
+		return;
+	}
+	// The caller keeps the requested script alive from now on. The game loads the
+	// autoloads in the order of the list, so the ones before it that weren't
+	// requested were skipped and won't be.
+	int index = autoload_paths.find(p_path);
+	for (int i = 0; i < index; i++) {
+		precompiled_scripts.erase(autoload_paths[i]);
+	}
+	precompiled_scripts.erase(p_path);
+}
+
+static void _add_after_base(const String &p_path, const HashMap<String, String> &p_bases, Set<String> &r_added, Vector<String> &r_ordered) {
+	if (r_added.has(p_path)) {
+		return;
+	}
+	r_added.insert(p_path);
+
+	const String *base = p_bases.getptr(p_path);
+	if (base) {
+		_add_after_base(*base, p_bases, r_added, r_ordered);
+	}
+	r_ordered.push_back(p_path);
+}
+
+Error GDScriptCache::compile_scripts(const Vector<String> &p_paths, Vector<Ref<GDScript>> *r_scripts) {
+	// Fill the tables the parser initializes on first use before using it on multiple threads.
+	GDScriptParser::get_builtin_type(StringName());
+	GDScriptParser::get_real_class_name(StringName());
+
+	// Parsing doesn't depend on other scripts, so it's done in parallel.
+	Vector<Ref<GDScriptParserRef>> parsers;
+	{
+		MutexLock lock(singleton->lock);
+		for (int i = 0; i < p_paths.size(); i++) {
+			const String &path = p_paths[i];
+			if (singleton->full_gdscript_cache.has(path) || singleton->parsed_scripts.has(path)) {
+				continue;
+			}
+			if (!EngineDebugger::is_active() && FileAccess::exists(GDScriptBytecodeCache::get_cache_path(path))) {
+				// Most likely loaded from the compiled script instead.
+				continue;
+			}
+			Error err = OK;
+			Ref<GDScriptParserRef> ref = get_parser(path, GDScriptParserRef::EMPTY, err);
+			if (ref.is_valid() && ref->get_status() == GDScriptParserRef::EMPTY) {
+				parsers.push_back(ref);
+			}
+		}
+	}
+
+	if (!parsers.is_empty()) {
+		WorkerThreadPool::GroupID group_task = WorkerThreadPool::get_singleton()->add_template_group_task(singleton, &GDScriptCache::_parse_script, parsers.ptrw(), parsers.size());
+		WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group_task);
+	}
+
+	// The analyzer and compiler resolve the other scripts through the shared
+	// trees of the cache, so they run on this thread. Compile the base classes
+	// first, so they still use the parsed trees instead of parsing again when
+	// the derived classes need them.
+	HashMap<String, String> bases;
+	{
+		MutexLock lock(singleton->lock);
+		for (int i = 0; i < parsers.size(); i++) {
+			const Ref<GDScriptParserRef> &ref = parsers[i];
+			singleton->parsed_scripts[ref->path] = ref;
+			if (!ref->is_valid()) {
+				continue;
+			}
+			const GDScriptParser::ClassNode *head = ref->get_parser()->get_tree();
+			if (head == nullptr) {
+				continue;
+			}
+			if (!head->extends_path.is_empty()) {
+				bases[ref->path] = head->extends_path;
+			} else if (!head->extends.is_empty() && ScriptServer::is_global_class(head->extends[0])) {
+				bases[ref->path] = ScriptServer::get_global_class_path(head->extends[0]);
+			}
+		}
+	}
+
+	Set<String> added;
+	Vector<String> ordered;
+	for (int i = 0; i < p_paths.size(); i++) {
+		_add_after_base(p_paths[i], bases, added, ordered);
+	}
+
+	Error err = OK;
+	for (int i = 0; i < ordered.size(); i++) {
+		Error this_err = OK;
+		Ref<GDScript> script = ResourceFormatLoaderGDScript::load_script(ordered[i], this_err);
+		if (this_err != OK) {
+			err = this_err;
+		}
+		if (r_scripts && script.is_valid()) {
+			r_scripts->push_back(script);
+		}
+	}
+
+	// Drop the trees that weren't used, for scripts compiled while compiling another one.
+	MutexLock lock(singleton->lock);
+	for (int i = 0; i < parsers.size(); i++) {
+		Ref<GDScriptParserRef> *parsed = singleton->parsed_scripts.getptr(parsers[i]->path);
+		if (parsed && *parsed == parsers[i]) {
+			singleton->parsed_scripts.erase(parsers[i]->path);
+		}
+	}
+
+	return err;
+}
+
+void GDScriptCache::compile_autoloads(const String &p_path) {
+	Vector<String> paths;
+	{
+		MutexLock lock(singleton->lock);
+		if (singleton->autoloads_compiled) {
+			return;
+		}
+
+		if (!singleton->autoloads_listed) {
+			Map<StringName, ProjectSettings::AutoloadInfo> autoloads = ProjectSettings::get_singleton()->get_autoload_list();
+			for (const Map<StringName, ProjectSettings::AutoloadInfo>::Element *E = autoloads.front(); E; E = E->next()) {
+				if (E->get().path.get_extension() == "gd") {
+					singleton->autoload_paths.push_back(E->get().path);
+				}
+			}
+			singleton->autoloads_listed = true;
+			singleton->autoloads_compiled = singleton->autoload_paths.is_empty();
+		}
+
+		// Wait for the first autoload, the game registers their names before loading them.
+		if (singleton->autoload_paths.find(p_path) == -1) {
+			return;
+		}
+		singleton->autoloads_compiled = true;
+		paths = singleton->autoload_paths;
+	}
+
+	// Not locked, so other threads can load scripts while these are parsed and compiled.
+	Vector<Ref<GDScript>> scripts;
+	compile_scripts(paths, &scripts);
+
+	// Base classes compiled along are kept alive by the autoloads extending them.
+	MutexLock lock(singleton->lock);
+	for (int i = 0; i < scripts.size(); i++) {
+		if (paths.find(scripts[i]->get_path()) != -1) {
+			singleton->precompiled_scripts[scripts[i]->get_path()] = scripts[i];
+		}
+	}
+}
+
 GDScriptCache::GDScriptCache() {
 	singleton = this;
 }
 
 GDScriptCache::~GDScriptCache() {
+	precompiled_scripts.clear();
+	parsed_scripts.clear();
 	parser_map.clear();
 	shallow_gdscript_cache.clear();
 	full_gdscript_cache.clear();
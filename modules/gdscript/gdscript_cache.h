@@ -55,9 +55,13 @@ private:
 	GDScriptAnalyzer *analyzer = nullptr;
 	Status status = EMPTY;
 	String path;
+	String source;
+	Mutex mutex;
 
 	friend class GDScriptCache;
 
+	Error _raise_status(Status p_new_status);
+
 public:
 	bool is_valid() const;
 	Status get_status() const;
@@ -74,6 +78,14 @@ class GDScriptCache {
 	HashMap<String, GDScript *> shallow_gdscript_cache;
 	HashMap<String, GDScript *> full_gdscript_cache;
 	HashMap<String, Set<String>> dependencies;
+	// Trees parsed by `compile_scripts()`, reused by `GDScript::reload()`.
+	HashMap<String, Ref<GDScriptParserRef>> parsed_scripts;
+	// Autoloads compiled ahead of time, kept alive until they are requested or skipped.
+	HashMap<String, Ref<GDScript>> precompiled_scripts;
+	// GDScript autoloads of the project, listed on the first load.
+	Vector<String> autoload_paths;
+	bool autoloads_listed = false;
+	bool autoloads_compiled = false;
 
 	friend class GDScript;
 	friend class GDScriptParserRef;
@@ -82,13 +94,21 @@ class GDScriptCache {
 
 	Mutex lock;
 	static void remove_script(const String &p_path);
+	static Ref<GDScriptParserRef> take_parsed_script(const String &p_path, const String &p_source);
+
+	void _parse_script(uint32_t p_index, Ref<GDScriptParserRef> *p_parsers);
+	void _release_precompiled_scripts(const String &p_path);
 
 public:
 	static Ref<GDScriptParserRef> get_parser(const String &p_path, GDScriptParserRef::Status status, Error &r_error, const String &p_owner = String());
 	static String get_source_code(const String &p_path);
 	static Ref<GDScript> get_shallow_script(const String &p_path, const String &p_owner = String());
 	static Ref<GDScript> get_full_script(const String &p_path, Error &r_error, const String &p_owner = String());
+	static Ref<GDScript> get_byte_code_script(const String &p_path, const String &p_byte_code_path, const String &p_owner = String());
 	static Error finish_compiling(const String &p_owner);
+	// Only the parsing runs on the worker threads, the scripts are analyzed and compiled on this thread.
+	static Error compile_scripts(const Vector<String> &p_paths, Vector<Ref<GDScript>> *r_scripts = nullptr);
+	static void compile_autoloads(const String &p_path);
 
 	GDScriptCache();
 	~GDScriptCache();
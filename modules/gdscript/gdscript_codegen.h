@@ -82,6 +82,7 @@ public:
 
 	virtual void write_start(GDScript *p_script, const StringName &p_function_name, bool p_static, MultiplayerAPI::RPCConfig p_rpc_config, const GDScriptDataType &p_return_type) = 0;
 	virtual GDScriptFunction *write_end() = 0;
+	virtual bool is_optimizing() const = 0;
 
 #ifdef DEBUG_ENABLED
 	virtual void set_signature(const String &p_signature) = 0;
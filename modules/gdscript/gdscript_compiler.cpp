@@ -648,6 +648,17 @@ GDScriptCodeGenerator::Address GDScriptCompiler::_parse_expression(CodeGen &code
 		// Indexing operator.
 		case GDScriptParser::Node::SUBSCRIPT: {
 			const GDScriptParser::SubscriptNode *subscript = static_cast<const GDScriptParser::SubscriptNode *>(p_expression);
+			if (subscript->is_attribute && subscript->base->type == GDScriptParser::Node::IDENTIFIER && p_index_addr.mode == GDScriptCodeGenerator::Address::NIL) {
+				const StringName &base_name = static_cast<const GDScriptParser::IdentifierNode *>(subscript->base)->name;
+				for (int i = 0; i < codegen.hoisted_reads.size(); i++) {
+					const CodeGen::HoistedRead &hoisted = codegen.hoisted_reads[i];
+					if (hoisted.base == base_name && hoisted.attribute == subscript->attribute->name) {
+						// Read once before the loop.
+						return hoisted.address;
+					}
+				}
+			}
+
 			GDScriptCodeGenerator::Address result = codegen.add_temporary(_gdtype_from_datatype(subscript->get_datatype()));
 
 			GDScriptCodeGenerator::Address base = _parse_expression(codegen, r_error, subscript->base);
@@ -1532,6 +1543,215 @@ void GDScriptCompiler::_add_locals_in_block(CodeGen &codegen, const GDScriptPars
 	}
 }
 
+static const GDScriptParser::IdentifierNode *_get_root_identifier(const GDScriptParser::ExpressionNode *p_expression) {
+	while (p_expression && p_expression->type == GDScriptParser::Node::SUBSCRIPT) {
+		p_expression = static_cast<const GDScriptParser::SubscriptNode *>(p_expression)->base;
+	}
+	if (p_expression && p_expression->type == GDScriptParser::Node::IDENTIFIER) {
+		return static_cast<const GDScriptParser::IdentifierNode *>(p_expression);
+	}
+	return nullptr;
+}
+
+bool GDScriptCompiler::_scan_loop(const GDScriptParser::Node *p_node, Set<StringName> &r_changed, Vector<const GDScriptParser::SubscriptNode *> &r_reads) {
+	// Returns false for the code it doesn't know, so nothing is hoisted from the loop.
+	if (p_node == nullptr) {
+		return true;
+	}
+
+	switch (p_node->type) {
+		case GDScriptParser::Node::SUITE: {
+			const GDScriptParser::SuiteNode *suite = static_cast<const GDScriptParser::SuiteNode *>(p_node);
+			for (int i = 0; i < suite->statements.size(); i++) {
+				if (!_scan_loop(suite->statements[i], r_changed, r_reads)) {
+					return false;
+				}
+			}
+			return true;
+		}
+		case GDScriptParser::Node::IF: {
+			const GDScriptParser::IfNode *if_n = static_cast<const GDScriptParser::IfNode *>(p_node);
+			return _scan_loop(if_n->condition, r_changed, r_reads) && _scan_loop(if_n->true_block, r_changed, r_reads) && _scan_loop(if_n->false_block, r_changed, r_reads);
+		}
+		case GDScriptParser::Node::WHILE: {
+			const GDScriptParser::WhileNode *while_n = static_cast<const GDScriptParser::WhileNode *>(p_node);
+			return _scan_loop(while_n->condition, r_changed, r_reads) && _scan_loop(while_n->loop, r_changed, r_reads);
+		}
+		case GDScriptParser::Node::FOR: {
+			const GDScriptParser::ForNode *for_n = static_cast<const GDScriptParser::ForNode *>(p_node);
+			r_changed.insert(for_n->variable->name);
+			return _scan_loop(for_n->list, r_changed, r_reads) && _scan_loop(for_n->loop, r_changed, r_reads);
+		}
+		case GDScriptParser::Node::VARIABLE: {
+			const GDScriptParser::VariableNode *variable = static_cast<const GDScriptParser::VariableNode *>(p_node);
+			r_changed.insert(variable->identifier->name);
+			return _scan_loop(variable->initializer, r_changed, r_reads);
+		}
+		case GDScriptParser::Node::CONSTANT: {
+			r_changed.insert(static_cast<const GDScriptParser::ConstantNode *>(p_node)->identifier->name);
+			return true;
+		}
+		case GDScriptParser::Node::ASSERT: {
+			const GDScriptParser::AssertNode *as = static_cast<const GDScriptParser::AssertNode *>(p_node);
+			return _scan_loop(as->condition, r_changed, r_reads) && _scan_loop(as->message, r_changed, r_reads);
+		}
+		case GDScriptParser::Node::RETURN: {
+			return _scan_loop(static_cast<const GDScriptParser::ReturnNode *>(p_node)->return_value, r_changed, r_reads);
+		}
+		case GDScriptParser::Node::BREAK:
+		case GDScriptParser::Node::BREAKPOINT:
+		case GDScriptParser::Node::CONTINUE:
+		case GDScriptParser::Node::PASS:
+		case GDScriptParser::Node::GET_NODE:
+		case GDScriptParser::Node::IDENTIFIER:
+		case GDScriptParser::Node::LITERAL:
+		case GDScriptParser::Node::PRELOAD:
+		case GDScriptParser::Node::SELF:
+		case GDScriptParser::Node::LAMBDA: // Compiled as another function, which only gets copies of the locals.
+			return true;
+		case GDScriptParser::Node::ARRAY: {
+			const GDScriptParser::ArrayNode *array = static_cast<const GDScriptParser::ArrayNode *>(p_node);
+			for (int i = 0; i < array->elements.size(); i++) {
+				if (!_scan_loop(array->elements[i], r_changed, r_reads)) {
+					return false;
+				}
+			}
+			return true;
+		}
+		case GDScriptParser::Node::DICTIONARY: {
+			const GDScriptParser::DictionaryNode *dict = static_cast<const GDScriptParser::DictionaryNode *>(p_node);
+			for (int i = 0; i < dict->elements.size(); i++) {
+				if (!_scan_loop(dict->elements[i].key, r_changed, r_reads) || !_scan_loop(dict->elements[i].value, r_changed, r_reads)) {
+					return false;
+				}
+			}
+			return true;
+		}
+		case GDScriptParser::Node::ASSIGNMENT: {
+			const GDScriptParser::AssignmentNode *assignment = static_cast<const GDScriptParser::AssignmentNode *>(p_node);
+			const GDScriptParser::IdentifierNode *root = _get_root_identifier(assignment->assignee);
+			if (root) {
+				r_changed.insert(root->name);
+			}
+			return _scan_loop(assignment->assignee, r_changed, r_reads) && _scan_loop(assignment->assigned_value, r_changed, r_reads);
+		}
+		case GDScriptParser::Node::AWAIT: {
+			return _scan_loop(static_cast<const GDScriptParser::AwaitNode *>(p_node)->to_await, r_changed, r_reads);
+		}
+		case GDScriptParser::Node::BINARY_OPERATOR: {
+			const GDScriptParser::BinaryOpNode *binary = static_cast<const GDScriptParser::BinaryOpNode *>(p_node);
+			return _scan_loop(binary->left_operand, r_changed, r_reads) && _scan_loop(binary->right_operand, r_changed, r_reads);
+		}
+		case GDScriptParser::Node::UNARY_OPERATOR: {
+			return _scan_loop(static_cast<const GDScriptParser::UnaryOpNode *>(p_node)->operand, r_changed, r_reads);
+		}
+		case GDScriptParser::Node::TERNARY_OPERATOR: {
+			const GDScriptParser::TernaryOpNode *ternary = static_cast<const GDScriptParser::TernaryOpNode *>(p_node);
+			return _scan_loop(ternary->condition, r_changed, r_reads) && _scan_loop(ternary->true_expr, r_changed, r_reads) && _scan_loop(ternary->false_expr, r_changed, r_reads);
+		}
+		case GDScriptParser::Node::CAST: {
+			return _scan_loop(static_cast<const GDScriptParser::CastNode *>(p_node)->operand, r_changed, r_reads);
+		}
+		case GDScriptParser::Node::CALL: {
+			const GDScriptParser::CallNode *call = static_cast<const GDScriptParser::CallNode *>(p_node);
+			if (call->callee && call->callee->type == GDScriptParser::Node::SUBSCRIPT) {
+				// Methods may change the value they are called on.
+				const GDScriptParser::SubscriptNode *callee = static_cast<const GDScriptParser::SubscriptNode *>(call->callee);
+				const GDScriptParser::IdentifierNode *root = _get_root_identifier(callee);
+				if (root) {
+					r_changed.insert(root->name);
+				}
+				if (!_scan_loop(callee->base, r_changed, r_reads) || (!callee->is_attribute && !_scan_loop(callee->index, r_changed, r_reads))) {
+					return false;
+				}
+			} else if (!_scan_loop(call->callee, r_changed, r_reads)) {
+				return false;
+			}
+			for (int i = 0; i < call->arguments.size(); i++) {
+				if (!_scan_loop(call->arguments[i], r_changed, r_reads)) {
+					return false;
+				}
+			}
+			return true;
+		}
+		case GDScriptParser::Node::SUBSCRIPT: {
+			const GDScriptParser::SubscriptNode *subscript = static_cast<const GDScriptParser::SubscriptNode *>(p_node);
+			if (subscript->is_attribute) {
+				if (subscript->base->type == GDScriptParser::Node::IDENTIFIER) {
+					r_reads.push_back(subscript);
+				}
+				return _scan_loop(subscript->base, r_changed, r_reads);
+			}
+			return _scan_loop(subscript->base, r_changed, r_reads) && _scan_loop(subscript->index, r_changed, r_reads);
+		}
+		default:
+			return false;
+	}
+}
+
+void GDScriptCompiler::_hoist_loop_invariant_reads(CodeGen &codegen, const GDScriptParser::Node *p_loop) {
+	if (!codegen.generator->is_optimizing()) {
+		return;
+	}
+
+	Set<StringName> changed;
+	Vector<const GDScriptParser::SubscriptNode *> reads;
+	if (!_scan_loop(p_loop, changed, reads)) {
+		return;
+	}
+
+	for (int i = 0; i < reads.size(); i++) {
+		const GDScriptParser::SubscriptNode *read = reads[i];
+		const StringName &base_name = static_cast<const GDScriptParser::IdentifierNode *>(read->base)->name;
+		const StringName &attribute = read->attribute->name;
+		if (read->is_constant || changed.has(base_name)) {
+			continue;
+		}
+
+		bool hoisted = false;
+		for (int j = 0; j < codegen.hoisted_reads.size(); j++) {
+			if (codegen.hoisted_reads[j].base == base_name && codegen.hoisted_reads[j].attribute == attribute) {
+				hoisted = true;
+				break;
+			}
+		}
+		if (hoisted) {
+			continue;
+		}
+
+		// Same lookup as for identifiers. Only the members of builtin values, which have
+		// validated getters, can be read early: they can't fail or have side effects.
+		GDScriptCodeGenerator::Address base;
+		if (codegen.parameters.has(base_name)) {
+			base = codegen.parameters[base_name];
+		} else if (codegen.locals.has(base_name)) {
+			base = codegen.locals[base_name];
+		} else {
+			continue;
+		}
+		if (base.mode != GDScriptCodeGenerator::Address::LOCAL_VARIABLE && base.mode != GDScriptCodeGenerator::Address::FUNCTION_PARAMETER) {
+			continue;
+		}
+		if (!base.type.has_type || base.type.kind != GDScriptDataType::BUILTIN || !Variant::get_member_validated_getter(base.type.builtin_type, attribute)) {
+			continue;
+		}
+
+		// The getter writes into a value of the right type, which the temporaries are.
+		GDScriptDataType type = _gdtype_from_datatype(read->get_datatype());
+		GDScriptCodeGenerator::Address value = codegen.add_temporary(type);
+		codegen.generator->write_get_named(value, attribute, base);
+		GDScriptCodeGenerator::Address local = codegen.add_local("@" + String(base_name) + "." + String(attribute), type);
+		codegen.generator->write_assign(local, value);
+		codegen.generator->pop_temporary();
+
+		CodeGen::HoistedRead hoisted_read;
+		hoisted_read.base = base_name;
+		hoisted_read.attribute = attribute;
+		hoisted_read.address = local;
+		codegen.hoisted_reads.push_back(hoisted_read);
+	}
+}
+
 Error GDScriptCompiler::_parse_block(CodeGen &codegen, const GDScriptParser::SuiteNode *p_block, bool p_add_locals) {
 	Error error = OK;
 	GDScriptCodeGenerator *gen = codegen.generator;
@@ -1667,6 +1887,9 @@ Error GDScriptCompiler::_parse_block(CodeGen &codegen, const GDScriptParser::Sui
 				const GDScriptParser::ForNode *for_n = static_cast<const GDScriptParser::ForNode *>(s);
 
 				codegen.start_block();
+				int hoisted_count = codegen.hoisted_reads.size();
+				_hoist_loop_invariant_reads(codegen, for_n);
+
 				GDScriptCodeGenerator::Address iterator = codegen.add_local(for_n->variable->name, _gdtype_from_datatype(for_n->variable->get_datatype()));
 
 				gen->start_for(iterator.type, _gdtype_from_datatype(for_n->list->get_datatype()));
@@ -1691,11 +1914,16 @@ Error GDScriptCompiler::_parse_block(CodeGen &codegen, const GDScriptParser::Sui
 
 				gen->write_endfor();
 
+				codegen.hoisted_reads.resize(hoisted_count);
 				codegen.end_block();
 			} break;
 			case GDScriptParser::Node::WHILE: {
 				const GDScriptParser::WhileNode *while_n = static_cast<const GDScriptParser::WhileNode *>(s);
 
+				codegen.start_block();
+				int hoisted_count = codegen.hoisted_reads.size();
+				_hoist_loop_invariant_reads(codegen, while_n);
+
 				gen->start_while_condition();
 
 				GDScriptCodeGenerator::Address condition = _parse_expression(codegen, error, while_n->condition);
@@ -1715,6 +1943,9 @@ Error GDScriptCompiler::_parse_block(CodeGen &codegen, const GDScriptParser::Sui
 				}
 
 				gen->write_endwhile();
+
+				codegen.hoisted_reads.resize(hoisted_count);
+				codegen.end_block();
 			} break;
 			case GDScriptParser::Node::BREAK: {
 				gen->write_break();
@@ -2180,6 +2411,7 @@ Error GDScriptCompiler::_parse_class_level(GDScript *p_script, const GDScriptPar
 	}
 	p_script->member_functions.clear();
 	p_script->member_indices.clear();
+	GDScriptLanguage::get_singleton()->invalidate_inline_caches();
 	p_script->member_info.clear();
 	p_script->_signals.clear();
 	p_script->initializer = nullptr;
@@ -2218,7 +2450,7 @@ Error GDScriptCompiler::_parse_class_level(GDScript *p_script, const GDScriptPar
 					}
 				} else {
 					Error err = OK;
-					base = GDScriptCache::get_full_script(p_class->base_type.script_path, err, main_script->path);
+					base = ResourceFormatLoaderGDScript::load_script(p_class->base_type.script_path, err, main_script->path);
 					if (err) {
 						return err;
 					}
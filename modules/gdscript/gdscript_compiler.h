@@ -53,6 +53,14 @@ class GDScriptCompiler {
 		Map<StringName, GDScriptCodeGenerator::Address> locals;
 		List<Map<StringName, GDScriptCodeGenerator::Address>> locals_stack;
 
+		// Members of locals read once before the loops that don't change them.
+		struct HoistedRead {
+			StringName base;
+			StringName attribute;
+			GDScriptCodeGenerator::Address address;
+		};
+		Vector<HoistedRead> hoisted_reads;
+
 		GDScriptCodeGenerator::Address add_local(const StringName &p_name, const GDScriptDataType &p_type) {
 			uint32_t addr = generator->add_local(p_name, p_type);
 			locals[p_name] = GDScriptCodeGenerator::Address(GDScriptCodeGenerator::Address::LOCAL_VARIABLE, addr, p_type);
@@ -127,6 +135,8 @@ class GDScriptCompiler {
 	GDScriptCodeGenerator::Address _parse_expression(CodeGen &codegen, Error &r_error, const GDScriptParser::ExpressionNode *p_expression, bool p_root = false, bool p_initializer = false, const GDScriptCodeGenerator::Address &p_index_addr = GDScriptCodeGenerator::Address());
 	GDScriptCodeGenerator::Address _parse_match_pattern(CodeGen &codegen, Error &r_error, const GDScriptParser::PatternNode *p_pattern, const GDScriptCodeGenerator::Address &p_value_addr, const GDScriptCodeGenerator::Address &p_type_addr, const GDScriptCodeGenerator::Address &p_previous_test, bool p_is_first, bool p_is_nested);
 	void _add_locals_in_block(CodeGen &codegen, const GDScriptParser::SuiteNode *p_block);
+	bool _scan_loop(const GDScriptParser::Node *p_node, Set<StringName> &r_changed, Vector<const GDScriptParser::SubscriptNode *> &r_reads);
+	void _hoist_loop_invariant_reads(CodeGen &codegen, const GDScriptParser::Node *p_loop);
 	Error _parse_block(CodeGen &codegen, const GDScriptParser::SuiteNode *p_block, bool p_add_locals = true);
 	GDScriptFunction *_parse_function(Error &r_error, GDScript *p_script, const GDScriptParser::ClassNode *p_class, const GDScriptParser::FunctionNode *p_func, bool p_for_ready = false, bool p_for_lambda = false);
 	Error _parse_setter_getter(GDScript *p_script, const GDScriptParser::ClassNode *p_class, const GDScriptParser::VariableNode *p_variable, bool p_is_setter);
@@ -33,11 +33,15 @@
 
 #include "core/object/ref_counted.h"
 #include "core/object/script_language.h"
+#include "core/os/spin_lock.h"
 #include "core/os/thread.h"
 #include "core/string/string_name.h"
+#include "core/templates/local_vector.h"
 #include "core/templates/pair.h"
+#include "core/templates/safe_refcount.h"
 #include "core/templates/self_list.h"
 #include "core/variant/variant.h"
+#include "gdscript_jit.h"
 #include "gdscript_utility_functions.h"
 
 class GDScriptInstance;
@@ -306,6 +310,7 @@ public:
 		OPCODE_JUMP,
 		OPCODE_JUMP_IF,
 		OPCODE_JUMP_IF_NOT,
+		OPCODE_OPERATOR_VALIDATED_JUMP_IF_NOT,
 		OPCODE_JUMP_TO_DEF_ARGUMENT,
 		OPCODE_RETURN,
 		OPCODE_RETURN_TYPED_BUILTIN,
@@ -427,6 +432,8 @@ public:
 private:
 	friend class GDScriptCompiler;
 	friend class GDScriptByteCodeGenerator;
+	friend class GDScriptBytecodeCache;
+	friend class GDScriptJIT;
 
 	StringName source;
 
@@ -470,6 +477,11 @@ private:
 	int _instruction_args_size = 0;
 	int _ptrcall_args_size = 0;
 
+	// Native code of the function, if compiled by the JIT.
+	GDScriptJIT::Function _jit_function = nullptr;
+	size_t _jit_code_size = 0;
+	bool _jit_uses_members = false;
+
 	int _initial_line = 0;
 	bool _static = false;
 	MultiplayerAPI::RPCConfig rpc_config;
@@ -506,6 +518,50 @@ private:
 
 	List<StackDebug> stack_debug;
 
+	// What `OPCODE_GET_NAMED`, `OPCODE_SET_NAMED` and `OPCODE_CALL` resolved on the
+	// last objects they were used on, so the name lookup is skipped for the same class.
+	struct InlineCache {
+		enum {
+			ENTRY_COUNT = 4, // Classes seen by a call site before entries get replaced.
+		};
+
+		struct Entry {
+			// The class name pointer is the same for all objects of a class.
+			const StringName *native_class = nullptr;
+			const GDScript *script = nullptr;
+
+			GDScriptFunction *function = nullptr;
+			MethodBind *method = nullptr;
+			int member_index = -1;
+			Variant::Type member_type = Variant::NIL;
+		};
+
+		// Read without locking: a slot is valid if its sequence is even and didn't change while it was read.
+		struct Slot {
+			SafeNumeric<uint32_t> sequence; // Odd while the slot is filled.
+			SafeNumeric<uint32_t> generation;
+			SafeNumeric<const StringName *> native_class;
+			SafeNumeric<const GDScript *> script;
+			SafeNumeric<GDScriptFunction *> function;
+			SafeNumeric<MethodBind *> method;
+			SafeNumeric<int> member_index;
+			SafeNumeric<Variant::Type> member_type;
+		};
+
+		Slot slots[ENTRY_COUNT];
+		uint32_t next_slot = 0;
+	};
+
+	LocalVector<InlineCache> inline_caches;
+	SpinLock inline_cache_lock; // Only taken to fill the caches.
+
+	bool _get_inline_cache_key(Object *p_object, InlineCache::Entry &r_key, GDScriptInstance *&r_instance) const;
+	bool _find_inline_cache(int p_cache, InlineCache::Entry &r_entry, uint32_t &r_generation);
+	void _store_inline_cache(int p_cache, const InlineCache::Entry &p_entry, uint32_t p_generation);
+	Variant _get_named_cached(int p_cache, const Variant *p_base, const StringName &p_name, bool &r_valid);
+	void _set_named_cached(int p_cache, Variant *p_base, const StringName &p_name, const Variant &p_value, bool &r_valid);
+	void _call_cached(int p_cache, Variant *p_base, const StringName &p_method, const Variant **p_args, int p_argcount, Variant &r_ret, Callable::CallError &r_error);
+
 	_FORCE_INLINE_ Variant *_get_variant(int p_address, GDScriptInstance *p_instance, Variant *p_stack, String &r_error) const;
 	_FORCE_INLINE_ String _get_call_error(const Callable::CallError &p_err, const String &p_where, const Variant **argptrs) const;
 
@@ -0,0 +1,1158 @@
+/*************************************************************************/
+/*  gdscript_jit.cpp                                                     */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "gdscript_jit.h"
+
+#include "core/config/project_settings.h"
+
+#ifdef GDSCRIPT_JIT_ENABLED
+
+#include "core/templates/local_vector.h"
+#include "core/variant/variant_internal.h"
+#include "gdscript_function.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+// Register numbers, as encoded in the instructions.
+enum Register {
+	RAX = 0,
+	RCX = 1,
+	RDX = 2,
+	RBX = 3,
+	RSP = 4,
+	RBP = 5,
+	RSI = 6,
+	RDI = 7,
+	R8 = 8,
+	R9 = 9,
+	R10 = 10,
+	R11 = 11,
+	R12 = 12,
+	R13 = 13,
+	R14 = 14,
+	R15 = 15,
+};
+
+// Callee-saved registers holding the arguments of the compiled function.
+const Register REG_STACK = RBX;
+const Register REG_MEMBERS = R12;
+const Register REG_RETURN = R13;
+const Register REG_LINE = R14;
+const Register REG_MEMBERS_VECTOR = R15;
+// Size of the instance members, to check the member addresses in debug builds.
+const Register REG_MEMBER_COUNT = RBP;
+
+// Calls with more arguments are left to the VM.
+const int MAX_CALL_ARGS = 8;
+
+// Low bits of the `Jcc` and `SETcc` opcodes. Flipping the lowest bit negates the condition.
+enum Condition {
+	COND_EQUAL = 0x4,
+	COND_NOT_EQUAL = 0x5,
+	COND_BELOW_EQUAL = 0x6,
+	COND_LESS = 0xC,
+	COND_GREATER_EQUAL = 0xD,
+	COND_LESS_EQUAL = 0xE,
+	COND_GREATER = 0xF,
+};
+
+Condition negate(Condition p_condition) {
+	return Condition(p_condition ^ 1);
+}
+
+// Only encodes the few instruction forms used by the templates. Memory operands
+// are always `[base + disp32]`.
+class Assembler {
+	LocalVector<uint8_t> code;
+
+	void _rex(bool p_wide, int p_reg, int p_base) {
+		uint8_t rex = 0x40 | (p_wide ? 0x08 : 0) | ((p_reg & 8) ? 0x04 : 0) | ((p_base & 8) ? 0x01 : 0);
+		if (rex != 0x40) {
+			byte(rex);
+		}
+	}
+
+	void _memory(int p_reg, Register p_base, int32_t p_offset) {
+		byte(0x80 | ((p_reg & 7) << 3) | (p_base & 7));
+		if ((p_base & 7) == RSP) {
+			// RSP and R12 need a SIB byte.
+			byte(0x24);
+		}
+		u32(p_offset);
+	}
+
+public:
+	void byte(uint8_t p_byte) {
+		code.push_back(p_byte);
+	}
+
+	void u32(uint32_t p_value) {
+		for (int i = 0; i < 4; i++) {
+			byte(p_value >> (i * 8));
+		}
+	}
+
+	void u64(uint64_t p_value) {
+		for (int i = 0; i < 8; i++) {
+			byte(p_value >> (i * 8));
+		}
+	}
+
+	uint32_t get_position() const {
+		return code.size();
+	}
+
+	const LocalVector<uint8_t> &get_code() const {
+		return code;
+	}
+
+	void push(Register p_reg) {
+		_rex(false, 0, p_reg);
+		byte(0x50 | (p_reg & 7));
+	}
+
+	void pop(Register p_reg) {
+		_rex(false, 0, p_reg);
+		byte(0x58 | (p_reg & 7));
+	}
+
+	void mov(Register p_dst, Register p_src) {
+		_rex(true, p_src, p_dst);
+		byte(0x89);
+		byte(0xC0 | ((p_src & 7) << 3) | (p_dst & 7));
+	}
+
+	// Zero-extended to 64 bits.
+	void mov_imm32(Register p_dst, uint32_t p_value) {
+		_rex(false, 0, p_dst);
+		byte(0xB8 | (p_dst & 7));
+		u32(p_value);
+	}
+
+	void mov_imm64(Register p_dst, uint64_t p_value) {
+		_rex(true, 0, p_dst);
+		byte(0xB8 | (p_dst & 7));
+		u64(p_value);
+	}
+
+	void lea(Register p_dst, Register p_base, int32_t p_offset) {
+		_rex(true, p_dst, p_base);
+		byte(0x8D);
+		_memory(p_dst, p_base, p_offset);
+	}
+
+	void load(Register p_dst, Register p_base, int32_t p_offset) {
+		_rex(true, p_dst, p_base);
+		byte(0x8B);
+		_memory(p_dst, p_base, p_offset);
+	}
+
+	void store(Register p_base, int32_t p_offset, Register p_src) {
+		_rex(true, p_src, p_base);
+		byte(0x89);
+		_memory(p_src, p_base, p_offset);
+	}
+
+	// Stores the low byte of RAX, RCX, RDX or RBX.
+	void store8(Register p_base, int32_t p_offset, Register p_src) {
+		_rex(false, p_src, p_base);
+		byte(0x88);
+		_memory(p_src, p_base, p_offset);
+	}
+
+	void store32_imm(Register p_base, int32_t p_offset, uint32_t p_value) {
+		_rex(false, 0, p_base);
+		byte(0xC7);
+		_memory(0, p_base, p_offset);
+		u32(p_value);
+	}
+
+	// `add` (0x03), `sub` (0x2B) or `cmp` (0x3B) of a register with memory.
+	void alu(uint8_t p_opcode, Register p_dst, Register p_base, int32_t p_offset) {
+		_rex(true, p_dst, p_base);
+		byte(p_opcode);
+		_memory(p_dst, p_base, p_offset);
+	}
+
+	void imul(Register p_dst, Register p_base, int32_t p_offset) {
+		_rex(true, p_dst, p_base);
+		byte(0x0F);
+		byte(0xAF);
+		_memory(p_dst, p_base, p_offset);
+	}
+
+	void cmp_imm32(Register p_reg, uint32_t p_value) {
+		_rex(true, 0, p_reg);
+		byte(0x81);
+		byte(0xF8 | (p_reg & 7));
+		u32(p_value);
+	}
+
+	void add_imm8(Register p_dst, int8_t p_value) {
+		_rex(true, 0, p_dst);
+		byte(0x83);
+		byte(0xC0 | (p_dst & 7));
+		byte(p_value);
+	}
+
+	void sub_imm8(Register p_dst, int8_t p_value) {
+		_rex(true, 0, p_dst);
+		byte(0x83);
+		byte(0xE8 | (p_dst & 7));
+		byte(p_value);
+	}
+
+	// Scalar double instruction between XMM0 and memory: `movsd` (0x10 to load,
+	// 0x11 to store), `addsd` (0x58), `mulsd` (0x59), `subsd` (0x5C) or `divsd` (0x5E).
+	void sse(uint8_t p_opcode, Register p_base, int32_t p_offset) {
+		byte(0xF2);
+		_rex(false, 0, p_base);
+		byte(0x0F);
+		byte(p_opcode);
+		_memory(0, p_base, p_offset);
+	}
+
+	// Sets the low byte of RAX, RCX, RDX or RBX.
+	void setcc(Condition p_condition, Register p_dst) {
+		byte(0x0F);
+		byte(0x90 | p_condition);
+		byte(0xC0 | p_dst);
+	}
+
+	// Tests the low byte of RAX, RCX, RDX or RBX.
+	void test8(Register p_reg) {
+		byte(0x84);
+		byte(0xC0 | (p_reg << 3) | p_reg);
+	}
+
+	template <class T>
+	void call(T p_function) {
+		mov_imm64(RAX, (uint64_t)p_function);
+		byte(0xFF);
+		byte(0xD0);
+	}
+
+	void ret() {
+		byte(0xC3);
+	}
+
+	// Jumps return the position of their offset, to bind them once the target is known.
+	uint32_t jump() {
+		byte(0xE9);
+		u32(0);
+		return code.size() - 4;
+	}
+
+	uint32_t jump(Condition p_condition) {
+		byte(0x0F);
+		byte(0x80 | p_condition);
+		u32(0);
+		return code.size() - 4;
+	}
+
+	void bind(uint32_t p_jump, uint32_t p_target) {
+		uint32_t offset = p_target - (p_jump + 4);
+		for (int i = 0; i < 4; i++) {
+			code[p_jump + i] = offset >> (i * 8);
+		}
+	}
+};
+
+// Helpers called by the templates, for what isn't worth inlining.
+
+Variant *_get_members(Vector<Variant> *p_members) {
+	return p_members ? p_members->ptrw() : nullptr;
+}
+
+#ifdef DEBUG_ENABLED
+int64_t _get_member_count(Vector<Variant> *p_members) {
+	return p_members ? p_members->size() : 0;
+}
+#endif
+
+bool _booleanize(const Variant *p_value) {
+	return p_value->booleanize();
+}
+
+void _assign(Variant *r_dst, const Variant *p_src) {
+	*r_dst = *p_src;
+}
+
+void _assign_bool(Variant *r_dst, bool p_value) {
+	*r_dst = p_value;
+}
+
+// Values of another type are converted by the VM.
+bool _assign_typed_builtin(Variant *r_dst, const Variant *p_src, int p_type) {
+	if (p_src->get_type() != p_type) {
+		return false;
+	}
+	*r_dst = *p_src;
+	return true;
+}
+
+// Out of bounds accesses are reported by the VM.
+bool _get_indexed(Variant::ValidatedIndexedGetter p_getter, const Variant *p_base, const Variant *p_index, Variant *r_value) {
+	bool oob;
+	p_getter(p_base, *VariantInternal::get_int(p_index), r_value, &oob);
+	return !oob;
+}
+
+bool _set_indexed(Variant::ValidatedIndexedSetter p_setter, Variant *p_base, const Variant *p_index, const Variant *p_value) {
+	bool oob;
+	p_setter(p_base, *VariantInternal::get_int(p_index), p_value, &oob);
+	return !oob;
+}
+
+// Null and freed bases are reported by the VM.
+bool _ptrcall(MethodBind *p_method, const Variant **p_args, int p_argc, Variant *p_base, Variant *r_ret, int p_type) {
+#ifdef DEBUG_ENABLED
+	bool freed = false;
+	Object *base_obj = p_base->get_validated_object_with_check(freed);
+	if (freed || !base_obj) {
+		return false;
+	}
+#else
+	Object *base_obj = *VariantInternal::get_object(p_base);
+#endif
+
+	const void *argptrs[MAX_CALL_ARGS];
+	for (int i = 0; i < p_argc; i++) {
+		argptrs[i] = VariantInternal::get_opaque_pointer(p_args[i]);
+	}
+
+	VariantInternal::initialize(r_ret, Variant::Type(p_type));
+	if (p_type == Variant::OBJECT) {
+		Object **ret_opaque = VariantInternal::get_object(r_ret);
+		p_method->ptrcall(base_obj, argptrs, ret_opaque);
+		VariantInternal::object_assign(r_ret, *ret_opaque); // Set so ID is correct too.
+	} else {
+		p_method->ptrcall(base_obj, argptrs, VariantInternal::get_opaque_pointer(r_ret));
+	}
+	return true;
+}
+
+bool _iterate_begin_int(Variant *r_counter, const Variant *p_size, Variant *r_iterator) {
+	int64_t size = *VariantInternal::get_int(p_size);
+
+	VariantInternal::initialize(r_counter, Variant::INT);
+	*VariantInternal::get_int(r_counter) = 0;
+
+	if (size > 0) {
+		VariantInternal::initialize(r_iterator, Variant::INT);
+		*VariantInternal::get_int(r_iterator) = 0;
+		return true;
+	}
+	return false;
+}
+
+template <class T>
+void _type_adjust(Variant *r_value) {
+	VariantTypeAdjust<T>::adjust(r_value);
+}
+
+typedef void (*TypeAdjust)(Variant *);
+
+TypeAdjust _get_type_adjust(int p_opcode) {
+#define JIT_TYPE_ADJUST(m_v_type, m_c_type)              \
+	case GDScriptFunction::OPCODE_TYPE_ADJUST_##m_v_type: \
+		return &_type_adjust<m_c_type>;
+
+	switch (p_opcode) {
+		JIT_TYPE_ADJUST(BOOL, bool);
+		JIT_TYPE_ADJUST(INT, int64_t);
+		JIT_TYPE_ADJUST(FLOAT, double);
+		JIT_TYPE_ADJUST(STRING, String);
+		JIT_TYPE_ADJUST(VECTOR2, Vector2);
+		JIT_TYPE_ADJUST(VECTOR2I, Vector2i);
+		JIT_TYPE_ADJUST(RECT2, Rect2);
+		JIT_TYPE_ADJUST(RECT2I, Rect2i);
+		JIT_TYPE_ADJUST(VECTOR3, Vector3);
+		JIT_TYPE_ADJUST(VECTOR3I, Vector3i);
+		JIT_TYPE_ADJUST(TRANSFORM2D, Transform2D);
+		JIT_TYPE_ADJUST(PLANE, Plane);
+		JIT_TYPE_ADJUST(QUATERNION, Quaternion);
+		JIT_TYPE_ADJUST(AABB, AABB);
+		JIT_TYPE_ADJUST(BASIS, Basis);
+		JIT_TYPE_ADJUST(TRANSFORM, Transform3D);
+		JIT_TYPE_ADJUST(COLOR, Color);
+		JIT_TYPE_ADJUST(STRING_NAME, StringName);
+		JIT_TYPE_ADJUST(NODE_PATH, NodePath);
+		JIT_TYPE_ADJUST(RID, RID);
+		JIT_TYPE_ADJUST(OBJECT, Object *);
+		JIT_TYPE_ADJUST(CALLABLE, Callable);
+		JIT_TYPE_ADJUST(SIGNAL, Signal);
+		JIT_TYPE_ADJUST(DICTIONARY, Dictionary);
+		JIT_TYPE_ADJUST(ARRAY, Array);
+		JIT_TYPE_ADJUST(PACKED_BYTE_ARRAY, PackedByteArray);
+		JIT_TYPE_ADJUST(PACKED_INT32_ARRAY, PackedInt32Array);
+		JIT_TYPE_ADJUST(PACKED_INT64_ARRAY, PackedInt64Array);
+		JIT_TYPE_ADJUST(PACKED_FLOAT32_ARRAY, PackedFloat32Array);
+		JIT_TYPE_ADJUST(PACKED_FLOAT64_ARRAY, PackedFloat64Array);
+		JIT_TYPE_ADJUST(PACKED_STRING_ARRAY, PackedStringArray);
+		JIT_TYPE_ADJUST(PACKED_VECTOR2_ARRAY, PackedVector2Array);
+		JIT_TYPE_ADJUST(PACKED_VECTOR3_ARRAY, PackedVector3Array);
+		JIT_TYPE_ADJUST(PACKED_COLOR_ARRAY, PackedColorArray);
+		default:
+			return nullptr;
+	}
+
+#undef JIT_TYPE_ADJUST
+}
+
+// Validated operators with a native template, working directly on the values inside the variants.
+enum NativeOperatorKind {
+	NATIVE_INT_ALU,
+	NATIVE_INT_MULTIPLY,
+	NATIVE_INT_COMPARE,
+	NATIVE_FLOAT,
+};
+
+struct NativeOperator {
+	Variant::Operator op;
+	Variant::Type type;
+	NativeOperatorKind kind;
+	uint8_t code;
+};
+
+const NativeOperator native_operators[] = {
+	{ Variant::OP_ADD, Variant::INT, NATIVE_INT_ALU, 0x03 },
+	{ Variant::OP_SUBTRACT, Variant::INT, NATIVE_INT_ALU, 0x2B },
+	{ Variant::OP_MULTIPLY, Variant::INT, NATIVE_INT_MULTIPLY, 0 },
+	{ Variant::OP_EQUAL, Variant::INT, NATIVE_INT_COMPARE, COND_EQUAL },
+	{ Variant::OP_NOT_EQUAL, Variant::INT, NATIVE_INT_COMPARE, COND_NOT_EQUAL },
+	{ Variant::OP_LESS, Variant::INT, NATIVE_INT_COMPARE, COND_LESS },
+	{ Variant::OP_LESS_EQUAL, Variant::INT, NATIVE_INT_COMPARE, COND_LESS_EQUAL },
+	{ Variant::OP_GREATER, Variant::INT, NATIVE_INT_COMPARE, COND_GREATER },
+	{ Variant::OP_GREATER_EQUAL, Variant::INT, NATIVE_INT_COMPARE, COND_GREATER_EQUAL },
+	{ Variant::OP_ADD, Variant::FLOAT, NATIVE_FLOAT, 0x58 },
+	{ Variant::OP_SUBTRACT, Variant::FLOAT, NATIVE_FLOAT, 0x5C },
+	{ Variant::OP_MULTIPLY, Variant::FLOAT, NATIVE_FLOAT, 0x59 },
+	{ Variant::OP_DIVIDE, Variant::FLOAT, NATIVE_FLOAT, 0x5E },
+};
+
+const NativeOperator *_find_native_operator(Variant::ValidatedOperatorEvaluator p_evaluator) {
+	for (uint32_t i = 0; i < sizeof(native_operators) / sizeof(native_operators[0]); i++) {
+		const NativeOperator &native = native_operators[i];
+		if (Variant::get_validated_operator_evaluator(native.op, native.type, native.type) == p_evaluator) {
+			return &native;
+		}
+	}
+	return nullptr;
+}
+
+static_assert(GDScriptFunction::OPCODE_CALL_PTRCALL_PACKED_COLOR_ARRAY - GDScriptFunction::OPCODE_CALL_PTRCALL_NO_RETURN == Variant::PACKED_COLOR_ARRAY, "The ptrcall opcodes must follow the order of the variant types.");
+
+} // namespace
+
+class GDScriptJIT::Compiler {
+	enum {
+		// Room for the argument pointers of calls, plus padding: the six saved registers
+		// and the return address leave the stack misaligned by 8 bytes.
+		FRAME_SIZE = MAX_CALL_ARGS * sizeof(Variant *) + 8,
+	};
+
+	struct Operand {
+		Register base = RAX;
+		int32_t offset = 0;
+	};
+
+	struct Jump {
+		uint32_t position = 0;
+		int address = 0;
+	};
+
+	const GDScriptFunction *function = nullptr;
+	const int *code = nullptr;
+	Assembler as;
+
+	int32_t data_offset = 0;
+
+	// Position of the template of each translated instruction, -1 for the others.
+	LocalVector<int32_t> labels;
+	// Jumps between instructions, bound once all the reachable code is translated.
+	LocalVector<Jump> jumps;
+	// Failed checks, bound to an exit to the VM at the instruction address.
+	LocalVector<Jump> exits;
+	LocalVector<int> pending;
+
+	int translated_count = 0;
+	bool uses_members = false;
+
+	bool _is_valid_address(int p_address) const {
+		int index = p_address & GDScriptFunction::ADDR_MASK;
+		switch ((p_address & GDScriptFunction::ADDR_TYPE_MASK) >> GDScriptFunction::ADDR_BITS) {
+			case GDScriptFunction::ADDR_TYPE_STACK:
+				return index < function->_stack_size;
+			case GDScriptFunction::ADDR_TYPE_CONSTANT:
+				return index < function->_constant_count;
+			case GDScriptFunction::ADDR_TYPE_MEMBER:
+				// The size of the members is only known when running, see `_check_members()`.
+				return true;
+		}
+		return false;
+	}
+
+	bool _is_valid_target(int p_address) const {
+		return p_address >= 0 && p_address <= function->_code_size;
+	}
+
+	// Constants are at a fixed address, loaded into the scratch register.
+	Operand _get_operand(int p_address, Register p_scratch) {
+		int index = p_address & GDScriptFunction::ADDR_MASK;
+		Operand operand;
+		switch ((p_address & GDScriptFunction::ADDR_TYPE_MASK) >> GDScriptFunction::ADDR_BITS) {
+			case GDScriptFunction::ADDR_TYPE_STACK: {
+				operand.base = REG_STACK;
+				operand.offset = index * sizeof(Variant);
+			} break;
+			case GDScriptFunction::ADDR_TYPE_MEMBER: {
+				uses_members = true;
+				operand.base = REG_MEMBERS;
+				operand.offset = index * sizeof(Variant);
+			} break;
+			default: {
+				as.mov_imm64(p_scratch, (uint64_t)&function->_constants_ptr[index]);
+				operand.base = p_scratch;
+			} break;
+		}
+		return operand;
+	}
+
+	void _load_address(Register p_reg, int p_address) {
+		Operand operand = _get_operand(p_address, p_reg);
+		if (operand.base != p_reg) {
+			as.lea(p_reg, operand.base, operand.offset);
+		}
+	}
+
+	// Calls that can run scripts may reallocate the instance members.
+	void _reload_members() {
+		as.mov(RDI, REG_MEMBERS_VECTOR);
+		as.call(&_get_members);
+		as.mov(REG_MEMBERS, RAX);
+#ifdef DEBUG_ENABLED
+		as.mov(RDI, REG_MEMBERS_VECTOR);
+		as.call(&_get_member_count);
+		as.mov(REG_MEMBER_COUNT, RAX);
+#endif
+	}
+
+	// Leaves the instructions accessing members out of bounds to the VM.
+	void _check_members(int p_ip, int p_argc) {
+#ifdef DEBUG_ENABLED
+		int max_index = -1;
+		for (int i = 0; i < p_argc; i++) {
+			int address = code[p_ip + 1 + i];
+			if (((address & GDScriptFunction::ADDR_TYPE_MASK) >> GDScriptFunction::ADDR_BITS) == GDScriptFunction::ADDR_TYPE_MEMBER) {
+				max_index = MAX(max_index, address & GDScriptFunction::ADDR_MASK);
+			}
+		}
+		if (max_index != -1) {
+			as.cmp_imm32(REG_MEMBER_COUNT, max_index);
+			_exit_if(COND_BELOW_EQUAL, p_ip);
+		}
+#endif
+	}
+
+	void _emit_epilogue() {
+		as.add_imm8(RSP, FRAME_SIZE);
+		as.pop(REG_MEMBER_COUNT);
+		as.pop(REG_MEMBERS_VECTOR);
+		as.pop(REG_LINE);
+		as.pop(REG_RETURN);
+		as.pop(REG_MEMBERS);
+		as.pop(REG_STACK);
+		as.ret();
+	}
+
+	void _emit_exit(int p_address) {
+		as.mov_imm32(RAX, p_address);
+		_emit_epilogue();
+	}
+
+	void _jump_to(int p_address) {
+		jumps.push_back({ as.jump(), p_address });
+		pending.push_back(p_address);
+	}
+
+	void _jump_to(Condition p_condition, int p_address) {
+		jumps.push_back({ as.jump(p_condition), p_address });
+		pending.push_back(p_address);
+	}
+
+	void _exit_if(Condition p_condition, int p_address) {
+		exits.push_back({ as.jump(p_condition), p_address });
+	}
+
+	// Fills the array of argument pointers of validated calls, at the bottom of the frame.
+	void _emit_call_arguments(int p_ip, int p_argc) {
+		for (int i = 0; i < p_argc; i++) {
+			_load_address(RAX, code[p_ip + 1 + i]);
+			as.store(RSP, i * sizeof(Variant *), RAX);
+		}
+	}
+
+	// Returns true and sets the condition when the result was compared natively,
+	// in which case the condition is also left in the CPU flags.
+	bool _emit_operator(int p_ip, Condition &r_condition) {
+		Variant::ValidatedOperatorEvaluator evaluator = function->_operator_funcs_ptr[code[p_ip + 4]];
+		const NativeOperator *native = _find_native_operator(evaluator);
+
+		if (!native) {
+			_load_address(RDI, code[p_ip + 1]);
+			_load_address(RSI, code[p_ip + 2]);
+			_load_address(RDX, code[p_ip + 3]);
+			as.call(evaluator);
+			_reload_members();
+			return false;
+		}
+
+		Operand a = _get_operand(code[p_ip + 1], RDI);
+		Operand b = _get_operand(code[p_ip + 2], RSI);
+		Operand dst = _get_operand(code[p_ip + 3], RDX);
+
+		switch (native->kind) {
+			case NATIVE_INT_ALU: {
+				as.load(RAX, a.base, a.offset + data_offset);
+				as.alu(native->code, RAX, b.base, b.offset + data_offset);
+				as.store(dst.base, dst.offset + data_offset, RAX);
+			} break;
+			case NATIVE_INT_MULTIPLY: {
+				as.load(RAX, a.base, a.offset + data_offset);
+				as.imul(RAX, b.base, b.offset + data_offset);
+				as.store(dst.base, dst.offset + data_offset, RAX);
+			} break;
+			case NATIVE_INT_COMPARE: {
+				r_condition = Condition(native->code);
+				as.load(RAX, a.base, a.offset + data_offset);
+				as.alu(0x3B, RAX, b.base, b.offset + data_offset);
+				as.setcc(r_condition, RAX);
+				as.store8(dst.base, dst.offset + data_offset, RAX);
+				return true;
+			}
+			case NATIVE_FLOAT: {
+				as.sse(0x10, a.base, a.offset + data_offset);
+				as.sse(native->code, b.base, b.offset + data_offset);
+				as.sse(0x11, dst.base, dst.offset + data_offset);
+			} break;
+		}
+		return false;
+	}
+
+	// Returns the address of the next instruction, or -1 when the execution can't
+	// continue there (jumps, returns and exits to the VM).
+	int _translate_instruction(int p_ip) {
+		int opcode = code[p_ip] & GDScriptFunction::INSTR_MASK;
+		int argc = (code[p_ip] & GDScriptFunction::INSTR_ARGS_MASK) >> GDScriptFunction::INSTR_BITS;
+		int remaining = function->_code_size - p_ip;
+
+		bool valid = argc < remaining;
+		for (int i = 0; valid && i < argc; i++) {
+			valid = _is_valid_address(code[p_ip + 1 + i]);
+		}
+		if (!valid) {
+			_emit_exit(p_ip);
+			return -1;
+		}
+		_check_members(p_ip, argc);
+
+		switch (opcode) {
+			case GDScriptFunction::OPCODE_OPERATOR_VALIDATED: {
+				if (argc != 3 || remaining < 5 || code[p_ip + 4] < 0 || code[p_ip + 4] >= function->_operator_funcs_count) {
+					break;
+				}
+				Condition condition = COND_NOT_EQUAL;
+				_emit_operator(p_ip, condition);
+				translated_count++;
+				return p_ip + 5;
+			}
+			case GDScriptFunction::OPCODE_OPERATOR_VALIDATED_JUMP_IF_NOT: {
+				if (argc != 3 || remaining < 6 || code[p_ip + 4] < 0 || code[p_ip + 4] >= function->_operator_funcs_count || !_is_valid_target(code[p_ip + 5])) {
+					break;
+				}
+				Condition condition = COND_NOT_EQUAL;
+				if (!_emit_operator(p_ip, condition)) {
+					_load_address(RDI, code[p_ip + 3]);
+					as.call(&_booleanize);
+					as.test8(RAX);
+					condition = COND_NOT_EQUAL;
+				}
+				_jump_to(negate(condition), code[p_ip + 5]);
+				translated_count++;
+				return p_ip + 6;
+			}
+			case GDScriptFunction::OPCODE_SET_INDEXED_VALIDATED:
+			case GDScriptFunction::OPCODE_GET_INDEXED_VALIDATED: {
+				if (argc != 3 || remaining < 5) {
+					break;
+				}
+				int index = code[p_ip + 4];
+				if (opcode == GDScriptFunction::OPCODE_SET_INDEXED_VALIDATED) {
+					if (index < 0 || index >= function->_indexed_setters_count) {
+						break;
+					}
+					as.mov_imm64(RDI, (uint64_t)function->_indexed_setters_ptr[index]);
+					_load_address(RSI, code[p_ip + 1]);
+					_load_address(RDX, code[p_ip + 2]);
+					_load_address(RCX, code[p_ip + 3]);
+					as.call(&_set_indexed);
+				} else {
+					if (index < 0 || index >= function->_indexed_getters_count) {
+						break;
+					}
+					as.mov_imm64(RDI, (uint64_t)function->_indexed_getters_ptr[index]);
+					_load_address(RSI, code[p_ip + 1]);
+					_load_address(RDX, code[p_ip + 2]);
+					_load_address(RCX, code[p_ip + 3]);
+					as.call(&_get_indexed);
+				}
+				as.test8(RAX);
+				_exit_if(COND_EQUAL, p_ip);
+				translated_count++;
+				return p_ip + 5;
+			}
+			case GDScriptFunction::OPCODE_SET_NAMED_VALIDATED:
+			case GDScriptFunction::OPCODE_GET_NAMED_VALIDATED: {
+				if (argc != 2 || remaining < 4) {
+					break;
+				}
+				int index = code[p_ip + 3];
+				bool setter = opcode == GDScriptFunction::OPCODE_SET_NAMED_VALIDATED;
+				if (index < 0 || index >= (setter ? function->_setters_count : function->_getters_count)) {
+					break;
+				}
+				_load_address(RDI, code[p_ip + 1]);
+				_load_address(RSI, code[p_ip + 2]);
+				if (setter) {
+					as.call(function->_setters_ptr[index]);
+				} else {
+					as.call(function->_getters_ptr[index]);
+				}
+				translated_count++;
+				return p_ip + 4;
+			}
+			case GDScriptFunction::OPCODE_ASSIGN: {
+				if (argc != 2 || remaining < 3) {
+					break;
+				}
+				_load_address(RDI, code[p_ip + 1]);
+				_load_address(RSI, code[p_ip + 2]);
+				as.call(&_assign);
+				translated_count++;
+				return p_ip + 3;
+			}
+			case GDScriptFunction::OPCODE_ASSIGN_TRUE:
+			case GDScriptFunction::OPCODE_ASSIGN_FALSE: {
+				if (argc != 1 || remaining < 2) {
+					break;
+				}
+				_load_address(RDI, code[p_ip + 1]);
+				as.mov_imm32(RSI, opcode == GDScriptFunction::OPCODE_ASSIGN_TRUE);
+				as.call(&_assign_bool);
+				translated_count++;
+				return p_ip + 2;
+			}
+			case GDScriptFunction::OPCODE_ASSIGN_TYPED_BUILTIN: {
+				if (argc != 2 || remaining < 4) {
+					break;
+				}
+				_load_address(RDI, code[p_ip + 1]);
+				_load_address(RSI, code[p_ip + 2]);
+				as.mov_imm32(RDX, code[p_ip + 3]);
+				as.call(&_assign_typed_builtin);
+				as.test8(RAX);
+				_exit_if(COND_EQUAL, p_ip);
+				translated_count++;
+				return p_ip + 4;
+			}
+			case GDScriptFunction::OPCODE_CONSTRUCT_VALIDATED: {
+				// Arguments, then the destination.
+				if (argc < 1 || remaining < argc + 3) {
+					break;
+				}
+				int call_argc = code[p_ip + argc + 1];
+				int index = code[p_ip + argc + 2];
+				if (call_argc != argc - 1 || call_argc > MAX_CALL_ARGS || index < 0 || index >= function->_constructors_count) {
+					break;
+				}
+				_emit_call_arguments(p_ip, call_argc);
+				_load_address(RDI, code[p_ip + argc]);
+				as.mov(RSI, RSP);
+				as.call(function->_constructors_ptr[index]);
+				_reload_members();
+				translated_count++;
+				return p_ip + argc + 3;
+			}
+			case GDScriptFunction::OPCODE_CALL_BUILTIN_TYPE_VALIDATED: {
+				// Arguments, then the base and the destination.
+				if (argc < 2 || remaining < argc + 3) {
+					break;
+				}
+				int call_argc = code[p_ip + argc + 1];
+				int index = code[p_ip + argc + 2];
+				if (call_argc != argc - 2 || call_argc > MAX_CALL_ARGS || index < 0 || index >= function->_builtin_methods_count) {
+					break;
+				}
+				_emit_call_arguments(p_ip, call_argc);
+				_load_address(RDI, code[p_ip + argc - 1]);
+				as.mov(RSI, RSP);
+				as.mov_imm32(RDX, call_argc);
+				_load_address(RCX, code[p_ip + argc]);
+				as.call(function->_builtin_methods_ptr[index]);
+				_reload_members();
+				translated_count++;
+				return p_ip + argc + 3;
+			}
+			case GDScriptFunction::OPCODE_CALL_UTILITY_VALIDATED: {
+				// Arguments, then the destination.
+				if (argc < 1 || remaining < argc + 3) {
+					break;
+				}
+				int call_argc = code[p_ip + argc + 1];
+				int index = code[p_ip + argc + 2];
+				if (call_argc != argc - 1 || call_argc > MAX_CALL_ARGS || index < 0 || index >= function->_utilities_count) {
+					break;
+				}
+				_emit_call_arguments(p_ip, call_argc);
+				_load_address(RDI, code[p_ip + argc]);
+				as.mov(RSI, RSP);
+				as.mov_imm32(RDX, call_argc);
+				as.call(function->_utilities_ptr[index]);
+				_reload_members();
+				translated_count++;
+				return p_ip + argc + 3;
+			}
+			case GDScriptFunction::OPCODE_CALL_PTRCALL_NO_RETURN:
+			case GDScriptFunction::OPCODE_CALL_PTRCALL_BOOL:
+			case GDScriptFunction::OPCODE_CALL_PTRCALL_INT:
+			case GDScriptFunction::OPCODE_CALL_PTRCALL_FLOAT:
+			case GDScriptFunction::OPCODE_CALL_PTRCALL_STRING:
+			case GDScriptFunction::OPCODE_CALL_PTRCALL_VECTOR2:
+			case GDScriptFunction::OPCODE_CALL_PTRCALL_VECTOR2I:
+			case GDScriptFunction::OPCODE_CALL_PTRCALL_RECT2:
+			case GDScriptFunction::OPCODE_CALL_PTRCALL_RECT2I:
+			case GDScriptFunction::OPCODE_CALL_PTRCALL_VECTOR3:
+			case GDScriptFunction::OPCODE_CALL_PTRCALL_VECTOR3I:
+			case GDScriptFunction::OPCODE_CALL_PTRCALL_TRANSFORM2D:
+			case GDScriptFunction::OPCODE_CALL_PTRCALL_PLANE:
+			case GDScriptFunction::OPCODE_CALL_PTRCALL_QUATERNION:
+			case GDScriptFunction::OPCODE_CALL_PTRCALL_AABB:
+			case GDScriptFunction::OPCODE_CALL_PTRCALL_BASIS:
+			case GDScriptFunction::OPCODE_CALL_PTRCALL_TRANSFORM3D:
+			case GDScriptFunction::OPCODE_CALL_PTRCALL_COLOR:
+			case GDScriptFunction::OPCODE_CALL_PTRCALL_STRING_NAME:
+			case GDScriptFunction::OPCODE_CALL_PTRCALL_NODE_PATH:
+			case GDScriptFunction::OPCODE_CALL_PTRCALL_RID:
+			case GDScriptFunction::OPCODE_CALL_PTRCALL_OBJECT:
+			case GDScriptFunction::OPCODE_CALL_PTRCALL_CALLABLE:
+			case GDScriptFunction::OPCODE_CALL_PTRCALL_SIGNAL:
+			case GDScriptFunction::OPCODE_CALL_PTRCALL_DICTIONARY:
+			case GDScriptFunction::OPCODE_CALL_PTRCALL_ARRAY:
+			case GDScriptFunction::OPCODE_CALL_PTRCALL_PACKED_BYTE_ARRAY:
+			case GDScriptFunction::OPCODE_CALL_PTRCALL_PACKED_INT32_ARRAY:
+			case GDScriptFunction::OPCODE_CALL_PTRCALL_PACKED_INT64_ARRAY:
+			case GDScriptFunction::OPCODE_CALL_PTRCALL_PACKED_FLOAT32_ARRAY:
+			case GDScriptFunction::OPCODE_CALL_PTRCALL_PACKED_FLOAT64_ARRAY:
+			case GDScriptFunction::OPCODE_CALL_PTRCALL_PACKED_STRING_ARRAY:
+			case GDScriptFunction::OPCODE_CALL_PTRCALL_PACKED_VECTOR2_ARRAY:
+			case GDScriptFunction::OPCODE_CALL_PTRCALL_PACKED_VECTOR3_ARRAY:
+			case GDScriptFunction::OPCODE_CALL_PTRCALL_PACKED_COLOR_ARRAY: {
+				// Arguments, then the base and the destination.
+				if (argc < 2 || remaining < argc + 3) {
+					break;
+				}
+				int call_argc = code[p_ip + argc + 1];
+				int index = code[p_ip + argc + 2];
+				if (call_argc != argc - 2 || call_argc > MAX_CALL_ARGS || index < 0 || index >= function->_methods_count) {
+					break;
+				}
+				_emit_call_arguments(p_ip, call_argc);
+				as.mov_imm64(RDI, (uint64_t)function->_methods_ptr[index]);
+				as.mov(RSI, RSP);
+				as.mov_imm32(RDX, call_argc);
+				_load_address(RCX, code[p_ip + argc - 1]);
+				_load_address(R8, code[p_ip + argc]);
+				// The return types follow the order of the variant types.
+				as.mov_imm32(R9, opcode - GDScriptFunction::OPCODE_CALL_PTRCALL_NO_RETURN);
+				as.call(&_ptrcall);
+				as.test8(RAX);
+				_exit_if(COND_EQUAL, p_ip);
+				_reload_members();
+				translated_count++;
+				return p_ip + argc + 3;
+			}
+			case GDScriptFunction::OPCODE_JUMP: {
+				if (argc != 0 || remaining < 2 || !_is_valid_target(code[p_ip + 1])) {
+					break;
+				}
+				_jump_to(code[p_ip + 1]);
+				return -1;
+			}
+			case GDScriptFunction::OPCODE_JUMP_IF:
+			case GDScriptFunction::OPCODE_JUMP_IF_NOT: {
+				if (argc != 1 || remaining < 3 || !_is_valid_target(code[p_ip + 2])) {
+					break;
+				}
+				_load_address(RDI, code[p_ip + 1]);
+				as.call(&_booleanize);
+				as.test8(RAX);
+				_jump_to(opcode == GDScriptFunction::OPCODE_JUMP_IF ? COND_NOT_EQUAL : COND_EQUAL, code[p_ip + 2]);
+				return p_ip + 3;
+			}
+			case GDScriptFunction::OPCODE_JUMP_TO_DEF_ARGUMENT: {
+				// Compiled code only runs when all the arguments are passed.
+				if (!function->_default_arg_ptr || !_is_valid_target(function->_default_arg_ptr[0])) {
+					break;
+				}
+				_jump_to(function->_default_arg_ptr[0]);
+				return -1;
+			}
+			case GDScriptFunction::OPCODE_RETURN: {
+				if (argc != 1 || remaining < 2) {
+					break;
+				}
+				as.mov(RDI, REG_RETURN);
+				_load_address(RSI, code[p_ip + 1]);
+				as.call(&_assign);
+				_emit_exit(function->_code_size - 1);
+				translated_count++;
+				return -1;
+			}
+			case GDScriptFunction::OPCODE_RETURN_TYPED_BUILTIN: {
+				if (argc != 1 || remaining < 3) {
+					break;
+				}
+				as.mov(RDI, REG_RETURN);
+				_load_address(RSI, code[p_ip + 1]);
+				as.mov_imm32(RDX, code[p_ip + 2]);
+				as.call(&_assign_typed_builtin);
+				as.test8(RAX);
+				_exit_if(COND_EQUAL, p_ip);
+				_emit_exit(function->_code_size - 1);
+				translated_count++;
+				return -1;
+			}
+			case GDScriptFunction::OPCODE_ITERATE_BEGIN_INT: {
+				if (argc != 3 || remaining < 5 || !_is_valid_target(code[p_ip + 4])) {
+					break;
+				}
+				_load_address(RDI, code[p_ip + 1]);
+				_load_address(RSI, code[p_ip + 2]);
+				_load_address(RDX, code[p_ip + 3]);
+				as.call(&_iterate_begin_int);
+				as.test8(RAX);
+				_jump_to(COND_EQUAL, code[p_ip + 4]);
+				translated_count++;
+				return p_ip + 5;
+			}
+			case GDScriptFunction::OPCODE_ITERATE_INT: {
+				if (argc != 3 || remaining < 5 || !_is_valid_target(code[p_ip + 4])) {
+					break;
+				}
+				Operand counter = _get_operand(code[p_ip + 1], RDI);
+				Operand size = _get_operand(code[p_ip + 2], RSI);
+				Operand iterator = _get_operand(code[p_ip + 3], RDX);
+				as.load(RAX, counter.base, counter.offset + data_offset);
+				as.add_imm8(RAX, 1);
+				as.store(counter.base, counter.offset + data_offset, RAX);
+				as.alu(0x3B, RAX, size.base, size.offset + data_offset);
+				_jump_to(COND_GREATER_EQUAL, code[p_ip + 4]);
+				as.store(iterator.base, iterator.offset + data_offset, RAX);
+				translated_count++;
+				return p_ip + 5;
+			}
+			case GDScriptFunction::OPCODE_ASSERT: {
+				if (argc != 2 || remaining < 3) {
+					break;
+				}
+#ifdef DEBUG_ENABLED
+				// Failed assertions are reported by the VM.
+				_load_address(RDI, code[p_ip + 1]);
+				as.call(&_booleanize);
+				as.test8(RAX);
+				_exit_if(COND_EQUAL, p_ip);
+#endif
+				return p_ip + 3;
+			}
+			case GDScriptFunction::OPCODE_LINE: {
+				if (argc != 0 || remaining < 2) {
+					break;
+				}
+				as.store32_imm(REG_LINE, 0, code[p_ip + 1]);
+				return p_ip + 2;
+			}
+			default: {
+				TypeAdjust adjust = _get_type_adjust(opcode);
+				if (!adjust || argc != 1 || remaining < 2) {
+					break;
+				}
+				_load_address(RDI, code[p_ip + 1]);
+				as.call(adjust);
+				translated_count++;
+				return p_ip + 2;
+			}
+		}
+
+		_emit_exit(p_ip);
+		return -1;
+	}
+
+	// Translates the instructions from the address until the execution can't continue.
+	void _translate(int p_address) {
+		int ip = p_address;
+		while (ip != -1) {
+			if (labels[ip] != -1) {
+				// Already translated, continue there.
+				if (ip != p_address) {
+					_jump_to(ip);
+				}
+				return;
+			}
+			labels[ip] = as.get_position();
+
+			if (ip == function->_code_size) {
+				_emit_exit(ip);
+				return;
+			}
+			ip = _translate_instruction(ip);
+		}
+	}
+
+public:
+	Compiler(const GDScriptFunction *p_function) {
+		function = p_function;
+		code = p_function->_code_ptr;
+
+		Variant variant;
+		data_offset = (uint8_t *)VariantInternal::get_int(&variant) - (uint8_t *)&variant;
+	}
+
+	// Returns false if nothing worth running natively was translated.
+	bool compile() {
+		labels.resize(function->_code_size + 1);
+		for (uint32_t i = 0; i < labels.size(); i++) {
+			labels[i] = -1;
+		}
+
+		as.push(REG_STACK);
+		as.push(REG_MEMBERS);
+		as.push(REG_RETURN);
+		as.push(REG_LINE);
+		as.push(REG_MEMBERS_VECTOR);
+		as.push(REG_MEMBER_COUNT);
+		as.sub_imm8(RSP, FRAME_SIZE);
+		as.mov(REG_STACK, RDI);
+		as.mov(REG_MEMBERS_VECTOR, RSI);
+		as.mov(REG_RETURN, RDX);
+		as.mov(REG_LINE, RCX);
+		_reload_members();
+
+		pending.push_back(0);
+		while (pending.size()) {
+			int address = pending[pending.size() - 1];
+			pending.resize(pending.size() - 1);
+			_translate(address);
+		}
+
+		for (uint32_t i = 0; i < jumps.size(); i++) {
+			as.bind(jumps[i].position, labels[jumps[i].address]);
+		}
+		for (uint32_t i = 0; i < exits.size(); i++) {
+			as.bind(exits[i].position, as.get_position());
+			_emit_exit(exits[i].address);
+		}
+
+		return translated_count > 0;
+	}
+
+	bool is_using_members() const {
+		return uses_members;
+	}
+
+	const LocalVector<uint8_t> &get_code() const {
+		return as.get_code();
+	}
+};
+
+#endif // GDSCRIPT_JIT_ENABLED
+
+bool GDScriptJIT::is_enabled() {
+#ifdef GDSCRIPT_JIT_ENABLED
+	return GLOBAL_GET("debug/gdscript/compiler/enable_jit");
+#else
+	return false;
+#endif
+}
+
+void GDScriptJIT::compile(GDScriptFunction *p_function) {
+#ifdef GDSCRIPT_JIT_ENABLED
+	clear(p_function);
+
+	if (!p_function->_code_ptr || p_function->_code_size == 0 || (p_function->_code_ptr[p_function->_code_size - 1] & GDScriptFunction::INSTR_MASK) != GDScriptFunction::OPCODE_END) {
+		return;
+	}
+
+	Compiler compiler(p_function);
+	if (!compiler.compile()) {
+		return;
+	}
+
+	const LocalVector<uint8_t> &code = compiler.get_code();
+	const size_t page_size = sysconf(_SC_PAGESIZE);
+	const size_t size = ((code.size() + page_size - 1) / page_size) * page_size;
+
+	void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	ERR_FAIL_COND_MSG(memory == MAP_FAILED, "Couldn't allocate memory for the compiled GDScript function.");
+	memcpy(memory, code.ptr(), code.size());
+	if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+		munmap(memory, size);
+		ERR_FAIL_MSG("Couldn't make the compiled GDScript function executable.");
+	}
+
+	p_function->_jit_function = (Function)memory;
+	p_function->_jit_code_size = size;
+	p_function->_jit_uses_members = compiler.is_using_members();
+#endif
+}
+
+void GDScriptJIT::clear(GDScriptFunction *p_function) {
+#ifdef GDSCRIPT_JIT_ENABLED
+	if (p_function->_jit_function) {
+		munmap((void *)p_function->_jit_function, p_function->_jit_code_size);
+	}
+#endif
+	p_function->_jit_function = nullptr;
+	p_function->_jit_code_size = 0;
+	p_function->_jit_uses_members = false;
+}
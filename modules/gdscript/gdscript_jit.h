@@ -1,5 +1,5 @@
 /*************************************************************************/
-/*  thread_work_pool.cpp                                                 */
+/*  gdscript_jit.h                                                       */
 /*************************************************************************/
 /*                       This file is part of:                           */
 /*                           GODOT ENGINE                                */
@@ -28,54 +28,38 @@
 /* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
 /*************************************************************************/
 
-#include "thread_work_pool.h"
+#ifndef GDSCRIPT_JIT_H
+#define GDSCRIPT_JIT_H
 
-#include "core/os/os.h"
+#include "core/typedefs.h"
 
-void ThreadWorkPool::_thread_function(void *p_user) {
-	ThreadData *thread = static_cast<ThreadData *>(p_user);
-	while (true) {
-		thread->start.wait();
-		if (thread->exit.load()) {
-			break;
-		}
-		thread->work->work();
-		thread->completed.post();
-	}
-}
+#if defined(__x86_64__) && defined(__linux__)
+#define GDSCRIPT_JIT_ENABLED
+#endif
 
-void ThreadWorkPool::init(int p_thread_count) {
-	ERR_FAIL_COND(threads != nullptr);
-	if (p_thread_count < 0) {
-		p_thread_count = OS::get_singleton()->get_processor_count();
-	}
+class GDScriptFunction;
+class Variant;
+template <class T>
+class Vector;
 
-	thread_count = p_thread_count;
-	threads = memnew_arr(ThreadData, thread_count);
+// Baseline compiler turning the bytecode of a function into x86-64 machine code.
+// Each instruction is translated to its own code template, which works on the
+// same stack as the VM. Instructions that aren't translated (and failed checks
+// of the translated ones) hand the execution back to the VM at that address,
+// so the compiled code never has to support the whole instruction set.
+class GDScriptJIT {
+	class Compiler;
 
-	for (uint32_t i = 0; i < thread_count; i++) {
-		threads[i].exit.store(false);
-		threads[i].thread.start(&ThreadWorkPool::_thread_function, &threads[i]);
-	}
-}
+public:
+	// Runs the function from its first instruction, and returns the address
+	// where the VM must continue. When the function returned, that's the
+	// address of the final `OPCODE_END`.
+	typedef int (*Function)(Variant *p_stack, Vector<Variant> *p_members, Variant *r_return, int *r_line);
 
-void ThreadWorkPool::finish() {
-	if (threads == nullptr) {
-		return;
-	}
+	static bool is_enabled();
 
-	for (uint32_t i = 0; i < thread_count; i++) {
-		threads[i].exit.store(true);
-		threads[i].start.post();
-	}
-	for (uint32_t i = 0; i < thread_count; i++) {
-		threads[i].thread.wait_to_finish();
-	}
+	static void compile(GDScriptFunction *p_function);
+	static void clear(GDScriptFunction *p_function);
+};
 
-	memdelete_arr(threads);
-	threads = nullptr;
-}
-
-ThreadWorkPool::~ThreadWorkPool() {
-	finish();
-}
+#endif // GDSCRIPT_JIT_H
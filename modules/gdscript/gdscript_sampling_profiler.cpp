@@ -0,0 +1,190 @@
+/*************************************************************************/
+/*  gdscript_sampling_profiler.cpp                                       */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "gdscript_sampling_profiler.h"
+
+#include "core/config/project_settings.h"
+#include "core/debugger/engine_debugger.h"
+#include "core/io/file_access.h"
+#include "core/os/os.h"
+#include "gdscript_function.h"
+
+SafeFlag GDScriptSamplingProfiler::sampling;
+SafeFlag GDScriptSamplingProfiler::sampler_running;
+SafeNumeric<uint32_t> GDScriptSamplingProfiler::ticks;
+uint32_t GDScriptSamplingProfiler::interval_usec = 1000;
+Thread GDScriptSamplingProfiler::sampler_thread;
+
+Mutex GDScriptSamplingProfiler::stacks_mutex;
+HashMap<String, uint64_t> GDScriptSamplingProfiler::stacks;
+
+thread_local GDScriptSamplingProfiler::ThreadState GDScriptSamplingProfiler::thread_state;
+
+void GDScriptSamplingProfiler::_sampler_thread_func(void *p_userdata) {
+	while (sampler_running.is_set()) {
+		OS::get_singleton()->delay_usec(interval_usec);
+		ticks.increment();
+	}
+}
+
+void GDScriptSamplingProfiler::_take_sample() {
+	ThreadState &state = thread_state;
+	const uint32_t tick = ticks.get();
+	// Counts the ticks missed while running native code, so long calls keep their weight.
+	const uint32_t weight = tick - state.last_tick;
+	state.last_tick = tick;
+
+	if (state.frames.is_empty()) {
+		return;
+	}
+
+	String stack;
+	for (uint32_t i = 0; i < state.frames.size(); i++) {
+		const Frame &frame = state.frames[i];
+		String source = frame.function->get_source();
+		if (source.is_empty()) {
+			source = "<built-in>";
+		}
+		if (i > 0) {
+			stack += ";";
+		}
+		stack += source + ":" + String(frame.function->get_name()) + ":" + itos(*frame.line);
+	}
+
+	MutexLock lock(stacks_mutex);
+	uint64_t *count = stacks.getptr(stack);
+	if (count) {
+		*count += weight;
+	} else {
+		stacks.set(stack, weight);
+	}
+}
+
+void GDScriptSamplingProfiler::_profiler_toggle(void *p_user, bool p_enable, const Array &p_opts) {
+	if (p_enable) {
+		clear();
+		start(p_opts.size() > 0 ? int(p_opts[0]) : int(GLOBAL_GET("debug/gdscript/sampling_profiler/interval_usec")));
+	} else {
+		stop();
+		if (EngineDebugger::get_singleton()) {
+			Array data;
+			data.push_back(get_folded_stacks());
+			EngineDebugger::get_singleton()->send_message("gdscript_sampler:stacks", data);
+		}
+	}
+}
+
+void GDScriptSamplingProfiler::push(const GDScriptFunction *p_function, const int *p_line) {
+	ThreadState &state = thread_state;
+	if (state.frames.is_empty()) {
+		// Time spent outside of scripts isn't attributed to them.
+		state.last_tick = ticks.get();
+	}
+	Frame frame;
+	frame.function = p_function;
+	frame.line = p_line;
+	state.frames.push_back(frame);
+}
+
+void GDScriptSamplingProfiler::pop() {
+	ThreadState &state = thread_state;
+	ERR_FAIL_COND(state.frames.is_empty());
+	state.frames.resize(state.frames.size() - 1);
+}
+
+void GDScriptSamplingProfiler::start(uint32_t p_interval_usec) {
+	ERR_FAIL_COND_MSG(p_interval_usec == 0, "The sampling interval must be greater than zero.");
+	stop();
+
+	interval_usec = p_interval_usec;
+	sampler_running.set();
+	sampler_thread.start(_sampler_thread_func, nullptr);
+	sampling.set();
+}
+
+void GDScriptSamplingProfiler::start_manual() {
+	stop();
+	sampling.set();
+}
+
+void GDScriptSamplingProfiler::tick() {
+	ticks.increment();
+}
+
+void GDScriptSamplingProfiler::stop() {
+	sampling.clear();
+	if (!sampler_running.is_set()) {
+		return;
+	}
+	sampler_running.clear();
+	sampler_thread.wait_to_finish();
+}
+
+void GDScriptSamplingProfiler::clear() {
+	MutexLock lock(stacks_mutex);
+	stacks.clear();
+}
+
+String GDScriptSamplingProfiler::get_folded_stacks() {
+	Vector<String> lines;
+	{
+		MutexLock lock(stacks_mutex);
+		const String *key = nullptr;
+		while ((key = stacks.next(key))) {
+			lines.push_back(*key + " " + itos(stacks[*key]));
+		}
+	}
+	lines.sort();
+
+	String result;
+	for (int i = 0; i < lines.size(); i++) {
+		result += lines[i] + "\n";
+	}
+	return result;
+}
+
+Error GDScriptSamplingProfiler::save_folded_stacks(const String &p_path) {
+	Error err;
+	FileAccessRef f = FileAccess::open(p_path, FileAccess::WRITE, &err);
+	ERR_FAIL_COND_V_MSG(err != OK, err, "Can't save the GDScript samples to '" + p_path + "'.");
+	f->store_string(get_folded_stacks());
+	return OK;
+}
+
+void GDScriptSamplingProfiler::register_profiler() {
+	EngineDebugger::register_profiler("gdscript_sampler", EngineDebugger::Profiler(nullptr, _profiler_toggle, nullptr, nullptr));
+}
+
+void GDScriptSamplingProfiler::unregister_profiler() {
+	if (EngineDebugger::has_profiler("gdscript_sampler")) {
+		EngineDebugger::unregister_profiler("gdscript_sampler");
+	}
+	stop();
+}
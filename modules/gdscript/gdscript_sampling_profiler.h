@@ -0,0 +1,119 @@
+/*************************************************************************/
+/*  gdscript_sampling_profiler.h                                         */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef GDSCRIPT_SAMPLING_PROFILER_H
+#define GDSCRIPT_SAMPLING_PROFILER_H
+
+#include "core/os/mutex.h"
+#include "core/os/thread.h"
+#include "core/templates/hash_map.h"
+#include "core/templates/local_vector.h"
+#include "core/templates/safe_refcount.h"
+#include "core/variant/array.h"
+
+class GDScriptFunction;
+
+// Statistical profiler for production builds. A background thread only advances a tick
+// counter at a fixed interval. Each thread running scripts keeps a light stack of its
+// functions and current lines, and records it at the next line it runs after a tick,
+// weighted by the ticks elapsed. The samples are aggregated as folded stacks, the text
+// format read by flame graph tools (`frame;frame;frame count` lines).
+class GDScriptSamplingProfiler {
+	struct Frame {
+		const GDScriptFunction *function = nullptr;
+		const int *line = nullptr;
+	};
+
+	struct ThreadState {
+		LocalVector<Frame> frames;
+		uint32_t last_tick = 0;
+	};
+
+	static SafeFlag sampling;
+	static SafeFlag sampler_running;
+	static SafeNumeric<uint32_t> ticks;
+	static uint32_t interval_usec;
+	static Thread sampler_thread;
+
+	static Mutex stacks_mutex;
+	static HashMap<String, uint64_t> stacks;
+
+	static thread_local ThreadState thread_state;
+
+	static void _sampler_thread_func(void *p_userdata);
+	static void _take_sample();
+	static void _profiler_toggle(void *p_user, bool p_enable, const Array &p_opts);
+
+public:
+	// Keeps the function in the stack of the current thread while sampling.
+	class Scope {
+		bool pushed = false;
+
+	public:
+		_FORCE_INLINE_ Scope(const GDScriptFunction *p_function, const int *p_line) {
+			if (unlikely(sampling.is_set())) {
+				push(p_function, p_line);
+				pushed = true;
+			}
+		}
+		_FORCE_INLINE_ ~Scope() {
+			if (unlikely(pushed)) {
+				pop();
+			}
+		}
+	};
+
+	_FORCE_INLINE_ static bool is_sampling() { return sampling.is_set(); }
+
+	// Called before each line, records a sample if a tick happened since the last one.
+	_FORCE_INLINE_ static void poll() {
+		if (unlikely(sampling.is_set()) && thread_state.last_tick != ticks.get()) {
+			_take_sample();
+		}
+	}
+
+	static void push(const GDScriptFunction *p_function, const int *p_line);
+	static void pop();
+
+	static void start(uint32_t p_interval_usec);
+	// Samples without the background thread, only after the ticks advanced by `tick()`. Used by tests to sample known lines.
+	static void start_manual();
+	static void tick();
+	static void stop();
+	static void clear();
+
+	static String get_folded_stacks();
+	static Error save_folded_stacks(const String &p_path);
+
+	static void register_profiler();
+	static void unregister_profiler();
+};
+
+#endif // GDSCRIPT_SAMPLING_PROFILER_H
@@ -34,6 +34,7 @@
 #include "core/os/os.h"
 #include "gdscript.h"
 #include "gdscript_lambda_callable.h"
+#include "gdscript_sampling_profiler.h"
 
 Variant *GDScriptFunction::_get_variant(int p_address, GDScriptInstance *p_instance, Variant *p_stack, String &r_error) const {
 	int address = p_address & ADDR_MASK;
@@ -190,6 +191,187 @@ void (*type_init_function_table[])(Variant *) = {
 	&VariantInitializer<PackedColorArray>::init, // PACKED_COLOR_ARRAY.
 };
 
+bool GDScriptFunction::_get_inline_cache_key(Object *p_object, InlineCache::Entry &r_key, GDScriptInstance *&r_instance) const {
+	ScriptInstance *script_instance = p_object->get_script_instance();
+	if (script_instance && (script_instance->is_placeholder() || script_instance->get_language() != GDScriptLanguage::get_singleton())) {
+		return false; // Other script instances resolve names their own way.
+	}
+
+	r_instance = static_cast<GDScriptInstance *>(script_instance);
+	r_key.native_class = &p_object->get_class_name();
+	r_key.script = r_instance ? r_instance->script.ptr() : nullptr;
+	return true;
+}
+
+bool GDScriptFunction::_find_inline_cache(int p_cache, InlineCache::Entry &r_entry, uint32_t &r_generation) {
+	r_generation = GDScriptLanguage::get_singleton()->get_inline_cache_generation();
+
+	const InlineCache &cache = inline_caches[p_cache];
+	for (uint32_t i = 0; i < InlineCache::ENTRY_COUNT; i++) {
+		const InlineCache::Slot &slot = cache.slots[i];
+		uint32_t sequence = slot.sequence.get();
+		if (sequence & 1) {
+			continue; // Being filled.
+		}
+		if (slot.native_class.get() != r_entry.native_class || slot.script.get() != r_entry.script || slot.generation.get() != r_generation) {
+			continue;
+		}
+
+		InlineCache::Entry entry = r_entry;
+		entry.function = slot.function.get();
+		entry.method = slot.method.get();
+		entry.member_index = slot.member_index.get();
+		entry.member_type = slot.member_type.get();
+		if (slot.sequence.get() != sequence) {
+			continue; // Filled again while it was read.
+		}
+
+		r_entry = entry;
+		return true;
+	}
+
+	return false;
+}
+
+void GDScriptFunction::_store_inline_cache(int p_cache, const InlineCache::Entry &p_entry, uint32_t p_generation) {
+	inline_cache_lock.lock();
+	// Scripts may have been reloaded while the entry was resolved.
+	if (GDScriptLanguage::get_singleton()->get_inline_cache_generation() == p_generation) {
+		InlineCache &cache = inline_caches[p_cache];
+
+		// Replace the entries of previous generations first, then the oldest one.
+		uint32_t index = InlineCache::ENTRY_COUNT;
+		for (uint32_t i = 0; i < InlineCache::ENTRY_COUNT; i++) {
+			if (cache.slots[i].native_class.get() == nullptr || cache.slots[i].generation.get() != p_generation) {
+				index = i;
+				break;
+			}
+		}
+		if (index == InlineCache::ENTRY_COUNT) {
+			index = cache.next_slot;
+			cache.next_slot = (cache.next_slot + 1) % InlineCache::ENTRY_COUNT;
+		}
+
+		InlineCache::Slot &slot = cache.slots[index];
+		uint32_t sequence = slot.sequence.get();
+		slot.sequence.set(sequence + 1);
+		slot.generation.set(p_generation);
+		slot.native_class.set(p_entry.native_class);
+		slot.script.set(p_entry.script);
+		slot.function.set(p_entry.function);
+		slot.method.set(p_entry.method);
+		slot.member_index.set(p_entry.member_index);
+		slot.member_type.set(p_entry.member_type);
+		slot.sequence.set(sequence + 2);
+	}
+	inline_cache_lock.unlock();
+}
+
+Variant GDScriptFunction::_get_named_cached(int p_cache, const Variant *p_base, const StringName &p_name, bool &r_valid) {
+	Object *object = p_base->get_validated_object();
+	InlineCache::Entry entry;
+	GDScriptInstance *instance = nullptr;
+
+	if (object && _get_inline_cache_key(object, entry, instance) && instance) {
+		uint32_t generation;
+		if (!_find_inline_cache(p_cache, entry, generation)) {
+			// Only members without getter, the first thing `GDScriptInstance::get()` checks.
+			const Map<StringName, GDScript::MemberInfo>::Element *E = instance->script->member_indices.find(p_name);
+			if (E && !E->get().getter) {
+				entry.member_index = E->get().index;
+			}
+			_store_inline_cache(p_cache, entry, generation);
+		}
+
+		if (entry.member_index >= 0 && entry.member_index < instance->members.size()) {
+			r_valid = true;
+			return instance->members[entry.member_index];
+		}
+	}
+
+	return p_base->get_named(p_name, r_valid);
+}
+
+void GDScriptFunction::_set_named_cached(int p_cache, Variant *p_base, const StringName &p_name, const Variant &p_value, bool &r_valid) {
+	Object *object = p_base->get_validated_object();
+	InlineCache::Entry entry;
+	GDScriptInstance *instance = nullptr;
+
+	if (object && _get_inline_cache_key(object, entry, instance) && instance) {
+		uint32_t generation;
+		if (!_find_inline_cache(p_cache, entry, generation)) {
+			// Only members without setter, and which don't need the conversions of `GDScriptInstance::set()`.
+			const Map<StringName, GDScript::MemberInfo>::Element *E = instance->script->member_indices.find(p_name);
+			if (E && !E->get().setter) {
+				const GDScriptDataType &type = E->get().data_type;
+				if (!type.has_type) {
+					entry.member_index = E->get().index;
+				} else if (type.kind == GDScriptDataType::BUILTIN && type.builtin_type != Variant::NIL && !type.has_container_element_type()) {
+					entry.member_index = E->get().index;
+					entry.member_type = type.builtin_type;
+				}
+			}
+			_store_inline_cache(p_cache, entry, generation);
+		}
+
+		if (entry.member_index >= 0 && entry.member_index < instance->members.size() && (entry.member_type == Variant::NIL || entry.member_type == p_value.get_type())) {
+			instance->members.write[entry.member_index] = p_value;
+			r_valid = true;
+			return;
+		}
+	}
+
+	p_base->set_named(p_name, p_value, r_valid);
+}
+
+void GDScriptFunction::_call_cached(int p_cache, Variant *p_base, const StringName &p_method, const Variant **p_args, int p_argcount, Variant &r_ret, Callable::CallError &r_error) {
+	Object *object = p_base->get_validated_object();
+	InlineCache::Entry entry;
+	GDScriptInstance *instance = nullptr;
+
+	if (!object || !_get_inline_cache_key(object, entry, instance)) {
+		p_base->call(p_method, p_args, p_argcount, r_ret, r_error);
+		return;
+	}
+
+	uint32_t generation;
+	if (!_find_inline_cache(p_cache, entry, generation)) {
+		// Classes overriding `call()` resolve the methods their own way, their entry stays empty so they go through it.
+		if (!object->has_custom_call()) {
+			// Same order as `Object::call()`: script functions, then the native method.
+			const GDScript *script = instance ? instance->script.ptr() : nullptr;
+			while (script && !entry.function) {
+				const Map<StringName, GDScriptFunction *>::Element *E = script->member_functions.find(p_method);
+				if (E) {
+					entry.function = E->get();
+				}
+				script = script->_base;
+			}
+			if (!entry.function && p_method != CoreStringNames::get_singleton()->_free) {
+				entry.method = ClassDB::get_method(*entry.native_class, p_method);
+			}
+		}
+		_store_inline_cache(p_cache, entry, generation);
+	}
+
+	if (entry.function) {
+#ifdef DEBUG_ENABLED
+		// Like `Object::call()`, so the object can't be freed while the function runs.
+		_ObjectDebugLock debug_lock(object);
+#endif
+		r_error.error = Callable::CallError::CALL_OK;
+		r_ret = entry.function->call(instance, p_args, p_argcount, r_error);
+	} else if (entry.method) {
+#ifdef DEBUG_ENABLED
+		_ObjectDebugLock debug_lock(object);
+#endif
+		r_error.error = Callable::CallError::CALL_OK;
+		r_ret = entry.method->call(object, p_args, p_argcount, r_error);
+	} else {
+		p_base->call(p_method, p_args, p_argcount, r_ret, r_error);
+	}
+}
+
 #if defined(__GNUC__)
 #define OPCODES_TABLE                                \
 	static const void *switch_table_ops[] = {        \
@@ -276,6 +458,7 @@ void (*type_init_function_table[])(Variant *) = {
 		&&OPCODE_JUMP,                               \
 		&&OPCODE_JUMP_IF,                            \
 		&&OPCODE_JUMP_IF_NOT,                        \
+		&&OPCODE_OPERATOR_VALIDATED_JUMP_IF_NOT,    \
 		&&OPCODE_JUMP_TO_DEF_ARGUMENT,               \
 		&&OPCODE_RETURN,                             \
 		&&OPCODE_RETURN_TYPED_BUILTIN,               \
@@ -448,6 +631,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 	GDScript *script;
 	int ip = 0;
 	int line = _initial_line;
+	GDScriptSamplingProfiler::Scope sampling_scope(this, &line);
 
 	if (p_state) {
 		//use existing (supplied) state (awaited)
@@ -586,6 +770,12 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 	bool awaited = false;
 #endif
 
+	if (_jit_function && !p_state && defarg == 0 && (p_instance || !_jit_uses_members) && !EngineDebugger::is_active() && !GDScriptSamplingProfiler::is_sampling()) {
+		// Runs natively until the function returns or reaches code that wasn't compiled,
+		// then the VM continues from there.
+		ip = _jit_function(stack, p_instance ? &p_instance->members : nullptr, &retvalue, &line);
+	}
+
 #ifdef DEBUG_ENABLED
 	OPCODE_WHILE(ip < _code_size) {
 		int last_opcode = _code_ptr[ip] & INSTR_MASK;
@@ -930,7 +1120,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 			DISPATCH_OPCODE;
 
 			OPCODE(OPCODE_SET_NAMED) {
-				CHECK_SPACE(3);
+				CHECK_SPACE(5);
 
 				GET_INSTRUCTION_ARG(dst, 0);
 				GET_INSTRUCTION_ARG(value, 1);
@@ -940,8 +1130,11 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				GD_ERR_BREAK(indexname < 0 || indexname >= _global_names_count);
 				const StringName *index = &_global_names_ptr[indexname];
 
+				int cache_idx = _code_ptr[ip + 4];
+				GD_ERR_BREAK(cache_idx < 0 || cache_idx >= (int)inline_caches.size());
+
 				bool valid;
-				dst->set_named(*index, *value, valid);
+				_set_named_cached(cache_idx, dst, *index, *value, valid);
 
 #ifdef DEBUG_ENABLED
 				if (!valid) {
@@ -950,7 +1143,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 					OPCODE_BREAK;
 				}
 #endif
-				ip += 4;
+				ip += 5;
 			}
 			DISPATCH_OPCODE;
 
@@ -970,7 +1163,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 			DISPATCH_OPCODE;
 
 			OPCODE(OPCODE_GET_NAMED) {
-				CHECK_SPACE(4);
+				CHECK_SPACE(5);
 
 				GET_INSTRUCTION_ARG(src, 0);
 				GET_INSTRUCTION_ARG(dst, 1);
@@ -980,13 +1173,16 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				GD_ERR_BREAK(indexname < 0 || indexname >= _global_names_count);
 				const StringName *index = &_global_names_ptr[indexname];
 
+				int cache_idx = _code_ptr[ip + 4];
+				GD_ERR_BREAK(cache_idx < 0 || cache_idx >= (int)inline_caches.size());
+
 				bool valid;
 #ifdef DEBUG_ENABLED
 				//allow better error message in cases where src and dst are the same stack position
-				Variant ret = src->get_named(*index, valid);
+				Variant ret = _get_named_cached(cache_idx, src, *index, valid);
 
 #else
-				*dst = src->get_named(*index, valid);
+				*dst = _get_named_cached(cache_idx, src, *index, valid);
 #endif
 #ifdef DEBUG_ENABLED
 				if (!valid) {
@@ -999,7 +1195,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				}
 				*dst = ret;
 #endif
-				ip += 4;
+				ip += 5;
 			}
 			DISPATCH_OPCODE;
 
@@ -1439,7 +1635,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 			OPCODE(OPCODE_CALL_ASYNC)
 			OPCODE(OPCODE_CALL_RETURN)
 			OPCODE(OPCODE_CALL) {
-				CHECK_SPACE(3 + instr_arg_count);
+				CHECK_SPACE(4 + instr_arg_count);
 				bool call_ret = (_code_ptr[ip] & INSTR_MASK) != OPCODE_CALL;
 #ifdef DEBUG_ENABLED
 				bool call_async = (_code_ptr[ip] & INSTR_MASK) == OPCODE_CALL_ASYNC;
@@ -1454,6 +1650,9 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				GD_ERR_BREAK(methodname_idx < 0 || methodname_idx >= _global_names_count);
 				const StringName *methodname = &_global_names_ptr[methodname_idx];
 
+				int cache_idx = _code_ptr[ip + 3];
+				GD_ERR_BREAK(cache_idx < 0 || cache_idx >= (int)inline_caches.size());
+
 				GET_INSTRUCTION_ARG(base, argc);
 				Variant **argptrs = instruction_args;
 
@@ -1468,7 +1667,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				Callable::CallError err;
 				if (call_ret) {
 					GET_INSTRUCTION_ARG(ret, argc + 1);
-					base->call(*methodname, (const Variant **)argptrs, argc, *ret, err);
+					_call_cached(cache_idx, base, *methodname, (const Variant **)argptrs, argc, *ret, err);
 #ifdef DEBUG_ENABLED
 					if (!call_async && ret->get_type() == Variant::OBJECT) {
 						// Check if getting a function state without await.
@@ -1487,7 +1686,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 #endif
 				} else {
 					Variant ret;
-					base->call(*methodname, (const Variant **)argptrs, argc, ret, err);
+					_call_cached(cache_idx, base, *methodname, (const Variant **)argptrs, argc, ret, err);
 				}
 #ifdef DEBUG_ENABLED
 				if (GDScriptLanguage::get_singleton()->profiling) {
@@ -1532,7 +1731,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				}
 #endif
 
-				ip += 3;
+				ip += 4;
 			}
 			DISPATCH_OPCODE;
 
@@ -2222,6 +2421,31 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 			}
 			DISPATCH_OPCODE;
 
+			OPCODE(OPCODE_OPERATOR_VALIDATED_JUMP_IF_NOT) {
+				CHECK_SPACE(6);
+
+				int operator_idx = _code_ptr[ip + 4];
+				GD_ERR_BREAK(operator_idx < 0 || operator_idx >= _operator_funcs_count);
+				Variant::ValidatedOperatorEvaluator operator_func = _operator_funcs_ptr[operator_idx];
+
+				GET_INSTRUCTION_ARG(a, 0);
+				GET_INSTRUCTION_ARG(b, 1);
+				GET_INSTRUCTION_ARG(dst, 2);
+
+				operator_func(a, b, dst);
+
+				bool result = dst->booleanize();
+
+				if (!result) {
+					int to = _code_ptr[ip + 5];
+					GD_ERR_BREAK(to < 0 || to > _code_size);
+					ip = to;
+				} else {
+					ip += 6;
+				}
+			}
+			DISPATCH_OPCODE;
+
 			OPCODE(OPCODE_JUMP_TO_DEF_ARGUMENT) {
 				CHECK_SPACE(2);
 				ip = _default_arg_ptr[defarg];
@@ -3212,6 +3436,9 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 			OPCODE(OPCODE_LINE) {
 				CHECK_SPACE(2);
 
+				// Before updating the line, so it's attributed the time since the last one.
+				GDScriptSamplingProfiler::poll();
+
 				line = _code_ptr[ip + 1];
 				ip += 2;
 
@@ -36,6 +36,7 @@
 #include "core/io/resource_loader.h"
 #include "gdscript.h"
 #include "gdscript_analyzer.h"
+#include "gdscript_bytecode_cache.h"
 #include "gdscript_cache.h"
 #include "gdscript_tokenizer.h"
 #include "gdscript_utility_functions.h"
@@ -85,8 +86,20 @@ public:
 			return;
 		}
 
-		// TODO: Re-add compiled GDScript on export.
-		return;
+		// The source is still exported, it's used when the compiled script
+		// doesn't match the engine build running the project.
+		Ref<GDScript> script = ResourceLoader::load(p_path);
+		if (script.is_null() || !script->is_valid()) {
+			return;
+		}
+
+		String error;
+		Vector<uint8_t> bytecode = GDScriptBytecodeCache::serialize(script.ptr(), &error);
+		if (bytecode.is_empty()) {
+			WARN_PRINT("Script '" + p_path + "' can't be exported as bytecode and will be compiled when loaded: " + error);
+			return;
+		}
+		add_file(GDScriptBytecodeCache::get_cache_path(p_path), bytecode, false);
 	}
 };
 
@@ -140,6 +140,9 @@ GDScriptTestRunner::GDScriptTestRunner(const String &p_source_dir, bool p_init_l
 			String warning = GDScriptWarning::get_name_from_code((GDScriptWarning::Code)i).to_lower();
 			ProjectSettings::get_singleton()->set_setting("debug/gdscript/warnings/" + warning, true);
 		}
+
+		// The bytecode optimizations are opt-in, make sure the scripts behave the same with them.
+		ProjectSettings::get_singleton()->set_setting("debug/gdscript/compiler/optimize_bytecode", true);
 	}
 
 	// Enable printing to show results
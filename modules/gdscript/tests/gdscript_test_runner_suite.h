@@ -32,6 +32,15 @@
 #define GDSCRIPT_TEST_RUNNER_SUITE_H
 
 #include "gdscript_test_runner.h"
+#include "core/config/project_settings.h"
+#include "core/io/dir_access.h"
+#include "core/io/file_access.h"
+#include "core/io/marshalls.h"
+#include "core/math/random_number_generator.h"
+#include "core/os/os.h"
+#include "modules/gdscript/gdscript_bytecode_cache.h"
+#include "modules/gdscript/gdscript_cache.h"
+#include "modules/gdscript/gdscript_sampling_profiler.h"
 #include "tests/test_macros.h"
 
 namespace GDScriptTests {
@@ -69,6 +78,287 @@ func _init():
 	CHECK_MESSAGE(int(ref_counted->get_meta("result")) == 42, "The script should assign object metadata successfully.");
 }
 
+TEST_CASE("[Modules][GDScript] Load compiled bytecode and run it") {
+	const String source = R"(
+extends RefCounted
+
+const OFFSET = 10
+
+class Counter:
+	var count := 0
+
+	func add(p_value: int) -> int:
+		count += p_value
+		return count
+
+func compute(p_values: Array) -> int:
+	var counter := Counter.new()
+	for value in p_values:
+		counter.add(value * 2)
+	return counter.count + OFFSET + str(p_values.size()).length()
+)";
+
+	Ref<GDScript> compiled = memnew(GDScript);
+	compiled->set_source_code(source);
+	ERR_PRINT_OFF;
+	const Error error = compiled->reload();
+	ERR_PRINT_ON;
+	REQUIRE_MESSAGE(error == OK, "The script should compile successfully.");
+
+	const Vector<uint8_t> bytecode = compiled->get_as_byte_code();
+	REQUIRE_MESSAGE(!bytecode.is_empty(), "The script should be serialized.");
+
+	Ref<GDScript> loaded = memnew(GDScript);
+	loaded->set_source_code(source);
+	CHECK_MESSAGE(GDScriptBytecodeCache::deserialize(loaded.ptr(), bytecode) == OK, "The bytecode should be loaded without compiling the script.");
+	CHECK(loaded->is_valid());
+
+	Array values;
+	values.push_back(1);
+	values.push_back(2);
+	values.push_back(3);
+	Ref<RefCounted> ref_counted = memnew(RefCounted);
+	ref_counted->set_script(loaded);
+	CHECK_MESSAGE(int(ref_counted->call("compute", values)) == 23, "The loaded script should behave like the compiled one.");
+
+	Ref<GDScript> modified = memnew(GDScript);
+	modified->set_source_code(source + "\n");
+	CHECK_MESSAGE(GDScriptBytecodeCache::deserialize(modified.ptr(), bytecode) == ERR_FILE_UNRECOGNIZED, "Bytecode of another source code should be rejected.");
+	CHECK_FALSE(modified->is_valid());
+}
+
+TEST_CASE("[Modules][GDScript] Reject corrupted bytecode") {
+	const String source = R"(
+extends RefCounted
+
+var total := 0
+
+func compute(p_values: Array) -> int:
+	for value in p_values:
+		if value > 1:
+			total += value
+	return total
+)";
+
+	Ref<GDScript> compiled = memnew(GDScript);
+	compiled->set_source_code(source);
+	ERR_PRINT_OFF;
+	const Error error = compiled->reload();
+	ERR_PRINT_ON;
+	REQUIRE_MESSAGE(error == OK, "The script should compile successfully.");
+
+	const Vector<uint8_t> bytecode = compiled->get_as_byte_code();
+	REQUIRE(compiled->get_member_functions().has("compute"));
+	const GDScriptFunction *function = compiled->get_member_functions()["compute"];
+	const int *code = function->get_code();
+	const int code_size = function->get_code_size();
+
+	// Find the code of the function, stored as its size followed by its words.
+	Vector<uint8_t> code_bytes;
+	code_bytes.resize((code_size + 1) * 4);
+	encode_uint32(code_size, code_bytes.ptrw());
+	for (int i = 0; i < code_size; i++) {
+		encode_uint32(code[i], code_bytes.ptrw() + (i + 1) * 4);
+	}
+	int code_offset = -1;
+	for (int i = 0; i + code_bytes.size() <= bytecode.size(); i++) {
+		if (memcmp(bytecode.ptr() + i, code_bytes.ptr(), code_bytes.size()) == 0) {
+			code_offset = i + 4;
+			break;
+		}
+	}
+	REQUIRE_MESSAGE(code_offset >= 0, "The code of the function should be found in the bytecode.");
+
+	// Out of bounds as a stack address, an index in any table or a jump target, and not an opcode.
+	// Only the line numbers can take any value.
+	const uint32_t invalid_word = GDScriptFunction::ADDR_MASK;
+	int rejected = 0;
+	int corrupted = 0;
+	for (int i = 0; i < code_size; i++) {
+		if (i > 0 && code[i - 1] == GDScriptFunction::OPCODE_LINE) {
+			continue;
+		}
+		Vector<uint8_t> corrupted_bytecode = bytecode;
+		encode_uint32(invalid_word, corrupted_bytecode.ptrw() + code_offset + i * 4);
+
+		Ref<GDScript> loaded = memnew(GDScript);
+		loaded->set_source_code(source);
+		ERR_PRINT_OFF;
+		const Error load_error = GDScriptBytecodeCache::deserialize(loaded.ptr(), corrupted_bytecode);
+		ERR_PRINT_ON;
+		corrupted++;
+		if (load_error == ERR_FILE_CORRUPT && !loaded->is_valid()) {
+			rejected++;
+		}
+	}
+	CHECK_MESSAGE(rejected == corrupted, "Every corrupted instruction should be rejected.");
+
+	Ref<GDScript> loaded = memnew(GDScript);
+	loaded->set_source_code(source);
+	CHECK_MESSAGE(GDScriptBytecodeCache::deserialize(loaded.ptr(), bytecode) == OK, "The bytecode should still be valid.");
+}
+
+TEST_CASE("[Modules][GDScript] Compile scripts parsed in parallel") {
+	const String base_path = OS::get_singleton()->get_cache_path().plus_file("gdscript_parallel_base.gd");
+	const String derived_path = OS::get_singleton()->get_cache_path().plus_file("gdscript_parallel_derived.gd");
+	const String other_path = OS::get_singleton()->get_cache_path().plus_file("gdscript_parallel_other.gd");
+
+	// `FileAccessRef` has no assignment operator, reassigning it would free the new file.
+	{
+		FileAccessRef f = FileAccess::open(base_path, FileAccess::WRITE);
+		f->store_string("extends RefCounted\n\nfunc value() -> int:\n\treturn 40\n");
+	}
+	{
+		FileAccessRef f = FileAccess::open(derived_path, FileAccess::WRITE);
+		f->store_string(vformat("extends \"%s\"\n\nfunc value() -> int:\n\treturn super.value() + 2\n", base_path));
+	}
+	{
+		FileAccessRef f = FileAccess::open(other_path, FileAccess::WRITE);
+		f->store_string("extends RefCounted\n\nfunc value() -> int:\n\treturn 7\n");
+	}
+
+	Vector<String> paths;
+	paths.push_back(derived_path);
+	paths.push_back(other_path);
+	paths.push_back(base_path);
+	{
+		Vector<Ref<GDScript>> scripts;
+		CHECK_MESSAGE(GDScriptCache::compile_scripts(paths, &scripts) == OK, "The scripts should compile successfully.");
+		REQUIRE(scripts.size() == 3);
+		CHECK_MESSAGE(scripts[0]->get_path() == base_path, "Base classes should be compiled first.");
+		CHECK(scripts[1]->get_path() == derived_path);
+		CHECK(scripts[2]->get_path() == other_path);
+
+		Ref<RefCounted> derived = memnew(RefCounted);
+		derived->set_script(scripts[1]);
+		CHECK(int(derived->call("value")) == 42);
+		Ref<RefCounted> other = memnew(RefCounted);
+		other->set_script(scripts[2]);
+		CHECK(int(other->call("value")) == 7);
+	}
+
+	// Freeing the scripts removes them from the cache.
+	for (int i = 0; i < paths.size(); i++) {
+		CHECK_FALSE_MESSAGE(ResourceCache::has(paths[i]), "The compiled scripts should be freed.");
+		DirAccess::remove_file_or_error(paths[i]);
+	}
+}
+
+// Advances the sampling ticks from a script, so the samples are taken at known lines.
+class _SamplingTicker : public Object {
+public:
+	void tick() {
+		GDScriptSamplingProfiler::tick();
+	}
+};
+
+TEST_CASE("[Modules][GDScript] Sample the call stacks of running scripts") {
+	Ref<GDScript> gdscript = memnew(GDScript);
+	gdscript->set_source_code(R"(
+extends RefCounted
+
+func busy(p_tick: Callable) -> int:
+	var total := 0
+	for i in 3:
+		p_tick.call()
+		total += i
+	return total
+
+func run(p_tick: Callable) -> int:
+	return busy(p_tick)
+)");
+	ERR_PRINT_OFF;
+	const Error error = gdscript->reload();
+	ERR_PRINT_ON;
+	REQUIRE_MESSAGE(error == OK, "The script should compile successfully.");
+
+	Ref<RefCounted> ref_counted = memnew(RefCounted);
+	ref_counted->set_script(gdscript);
+	_SamplingTicker *ticker = memnew(_SamplingTicker);
+
+	GDScriptSamplingProfiler::clear();
+	GDScriptSamplingProfiler::start_manual();
+	ref_counted->call("run", callable_mp(ticker, &_SamplingTicker::tick));
+	GDScriptSamplingProfiler::stop();
+	const String folded = GDScriptSamplingProfiler::get_folded_stacks();
+	GDScriptSamplingProfiler::clear();
+	memdelete(ticker);
+
+	// Each tick is sampled at the next line, with the line that was running.
+	CHECK_MESSAGE(folded == "<built-in>:run:12;<built-in>:busy:7 3\n", "The samples should contain the stack of the running functions, attributed to the running line.");
+}
+
+#ifdef GDSCRIPT_JIT_ENABLED
+TEST_CASE("[Modules][GDScript] Run typed functions compiled to native code") {
+	const String source = R"(
+extends RefCounted
+
+var scale := 3
+
+func sum_squares(p_count: int) -> int:
+	var total := 0
+	for i in p_count:
+		if i % 2 == 0 and i > 2:
+			total += i * i * scale
+		else:
+			total -= i
+	return total
+
+func lerp_all(p_from: float, p_to: float, p_steps: int) -> float:
+	var result := 0.0
+	for i in p_steps:
+		result += p_from + (p_to - p_from) * (float(i) / p_steps)
+	return result
+
+func first_index(p_values: Array, p_value: int) -> int:
+	for i in p_values.size():
+		if p_values[i] == p_value:
+			return i
+	return -1
+
+func roll(p_rng: RandomNumberGenerator, p_count: int) -> int:
+	var total := 0
+	for i in p_count:
+		total += p_rng.randi_range(1, 6)
+	return total
+)";
+
+	Array values;
+	values.push_back(4);
+	values.push_back(8);
+	values.push_back(15);
+
+	Vector<Variant> results[2];
+	for (int jit = 0; jit < 2; jit++) {
+		ProjectSettings::get_singleton()->set_setting("debug/gdscript/compiler/enable_jit", jit == 1);
+
+		Ref<GDScript> gdscript = memnew(GDScript);
+		gdscript->set_source_code(source);
+		ERR_PRINT_OFF;
+		const Error error = gdscript->reload();
+		ERR_PRINT_ON;
+		REQUIRE_MESSAGE(error == OK, "The script should compile successfully.");
+
+		Ref<RefCounted> ref_counted = memnew(RefCounted);
+		ref_counted->set_script(gdscript);
+		results[jit].push_back(ref_counted->call("sum_squares", 100));
+		results[jit].push_back(ref_counted->call("lerp_all", 1.0, 3.0, 8));
+		results[jit].push_back(ref_counted->call("first_index", values, 15));
+		results[jit].push_back(ref_counted->call("first_index", values, 16));
+		Ref<RandomNumberGenerator> rng = memnew(RandomNumberGenerator);
+		rng->set_seed(5);
+		results[jit].push_back(ref_counted->call("roll", rng, 10));
+	}
+	ProjectSettings::get_singleton()->set_setting("debug/gdscript/compiler/enable_jit", false);
+
+	for (int i = 0; i < results[0].size(); i++) {
+		CHECK_MESSAGE(results[1][i] == results[0][i], "Native code should return the same values as the interpreter.");
+	}
+	CHECK(int(results[1][2]) == 2);
+	CHECK(int(results[1][3]) == -1);
+}
+#endif // GDSCRIPT_JIT_ENABLED
+
 } // namespace GDScriptTests
 
 #endif // GDSCRIPT_TEST_RUNNER_SUITE_H
@@ -0,0 +1,9 @@
+class Destructible extends Object:
+	func self_destruct():
+		var myself = self
+		myself.free()
+
+func test():
+	# The object stays locked while a method called through an inline cache runs.
+	var object = Destructible.new()
+	object.self_destruct()
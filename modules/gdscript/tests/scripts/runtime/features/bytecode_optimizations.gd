@@ -0,0 +1,65 @@
+func add_default(a, b = [1, 2].size()):
+	return a + b
+
+func test():
+	var values: Array = [3, 1, 2]
+	var count = values.size()
+	print(count)
+
+	# The local is also an operand, so the copy must stay.
+	var x = 1
+	x = x + count
+	x = max(x, 10)
+	print(x)
+
+	var text = "a"
+	text = str(text, "b")
+	print(text)
+
+	var sum := 0
+	var i := 0
+	var n: int = values.size()
+	while i < n:
+		sum += values[i]
+		i += 1
+	print(sum)
+
+	if sum > 5:
+		print("greater")
+	else:
+		print("not greater")
+
+	var both = count > 1 and sum > 100
+	print(both)
+
+	var picked = values[0] if sum > 5 else values[1]
+	print(picked)
+
+	print(add_default(1))
+	print(add_default(1, 5))
+
+	# Members of values the loop doesn't change are read once before it.
+	var origin := Vector2i(1, 2)
+	var offset := Vector2i(0, 0)
+	var total := 0
+	for k in 3:
+		total += origin.x + origin.y
+		offset.x += origin.x
+	print(total)
+	print(offset)
+
+	# The value changes in the loop, so it's read at each iteration.
+	var moving := Vector2i(0, 0)
+	var steps := 0
+	while moving.x < 3:
+		moving.x += 1
+		steps += 1
+	print(steps)
+
+	# Repeated reads of the same member reuse the first one.
+	var size := Vector2i(3, 4)
+	print(size.x * size.x + size.y * size.y)
+	var cell := Vector3i(1, 2, 3)
+	print(cell[0] + cell[0] + cell[2])
+	size.x = 5
+	print(size.x + size.x)
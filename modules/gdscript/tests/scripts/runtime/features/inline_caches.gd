@@ -0,0 +1,43 @@
+class A:
+	var value = 1
+	func get_name_text():
+		return "A"
+
+class B extends A:
+	var typed: int = 0
+	func get_name_text():
+		return "B"
+
+class C:
+	var value = "c"
+	func get_name_text():
+		return "C"
+
+class D:
+	static func get_path():
+		return "static get_path"
+
+func read_value(object):
+	return object.value
+
+func test():
+	# The same call sites see several classes.
+	var objects = [A.new(), B.new(), C.new(), A.new(), RefCounted.new()]
+	for object in objects:
+		print(object.get_class())
+	for object in [A.new(), B.new(), C.new(), A.new()]:
+		print(object.get_name_text())
+		print(read_value(object))
+
+	var untyped = B.new()
+	untyped.typed = 5
+	print(untyped.typed)
+	# Needs a conversion, so it doesn't use the cached member.
+	untyped.typed = 2.5
+	print(untyped.typed)
+	untyped.value = "changed"
+	print(untyped.value)
+
+	# Scripts override `call()` for their static functions, which hide the native methods with the same name.
+	var script = D
+	print(script.get_path())
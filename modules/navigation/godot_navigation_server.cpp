@@ -31,6 +31,7 @@
 #include "godot_navigation_server.h"
 
 #include "core/os/mutex.h"
+#include "core/templates/pair.h"
 
 #ifndef _3D_DISABLED
 #include "navigation_mesh_generator.h"
@@ -119,6 +120,13 @@ GodotNavigationServer::GodotNavigationServer() :
 
 GodotNavigationServer::~GodotNavigationServer() {
 	flush_queries();
+
+	MutexLock lock(path_queries_mutex);
+	for (Map<int64_t, PathQuery *>::Element *E = path_queries.front(); E; E = E->next()) {
+		WorkerThreadPool::get_singleton()->wait_for_task_completion(E->get()->task_id);
+		memdelete(E->get());
+	}
+	path_queries.clear();
 }
 
 void GodotNavigationServer::add_command(SetCommand *command) const {
@@ -204,6 +212,20 @@ real_t GodotNavigationServer::map_get_edge_connection_margin(RID p_map) const {
 	return map->get_edge_connection_margin();
 }
 
+COMMAND_2(map_set_cluster_size, RID, p_map, real_t, p_cluster_size) {
+	NavMap *map = map_owner.getornull(p_map);
+	ERR_FAIL_COND(map == nullptr);
+
+	map->set_cluster_size(p_cluster_size);
+}
+
+real_t GodotNavigationServer::map_get_cluster_size(RID p_map) const {
+	const NavMap *map = map_owner.getornull(p_map);
+	ERR_FAIL_COND_V(map == nullptr, 0);
+
+	return map->get_cluster_size();
+}
+
 Vector<Vector3> GodotNavigationServer::map_get_path(RID p_map, Vector3 p_origin, Vector3 p_destination, bool p_optimize, uint32_t p_layers) const {
 	const NavMap *map = map_owner.getornull(p_map);
 	ERR_FAIL_COND_V(map == nullptr, Vector<Vector3>());
@@ -239,6 +261,88 @@ RID GodotNavigationServer::map_get_closest_point_owner(RID p_map, const Vector3
 	return map->get_closest_point_owner(p_point);
 }
 
+int64_t GodotNavigationServer::map_get_path_async(RID p_map, Vector3 p_origin, Vector3 p_destination, bool p_optimize, uint32_t p_layers, const Callable &p_callback) const {
+	const NavMap *map = map_owner.getornull(p_map);
+	ERR_FAIL_COND_V(map == nullptr, 0);
+
+	PathQuery *query = memnew(PathQuery);
+	query->snapshot = map->get_snapshot();
+	query->origin = p_origin;
+	query->destination = p_destination;
+	query->optimize = p_optimize;
+	query->layers = p_layers;
+	query->callback = p_callback;
+
+	GodotNavigationServer *mut_this = const_cast<GodotNavigationServer *>(this);
+	MutexLock lock(path_queries_mutex);
+	query->task_id = WorkerThreadPool::get_singleton()->add_template_task(mut_this, &GodotNavigationServer::_compute_path_query, query, nullptr, 0, false);
+	last_path_query_id++;
+	path_queries.insert(last_path_query_id, query);
+	return last_path_query_id;
+}
+
+bool GodotNavigationServer::path_query_is_done(int64_t p_query) const {
+	MutexLock lock(path_queries_mutex);
+	const Map<int64_t, PathQuery *>::Element *E = path_queries.find(p_query);
+	ERR_FAIL_COND_V_MSG(E == nullptr, false, "Invalid path query ID.");
+
+	return WorkerThreadPool::get_singleton()->is_task_completed(E->get()->task_id);
+}
+
+Vector<Vector3> GodotNavigationServer::path_query_get_result(int64_t p_query) const {
+	PathQuery *query = nullptr;
+	{
+		MutexLock lock(path_queries_mutex);
+		Map<int64_t, PathQuery *>::Element *E = path_queries.find(p_query);
+		ERR_FAIL_COND_V_MSG(E == nullptr, Vector<Vector3>(), "Invalid path query ID.");
+		query = E->get();
+		path_queries.erase(E);
+	}
+
+	WorkerThreadPool::get_singleton()->wait_for_task_completion(query->task_id);
+	Vector<Vector3> path = query->path;
+	memdelete(query);
+	return path;
+}
+
+void GodotNavigationServer::_compute_path_query(PathQuery *p_query) {
+	p_query->path = p_query->snapshot->get_path(p_query->origin, p_query->destination, p_query->optimize, p_query->layers);
+}
+
+void GodotNavigationServer::_dispatch_path_queries() {
+	LocalVector<Pair<int64_t, PathQuery *>> done_queries;
+	{
+		MutexLock lock(path_queries_mutex);
+		Map<int64_t, PathQuery *>::Element *E = path_queries.front();
+		while (E) {
+			Map<int64_t, PathQuery *>::Element *next = E->next();
+			if (!E->get()->callback.is_null() && WorkerThreadPool::get_singleton()->is_task_completed(E->get()->task_id)) {
+				done_queries.push_back(Pair<int64_t, PathQuery *>(E->key(), E->get()));
+				path_queries.erase(E);
+			}
+			E = next;
+		}
+	}
+
+	// The callbacks are called without holding the lock, so they can queue new queries.
+	for (uint32_t i = 0; i < done_queries.size(); i++) {
+		PathQuery *query = done_queries[i].second;
+		WorkerThreadPool::get_singleton()->wait_for_task_completion(query->task_id);
+
+		const Variant query_id = done_queries[i].first;
+		const Variant path = query->path;
+		const Variant *args[2] = { &query_id, &path };
+		Variant ret;
+		Callable::CallError ce;
+		query->callback.call(args, 2, ret, ce);
+		if (ce.error != Callable::CallError::CALL_OK) {
+			ERR_PRINT("Error calling the path query callback: " + Variant::get_callable_error_text(query->callback, args, 2, ce));
+		}
+
+		memdelete(query);
+	}
+}
+
 RID GodotNavigationServer::region_create() const {
 	GodotNavigationServer *mut_this = const_cast<GodotNavigationServer *>(this);
 	MutexLock lock(mut_this->operations_mutex);
@@ -540,6 +644,8 @@ void GodotNavigationServer::process(real_t p_delta_time) {
 			active_maps_update_id[i] = new_map_update_id;
 		}
 	}
+
+	_dispatch_path_queries();
 }
 
 #undef COMMAND_1
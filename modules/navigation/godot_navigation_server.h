@@ -31,7 +31,9 @@
 #ifndef GODOT_NAVIGATION_SERVER_H
 #define GODOT_NAVIGATION_SERVER_H
 
+#include "core/os/worker_thread_pool.h"
 #include "core/templates/local_vector.h"
+#include "core/templates/map.h"
 #include "core/templates/rid.h"
 #include "core/templates/rid_owner.h"
 #include "servers/navigation_server_3d.h"
@@ -83,6 +85,26 @@ class GodotNavigationServer : public NavigationServer3D {
 	LocalVector<NavMap *> active_maps;
 	LocalVector<uint32_t> active_maps_update_id;
 
+	/// A path computed on a worker thread, against a snapshot of the map.
+	struct PathQuery {
+		NavMapSnapshotRef snapshot;
+		Vector3 origin;
+		Vector3 destination;
+		bool optimize = false;
+		uint32_t layers = 1;
+		Callable callback;
+
+		WorkerThreadPool::TaskID task_id = WorkerThreadPool::INVALID_TASK_ID;
+		Vector<Vector3> path;
+	};
+
+	mutable Mutex path_queries_mutex;
+	mutable Map<int64_t, PathQuery *> path_queries;
+	mutable int64_t last_path_query_id = 0; // IDs start at 1, 0 is returned on errors.
+
+	void _compute_path_query(PathQuery *p_query);
+	void _dispatch_path_queries();
+
 public:
 	GodotNavigationServer();
 	virtual ~GodotNavigationServer();
@@ -102,6 +124,9 @@ public:
 	COMMAND_2(map_set_edge_connection_margin, RID, p_map, real_t, p_connection_margin);
 	virtual real_t map_get_edge_connection_margin(RID p_map) const;
 
+	COMMAND_2(map_set_cluster_size, RID, p_map, real_t, p_cluster_size);
+	virtual real_t map_get_cluster_size(RID p_map) const;
+
 	virtual Vector<Vector3> map_get_path(RID p_map, Vector3 p_origin, Vector3 p_destination, bool p_optimize, uint32_t p_layers = 1) const;
 
 	virtual Vector3 map_get_closest_point_to_segment(RID p_map, const Vector3 &p_from, const Vector3 &p_to, const bool p_use_collision = false) const;
@@ -109,6 +134,10 @@ public:
 	virtual Vector3 map_get_closest_point_normal(RID p_map, const Vector3 &p_point) const;
 	virtual RID map_get_closest_point_owner(RID p_map, const Vector3 &p_point) const;
 
+	virtual int64_t map_get_path_async(RID p_map, Vector3 p_origin, Vector3 p_destination, bool p_optimize, uint32_t p_layers = 1, const Callable &p_callback = Callable()) const;
+	virtual bool path_query_is_done(int64_t p_query) const;
+	virtual Vector<Vector3> path_query_get_result(int64_t p_query) const;
+
 	virtual RID region_create() const;
 	COMMAND_2(region_set_map, RID, p_region, RID, p_map);
 	COMMAND_2(region_set_layers, RID, p_region, uint32_t, p_layers);
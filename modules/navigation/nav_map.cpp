@@ -30,11 +30,13 @@
 
 #include "nav_map.h"
 
-#include "core/os/threaded_array_processor.h"
+#include "core/os/worker_thread_pool.h"
+#include "core/templates/hash_map.h"
 #include "nav_region.h"
 #include "rvo_agent.h"
 
 #include <algorithm>
+#include <functional>
 
 /**
 	@author AndreaCatania
@@ -42,6 +44,201 @@
 
 #define THREE_POINTS_CROSS_PRODUCT(m_a, m_b, m_c) (((m_c) - (m_a)).cross((m_b) - (m_a)))
 
+/// Search state of the path queries, kept per thread so the queries don't
+/// allocate once warmed up. Polygons are marked as visited by stamping them
+/// with the generation of the current search, instead of clearing arrays.
+struct NavMapPathScratch {
+	/// The navigation polys reached by the current search.
+	std::vector<gd::NavigationPoly> navigation_polys;
+
+	/// Binary min heap of navigation poly IDs to visit, ordered by cost.
+	std::vector<uint32_t> open_heap;
+
+	/// Navigation poly ID of each map polygon, valid when its generation is the current one.
+	std::vector<uint32_t> polygon_navigation_ids;
+	std::vector<uint32_t> polygon_generations;
+	uint32_t generation = 0;
+
+	void begin(size_t p_polygon_count) {
+		navigation_polys.clear();
+		open_heap.clear();
+
+		if (polygon_generations.size() < p_polygon_count) {
+			polygon_navigation_ids.resize(p_polygon_count);
+			polygon_generations.resize(p_polygon_count, 0);
+		}
+
+		generation++;
+		if (generation == 0) {
+			// Wrapped around, old stamps could match again.
+			std::fill(polygon_generations.begin(), polygon_generations.end(), 0);
+			generation = 1;
+		}
+	}
+
+	_FORCE_INLINE_ uint32_t get_visited(uint32_t p_polygon_id) const {
+		return polygon_generations[p_polygon_id] == generation ? polygon_navigation_ids[p_polygon_id] : UINT32_MAX;
+	}
+
+	_FORCE_INLINE_ void set_visited(uint32_t p_polygon_id, uint32_t p_navigation_id) {
+		polygon_generations[p_polygon_id] = generation;
+		polygon_navigation_ids[p_polygon_id] = p_navigation_id;
+	}
+
+	_FORCE_INLINE_ bool heap_less(uint32_t p_a, uint32_t p_b) const {
+		const gd::NavigationPoly &a = navigation_polys[p_a];
+		const gd::NavigationPoly &b = navigation_polys[p_b];
+		// Ties are broken by discovery order, to keep the paths deterministic.
+		return a.cost == b.cost ? a.self_id < b.self_id : a.cost < b.cost;
+	}
+
+	_FORCE_INLINE_ void heap_set(uint32_t p_index, uint32_t p_navigation_id) {
+		open_heap[p_index] = p_navigation_id;
+		navigation_polys[p_navigation_id].heap_index = p_index;
+	}
+
+	void heap_sift_up(uint32_t p_index) {
+		const uint32_t navigation_id = open_heap[p_index];
+		while (p_index > 0) {
+			const uint32_t parent = (p_index - 1) / 2;
+			if (!heap_less(navigation_id, open_heap[parent])) {
+				break;
+			}
+			heap_set(p_index, open_heap[parent]);
+			p_index = parent;
+		}
+		heap_set(p_index, navigation_id);
+	}
+
+	void heap_sift_down(uint32_t p_index) {
+		const uint32_t navigation_id = open_heap[p_index];
+		const uint32_t size = open_heap.size();
+		while (true) {
+			uint32_t child = p_index * 2 + 1;
+			if (child >= size) {
+				break;
+			}
+			if (child + 1 < size && heap_less(open_heap[child + 1], open_heap[child])) {
+				child++;
+			}
+			if (!heap_less(open_heap[child], navigation_id)) {
+				break;
+			}
+			heap_set(p_index, open_heap[child]);
+			p_index = child;
+		}
+		heap_set(p_index, navigation_id);
+	}
+
+	void heap_push(uint32_t p_navigation_id) {
+		open_heap.push_back(p_navigation_id);
+		heap_sift_up(open_heap.size() - 1);
+	}
+
+	uint32_t heap_pop() {
+		const uint32_t navigation_id = open_heap[0];
+		navigation_polys[navigation_id].heap_index = UINT32_MAX;
+
+		const uint32_t last = open_heap.back();
+		open_heap.pop_back();
+		if (!open_heap.empty()) {
+			open_heap[0] = last;
+			heap_sift_down(0);
+		}
+		return navigation_id;
+	}
+
+	/// Restores the heap order after the cost of the poly at `p_index` was reduced.
+	void heap_decrease(uint32_t p_index) {
+		heap_sift_up(p_index);
+	}
+
+	/// State of the searches over the clusters, per map polygon. The extra last
+	/// entry is the end node of the portals graph search.
+	std::vector<float> cluster_costs;
+	std::vector<uint32_t> cluster_parents;
+	std::vector<uint32_t> cluster_generations;
+	uint32_t cluster_generation = 0;
+
+	/// Binary min heap of (cost, polygon ID); the outdated entries are skipped when popped.
+	std::vector<std::pair<float, uint32_t>> cluster_heap;
+
+	/// Travel costs between the begin and end polygons and the portals of their clusters.
+	std::vector<float> begin_portal_costs;
+	std::vector<float> end_portal_costs;
+
+	/// Portals of the clusters of a region, before they are compared with the cached ones.
+	std::vector<std::vector<uint32_t>> cluster_portals;
+
+	/// Clusters the path search may go through, when their generation is the current one.
+	std::vector<uint32_t> corridor_generations;
+	uint32_t corridor_generation = 0;
+
+	void cluster_begin(size_t p_polygon_count) {
+		cluster_heap.clear();
+
+		if (cluster_generations.size() < p_polygon_count + 1) {
+			cluster_costs.resize(p_polygon_count + 1);
+			cluster_parents.resize(p_polygon_count + 1);
+			cluster_generations.resize(p_polygon_count + 1, 0);
+		}
+
+		cluster_generation++;
+		if (cluster_generation == 0) {
+			std::fill(cluster_generations.begin(), cluster_generations.end(), 0);
+			cluster_generation = 1;
+		}
+	}
+
+	_FORCE_INLINE_ float get_cluster_cost(uint32_t p_polygon_id) const {
+		return cluster_generations[p_polygon_id] == cluster_generation ? cluster_costs[p_polygon_id] : FLT_MAX;
+	}
+
+	_FORCE_INLINE_ void set_cluster_cost(uint32_t p_polygon_id, float p_cost, uint32_t p_parent_id) {
+		cluster_generations[p_polygon_id] = cluster_generation;
+		cluster_costs[p_polygon_id] = p_cost;
+		cluster_parents[p_polygon_id] = p_parent_id;
+	}
+
+	void cluster_heap_push(float p_cost, uint32_t p_polygon_id) {
+		cluster_heap.push_back(std::make_pair(p_cost, p_polygon_id));
+		std::push_heap(cluster_heap.begin(), cluster_heap.end(), std::greater<std::pair<float, uint32_t>>());
+	}
+
+	std::pair<float, uint32_t> cluster_heap_pop() {
+		std::pop_heap(cluster_heap.begin(), cluster_heap.end(), std::greater<std::pair<float, uint32_t>>());
+		const std::pair<float, uint32_t> top = cluster_heap.back();
+		cluster_heap.pop_back();
+		return top;
+	}
+
+	void corridor_begin(size_t p_cluster_count) {
+		if (corridor_generations.size() < p_cluster_count) {
+			corridor_generations.resize(p_cluster_count, 0);
+		}
+
+		corridor_generation++;
+		if (corridor_generation == 0) {
+			std::fill(corridor_generations.begin(), corridor_generations.end(), 0);
+			corridor_generation = 1;
+		}
+	}
+
+	_FORCE_INLINE_ void add_to_corridor(uint32_t p_cluster) {
+		corridor_generations[p_cluster] = corridor_generation;
+	}
+
+	_FORCE_INLINE_ bool is_in_corridor(uint32_t p_cluster) const {
+		return corridor_generations[p_cluster] == corridor_generation;
+	}
+};
+
+static thread_local NavMapPathScratch path_scratch;
+
+NavMap::NavMap() :
+		snapshot(memnew(NavMapSnapshot)) {
+}
+
 void NavMap::set_up(Vector3 p_up) {
 	up = p_up;
 	regenerate_polygons = true;
@@ -57,6 +254,11 @@ void NavMap::set_edge_connection_margin(float p_edge_connection_margin) {
 	regenerate_links = true;
 }
 
+void NavMap::set_cluster_size(real_t p_cluster_size) {
+	cluster_size = MAX(p_cluster_size, 0.0);
+	regenerate_clusters = true;
+}
+
 gd::PointKey NavMap::get_point_key(const Vector3 &p_pos) const {
 	const int x = int(Math::floor(p_pos.x / cell_size));
 	const int y = int(Math::floor(p_pos.y / cell_size));
@@ -70,47 +272,12 @@ gd::PointKey NavMap::get_point_key(const Vector3 &p_pos) const {
 	return p;
 }
 
-Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p_optimize, uint32_t p_layers) const {
+Vector<Vector3> NavMapSnapshot::get_path(Vector3 p_origin, Vector3 p_destination, bool p_optimize, uint32_t p_layers) const {
 	// Find the start poly and the end poly on this map.
-	const gd::Polygon *begin_poly = nullptr;
-	const gd::Polygon *end_poly = nullptr;
 	Vector3 begin_point;
 	Vector3 end_point;
-	float begin_d = 1e20;
-	float end_d = 1e20;
-	// Find the initial poly and the end poly on this map.
-	for (size_t i(0); i < polygons.size(); i++) {
-		const gd::Polygon &p = polygons[i];
-
-		// Only consider the polygon if it in a region with compatible layers.
-		if ((p_layers & p.owner->get_layers()) == 0) {
-			continue;
-		}
-
-		// For each point cast a face and check the distance between the origin/destination
-		for (size_t point_id = 0; point_id < p.points.size(); point_id++) {
-			const Vector3 p1 = p.points[point_id].pos;
-			const Vector3 p2 = p.points[(point_id + 1) % p.points.size()].pos;
-			const Vector3 p3 = p.points[(point_id + 2) % p.points.size()].pos;
-			const Face3 face(p1, p2, p3);
-
-			Vector3 point = face.get_closest_point_to(p_origin);
-			float distance_to_point = point.distance_to(p_origin);
-			if (distance_to_point < begin_d) {
-				begin_d = distance_to_point;
-				begin_poly = &p;
-				begin_point = point;
-			}
-
-			point = face.get_closest_point_to(p_destination);
-			distance_to_point = point.distance_to(p_destination);
-			if (distance_to_point < end_d) {
-				end_d = distance_to_point;
-				end_poly = &p;
-				end_point = point;
-			}
-		}
-	}
+	const gd::Polygon *begin_poly = get_closest_polygon(p_origin, true, p_layers, begin_point);
+	const gd::Polygon *end_poly = get_closest_polygon(p_destination, true, p_layers, end_point);
 
 	// Check for trivial cases
 	if (!begin_poly || !end_poly) {
@@ -124,9 +291,15 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 		return path;
 	}
 
+	NavMapPathScratch &scratch = path_scratch;
+
+	// With the hierarchical search, only go through the clusters on the way to the end polygon.
+	bool use_corridor = !clusters.empty() && begin_poly->cluster != end_poly->cluster && find_corridor(begin_poly, end_poly, end_point, p_layers, scratch);
+
+	scratch.begin(polygons.size());
+
 	// List of all reachable navigation polys.
-	std::vector<gd::NavigationPoly> navigation_polys;
-	navigation_polys.reserve(polygons.size() * 0.75);
+	std::vector<gd::NavigationPoly> &navigation_polys = scratch.navigation_polys;
 
 	// Add the start polygon to the reachable navigation polygons.
 	gd::NavigationPoly begin_navigation_poly = gd::NavigationPoly(begin_poly);
@@ -135,10 +308,7 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 	begin_navigation_poly.back_navigation_edge_pathway_start = begin_point;
 	begin_navigation_poly.back_navigation_edge_pathway_end = begin_point;
 	navigation_polys.push_back(begin_navigation_poly);
-
-	// List of polygon IDs to visit.
-	List<uint32_t> to_visit;
-	to_visit.push_back(0);
+	scratch.set_visited(begin_poly->id, 0);
 
 	// This is an implementation of the A* algorithm.
 	int least_cost_id = 0;
@@ -160,7 +330,12 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 				const gd::Edge::Connection &connection = edge.connections[connection_index];
 
 				// Only consider the connection to another polygon if this polygon is in a region with compatible layers.
-				if ((p_layers & connection.polygon->owner->get_layers()) == 0) {
+				if ((p_layers & connection.polygon->owner_layers) == 0) {
+					continue;
+				}
+
+				// Stay in the corridor found by the hierarchical search.
+				if (use_corridor && !scratch.is_in_corridor(connection.polygon->cluster)) {
 					continue;
 				}
 
@@ -168,20 +343,21 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 				const Vector3 new_entry = Geometry3D::get_closest_point_to_segment(least_cost_poly->entry, pathway);
 				const float new_distance = least_cost_poly->entry.distance_to(new_entry) + least_cost_poly->traveled_distance;
 
-				const std::vector<gd::NavigationPoly>::iterator it = std::find(
-						navigation_polys.begin(),
-						navigation_polys.end(),
-						gd::NavigationPoly(connection.polygon));
-
-				if (it != navigation_polys.end()) {
+				const uint32_t visited_id = scratch.get_visited(connection.polygon->id);
+				if (visited_id != UINT32_MAX) {
 					// Polygon already visited, check if we can reduce the travel cost.
-					if (new_distance < it->traveled_distance) {
-						it->back_navigation_poly_id = least_cost_id;
-						it->back_navigation_edge = connection.edge;
-						it->back_navigation_edge_pathway_start = connection.pathway_start;
-						it->back_navigation_edge_pathway_end = connection.pathway_end;
-						it->traveled_distance = new_distance;
-						it->entry = new_entry;
+					gd::NavigationPoly &visited_poly = navigation_polys[visited_id];
+					if (new_distance < visited_poly.traveled_distance) {
+						visited_poly.back_navigation_poly_id = least_cost_id;
+						visited_poly.back_navigation_edge = connection.edge;
+						visited_poly.back_navigation_edge_pathway_start = connection.pathway_start;
+						visited_poly.back_navigation_edge_pathway_end = connection.pathway_end;
+						visited_poly.traveled_distance = new_distance;
+						visited_poly.entry = new_entry;
+						visited_poly.cost = new_distance + new_entry.distance_to(end_point);
+						if (visited_poly.heap_index != UINT32_MAX) {
+							scratch.heap_decrease(visited_poly.heap_index);
+						}
 					}
 				} else {
 					// Add the neighbour polygon to the reachable ones.
@@ -193,19 +369,36 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 					new_navigation_poly.back_navigation_edge_pathway_end = connection.pathway_end;
 					new_navigation_poly.traveled_distance = new_distance;
 					new_navigation_poly.entry = new_entry;
+					new_navigation_poly.cost = new_distance + new_entry.distance_to(end_point);
 					navigation_polys.push_back(new_navigation_poly);
+					scratch.set_visited(connection.polygon->id, new_navigation_poly.self_id);
 
 					// Add the neighbour polygon to the polygons to visit.
-					to_visit.push_back(navigation_polys.size() - 1);
+					scratch.heap_push(new_navigation_poly.self_id);
 				}
+
+				// The polygons may have been reallocated.
+				least_cost_poly = &navigation_polys[least_cost_id];
 			}
 		}
 
-		// Removes the least cost polygon from the list of polygons to visit so we can advance.
-		to_visit.erase(least_cost_id);
-
 		// When the list of polygons to visit is empty at this point it means the End Polygon is not reachable
-		if (to_visit.size() == 0) {
+		if (scratch.open_heap.empty()) {
+			if (use_corridor) {
+				// The corridor clusters are not connected inside, search the whole map.
+				use_corridor = false;
+				gd::NavigationPoly np = navigation_polys[0];
+				scratch.begin(polygons.size());
+				navigation_polys.push_back(np);
+				scratch.set_visited(begin_poly->id, 0);
+				least_cost_id = 0;
+
+				reachable_end = nullptr;
+				reachable_d = 1e30;
+
+				continue;
+			}
+
 			// Thus use the further reachable polygon
 			ERR_BREAK_MSG(is_reachable == false, "It's not expect to not find the most reachable polygons");
 			is_reachable = false;
@@ -216,9 +409,9 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 
 			// Set as end point the furthest reachable point.
 			end_poly = reachable_end;
-			end_d = 1e20;
+			float end_d = 1e20;
 			for (size_t point_id = 2; point_id < end_poly->points.size(); point_id++) {
-				Face3 f(end_poly->points[point_id - 2].pos, end_poly->points[point_id - 1].pos, end_poly->points[point_id].pos);
+				Face3 f(end_poly->points[0].pos, end_poly->points[point_id - 1].pos, end_poly->points[point_id].pos);
 				Vector3 spoint = f.get_closest_point_to(p_destination);
 				float dpoint = spoint.distance_to(p_destination);
 				if (dpoint < end_d) {
@@ -227,30 +420,20 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 				}
 			}
 
-			// Reset open and navigation_polys
+			// Reset the search, starting again from the begin polygon.
 			gd::NavigationPoly np = navigation_polys[0];
-			navigation_polys.clear();
+			scratch.begin(polygons.size());
 			navigation_polys.push_back(np);
-			to_visit.clear();
-			to_visit.push_back(0);
+			scratch.set_visited(begin_poly->id, 0);
+			least_cost_id = 0;
 
 			reachable_end = nullptr;
 
 			continue;
 		}
 
-		// Find the polygon with the minimum cost from the list of polygons to visit.
-		least_cost_id = -1;
-		float least_cost = 1e30;
-		for (List<uint32_t>::Element *element = to_visit.front(); element != nullptr; element = element->next()) {
-			gd::NavigationPoly *np = &navigation_polys[element->get()];
-			float cost = np->traveled_distance;
-			cost += np->entry.distance_to(end_point);
-			if (cost < least_cost) {
-				least_cost_id = np->self_id;
-				least_cost = cost;
-			}
-		}
+		// Take the polygon with the minimum cost from the polygons to visit.
+		least_cost_id = scratch.heap_pop();
 
 		// Stores the further reachable end polygon, in case our goal is not reachable.
 		if (is_reachable) {
@@ -261,8 +444,6 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 			}
 		}
 
-		ERR_BREAK(least_cost_id == -1);
-
 		// Check if we reached the end
 		if (navigation_polys[least_cost_id].poly == end_poly) {
 			found_route = true;
@@ -369,133 +550,369 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 	return path;
 }
 
-Vector3 NavMap::get_closest_point_to_segment(const Vector3 &p_from, const Vector3 &p_to, const bool p_use_collision) const {
-	bool use_collision = p_use_collision;
-	Vector3 closest_point;
-	real_t closest_point_d = 1e20;
+void NavMapSnapshot::search_cluster(const gd::Polygon &p_from, NavMapPathScratch &r_scratch) const {
+	r_scratch.cluster_begin(polygons.size());
+	r_scratch.set_cluster_cost(p_from.id, 0.0, UINT32_MAX);
+	r_scratch.cluster_heap_push(0.0, p_from.id);
 
-	// Find the initial poly and the end poly on this map.
-	for (size_t i(0); i < polygons.size(); i++) {
-		const gd::Polygon &p = polygons[i];
+	// Dijkstra search between the polygon centers.
+	while (!r_scratch.cluster_heap.empty()) {
+		const std::pair<float, uint32_t> top = r_scratch.cluster_heap_pop();
+		if (top.first > r_scratch.get_cluster_cost(top.second)) {
+			continue; // Outdated entry.
+		}
 
-		// For each point cast a face and check the distance to the segment
-		for (size_t point_id = 2; point_id < p.points.size(); point_id += 1) {
-			const Face3 f(p.points[point_id - 2].pos, p.points[point_id - 1].pos, p.points[point_id].pos);
-			Vector3 inters;
-			if (f.intersects_segment(p_from, p_to, &inters)) {
-				const real_t d = closest_point_d = p_from.distance_to(inters);
-				if (use_collision == false) {
-					closest_point = inters;
-					use_collision = true;
-					closest_point_d = d;
-				} else if (closest_point_d > d) {
-					closest_point = inters;
-					closest_point_d = d;
+		const gd::Polygon &poly = polygons[top.second];
+		for (size_t i = 0; i < poly.edges.size(); i++) {
+			const gd::Edge &edge = poly.edges[i];
+			for (int connection_index = 0; connection_index < edge.connections.size(); connection_index++) {
+				const gd::Polygon *other = edge.connections[connection_index].polygon;
+				if (other->cluster != p_from.cluster) {
+					continue;
+				}
+
+				const float cost = top.first + poly.center.distance_to(other->center);
+				if (cost < r_scratch.get_cluster_cost(other->id)) {
+					r_scratch.set_cluster_cost(other->id, cost, poly.id);
+					r_scratch.cluster_heap_push(cost, other->id);
 				}
 			}
 		}
+	}
+}
+
+bool NavMapSnapshot::find_corridor(const gd::Polygon *p_begin, const gd::Polygon *p_end, const Vector3 &p_end_point, uint32_t p_layers, NavMapPathScratch &r_scratch) const {
+	const gd::Cluster &begin_cluster = clusters[p_begin->cluster];
+	const gd::Cluster &end_cluster = clusters[p_end->cluster];
+
+	// Connect the begin and end polygons to the portals of their clusters.
+	search_cluster(*p_end, r_scratch);
+	r_scratch.end_portal_costs.resize(end_cluster.portals.size());
+	for (size_t i = 0; i < end_cluster.portals.size(); i++) {
+		r_scratch.end_portal_costs[i] = r_scratch.get_cluster_cost(end_cluster.portals[i]);
+	}
+
+	search_cluster(*p_begin, r_scratch);
+	r_scratch.begin_portal_costs.resize(begin_cluster.portals.size());
+	for (size_t i = 0; i < begin_cluster.portals.size(); i++) {
+		r_scratch.begin_portal_costs[i] = r_scratch.get_cluster_cost(begin_cluster.portals[i]);
+	}
+
+	// A* search over the portals graph: the portals of a cluster are connected by their
+	// precomputed travel costs, and to the portals of the neighbor clusters by their connections.
+	const uint32_t end_node = polygons.size();
+	r_scratch.cluster_begin(polygons.size());
+	for (size_t i = 0; i < begin_cluster.portals.size(); i++) {
+		const float cost = r_scratch.begin_portal_costs[i];
+		if (cost == FLT_MAX) {
+			continue;
+		}
+		const uint32_t portal = begin_cluster.portals[i];
+		r_scratch.set_cluster_cost(portal, cost, UINT32_MAX);
+		r_scratch.cluster_heap_push(cost + polygons[portal].center.distance_to(p_end_point), portal);
+	}
+
+	bool found = false;
+	while (!r_scratch.cluster_heap.empty()) {
+		const std::pair<float, uint32_t> top = r_scratch.cluster_heap_pop();
+		if (top.second == end_node) {
+			found = true;
+			break;
+		}
 
-		if (use_collision == false) {
-			for (size_t point_id = 0; point_id < p.points.size(); point_id += 1) {
-				Vector3 a, b;
+		const gd::Polygon &portal = polygons[top.second];
+		const float portal_cost = r_scratch.get_cluster_cost(portal.id);
+		if (top.first > portal_cost + portal.center.distance_to(p_end_point) + CMP_EPSILON) {
+			continue; // Outdated entry.
+		}
 
-				Geometry3D::get_closest_points_between_segments(
-						p_from,
-						p_to,
-						p.points[point_id].pos,
-						p.points[(point_id + 1) % p.points.size()].pos,
-						a,
-						b);
+		// Other portals of the same cluster.
+		const gd::Cluster &cluster = clusters[portal.cluster];
+		const float *portal_costs = &cluster.portal_costs[portal.portal_index * cluster.portals.size()];
+		for (size_t i = 0; i < cluster.portals.size(); i++) {
+			if (i == portal.portal_index || portal_costs[i] == FLT_MAX) {
+				continue;
+			}
+			const uint32_t other = cluster.portals[i];
+			const float cost = portal_cost + portal_costs[i];
+			if (cost < r_scratch.get_cluster_cost(other)) {
+				r_scratch.set_cluster_cost(other, cost, portal.id);
+				r_scratch.cluster_heap_push(cost + polygons[other].center.distance_to(p_end_point), other);
+			}
+		}
 
-				const real_t d = a.distance_to(b);
-				if (d < closest_point_d) {
-					closest_point_d = d;
-					closest_point = b;
+		// Portals of the neighbor clusters.
+		for (size_t i = 0; i < portal.edges.size(); i++) {
+			const gd::Edge &edge = portal.edges[i];
+			for (int connection_index = 0; connection_index < edge.connections.size(); connection_index++) {
+				const gd::Polygon *other = edge.connections[connection_index].polygon;
+				if (other->cluster == portal.cluster || other->portal_index == UINT32_MAX || (p_layers & other->owner_layers) == 0) {
+					continue;
+				}
+				const float cost = portal_cost + portal.center.distance_to(other->center);
+				if (cost < r_scratch.get_cluster_cost(other->id)) {
+					r_scratch.set_cluster_cost(other->id, cost, portal.id);
+					r_scratch.cluster_heap_push(cost + other->center.distance_to(p_end_point), other->id);
 				}
 			}
 		}
+
+		// The end polygon, from the portals of its cluster.
+		if (portal.cluster == p_end->cluster && r_scratch.end_portal_costs[portal.portal_index] != FLT_MAX) {
+			const float cost = portal_cost + r_scratch.end_portal_costs[portal.portal_index];
+			if (cost < r_scratch.get_cluster_cost(end_node)) {
+				r_scratch.set_cluster_cost(end_node, cost, portal.id);
+				r_scratch.cluster_heap_push(cost, end_node);
+			}
+		}
+	}
+
+	if (!found) {
+		return false;
 	}
 
+	// The corridor is made of the clusters of the portals on the way.
+	r_scratch.corridor_begin(clusters.size());
+	r_scratch.add_to_corridor(p_begin->cluster);
+	r_scratch.add_to_corridor(p_end->cluster);
+	for (uint32_t node = r_scratch.cluster_parents[end_node]; node != UINT32_MAX; node = r_scratch.cluster_parents[node]) {
+		r_scratch.add_to_corridor(polygons[node].cluster);
+	}
+
+	return true;
+}
+
+Vector3 NavMapSnapshot::get_closest_point(const Vector3 &p_point) const {
+	Vector3 closest_point;
+	get_closest_polygon(p_point, false, 0, closest_point);
 	return closest_point;
 }
 
-Vector3 NavMap::get_closest_point(const Vector3 &p_point) const {
-	// TODO this is really not optimal, please redesign the API to directly return all this data
+Vector3 NavMapSnapshot::get_closest_point_normal(const Vector3 &p_point) const {
+	Vector3 closest_point;
+	Vector3 closest_point_normal;
+	get_closest_polygon(p_point, false, 0, closest_point, &closest_point_normal);
+	return closest_point_normal;
+}
+
+RID NavMapSnapshot::get_closest_point_owner(const Vector3 &p_point) const {
+	Vector3 closest_point;
+	const gd::Polygon *closest_polygon = get_closest_polygon(p_point, false, 0, closest_point);
+	if (!closest_polygon) {
+		return RID();
+	}
+	return closest_polygon->owner_self;
+}
 
+namespace {
+struct ClosestPolygonQuery {
+	Vector3 point;
+	bool check_layers = false;
+	uint32_t layers = 0;
+
+	const gd::Polygon *closest_polygon = nullptr;
 	Vector3 closest_point;
-	real_t closest_point_d = 1e20;
+	Vector3 closest_normal;
+	real_t closest_distance = 1e20;
 
-	// Find the initial poly and the end poly on this map.
-	for (size_t i(0); i < polygons.size(); i++) {
-		const gd::Polygon &p = polygons[i];
+	_FORCE_INLINE_ bool operator()(void *p_data) {
+		const gd::Polygon *polygon = (const gd::Polygon *)p_data;
+		if (polygon == closest_polygon) {
+			return false;
+		}
+		if (check_layers && (layers & polygon->owner_layers) == 0) {
+			return false;
+		}
 
-		// For each point cast a face and check the distance to the point
-		for (size_t point_id = 2; point_id < p.points.size(); point_id += 1) {
-			const Face3 f(p.points[point_id - 2].pos, p.points[point_id - 1].pos, p.points[point_id].pos);
-			const Vector3 inters = f.get_closest_point_to(p_point);
-			const real_t d = inters.distance_to(p_point);
-			if (d < closest_point_d) {
-				closest_point = inters;
-				closest_point_d = d;
+		// Map polygons are convex, so they are covered by a fan of triangles.
+		for (size_t point_id = 2; point_id < polygon->points.size(); point_id++) {
+			const Face3 face(polygon->points[0].pos, polygon->points[point_id - 1].pos, polygon->points[point_id].pos);
+			const Vector3 face_point = face.get_closest_point_to(point);
+			const real_t distance = face_point.distance_to(point);
+			if (distance < closest_distance) {
+				closest_distance = distance;
+				closest_polygon = polygon;
+				closest_point = face_point;
+				closest_normal = face.get_plane().normal;
 			}
 		}
+
+		return false; // Visit all the polygons in the box.
 	}
+};
+} // namespace
 
-	return closest_point;
+static _FORCE_INLINE_ bool _is_finite(const Vector3 &p_vector) {
+	return !Math::is_nan(p_vector.x) && !Math::is_nan(p_vector.y) && !Math::is_nan(p_vector.z) && !Math::is_inf(p_vector.x) && !Math::is_inf(p_vector.y) && !Math::is_inf(p_vector.z);
 }
 
-Vector3 NavMap::get_closest_point_normal(const Vector3 &p_point) const {
-	// TODO this is really not optimal, please redesign the API to directly return all this data
+namespace {
+struct SegmentIntersectionQuery {
+	Vector3 from;
+	Vector3 to;
 
+	bool found = false;
 	Vector3 closest_point;
-	Vector3 closest_point_normal;
-	real_t closest_point_d = 1e20;
+	real_t closest_distance = 1e20;
+
+	_FORCE_INLINE_ bool operator()(void *p_data) {
+		const gd::Polygon *polygon = (const gd::Polygon *)p_data;
+		for (size_t point_id = 2; point_id < polygon->points.size(); point_id++) {
+			const Face3 face(polygon->points[0].pos, polygon->points[point_id - 1].pos, polygon->points[point_id].pos);
+			Vector3 intersection;
+			if (!face.intersects_segment(from, to, &intersection)) {
+				continue;
+			}
+			const real_t distance = from.distance_to(intersection);
+			if (distance < closest_distance) {
+				found = true;
+				closest_distance = distance;
+				closest_point = intersection;
+			}
+		}
 
-	// Find the initial poly and the end poly on this map.
-	for (size_t i(0); i < polygons.size(); i++) {
-		const gd::Polygon &p = polygons[i];
+		return false; // Visit all the polygons along the segment.
+	}
+};
+
+struct SegmentClosestEdgeQuery {
+	Vector3 from;
+	Vector3 to;
 
-		// For each point cast a face and check the distance to the point
-		for (size_t point_id = 2; point_id < p.points.size(); point_id += 1) {
-			const Face3 f(p.points[point_id - 2].pos, p.points[point_id - 1].pos, p.points[point_id].pos);
-			const Vector3 inters = f.get_closest_point_to(p_point);
-			const real_t d = inters.distance_to(p_point);
-			if (d < closest_point_d) {
-				closest_point = inters;
-				closest_point_normal = f.get_plane().normal;
-				closest_point_d = d;
+	bool found = false;
+	Vector3 closest_point;
+	real_t closest_distance = 1e20;
+
+	_FORCE_INLINE_ bool operator()(void *p_data) {
+		const gd::Polygon *polygon = (const gd::Polygon *)p_data;
+		for (size_t point_id = 0; point_id < polygon->points.size(); point_id++) {
+			Vector3 segment_point, edge_point;
+			Geometry3D::get_closest_points_between_segments(from, to, polygon->points[point_id].pos, polygon->points[(point_id + 1) % polygon->points.size()].pos, segment_point, edge_point);
+			const real_t distance = segment_point.distance_to(edge_point);
+			if (distance < closest_distance) {
+				found = true;
+				closest_distance = distance;
+				closest_point = edge_point;
 			}
 		}
+
+		return false; // Visit all the polygons in the box.
+	}
+};
+} // namespace
+
+Vector3 NavMapSnapshot::get_closest_point_to_segment(const Vector3 &p_from, const Vector3 &p_to, const bool p_use_collision) const {
+	if (polygons_bvh.is_empty()) {
+		return Vector3();
+	}
+	ERR_FAIL_COND_V_MSG(!_is_finite(p_from) || !_is_finite(p_to), Vector3(), "The segment must be finite.");
+
+	// The closest intersection with the polygons along the segment.
+	SegmentIntersectionQuery intersection_query;
+	intersection_query.from = p_from;
+	intersection_query.to = p_to;
+	polygons_bvh.ray_query(p_from, p_to, intersection_query);
+	if (intersection_query.found || p_use_collision) {
+		return intersection_query.closest_point;
+	}
+
+	// Otherwise the point of the polygon edges closest to the segment. As in get_closest_polygon(),
+	// search a box around the segment, growing it until it contains an edge closer than the growth.
+	SegmentClosestEdgeQuery edge_query;
+	edge_query.from = p_from;
+	edge_query.to = p_to;
+
+	AABB segment_aabb(p_from, Vector3());
+	segment_aabb.expand_to(p_to);
+	real_t half_size = MAX(cell_size * 4.0, CMP_EPSILON);
+	for (int axis = 0; axis < 3; axis++) {
+		// Skip the growth steps needed to reach the map.
+		half_size = MAX(half_size, polygons_aabb.position[axis] - (segment_aabb.position[axis] + segment_aabb.size[axis]));
+		half_size = MAX(half_size, segment_aabb.position[axis] - (polygons_aabb.position[axis] + polygons_aabb.size[axis]));
+	}
+
+	for (int i = 0; i < 128; i++) {
+		const AABB box = segment_aabb.grow(half_size);
+		polygons_bvh.aabb_query(box, edge_query);
+
+		if (edge_query.found && edge_query.closest_distance <= half_size) {
+			break;
+		}
+		if (box.encloses(polygons_aabb)) {
+			break;
+		}
+
+		half_size = MAX(half_size * 2.0, edge_query.closest_distance);
 	}
 
-	return closest_point_normal;
+	return edge_query.closest_point;
 }
 
-RID NavMap::get_closest_point_owner(const Vector3 &p_point) const {
-	// TODO this is really not optimal, please redesign the API to directly return all this data
+const gd::Polygon *NavMapSnapshot::get_closest_polygon(const Vector3 &p_point, bool p_check_layers, uint32_t p_layers, Vector3 &r_closest_point, Vector3 *r_closest_normal) const {
+	if (polygons_bvh.is_empty()) {
+		return nullptr;
+	}
+	ERR_FAIL_COND_V_MSG(!_is_finite(p_point), nullptr, "The point must be finite.");
 
-	Vector3 closest_point;
-	RID closest_point_owner;
-	real_t closest_point_d = 1e20;
+	ClosestPolygonQuery query;
+	query.point = p_point;
+	query.check_layers = p_check_layers;
+	query.layers = p_layers;
 
-	// Find the initial poly and the end poly on this map.
-	for (size_t i(0); i < polygons.size(); i++) {
-		const gd::Polygon &p = polygons[i];
+	// Search the polygons in a box around the point, growing it until it contains a polygon closer
+	// than the box half size (nothing outside the box can be closer) or it contains the whole map.
+	const Vector3 map_end = polygons_aabb.position + polygons_aabb.size;
+	const Vector3 point_in_map = Vector3(CLAMP(p_point.x, polygons_aabb.position.x, map_end.x), CLAMP(p_point.y, polygons_aabb.position.y, map_end.y), CLAMP(p_point.z, polygons_aabb.position.z, map_end.z));
+	real_t half_size = point_in_map.distance_to(p_point) + MAX(cell_size * 4.0, CMP_EPSILON);
 
-		// For each point cast a face and check the distance to the point
-		for (size_t point_id = 2; point_id < p.points.size(); point_id += 1) {
-			const Face3 f(p.points[point_id - 2].pos, p.points[point_id - 1].pos, p.points[point_id].pos);
-			const Vector3 inters = f.get_closest_point_to(p_point);
-			const real_t d = inters.distance_to(p_point);
-			if (d < closest_point_d) {
-				closest_point = inters;
-				closest_point_owner = p.owner->get_self();
-				closest_point_d = d;
-			}
+	// Doubling the box this many times covers any finite map, this only guards against a never ending loop.
+	for (int i = 0; i < 128; i++) {
+		const AABB box(p_point - Vector3(half_size, half_size, half_size), Vector3(half_size, half_size, half_size) * 2.0);
+		polygons_bvh.aabb_query(box, query);
+
+		if (query.closest_polygon && query.closest_distance <= half_size) {
+			break;
+		}
+		if (box.encloses(polygons_aabb)) {
+			break;
+		}
+
+		half_size = MAX(half_size * 2.0, query.closest_distance);
+	}
+
+	if (query.closest_polygon) {
+		r_closest_point = query.closest_point;
+		if (r_closest_normal) {
+			*r_closest_normal = query.closest_normal;
 		}
 	}
 
-	return closest_point_owner;
+	return query.closest_polygon;
+}
+
+NavMapSnapshotRef NavMap::get_snapshot() const {
+	MutexLock lock(snapshot_mutex);
+	return snapshot;
+}
+
+Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p_optimize, uint32_t p_layers) const {
+	return get_snapshot()->get_path(p_origin, p_destination, p_optimize, p_layers);
+}
+
+Vector3 NavMap::get_closest_point_to_segment(const Vector3 &p_from, const Vector3 &p_to, const bool p_use_collision) const {
+	return get_snapshot()->get_closest_point_to_segment(p_from, p_to, p_use_collision);
+}
+
+Vector3 NavMap::get_closest_point(const Vector3 &p_point) const {
+	return get_snapshot()->get_closest_point(p_point);
+}
+
+Vector3 NavMap::get_closest_point_normal(const Vector3 &p_point) const {
+	return get_snapshot()->get_closest_point_normal(p_point);
+}
+
+RID NavMap::get_closest_point_owner(const Vector3 &p_point) const {
+	return get_snapshot()->get_closest_point_owner(p_point);
 }
 
 void NavMap::add_region(NavRegion *p_region) {
@@ -518,7 +935,6 @@ bool NavMap::has_agent(RvoAgent *agent) const {
 void NavMap::add_agent(RvoAgent *agent) {
 	if (!has_agent(agent)) {
 		agents.push_back(agent);
-		agents_dirty = true;
 	}
 }
 
@@ -527,7 +943,7 @@ void NavMap::remove_agent(RvoAgent *agent) {
 	const std::vector<RvoAgent *>::iterator it = std::find(agents.begin(), agents.end(), agent);
 	if (it != agents.end()) {
 		agents.erase(it);
-		agents_dirty = true;
+		agent_grid.remove(agent);
 	}
 }
 
@@ -561,12 +977,28 @@ void NavMap::sync() {
 		}
 	}
 
+	if (regenerate_clusters) {
+		for (size_t r(0); r < regions.size(); r++) {
+			regions[r]->set_clusters_dirty(true);
+		}
+		regenerate_links = true;
+	}
+
 	if (regenerate_links) {
 		// Remove regions connections.
 		for (size_t r(0); r < regions.size(); r++) {
 			regions[r]->get_connections().clear();
 		}
 
+		// The running queries keep using the previous snapshot, build a new one.
+		NavMapSnapshotRef new_snapshot;
+		new_snapshot.instantiate();
+		new_snapshot->up = up;
+		new_snapshot->cell_size = cell_size;
+		std::vector<gd::Polygon> &polygons = new_snapshot->polygons;
+		DynamicBVH &polygons_bvh = new_snapshot->polygons_bvh;
+		AABB &polygons_aabb = new_snapshot->polygons_aabb;
+
 		// Resize the polygon count.
 		int count = 0;
 		for (size_t r(0); r < regions.size(); r++) {
@@ -584,6 +1016,34 @@ void NavMap::sync() {
 			count += regions[r]->get_polygons().size();
 		}
 
+		// Give the polygons their map index, used by the path search, and their owner data.
+		for (size_t poly_id(0); poly_id < polygons.size(); poly_id++) {
+			gd::Polygon &poly(polygons[poly_id]);
+			poly.id = poly_id;
+			poly.owner_self = poly.owner->get_self();
+			poly.owner_layers = poly.owner->get_layers();
+		}
+
+		// Build the polygons BVH.
+		for (size_t poly_id(0); poly_id < polygons.size(); poly_id++) {
+			gd::Polygon &poly(polygons[poly_id]);
+			if (poly.points.size() < 3) {
+				continue;
+			}
+
+			AABB poly_aabb(poly.points[0].pos, Vector3());
+			for (size_t p(1); p < poly.points.size(); p++) {
+				poly_aabb.expand_to(poly.points[p].pos);
+			}
+
+			if (polygons_bvh.is_empty()) {
+				polygons_aabb = poly_aabb;
+			} else {
+				polygons_aabb.merge_with(poly_aabb);
+			}
+			polygons_bvh.insert(poly_aabb, &poly);
+		}
+
 		// Group all edges per key.
 		Map<gd::EdgeKey, Vector<gd::Edge::Connection>> connections;
 		for (size_t poly_id(0); poly_id < polygons.size(); poly_id++) {
@@ -690,38 +1150,136 @@ void NavMap::sync() {
 			}
 		}
 
+		if (cluster_size > 0.0) {
+			update_clusters(*new_snapshot.ptr());
+		}
+
+		{
+			MutexLock lock(snapshot_mutex);
+			snapshot = new_snapshot;
+		}
+
 		// Update the update ID.
 		map_update_id = (map_update_id + 1) % 9999999;
 	}
 
-	// Update agents tree.
-	if (agents_dirty) {
-		std::vector<RVO::Agent *> raw_agents;
-		raw_agents.reserve(agents.size());
-		for (size_t i(0); i < agents.size(); i++) {
-			raw_agents.push_back(agents[i]->get_agent());
-		}
-		rvo.buildAgentTree(raw_agents);
-	}
+	// Move the agents to their current grid cell.
+	agent_grid.update(agents);
 
 	regenerate_polygons = false;
 	regenerate_links = false;
-	agents_dirty = false;
+	regenerate_clusters = false;
+}
+
+void NavMap::update_clusters(NavMapSnapshot &r_snapshot) {
+	std::vector<gd::Polygon> &polygons = r_snapshot.polygons;
+	NavMapPathScratch &scratch = path_scratch;
+
+	// The map polygons are the region polygons, one region after the other.
+	uint32_t polygon_base = 0;
+	for (size_t r(0); r < regions.size(); r++) {
+		NavRegion *region = regions[r];
+		gd::RegionClusters &region_clusters = region->get_clusters();
+		const uint32_t polygon_count = region->get_polygons().size();
+		const uint32_t cluster_base = r_snapshot.clusters.size();
+
+		if (region->are_clusters_dirty()) {
+			// Group the polygons by the cell containing their center.
+			region_clusters.polygon_clusters.resize(polygon_count);
+			region_clusters.clusters.clear();
+
+			HashMap<uint64_t, uint32_t> cell_clusters;
+			for (uint32_t i = 0; i < polygon_count; i++) {
+				const Vector3 &center = polygons[polygon_base + i].center;
+				gd::PointKey cell;
+				cell.key = 0;
+				cell.x = int(Math::floor(center.x / cluster_size));
+				cell.y = int(Math::floor(center.y / cluster_size));
+				cell.z = int(Math::floor(center.z / cluster_size));
+
+				const uint32_t *cluster = cell_clusters.getptr(cell.key);
+				if (cluster) {
+					region_clusters.polygon_clusters[i] = *cluster;
+				} else {
+					region_clusters.polygon_clusters[i] = region_clusters.clusters.size();
+					cell_clusters.set(cell.key, region_clusters.clusters.size());
+					region_clusters.clusters.push_back(gd::Cluster());
+				}
+			}
+		}
+
+		for (uint32_t i = 0; i < polygon_count; i++) {
+			polygons[polygon_base + i].cluster = cluster_base + region_clusters.polygon_clusters[i];
+		}
+
+		// The portals are the polygons with an edge shared with another cluster, or with another region.
+		// The links to the other regions change with them, so the portals are found again on every update.
+		std::vector<std::vector<uint32_t>> &cluster_portals = scratch.cluster_portals;
+		cluster_portals.resize(region_clusters.clusters.size());
+		for (size_t c = 0; c < cluster_portals.size(); c++) {
+			cluster_portals[c].clear();
+		}
+		for (uint32_t i = 0; i < polygon_count; i++) {
+			const gd::Polygon &poly = polygons[polygon_base + i];
+			bool is_portal = false;
+			for (size_t e = 0; e < poly.edges.size() && !is_portal; e++) {
+				const gd::Edge &edge = poly.edges[e];
+				for (int c = 0; c < edge.connections.size(); c++) {
+					// The clusters of the next regions are not set yet, check the owner first.
+					const gd::Polygon *other = edge.connections[c].polygon;
+					if (other->owner != poly.owner || other->cluster != poly.cluster) {
+						is_portal = true;
+						break;
+					}
+				}
+			}
+			if (is_portal) {
+				cluster_portals[region_clusters.polygon_clusters[i]].push_back(i);
+			}
+		}
+
+		// Travel costs between the portals of each cluster, only computed again when the portals change.
+		for (size_t c = 0; c < region_clusters.clusters.size(); c++) {
+			gd::Cluster &cluster = region_clusters.clusters[c];
+			if (!region->are_clusters_dirty() && cluster.portals == cluster_portals[c]) {
+				continue;
+			}
+			cluster.portals.swap(cluster_portals[c]);
+			const size_t portal_count = cluster.portals.size();
+			cluster.portal_costs.resize(portal_count * portal_count);
+			for (size_t a = 0; a < portal_count; a++) {
+				r_snapshot.search_cluster(polygons[polygon_base + cluster.portals[a]], scratch);
+				for (size_t b = 0; b < portal_count; b++) {
+					cluster.portal_costs[a * portal_count + b] = scratch.get_cluster_cost(polygon_base + cluster.portals[b]);
+				}
+			}
+		}
+		region->set_clusters_dirty(false);
+
+		// Add the region clusters to the map, with the map polygon indices.
+		for (size_t c = 0; c < region_clusters.clusters.size(); c++) {
+			gd::Cluster cluster = region_clusters.clusters[c];
+			for (size_t p = 0; p < cluster.portals.size(); p++) {
+				cluster.portals[p] += polygon_base;
+				polygons[cluster.portals[p]].portal_index = p;
+			}
+			r_snapshot.clusters.push_back(cluster);
+		}
+
+		polygon_base += polygon_count;
+	}
 }
 
 void NavMap::compute_single_step(uint32_t index, RvoAgent **agent) {
-	(*(agent + index))->get_agent()->computeNeighbors(&rvo);
+	agent_grid.compute_neighbors(*(agent + index));
 	(*(agent + index))->get_agent()->computeNewVelocity(deltatime);
 }
 
 void NavMap::step(real_t p_deltatime) {
 	deltatime = p_deltatime;
 	if (controlled_agents.size() > 0) {
-		thread_process_array(
-				controlled_agents.size(),
-				this,
-				&NavMap::compute_single_step,
-				controlled_agents.data());
+		WorkerThreadPool::GroupID group_task = WorkerThreadPool::get_singleton()->add_template_group_task(this, &NavMap::compute_single_step, controlled_agents.data(), controlled_agents.size());
+		WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group_task);
 	}
 }
 
@@ -731,7 +1289,7 @@ void NavMap::dispatch_callbacks() {
 	}
 }
 
-void NavMap::clip_path(const std::vector<gd::NavigationPoly> &p_navigation_polys, Vector<Vector3> &path, const gd::NavigationPoly *from_poly, const Vector3 &p_to_point, const gd::NavigationPoly *p_to_poly) const {
+void NavMapSnapshot::clip_path(const std::vector<gd::NavigationPoly> &p_navigation_polys, Vector<Vector3> &path, const gd::NavigationPoly *from_poly, const Vector3 &p_to_point, const gd::NavigationPoly *p_to_poly) const {
 	Vector3 from = path[path.size() - 1];
 
 	if (from.is_equal_approx(p_to_point)) {
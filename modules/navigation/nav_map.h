@@ -33,10 +33,13 @@
 
 #include "nav_rid.h"
 
+#include "core/math/dynamic_bvh.h"
 #include "core/math/math_defs.h"
+#include "core/object/ref_counted.h"
+#include "core/os/mutex.h"
 #include "core/templates/map.h"
 #include "nav_utils.h"
-#include <KdTree.h>
+#include "rvo_agent_grid.h"
 
 /**
 	@author AndreaCatania
@@ -45,6 +48,57 @@
 class NavRegion;
 class RvoAgent;
 class NavRegion;
+struct NavMapPathScratch;
+
+/// Navigation data of a map, built by `NavMap::sync()` and never modified afterwards.
+/// The queries only read it, so they can run on any thread while the map is updated;
+/// each query keeps a reference to the snapshot it started with.
+class NavMapSnapshot : public RefCounted {
+	GDCLASS(NavMapSnapshot, RefCounted);
+
+	friend class NavMap;
+
+	/// Map Up
+	Vector3 up = Vector3(0, 1, 0);
+
+	/// Cell size used to build the map polygons.
+	real_t cell_size = 0.3;
+
+	/// Map polygons
+	std::vector<gd::Polygon> polygons;
+
+	/// Bounding volume hierarchy of the map polygons, used to find the closest ones.
+	DynamicBVH polygons_bvh;
+
+	/// Bounds of all the map polygons.
+	AABB polygons_aabb;
+
+	/// Clusters of the polygons, empty when the hierarchical path search is disabled.
+	std::vector<gd::Cluster> clusters;
+
+public:
+	Vector<Vector3> get_path(Vector3 p_origin, Vector3 p_destination, bool p_optimize, uint32_t p_layers = 1) const;
+	Vector3 get_closest_point_to_segment(const Vector3 &p_from, const Vector3 &p_to, const bool p_use_collision) const;
+	Vector3 get_closest_point(const Vector3 &p_point) const;
+	Vector3 get_closest_point_normal(const Vector3 &p_point) const;
+	RID get_closest_point_owner(const Vector3 &p_point) const;
+
+private:
+	/// Returns the polygon closest to `p_point` and the closest point on it.
+	/// When `p_check_layers` is set, only the polygons of regions in `p_layers` are considered.
+	const gd::Polygon *get_closest_polygon(const Vector3 &p_point, bool p_check_layers, uint32_t p_layers, Vector3 &r_closest_point, Vector3 *r_closest_normal = nullptr) const;
+
+	/// Computes the travel costs from `p_from` to the polygons of its cluster, going only through the cluster.
+	void search_cluster(const gd::Polygon &p_from, NavMapPathScratch &r_scratch) const;
+
+	/// Searches the graph of the cluster portals, and marks the clusters a path from `p_begin` to `p_end`
+	/// goes through as the corridor of the path search. Returns false when `p_end` is not reachable.
+	bool find_corridor(const gd::Polygon *p_begin, const gd::Polygon *p_end, const Vector3 &p_end_point, uint32_t p_layers, NavMapPathScratch &r_scratch) const;
+
+	void clip_path(const std::vector<gd::NavigationPoly> &p_navigation_polys, Vector<Vector3> &path, const gd::NavigationPoly *from_poly, const Vector3 &p_to_point, const gd::NavigationPoly *p_to_poly) const;
+};
+
+typedef Ref<NavMapSnapshot> NavMapSnapshotRef;
 
 class NavMap : public NavRid {
 	/// Map Up
@@ -57,19 +111,22 @@ class NavMap : public NavRid {
 	/// This value is used to detect the near edges to connect.
 	real_t edge_connection_margin = 5.0;
 
+	/// Size of the cells grouping the polygons of each region in clusters, for the
+	/// hierarchical path search. The search is not hierarchical when 0.
+	real_t cluster_size = 0.0;
+
 	bool regenerate_polygons = true;
 	bool regenerate_links = true;
+	bool regenerate_clusters = false;
 
 	std::vector<NavRegion *> regions;
 
-	/// Map polygons
-	std::vector<gd::Polygon> polygons;
-
-	/// Rvo world
-	RVO::KdTree rvo;
+	/// Last snapshot built by `sync()`, shared with the running queries.
+	NavMapSnapshotRef snapshot;
+	mutable Mutex snapshot_mutex;
 
-	/// Is agent array modified?
-	bool agents_dirty = false;
+	/// Neighbor index of the agents, updated on each sync.
+	RvoAgentGrid agent_grid;
 
 	/// All the Agents (even the controlled one)
 	std::vector<RvoAgent *> agents;
@@ -84,7 +141,7 @@ class NavMap : public NavRid {
 	uint32_t map_update_id = 0;
 
 public:
-	NavMap() {}
+	NavMap();
 
 	void set_up(Vector3 p_up);
 	Vector3 get_up() const {
@@ -101,8 +158,16 @@ public:
 		return edge_connection_margin;
 	}
 
+	void set_cluster_size(real_t p_cluster_size);
+	real_t get_cluster_size() const {
+		return cluster_size;
+	}
+
 	gd::PointKey get_point_key(const Vector3 &p_pos) const;
 
+	/// Returns the data used by the queries, safe to use from any thread.
+	NavMapSnapshotRef get_snapshot() const;
+
 	Vector<Vector3> get_path(Vector3 p_origin, Vector3 p_destination, bool p_optimize, uint32_t p_layers = 1) const;
 	Vector3 get_closest_point_to_segment(const Vector3 &p_from, const Vector3 &p_to, const bool p_use_collision) const;
 	Vector3 get_closest_point(const Vector3 &p_point) const;
@@ -134,8 +199,8 @@ public:
 	void dispatch_callbacks();
 
 private:
+	void update_clusters(NavMapSnapshot &r_snapshot);
 	void compute_single_step(uint32_t index, RvoAgent **agent);
-	void clip_path(const std::vector<gd::NavigationPoly> &p_navigation_polys, Vector<Vector3> &path, const gd::NavigationPoly *from_poly, const Vector3 &p_to_point, const gd::NavigationPoly *p_to_poly) const;
 };
 
 #endif // RVO_SPACE_H
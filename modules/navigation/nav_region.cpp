@@ -46,6 +46,7 @@ void NavRegion::set_map(NavMap *p_map) {
 
 void NavRegion::set_layers(uint32_t p_layers) {
 	layers = p_layers;
+	layers_dirty = true;
 }
 
 uint32_t NavRegion::get_layers() const {
@@ -82,7 +83,8 @@ Vector3 NavRegion::get_connection_pathway_end(int p_connection_id) const {
 }
 
 bool NavRegion::sync() {
-	bool something_changed = polygons_dirty /* || something_dirty? */;
+	bool something_changed = polygons_dirty || layers_dirty;
+	layers_dirty = false;
 
 	update_polygons();
 
@@ -95,6 +97,7 @@ void NavRegion::update_polygons() {
 	}
 	polygons.clear();
 	polygons_dirty = false;
+	clusters_dirty = true;
 
 	if (map == nullptr) {
 		return;
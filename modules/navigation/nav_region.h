@@ -52,6 +52,11 @@ class NavRegion : public NavRid {
 	Vector<gd::Edge::Connection> connections;
 
 	bool polygons_dirty = true;
+	bool layers_dirty = false;
+
+	/// Computed by the map, only when the region polygons change.
+	gd::RegionClusters clusters;
+	bool clusters_dirty = true;
 
 	/// Cache
 	std::vector<gd::Polygon> polygons;
@@ -92,6 +97,16 @@ public:
 		return polygons;
 	}
 
+	gd::RegionClusters &get_clusters() {
+		return clusters;
+	}
+	bool are_clusters_dirty() const {
+		return clusters_dirty;
+	}
+	void set_clusters_dirty(bool p_dirty) {
+		clusters_dirty = p_dirty;
+	}
+
 	bool sync();
 
 private:
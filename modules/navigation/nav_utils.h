@@ -32,6 +32,7 @@
 #define NAV_UTILS_H
 
 #include "core/math/vector3.h"
+#include "core/templates/rid.h"
 
 #include <vector>
 
@@ -92,8 +93,15 @@ struct Edge {
 };
 
 struct Polygon {
+	/// Index of this `Polygon` in the map.
+	uint32_t id = 0;
+
 	NavRegion *owner;
 
+	/// Copied from the owner when the map is synced, so the queries never access the region.
+	RID owner_self;
+	uint32_t owner_layers = 0;
+
 	/// The points of this `Polygon`
 	std::vector<Point> points;
 
@@ -105,6 +113,27 @@ struct Polygon {
 
 	/// The center of this `Polygon`
 	Vector3 center;
+
+	/// Cluster of this `Polygon` in the map, used by the hierarchical path search.
+	uint32_t cluster = UINT32_MAX;
+
+	/// Index of this `Polygon` in the portals of its cluster, UINT32_MAX when it's not a portal.
+	uint32_t portal_index = UINT32_MAX;
+};
+
+/// Neighbor polygons of a region grouped together, a node of the hierarchical path search.
+struct Cluster {
+	/// The polygons with an edge leaving the cluster.
+	std::vector<uint32_t> portals;
+
+	/// Travel cost between each pair of portals, going only through the cluster; FLT_MAX when not connected.
+	std::vector<float> portal_costs;
+};
+
+/// Clusters of the polygons of a region, indexed like the region polygons.
+struct RegionClusters {
+	std::vector<uint32_t> polygon_clusters;
+	std::vector<Cluster> clusters;
 };
 
 struct NavigationPoly {
@@ -120,8 +149,12 @@ struct NavigationPoly {
 
 	/// The entry location of this poly.
 	Vector3 entry;
-	/// The distance to the destination.
+	/// The distance traveled from the origin.
 	float traveled_distance = 0.0;
+	/// The traveled distance plus the estimated distance to the destination.
+	float cost = 0.0;
+	/// Position in the open heap of the path search, UINT32_MAX when not in it.
+	uint32_t heap_index = UINT32_MAX;
 
 	NavigationPoly(const Polygon *p_poly) :
 			poly(p_poly) {}
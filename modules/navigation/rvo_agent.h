@@ -55,6 +55,12 @@ class RvoAgent : public NavRid {
 	AvoidanceComputedCallback callback;
 	uint32_t map_update_id = 0;
 
+	/// Cell of the map agent grid containing this agent, and index in it.
+	uint64_t grid_cell_key = 0;
+	uint32_t grid_index = UINT32_MAX;
+
+	friend class RvoAgentGrid;
+
 public:
 	RvoAgent();
 
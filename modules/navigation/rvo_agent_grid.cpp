@@ -0,0 +1,146 @@
+/*************************************************************************/
+/*  rvo_agent_grid.cpp                                                   */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "rvo_agent_grid.h"
+
+#include "rvo_agent.h"
+
+/// Smallest cell size, so agents without neighbor distance don't create a huge grid.
+#define MIN_CELL_SIZE 0.5
+
+gd::PointKey RvoAgentGrid::get_cell_key(real_t p_x, real_t p_y, real_t p_z) const {
+	gd::PointKey key;
+	key.key = 0;
+	key.x = int(Math::floor(p_x / cell_size));
+	key.y = int(Math::floor(p_y / cell_size));
+	key.z = int(Math::floor(p_z / cell_size));
+	return key;
+}
+
+void RvoAgentGrid::insert(RvoAgent *p_agent, uint64_t p_cell_key) {
+	LocalVector<RvoAgent *> &cell = cells[p_cell_key];
+	p_agent->grid_cell_key = p_cell_key;
+	p_agent->grid_index = cell.size();
+	cell.push_back(p_agent);
+}
+
+void RvoAgentGrid::remove(RvoAgent *p_agent) {
+	if (p_agent->grid_index == UINT32_MAX) {
+		return;
+	}
+
+	LocalVector<RvoAgent *> *cell = cells.getptr(p_agent->grid_cell_key);
+	ERR_FAIL_COND(cell == nullptr);
+	ERR_FAIL_UNSIGNED_INDEX(p_agent->grid_index, cell->size());
+
+	// Swap with the last agent of the cell.
+	RvoAgent *last = (*cell)[cell->size() - 1];
+	(*cell)[p_agent->grid_index] = last;
+	last->grid_index = p_agent->grid_index;
+	cell->resize(cell->size() - 1);
+	if (cell->size() == 0) {
+		cells.erase(p_agent->grid_cell_key);
+	}
+
+	p_agent->grid_index = UINT32_MAX;
+}
+
+void RvoAgentGrid::clear() {
+	const uint64_t *key = nullptr;
+	while ((key = cells.next(key))) {
+		LocalVector<RvoAgent *> &cell = cells[*key];
+		for (uint32_t i = 0; i < cell.size(); i++) {
+			cell[i]->grid_index = UINT32_MAX;
+		}
+	}
+	cells.clear();
+}
+
+void RvoAgentGrid::update(const std::vector<RvoAgent *> &p_agents) {
+	real_t max_neighbor_dist = MIN_CELL_SIZE;
+	for (size_t i(0); i < p_agents.size(); i++) {
+		max_neighbor_dist = MAX(max_neighbor_dist, p_agents[i]->get_agent()->neighborDist_);
+	}
+
+	// The cells must not be smaller than the neighbor distances, but much larger
+	// cells would hold too many agents: rebuild the grid in both cases.
+	if (max_neighbor_dist > cell_size || max_neighbor_dist < cell_size * 0.5) {
+		clear();
+		cell_size = max_neighbor_dist;
+	}
+
+	for (size_t i(0); i < p_agents.size(); i++) {
+		RvoAgent *agent = p_agents[i];
+		const RVO::Vector3 &position = agent->get_agent()->position_;
+		const uint64_t cell_key = get_cell_key(position.x(), position.y(), position.z()).key;
+
+		if (agent->grid_index == UINT32_MAX) {
+			insert(agent, cell_key);
+		} else if (agent->grid_cell_key != cell_key) {
+			remove(agent);
+			insert(agent, cell_key);
+		}
+	}
+}
+
+void RvoAgentGrid::compute_neighbors(RvoAgent *p_agent) const {
+	RVO::Agent *agent = p_agent->get_agent();
+	agent->agentNeighbors_.clear();
+	if (agent->maxNeighbors_ == 0 || cells.is_empty()) {
+		return;
+	}
+
+	// Shrinks once the agent has all its neighbors, to the farthest one.
+	float range_sq = agent->neighborDist_ * agent->neighborDist_;
+
+	const RVO::Vector3 &position = agent->position_;
+	const real_t range = agent->neighborDist_;
+	const gd::PointKey from = get_cell_key(position.x() - range, position.y() - range, position.z() - range);
+	const gd::PointKey to = get_cell_key(position.x() + range, position.y() + range, position.z() + range);
+
+	gd::PointKey cell_key;
+	cell_key.key = 0;
+	for (int64_t z = from.z; z <= to.z; z++) {
+		cell_key.z = z;
+		for (int64_t y = from.y; y <= to.y; y++) {
+			cell_key.y = y;
+			for (int64_t x = from.x; x <= to.x; x++) {
+				cell_key.x = x;
+				const LocalVector<RvoAgent *> *cell = cells.getptr(cell_key.key);
+				if (!cell) {
+					continue;
+				}
+				for (uint32_t i = 0; i < cell->size(); i++) {
+					agent->insertAgentNeighbor((*cell)[i]->get_agent(), range_sq);
+				}
+			}
+		}
+	}
+}
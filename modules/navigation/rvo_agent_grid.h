@@ -1,5 +1,5 @@
 /*************************************************************************/
-/*  threaded_array_processor.h                                           */
+/*  rvo_agent_grid.h                                                     */
 /*************************************************************************/
 /*                       This file is part of:                           */
 /*                           GODOT ENGINE                                */
@@ -28,80 +28,42 @@
 /* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
 /*************************************************************************/
 
-#ifndef THREADED_ARRAY_PROCESSOR_H
-#define THREADED_ARRAY_PROCESSOR_H
+#ifndef RVO_AGENT_GRID_H
+#define RVO_AGENT_GRID_H
 
-#include "core/os/mutex.h"
-#include "core/os/os.h"
-#include "core/os/thread.h"
-#include "core/os/thread_safe.h"
-#include "core/templates/safe_refcount.h"
+#include "core/templates/hash_map.h"
+#include "core/templates/local_vector.h"
+#include "nav_utils.h"
 
-template <class C, class U>
-struct ThreadArrayProcessData {
-	uint32_t elements;
-	SafeNumeric<uint32_t> index;
-	C *instance;
-	U userdata;
-	void (C::*method)(uint32_t, U);
+#include <vector>
 
-	void process(uint32_t p_index) {
-		(instance->*method)(p_index, userdata);
-	}
-};
-
-#ifndef NO_THREADS
+class RvoAgent;
 
-template <class T>
-void process_array_thread(void *ud) {
-	T &data = *(T *)ud;
-	while (true) {
-		uint32_t index = data.index.increment();
-		if (index >= data.elements) {
-			break;
-		}
-		data.process(index);
-	}
-}
+/// Uniform grid of the agents of a map, used to find the agent neighbors.
+/// The cells are as large as the biggest neighbor distance, so the neighbors
+/// of an agent are always in the 27 cells around it. Agents are only moved
+/// when they cross a cell border, so updating the grid is cheap.
+class RvoAgentGrid {
+	real_t cell_size = 0.0;
 
-template <class C, class M, class U>
-void thread_process_array(uint32_t p_elements, C *p_instance, M p_method, U p_userdata) {
-	ThreadArrayProcessData<C, U> data;
-	data.method = p_method;
-	data.instance = p_instance;
-	data.userdata = p_userdata;
-	data.index.set(0);
-	data.elements = p_elements;
-	data.process(0); //process first, let threads increment for next
+	/// Agents of each non-empty cell, by `gd::PointKey`.
+	HashMap<uint64_t, LocalVector<RvoAgent *>> cells;
 
-	int thread_count = OS::get_singleton()->get_processor_count();
-	Thread *threads = memnew_arr(Thread, thread_count);
+	gd::PointKey get_cell_key(real_t p_x, real_t p_y, real_t p_z) const;
 
-	for (int i = 0; i < thread_count; i++) {
-		threads[i].start(process_array_thread<ThreadArrayProcessData<C, U>>, &data);
-	}
+	void insert(RvoAgent *p_agent, uint64_t p_cell_key);
 
-	for (int i = 0; i < thread_count; i++) {
-		threads[i].wait_to_finish();
-	}
-	memdelete_arr(threads);
-}
+public:
+	/// Moves the agents to their current cell, adding the ones not in the grid yet.
+	/// The whole grid is rebuilt when the neighbor distances changed too much.
+	void update(const std::vector<RvoAgent *> &p_agents);
 
-#else
+	void remove(RvoAgent *p_agent);
+	void clear();
 
-template <class C, class M, class U>
-void thread_process_array(uint32_t p_elements, C *p_instance, M p_method, U p_userdata) {
-	ThreadArrayProcessData<C, U> data;
-	data.method = p_method;
-	data.instance = p_instance;
-	data.userdata = p_userdata;
-	data.index.set(0);
-	data.elements = p_elements;
-	for (uint32_t i = 0; i < p_elements; i++) {
-		data.process(i);
-	}
-}
-
-#endif
+	/// Fills the neighbors of the agent, like `RVO::Agent::computeNeighbors()`.
+	/// Only reads the grid, so it's safe to call from multiple threads.
+	void compute_neighbors(RvoAgent *p_agent) const;
+};
 
-#endif // THREADED_ARRAY_PROCESSOR_H
+#endif // RVO_AGENT_GRID_H
@@ -0,0 +1,139 @@
+/*************************************************************************/
+/*  test_godot_navigation_server.h                                       */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_GODOT_NAVIGATION_SERVER_H
+#define TEST_GODOT_NAVIGATION_SERVER_H
+
+#include "core/os/os.h"
+#include "modules/navigation/godot_navigation_server.h"
+#include "modules/navigation/tests/test_nav_map.h"
+
+#include "tests/test_macros.h"
+
+namespace TestGodotNavigationServer {
+
+class PathQueryReceiver : public Object {
+public:
+	int call_count = 0;
+	int64_t query = 0;
+	Vector<Vector3> path;
+
+	void path_ready(int64_t p_query, const Vector<Vector3> &p_path) {
+		call_count++;
+		query = p_query;
+		path = p_path;
+	}
+};
+
+// Waits for a query without releasing it, giving up after a few seconds.
+static bool wait_for_query(GodotNavigationServer *p_server, int64_t p_query) {
+	for (int i = 0; i < 10000; i++) {
+		if (p_server->path_query_is_done(p_query)) {
+			return true;
+		}
+		OS::get_singleton()->delay_usec(1000);
+	}
+	return false;
+}
+
+TEST_CASE("[GodotNavigationServer] Asynchronous path queries") {
+	GodotNavigationServer *server = memnew(GodotNavigationServer);
+	RID map = server->map_create();
+	server->map_set_active(map, true);
+	RID region = server->region_create();
+	server->region_set_map(region, map);
+	server->region_set_navmesh(region, TestNavMap::create_grid_mesh(10, TestNavMap::is_wall_cell));
+	server->process(0.0);
+
+	const Vector3 from = Vector3(0.5, 0, 0.5);
+	const Vector3 to = Vector3(9.5, 0, 0.5);
+	const Vector<Vector3> expected = server->map_get_path(map, from, to, true);
+	REQUIRE(expected.size() >= 3);
+
+	SUBCASE("Polling the result") {
+		int64_t first = server->map_get_path_async(map, from, to, true);
+		int64_t second = server->map_get_path_async(map, to, from, true);
+		CHECK(first >= 1);
+		CHECK(second > first);
+
+		CHECK(wait_for_query(server, first));
+		CHECK(server->path_query_get_result(first) == expected);
+		CHECK(server->path_query_get_result(second) == server->map_get_path(map, to, from, true));
+
+		// The queries are released with their result.
+		ERR_PRINT_OFF;
+		CHECK_FALSE(server->path_query_is_done(first));
+		CHECK(server->path_query_get_result(second).is_empty());
+		ERR_PRINT_ON;
+	}
+
+	SUBCASE("Dispatching to a callback") {
+		PathQueryReceiver receiver;
+		int64_t query = server->map_get_path_async(map, from, to, true, 1, callable_mp(&receiver, &PathQueryReceiver::path_ready));
+		REQUIRE(wait_for_query(server, query));
+		CHECK(receiver.call_count == 0);
+
+		server->process(0.0);
+		CHECK(receiver.call_count == 1);
+		CHECK(receiver.query == query);
+		CHECK(receiver.path == expected);
+
+		// The query is released once dispatched.
+		server->process(0.0);
+		CHECK(receiver.call_count == 1);
+		ERR_PRINT_OFF;
+		CHECK_FALSE(server->path_query_is_done(query));
+		ERR_PRINT_ON;
+	}
+
+	SUBCASE("Queries without a callback are not dispatched") {
+		int64_t query = server->map_get_path_async(map, from, to, true);
+		REQUIRE(wait_for_query(server, query));
+		server->process(0.0);
+		CHECK(server->path_query_is_done(query));
+		CHECK(server->path_query_get_result(query) == expected);
+	}
+
+	SUBCASE("Invalid map") {
+		ERR_PRINT_OFF;
+		CHECK(server->map_get_path_async(RID(), from, to, true) == 0);
+		CHECK_FALSE(server->path_query_is_done(0));
+		CHECK(server->path_query_get_result(0).is_empty());
+		ERR_PRINT_ON;
+	}
+
+	server->free(region);
+	server->free(map);
+	memdelete(server);
+}
+
+} // namespace TestGodotNavigationServer
+
+#endif // TEST_GODOT_NAVIGATION_SERVER_H
@@ -0,0 +1,450 @@
+/*************************************************************************/
+/*  test_nav_map.h                                                       */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_NAV_MAP_H
+#define TEST_NAV_MAP_H
+
+#include "core/os/os.h"
+#include "modules/navigation/nav_map.h"
+#include "modules/navigation/nav_region.h"
+#include "modules/navigation/rvo_agent.h"
+
+#include "tests/test_macros.h"
+
+namespace TestNavMap {
+
+// Navigation mesh made of a grid of 1x1 quads on the XZ plane, skipping the cells where `p_skip_cell` returns true.
+static Ref<NavigationMesh> create_grid_mesh(int p_size, bool (*p_skip_cell)(int, int) = nullptr) {
+	Ref<NavigationMesh> mesh;
+	mesh.instantiate();
+
+	Vector<Vector3> vertices;
+	for (int z = 0; z <= p_size; z++) {
+		for (int x = 0; x <= p_size; x++) {
+			vertices.push_back(Vector3(x, 0, z));
+		}
+	}
+	mesh->set_vertices(vertices);
+
+	for (int z = 0; z < p_size; z++) {
+		for (int x = 0; x < p_size; x++) {
+			if (p_skip_cell && p_skip_cell(x, z)) {
+				continue;
+			}
+			Vector<int> polygon;
+			polygon.push_back(z * (p_size + 1) + x);
+			polygon.push_back(z * (p_size + 1) + x + 1);
+			polygon.push_back((z + 1) * (p_size + 1) + x + 1);
+			polygon.push_back((z + 1) * (p_size + 1) + x);
+			mesh->add_polygon(polygon);
+		}
+	}
+
+	return mesh;
+}
+
+static real_t get_path_length(const Vector<Vector3> &p_path) {
+	real_t length = 0.0;
+	for (int i = 1; i < p_path.size(); i++) {
+		length += p_path[i - 1].distance_to(p_path[i]);
+	}
+	return length;
+}
+
+// Wall along x = 5, with a gap at z = 9.
+static bool is_wall_cell(int p_x, int p_z) {
+	return p_x == 5 && p_z != 9;
+}
+
+TEST_CASE("[NavMap] Closest point queries") {
+	NavMap map;
+	NavRegion region;
+	region.set_mesh(create_grid_mesh(10));
+	region.set_map(&map);
+	map.add_region(&region);
+	map.sync();
+
+	CHECK(map.get_closest_point(Vector3(3.25, 2, 4.75)).is_equal_approx(Vector3(3.25, 0, 4.75)));
+	CHECK(map.get_closest_point(Vector3(-2, 0, -3)).is_equal_approx(Vector3(0, 0, 0)));
+	CHECK(map.get_closest_point(Vector3(30, -1, 5.5)).is_equal_approx(Vector3(10, 0, 5.5)));
+	CHECK(Math::is_equal_approx(Math::abs(map.get_closest_point_normal(Vector3(3.25, 2, 4.75)).y), 1));
+	CHECK(map.get_closest_point_owner(Vector3(3.25, 2, 4.75)) == region.get_self());
+
+	// Non finite points must fail instead of growing the search box forever.
+	ERR_PRINT_OFF;
+	CHECK(map.get_closest_point(Vector3(NAN, 0, 0)) == Vector3());
+	CHECK(map.get_closest_point(Vector3(0, INFINITY, 0)) == Vector3());
+	CHECK(map.get_closest_point_owner(Vector3(0, 0, -INFINITY)) == RID());
+	ERR_PRINT_ON;
+
+	map.remove_region(&region);
+}
+
+TEST_CASE("[NavMap] Closest point to segment queries") {
+	NavMap map;
+	NavRegion region;
+	region.set_mesh(create_grid_mesh(10, is_wall_cell));
+	region.set_map(&map);
+	map.add_region(&region);
+	map.sync();
+
+	// Segments crossing the map give the intersection closest to their start.
+	CHECK(map.get_closest_point_to_segment(Vector3(3.25, 2, 4.75), Vector3(3.25, -2, 4.75), true).is_equal_approx(Vector3(3.25, 0, 4.75)));
+	CHECK(map.get_closest_point_to_segment(Vector3(1, 5, 2), Vector3(6, -5, 5), false).is_equal_approx(Vector3(3.5, 0, 3.5)));
+	CHECK(map.get_closest_point_to_segment(Vector3(7.5, -1, 2.5), Vector3(7.5, 1, 2.5), false).is_equal_approx(Vector3(7.5, 0, 2.5)));
+
+	// Without a collision, the closest point of the polygon edges.
+	Vector3 point = map.get_closest_point_to_segment(Vector3(2, 1, 2), Vector3(4, 1, 2), false);
+	CHECK(Math::is_zero_approx(point.y));
+	CHECK(Math::is_equal_approx(point.z, 2));
+	CHECK(point.x >= 2 - CMP_EPSILON);
+	CHECK(point.x <= 4 + CMP_EPSILON);
+	CHECK(map.get_closest_point_to_segment(Vector3(12, 0, 3.5), Vector3(15, 0, 3.5), false).is_equal_approx(Vector3(10, 0, 3.5)));
+	CHECK(map.get_closest_point_to_segment(Vector3(40, 20, -30), Vector3(40, 21, -30), false).is_equal_approx(Vector3(10, 0, 0)));
+
+	// Going through the hole of the wall, the segment touches the edges of the cells next to it.
+	point = map.get_closest_point_to_segment(Vector3(5.5, 1, 2.5), Vector3(5.5, -1, 2.5), false);
+	CHECK(Math::is_zero_approx(point.y));
+	CHECK((Math::is_equal_approx(point.x, 5) || Math::is_equal_approx(point.x, 6)));
+
+	// Only collisions are wanted.
+	CHECK(map.get_closest_point_to_segment(Vector3(2, 1, 2), Vector3(4, 1, 2), true) == Vector3());
+	CHECK(map.get_closest_point_to_segment(Vector3(5.5, 1, 2.5), Vector3(5.5, -1, 2.5), true) == Vector3());
+
+	ERR_PRINT_OFF;
+	CHECK(map.get_closest_point_to_segment(Vector3(NAN, 0, 0), Vector3(1, 0, 0), false) == Vector3());
+	ERR_PRINT_ON;
+
+	map.remove_region(&region);
+}
+
+TEST_CASE("[NavMap] Path queries") {
+	NavMap map;
+	NavRegion region;
+	region.set_mesh(create_grid_mesh(10, is_wall_cell));
+	region.set_map(&map);
+	map.add_region(&region);
+	map.sync();
+
+	SUBCASE("Straight path inside a single region") {
+		Vector<Vector3> path = map.get_path(Vector3(0.5, 0, 9.5), Vector3(9.5, 0, 9.5), true);
+		REQUIRE(path.size() >= 2);
+		CHECK(path[0].is_equal_approx(Vector3(0.5, 0, 9.5)));
+		CHECK(path[path.size() - 1].is_equal_approx(Vector3(9.5, 0, 9.5)));
+		// The path is clipped at the crossed edges, all the points stay on the line.
+		for (int i = 0; i < path.size(); i++) {
+			CHECK(Math::is_equal_approx(path[i].z, 9.5));
+		}
+		CHECK(Math::is_equal_approx(get_path_length(path), 9));
+	}
+
+	SUBCASE("Path going around a wall") {
+		Vector<Vector3> path = map.get_path(Vector3(0.5, 0, 0.5), Vector3(9.5, 0, 0.5), true);
+		REQUIRE(path.size() >= 3);
+		CHECK(path[0].is_equal_approx(Vector3(0.5, 0, 0.5)));
+		CHECK(path[path.size() - 1].is_equal_approx(Vector3(9.5, 0, 0.5)));
+		// Going through the gap is at least twice the distance to it.
+		CHECK(get_path_length(path) > 2.0 * Vector3(0.5, 0, 0.5).distance_to(Vector3(5, 0, 9)) - CMP_EPSILON);
+	}
+
+	SUBCASE("Repeated queries give the same path") {
+		Vector<Vector3> first = map.get_path(Vector3(0.5, 0, 0.5), Vector3(9.5, 0, 0.5), false);
+		Vector<Vector3> second = map.get_path(Vector3(0.5, 0, 0.5), Vector3(9.5, 0, 0.5), false);
+		CHECK(first == second);
+	}
+
+	SUBCASE("Incompatible layers") {
+		Vector<Vector3> path = map.get_path(Vector3(0.5, 0, 0.5), Vector3(9.5, 0, 0.5), true, 2);
+		CHECK(path.size() == 0);
+	}
+
+	map.remove_region(&region);
+}
+
+TEST_CASE("[NavMap] Hierarchical path queries") {
+	NavMap map;
+	NavRegion region;
+	region.set_mesh(create_grid_mesh(10, is_wall_cell));
+	region.set_map(&map);
+	map.add_region(&region);
+	map.sync();
+
+	const Vector<Vector3> full_path = map.get_path(Vector3(0.5, 0, 0.5), Vector3(9.5, 0, 0.5), true);
+
+	map.set_cluster_size(3.0);
+	map.sync();
+	CHECK_FALSE(region.are_clusters_dirty());
+
+	SUBCASE("Path going around a wall") {
+		Vector<Vector3> path = map.get_path(Vector3(0.5, 0, 0.5), Vector3(9.5, 0, 0.5), true);
+		REQUIRE(path.size() >= 3);
+		CHECK(path[0].is_equal_approx(Vector3(0.5, 0, 0.5)));
+		CHECK(path[path.size() - 1].is_equal_approx(Vector3(9.5, 0, 0.5)));
+		// Only the clusters on the way are searched, the path can be a bit longer.
+		CHECK(get_path_length(path) < get_path_length(full_path) * 1.5);
+	}
+
+	SUBCASE("Path inside a single cluster") {
+		Vector<Vector3> path = map.get_path(Vector3(0.5, 0, 0.5), Vector3(2.5, 0, 2.5), true);
+		REQUIRE(path.size() >= 2);
+		CHECK(path[path.size() - 1].is_equal_approx(Vector3(2.5, 0, 2.5)));
+		CHECK(Math::is_equal_approx(get_path_length(path), Vector3(0.5, 0, 0.5).distance_to(Vector3(2.5, 0, 2.5))));
+	}
+
+	SUBCASE("Incompatible layers") {
+		Vector<Vector3> path = map.get_path(Vector3(0.5, 0, 0.5), Vector3(9.5, 0, 0.5), true, 2);
+		CHECK(path.size() == 0);
+	}
+
+	map.remove_region(&region);
+}
+
+TEST_CASE("[NavMap] Cluster portals") {
+	NavMap map;
+	NavRegion region;
+	region.set_mesh(create_grid_mesh(10));
+	region.set_map(&map);
+	map.add_region(&region);
+	map.set_cluster_size(5.0);
+	map.sync();
+
+	// Four clusters of 5x5 cells, the polygon of the cell (x, z) is z * 10 + x.
+	const gd::RegionClusters &clusters = region.get_clusters();
+	REQUIRE(clusters.clusters.size() == 4);
+	const uint32_t corner_cluster = clusters.polygon_clusters[0];
+	const uint32_t side_cluster = clusters.polygon_clusters[9];
+
+	// Only the polygons next to another cluster are portals, not the ones on the border of the map.
+	CHECK(clusters.clusters[corner_cluster].portals.size() == 9);
+	CHECK(clusters.clusters[side_cluster].portals.size() == 9);
+	for (const uint32_t portal : clusters.clusters[corner_cluster].portals) {
+		CHECK((portal % 10 == 4 || portal / 10 == 4));
+	}
+
+	// A region next to it turns its border polygons into portals.
+	NavRegion next_region;
+	next_region.set_mesh(create_grid_mesh(10));
+	next_region.set_transform(Transform3D(Basis(), Vector3(10, 0, 0)));
+	next_region.set_map(&map);
+	map.add_region(&next_region);
+	map.sync();
+
+	CHECK(clusters.clusters[corner_cluster].portals.size() == 9);
+	CHECK(clusters.clusters[side_cluster].portals.size() == 13);
+	bool corner_is_portal = false;
+	for (const uint32_t portal : clusters.clusters[side_cluster].portals) {
+		corner_is_portal = corner_is_portal || portal == 9;
+	}
+	CHECK(corner_is_portal);
+
+	// The path to the next region goes through the new portals.
+	Vector<Vector3> path = map.get_path(Vector3(0.5, 0, 0.5), Vector3(19.5, 0, 0.5), true);
+	REQUIRE(path.size() >= 2);
+	CHECK(path[path.size() - 1].is_equal_approx(Vector3(19.5, 0, 0.5)));
+
+	map.set_cluster_size(0.0);
+	map.sync();
+	CHECK(Math::is_equal_approx(get_path_length(path), get_path_length(map.get_path(Vector3(0.5, 0, 0.5), Vector3(19.5, 0, 0.5), true))));
+
+	map.remove_region(&next_region);
+	map.remove_region(&region);
+}
+
+TEST_CASE("[NavMap] Snapshots outlive the map updates") {
+	NavMap map;
+	NavRegion region;
+	region.set_mesh(create_grid_mesh(10));
+	region.set_map(&map);
+	map.add_region(&region);
+	map.sync();
+
+	NavMapSnapshotRef snapshot = map.get_snapshot();
+
+	map.remove_region(&region);
+	map.sync();
+
+	// The map no longer has polygons, the previous snapshot keeps its own.
+	CHECK(map.get_path(Vector3(0.5, 0, 0.5), Vector3(9.5, 0, 9.5), true).size() == 0);
+
+	Vector<Vector3> path = snapshot->get_path(Vector3(0.5, 0, 0.5), Vector3(9.5, 0, 9.5), true);
+	REQUIRE(path.size() >= 2);
+	CHECK(path[path.size() - 1].is_equal_approx(Vector3(9.5, 0, 9.5)));
+	CHECK(Math::is_equal_approx(get_path_length(path), Vector3(0.5, 0, 0.5).distance_to(Vector3(9.5, 0, 9.5))));
+	CHECK(snapshot->get_closest_point(Vector3(3.25, 2, 4.75)).is_equal_approx(Vector3(3.25, 0, 4.75)));
+}
+
+TEST_CASE_PENDING("[NavMap][Benchmark] Path queries on a large grid") {
+	const int size = 300;
+
+	NavMap map;
+	NavRegion region;
+	region.set_mesh(create_grid_mesh(size));
+	region.set_map(&map);
+	map.add_region(&region);
+
+	uint64_t begin_usec = OS::get_singleton()->get_ticks_usec();
+	map.sync();
+	uint64_t sync_usec = OS::get_singleton()->get_ticks_usec() - begin_usec;
+
+	const int query_count = 100;
+	begin_usec = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < query_count; i++) {
+		real_t offset = (i % 10) + 0.5;
+		Vector<Vector3> path = map.get_path(Vector3(offset, 0, 0.5), Vector3(size - offset, 0, size - 0.5), true);
+		CHECK(path.size() >= 2);
+	}
+	uint64_t query_usec = OS::get_singleton()->get_ticks_usec() - begin_usec;
+
+	MESSAGE(vformat("%d polygons, sync: %d usec, %d path queries: %d usec (%d usec per query).", size * size, sync_usec, query_count, query_usec, query_usec / query_count));
+
+	map.set_cluster_size(16.0);
+	begin_usec = OS::get_singleton()->get_ticks_usec();
+	map.sync();
+	sync_usec = OS::get_singleton()->get_ticks_usec() - begin_usec;
+
+	begin_usec = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < query_count; i++) {
+		real_t offset = (i % 10) + 0.5;
+		Vector<Vector3> path = map.get_path(Vector3(offset, 0, 0.5), Vector3(size - offset, 0, size - 0.5), true);
+		CHECK(path.size() >= 2);
+	}
+	query_usec = OS::get_singleton()->get_ticks_usec() - begin_usec;
+
+	MESSAGE(vformat("Hierarchical, sync: %d usec, %d path queries: %d usec (%d usec per query).", sync_usec, query_count, query_usec, query_usec / query_count));
+
+	map.remove_region(&region);
+}
+
+static void setup_agent(RvoAgent &r_agent, NavMap &p_map, const Vector3 &p_position, const Vector3 &p_target_velocity) {
+	RVO::Agent *agent = r_agent.get_agent();
+	agent->position_ = RVO::Vector3(p_position.x, p_position.y, p_position.z);
+	agent->prefVelocity_ = RVO::Vector3(p_target_velocity.x, p_target_velocity.y, p_target_velocity.z);
+	agent->neighborDist_ = 3.0;
+	agent->maxNeighbors_ = 10;
+	agent->radius_ = 0.4;
+	agent->maxSpeed_ = 2.0;
+	agent->timeHorizon_ = 2.0;
+	agent->ignore_y_ = true;
+
+	r_agent.set_map(&p_map);
+	p_map.add_agent(&r_agent);
+	p_map.set_agent_as_controlled(&r_agent);
+}
+
+// Checks the neighbors found by the map against the ones found by testing all the agents.
+static void check_agent_neighbors(std::vector<RvoAgent> &p_agents) {
+	for (size_t i = 0; i < p_agents.size(); i++) {
+		RVO::Agent expected = *p_agents[i].get_agent();
+		expected.agentNeighbors_.clear();
+		float range_sq = expected.neighborDist_ * expected.neighborDist_;
+		for (size_t j = 0; j < p_agents.size(); j++) {
+			if (i != j) {
+				expected.insertAgentNeighbor(p_agents[j].get_agent(), range_sq);
+			}
+		}
+
+		const RVO::Agent *agent = p_agents[i].get_agent();
+		REQUIRE(agent->agentNeighbors_.size() == expected.agentNeighbors_.size());
+		for (size_t n = 0; n < expected.agentNeighbors_.size(); n++) {
+			// The order of the neighbors at the same distance is not defined.
+			CHECK(agent->agentNeighbors_[n].first == expected.agentNeighbors_[n].first);
+		}
+	}
+}
+
+TEST_CASE("[NavMap] Agent neighbors") {
+	NavMap map;
+	std::vector<RvoAgent> agents(200);
+	for (size_t i = 0; i < agents.size(); i++) {
+		const Vector3 position = Vector3(Math::fmod(i * 7.31, 30.0), 0, Math::fmod(i * 3.17, 20.0));
+		setup_agent(agents[i], map, position, Vector3(1, 0, 0));
+	}
+
+	map.sync();
+	map.step(0.1);
+	check_agent_neighbors(agents);
+
+	// Move the agents, some of them to another grid cell.
+	for (size_t i = 0; i < agents.size(); i++) {
+		RVO::Agent *agent = agents[i].get_agent();
+		agent->position_ = agent->position_ + RVO::Vector3(i % 5, 0, (i % 3) * 0.5);
+	}
+	map.sync();
+	map.step(0.1);
+	check_agent_neighbors(agents);
+
+	for (size_t i = 0; i < agents.size(); i++) {
+		map.remove_agent(&agents[i]);
+	}
+}
+
+TEST_CASE_PENDING("[NavMap][Benchmark] Crowd avoidance") {
+	const int agent_count = 2000;
+	const int frame_count = 100;
+
+	// Agents on a circle, crossing it to the opposite side.
+	NavMap map;
+	std::vector<RvoAgent> agents(agent_count);
+	const real_t circle_radius = 80.0;
+	for (int i = 0; i < agent_count; i++) {
+		const real_t angle = Math_TAU * i / agent_count;
+		const Vector3 position = Vector3(Math::cos(angle), 0, Math::sin(angle)) * circle_radius;
+		setup_agent(agents[i], map, position, -position.normalized() * 2.0);
+	}
+
+	uint64_t sync_usec = 0;
+	uint64_t step_usec = 0;
+	for (int frame = 0; frame < frame_count; frame++) {
+		uint64_t begin_usec = OS::get_singleton()->get_ticks_usec();
+		map.sync();
+		sync_usec += OS::get_singleton()->get_ticks_usec() - begin_usec;
+
+		begin_usec = OS::get_singleton()->get_ticks_usec();
+		map.step(1.0 / 60.0);
+		step_usec += OS::get_singleton()->get_ticks_usec() - begin_usec;
+
+		for (int i = 0; i < agent_count; i++) {
+			RVO::Agent *agent = agents[i].get_agent();
+			agent->velocity_ = agent->newVelocity_;
+			agent->position_ = agent->position_ + agent->velocity_ * (1.0 / 60.0);
+		}
+	}
+
+	const double frame_msec = (sync_usec + step_usec) / 1000.0 / frame_count;
+	MESSAGE(vformat("%d agents, %d frames: sync %d usec, step %d usec, %.1f agents/ms.", agent_count, frame_count, sync_usec, step_usec, agent_count / frame_msec));
+
+	for (int i = 0; i < agent_count; i++) {
+		map.remove_agent(&agents[i]);
+	}
+}
+
+} // namespace TestNavMap
+
+#endif // TEST_NAV_MAP_H
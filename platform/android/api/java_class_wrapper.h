@@ -180,6 +180,7 @@ class JavaClass : public RefCounted {
 
 public:
 	virtual Variant call(const StringName &p_method, const Variant **p_args, int p_argcount, Callable::CallError &r_error) override;
+	virtual bool has_custom_call() const override { return true; }
 
 	JavaClass();
 };
@@ -196,6 +197,7 @@ class JavaObject : public RefCounted {
 
 public:
 	virtual Variant call(const StringName &p_method, const Variant **p_args, int p_argcount, Callable::CallError &r_error) override;
+	virtual bool has_custom_call() const override { return true; }
 
 #ifdef ANDROID_ENABLED
 	JavaObject(const Ref<JavaClass> &p_base, jobject *p_instance);
@@ -179,6 +179,8 @@ public:
 #endif
 	}
 
+	virtual bool has_custom_call() const override { return true; }
+
 #ifdef ANDROID_ENABLED
 	jobject get_instance() const {
 		return instance;
@@ -141,6 +141,7 @@ void Node2D::_update_transform() {
 }
 
 void Node2D::set_position(const Point2 &p_pos) {
+	ERR_THREAD_GUARD;
 	if (_xform_dirty) {
 		((Node2D *)this)->_update_xform_values();
 	}
@@ -149,6 +150,7 @@ void Node2D::set_position(const Point2 &p_pos) {
 }
 
 void Node2D::set_rotation(real_t p_radians) {
+	ERR_THREAD_GUARD;
 	if (_xform_dirty) {
 		((Node2D *)this)->_update_xform_values();
 	}
@@ -157,6 +159,7 @@ void Node2D::set_rotation(real_t p_radians) {
 }
 
 void Node2D::set_skew(real_t p_radians) {
+	ERR_THREAD_GUARD;
 	if (_xform_dirty) {
 		((Node2D *)this)->_update_xform_values();
 	}
@@ -165,6 +168,7 @@ void Node2D::set_skew(real_t p_radians) {
 }
 
 void Node2D::set_scale(const Size2 &p_scale) {
+	ERR_THREAD_GUARD;
 	if (_xform_dirty) {
 		((Node2D *)this)->_update_xform_values();
 	}
@@ -253,6 +257,7 @@ Point2 Node2D::get_global_position() const {
 }
 
 void Node2D::set_global_position(const Point2 &p_pos) {
+	ERR_THREAD_GUARD;
 	Transform2D inv;
 	CanvasItem *pi = get_parent_item();
 	if (pi) {
@@ -268,6 +273,7 @@ real_t Node2D::get_global_rotation() const {
 }
 
 void Node2D::set_global_rotation(real_t p_radians) {
+	ERR_THREAD_GUARD;
 	CanvasItem *pi = get_parent_item();
 	if (pi) {
 		const real_t parent_global_rot = pi->get_global_transform().get_rotation();
@@ -282,6 +288,7 @@ Size2 Node2D::get_global_scale() const {
 }
 
 void Node2D::set_global_scale(const Size2 &p_scale) {
+	ERR_THREAD_GUARD;
 	CanvasItem *pi = get_parent_item();
 	if (pi) {
 		const Size2 parent_global_scale = pi->get_global_transform().get_scale();
@@ -292,6 +299,7 @@ void Node2D::set_global_scale(const Size2 &p_scale) {
 }
 
 void Node2D::set_transform(const Transform2D &p_transform) {
+	ERR_THREAD_GUARD;
 	_mat = p_transform;
 	_xform_dirty = true;
 
@@ -305,6 +313,7 @@ void Node2D::set_transform(const Transform2D &p_transform) {
 }
 
 void Node2D::set_global_transform(const Transform2D &p_transform) {
+	ERR_THREAD_GUARD;
 	CanvasItem *pi = get_parent_item();
 	if (pi) {
 		set_transform(pi->get_global_transform().affine_inverse() * p_transform);
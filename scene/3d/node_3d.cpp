@@ -32,6 +32,7 @@
 
 #include "core/config/engine.h"
 #include "core/object/message_queue.h"
+#include "scene/3d/transform_hierarchy_3d.h"
 #include "scene/3d/visual_instance_3d.h"
 #include "scene/main/scene_tree.h"
 #include "scene/main/window.h"
@@ -81,7 +82,7 @@ void Node3D::_notify_dirty() {
 	if (data.notify_transform && !data.ignore_notification && !xform_change.in_list()) {
 
 #endif
-		get_tree()->xform_change_list.add(&xform_change);
+		get_tree()->_add_xform_change(&xform_change);
 	}
 }
 
@@ -96,6 +97,12 @@ void Node3D::_propagate_transform_changed(Node3D *p_origin) {
 		return;
 	}
 
+	if (data.hierarchy) {
+		// The children are updated with the hierarchy, on the next flush.
+		data.hierarchy->set_dirty(this);
+		return;
+	}
+
 	/*
 	if (data.dirty&DIRTY_GLOBAL)
 		return; //already dirty
@@ -114,7 +121,7 @@ void Node3D::_propagate_transform_changed(Node3D *p_origin) {
 #else
 	if (data.notify_transform && !data.ignore_notification && !xform_change.in_list()) {
 #endif
-		get_tree()->xform_change_list.add(&xform_change);
+		get_tree()->_add_xform_change(&xform_change);
 	}
 	data.dirty |= DIRTY_GLOBAL;
 
@@ -146,7 +153,11 @@ void Node3D::_notification(int p_what) {
 			}
 
 			data.dirty |= DIRTY_GLOBAL; //global is always dirty upon entering a scene
-			_notify_dirty();
+			if (get_tree()->get_transform_hierarchy_3d()) {
+				get_tree()->get_transform_hierarchy_3d()->add_node(this);
+			} else {
+				_notify_dirty();
+			}
 
 			notification(NOTIFICATION_ENTER_WORLD);
 			_update_visibility_parent(true);
@@ -157,6 +168,9 @@ void Node3D::_notification(int p_what) {
 			if (xform_change.in_list()) {
 				get_tree()->xform_change_list.remove(&xform_change);
 			}
+			if (data.hierarchy) {
+				data.hierarchy->remove_node(this);
+			}
 			if (data.C) {
 				data.parent->data.children.erase(data.C);
 			}
@@ -223,6 +237,7 @@ void Node3D::_notification(int p_what) {
 }
 
 void Node3D::set_transform(const Transform3D &p_transform) {
+	ERR_THREAD_GUARD;
 	data.local_transform = p_transform;
 	data.dirty |= DIRTY_VECTORS;
 	_propagate_transform_changed(this);
@@ -232,6 +247,7 @@ void Node3D::set_transform(const Transform3D &p_transform) {
 }
 
 void Node3D::set_global_transform(const Transform3D &p_transform) {
+	ERR_THREAD_GUARD;
 	Transform3D xform =
 			(data.parent && !data.top_level_active) ?
 					  data.parent->get_global_transform().affine_inverse() * p_transform :
@@ -250,6 +266,29 @@ Transform3D Node3D::get_transform() const {
 Transform3D Node3D::get_global_transform() const {
 	ERR_FAIL_COND_V(!is_inside_tree(), Transform3D());
 
+	if (data.hierarchy) {
+		uint32_t version;
+		if (data.hierarchy->is_global_transform_valid(this, &version)) {
+			return data.hierarchy->get_global_transform(this);
+		}
+
+		// The node or one of its parents changed since the last update, compute
+		// it up the tree and keep it until one of them changes again.
+		if (!data.hierarchy_cached || data.hierarchy_version != version) {
+			if (data.parent && !data.top_level_active) {
+				data.global_transform = data.parent->get_global_transform() * get_transform();
+			} else {
+				data.global_transform = get_transform();
+			}
+			if (data.disable_scale) {
+				data.global_transform.basis.orthonormalize();
+			}
+			data.hierarchy_version = version;
+			data.hierarchy_cached = true;
+		}
+		return data.global_transform;
+	}
+
 	if (data.dirty & DIRTY_GLOBAL) {
 		if (data.dirty & DIRTY_LOCAL) {
 			_update_local_transform();
@@ -303,6 +342,7 @@ Transform3D Node3D::get_relative_transform(const Node *p_parent) const {
 }
 
 void Node3D::set_position(const Vector3 &p_position) {
+	ERR_THREAD_GUARD;
 	data.local_transform.origin = p_position;
 	_propagate_transform_changed(this);
 	if (data.notify_local_transform) {
@@ -311,6 +351,7 @@ void Node3D::set_position(const Vector3 &p_position) {
 }
 
 void Node3D::set_rotation(const Vector3 &p_euler_rad) {
+	ERR_THREAD_GUARD;
 	if (data.dirty & DIRTY_VECTORS) {
 		data.scale = data.local_transform.basis.get_scale();
 		data.dirty &= ~DIRTY_VECTORS;
@@ -325,6 +366,7 @@ void Node3D::set_rotation(const Vector3 &p_euler_rad) {
 }
 
 void Node3D::set_scale(const Vector3 &p_scale) {
+	ERR_THREAD_GUARD;
 	if (data.dirty & DIRTY_VECTORS) {
 		data.rotation = data.local_transform.basis.get_rotation();
 		data.dirty &= ~DIRTY_VECTORS;
@@ -481,6 +523,9 @@ void Node3D::set_disable_gizmos(bool p_enabled) {
 
 void Node3D::set_disable_scale(bool p_enabled) {
 	data.disable_scale = p_enabled;
+	if (data.hierarchy) {
+		data.hierarchy->set_disable_scale(this, p_enabled);
+	}
 }
 
 bool Node3D::is_scale_disabled() const {
@@ -500,6 +545,9 @@ void Node3D::set_as_top_level(bool p_enabled) {
 
 		data.top_level = p_enabled;
 		data.top_level_active = p_enabled;
+		if (data.hierarchy) {
+			data.hierarchy->update_subtree(this);
+		}
 
 	} else {
 		data.top_level = p_enabled;
@@ -536,6 +584,7 @@ void Node3D::_propagate_visibility_changed() {
 }
 
 void Node3D::show() {
+	ERR_THREAD_GUARD;
 	if (data.visible) {
 		return;
 	}
@@ -550,6 +599,7 @@ void Node3D::show() {
 }
 
 void Node3D::hide() {
+	ERR_THREAD_GUARD;
 	if (!data.visible) {
 		return;
 	}
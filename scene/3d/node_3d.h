@@ -34,6 +34,8 @@
 #include "scene/main/node.h"
 #include "scene/main/scene_tree.h"
 
+class TransformHierarchy3D;
+
 class Node3DGizmo : public RefCounted {
 	GDCLASS(Node3DGizmo, RefCounted);
 
@@ -52,6 +54,8 @@ class Node3D : public Node {
 	GDCLASS(Node3D, Node);
 	OBJ_CATEGORY("3D");
 
+	friend class TransformHierarchy3D;
+
 	enum TransformDirty {
 		DIRTY_NONE = 0,
 		DIRTY_VECTORS = 1,
@@ -89,6 +93,13 @@ class Node3D : public Node {
 		bool visible = true;
 		bool disable_scale = false;
 
+		// Set when the tree uses a TransformHierarchy3D.
+		TransformHierarchy3D *hierarchy = nullptr;
+		uint32_t hierarchy_level = 0;
+		uint32_t hierarchy_index = 0;
+		mutable uint32_t hierarchy_version = 0;
+		mutable bool hierarchy_cached = false;
+
 #ifdef TOOLS_ENABLED
 		Vector<Ref<Node3DGizmo>> gizmos;
 		bool gizmos_disabled = false;
@@ -110,6 +121,8 @@ class Node3D : public Node {
 
 protected:
 	_FORCE_INLINE_ void set_ignore_transform_notification(bool p_ignore) { data.ignore_notification = p_ignore; }
+	// The hierarchy sends the transforms of VisualInstance3D nodes to the RenderingServer.
+	_FORCE_INLINE_ bool _is_in_transform_hierarchy() const { return data.hierarchy; }
 
 	_FORCE_INLINE_ void _update_local_transform() const;
 
@@ -0,0 +1,273 @@
+/*************************************************************************/
+/*  transform_hierarchy_3d.cpp                                           */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "transform_hierarchy_3d.h"
+
+#include "core/os/worker_thread_pool.h"
+#include "scene/3d/node_3d.h"
+#include "scene/3d/visual_instance_3d.h"
+#include "servers/rendering_server.h"
+
+// The links are resolved through the Node parent and children rather than the
+// Node3D ones, which are only set inside the tree. In the tree, both match and
+// top level is always active, as there is no hierarchy in the editor.
+static Node3D *_get_parent(const Node3D *p_node) {
+	return Object::cast_to<Node3D>(p_node->get_parent());
+}
+
+void TransformHierarchy3D::_add_node(Node3D *p_node) {
+	uint32_t level_index = 0;
+	uint32_t parent_index = INVALID_INDEX;
+	const Node3D *parent = _get_parent(p_node);
+	if (parent && !p_node->data.top_level && parent->data.hierarchy == this) {
+		level_index = parent->data.hierarchy_level + 1;
+		parent_index = parent->data.hierarchy_index;
+	}
+
+	if (level_index == levels.size()) {
+		levels.resize(level_index + 1);
+	}
+	Level &level = levels[level_index];
+
+	p_node->data.hierarchy = this;
+	p_node->data.hierarchy_level = level_index;
+	p_node->data.hierarchy_index = level.nodes.size();
+	p_node->data.hierarchy_cached = false;
+
+	const VisualInstance3D *visual_instance = Object::cast_to<VisualInstance3D>(p_node);
+
+	level.nodes.push_back(p_node);
+	level.parents.push_back(parent_index);
+	level.local_transforms.push_back(Transform3D());
+	level.global_transforms.push_back(Transform3D());
+	level.flags.push_back(FLAG_DIRTY | (p_node->data.disable_scale ? FLAG_DISABLE_SCALE : 0));
+	level.versions.push_back(0);
+	level.instances.push_back(visual_instance ? visual_instance->get_instance() : RID());
+}
+
+void TransformHierarchy3D::_remove_node(Node3D *p_node) {
+	ERR_FAIL_COND(p_node->data.hierarchy != this);
+
+	const uint32_t level_index = p_node->data.hierarchy_level;
+	const uint32_t index = p_node->data.hierarchy_index;
+	Level &level = levels[level_index];
+	ERR_FAIL_UNSIGNED_INDEX(index, level.nodes.size());
+
+	// Move the last node of the level in its place, and point the children
+	// of the moved node to its new index.
+	const uint32_t last = level.nodes.size() - 1;
+	if (index != last) {
+		Node3D *moved = level.nodes[last];
+		level.nodes[index] = moved;
+		level.parents[index] = level.parents[last];
+		level.local_transforms[index] = level.local_transforms[last];
+		level.global_transforms[index] = level.global_transforms[last];
+		level.flags[index] = level.flags[last];
+		level.versions[index] = level.versions[last];
+		level.instances[index] = level.instances[last];
+		moved->data.hierarchy_index = index;
+
+		if (level_index + 1 < levels.size()) {
+			Level &child_level = levels[level_index + 1];
+			for (int i = 0; i < moved->get_child_count(); i++) {
+				Node3D *child = Object::cast_to<Node3D>(moved->get_child(i));
+				if (child && child->data.hierarchy == this && child->data.hierarchy_level == level_index + 1) {
+					child_level.parents[child->data.hierarchy_index] = index;
+				}
+			}
+		}
+	}
+
+	level.nodes.resize(last);
+	level.parents.resize(last);
+	level.local_transforms.resize(last);
+	level.global_transforms.resize(last);
+	level.flags.resize(last);
+	level.versions.resize(last);
+	level.instances.resize(last);
+
+	p_node->data.hierarchy = nullptr;
+}
+
+void TransformHierarchy3D::_add_subtree(Node3D *p_node) {
+	_add_node(p_node);
+	for (int i = 0; i < p_node->get_child_count(); i++) {
+		// Skip the children that did not enter the tree yet, they are added when they do.
+		Node3D *child = Object::cast_to<Node3D>(p_node->get_child(i));
+		if (child && !child->data.top_level && child->is_inside_tree() == p_node->is_inside_tree()) {
+			_add_subtree(child);
+		}
+	}
+}
+
+void TransformHierarchy3D::_remove_subtree(Node3D *p_node) {
+	for (int i = 0; i < p_node->get_child_count(); i++) {
+		Node3D *child = Object::cast_to<Node3D>(p_node->get_child(i));
+		if (child && !child->data.top_level && child->data.hierarchy == this) {
+			_remove_subtree(child);
+		}
+	}
+	_remove_node(p_node);
+}
+
+void TransformHierarchy3D::add_node(Node3D *p_node) {
+	ERR_FAIL_COND(p_node->data.hierarchy);
+	_add_node(p_node);
+	pending.set();
+}
+
+void TransformHierarchy3D::remove_node(Node3D *p_node) {
+	_remove_node(p_node);
+	pending.set();
+}
+
+void TransformHierarchy3D::update_subtree(Node3D *p_node) {
+	ERR_FAIL_COND(p_node->data.hierarchy != this);
+	_remove_subtree(p_node);
+	_add_subtree(p_node);
+	pending.set();
+}
+
+void TransformHierarchy3D::set_dirty(Node3D *p_node) {
+	Level &level = levels[p_node->data.hierarchy_level];
+	level.flags[p_node->data.hierarchy_index] |= FLAG_DIRTY;
+	level.versions[p_node->data.hierarchy_index]++;
+	pending.set();
+}
+
+void TransformHierarchy3D::set_disable_scale(Node3D *p_node, bool p_disable) {
+	uint8_t &flags = levels[p_node->data.hierarchy_level].flags[p_node->data.hierarchy_index];
+	if (p_disable) {
+		flags |= FLAG_DISABLE_SCALE;
+	} else {
+		flags &= ~FLAG_DISABLE_SCALE;
+	}
+	set_dirty(p_node);
+}
+
+bool TransformHierarchy3D::is_global_transform_valid(const Node3D *p_node, uint32_t *r_version) const {
+	bool valid = true;
+	uint32_t version = 0;
+	uint32_t index = p_node->data.hierarchy_index;
+	for (int64_t i = p_node->data.hierarchy_level; i >= 0 && index != INVALID_INDEX; i--) {
+		const Level &level = levels[i];
+		if (level.flags[index] & FLAG_DIRTY) {
+			valid = false;
+			if (!r_version) {
+				break;
+			}
+		}
+		version += level.versions[index];
+		index = level.parents[index];
+	}
+	if (r_version) {
+		*r_version = version;
+	}
+	return valid;
+}
+
+const Transform3D &TransformHierarchy3D::get_global_transform(const Node3D *p_node) const {
+	return levels[p_node->data.hierarchy_level].global_transforms[p_node->data.hierarchy_index];
+}
+
+void TransformHierarchy3D::_update_range(uint32_t p_level, uint32_t p_from, uint32_t p_to) {
+	Level &level = levels[p_level];
+	const Level *parent_level = p_level > 0 ? &levels[p_level - 1] : nullptr;
+
+	for (uint32_t i = p_from; i < p_to; i++) {
+		const uint8_t flags = level.flags[i];
+		const uint32_t parent = level.parents[i];
+		const bool parent_changed = parent != INVALID_INDEX && (parent_level->flags[parent] & FLAG_CHANGED);
+
+		if (!(flags & FLAG_DIRTY) && !parent_changed) {
+			level.flags[i] = flags & ~FLAG_CHANGED;
+			continue;
+		}
+
+		if (flags & FLAG_DIRTY) {
+			level.local_transforms[i] = level.nodes[i]->get_transform();
+		}
+
+		Transform3D &global = level.global_transforms[i];
+		if (parent != INVALID_INDEX) {
+			global = parent_level->global_transforms[parent] * level.local_transforms[i];
+		} else {
+			global = level.local_transforms[i];
+		}
+		if (flags & FLAG_DISABLE_SCALE) {
+			global.basis.orthonormalize();
+		}
+
+		level.flags[i] = (flags & ~FLAG_DIRTY) | FLAG_CHANGED;
+	}
+}
+
+void TransformHierarchy3D::_update_chunk(uint32_t p_chunk, uint32_t p_level) {
+	const uint32_t from = p_chunk * PARALLEL_CHUNK_SIZE;
+	const uint32_t to = MIN(from + PARALLEL_CHUNK_SIZE, levels[p_level].nodes.size());
+	_update_range(p_level, from, to);
+}
+
+void TransformHierarchy3D::update() {
+	if (!pending.is_set()) {
+		return;
+	}
+	pending.clear();
+
+	for (uint32_t i = 0; i < levels.size(); i++) {
+		const uint32_t node_count = levels[i].nodes.size();
+		if (node_count < PARALLEL_THRESHOLD) {
+			_update_range(i, 0, node_count);
+		} else {
+			const uint32_t chunk_count = (node_count + PARALLEL_CHUNK_SIZE - 1) / PARALLEL_CHUNK_SIZE;
+			WorkerThreadPool::GroupID task = WorkerThreadPool::get_singleton()->add_template_group_task(this, &TransformHierarchy3D::_update_chunk, i, chunk_count);
+			WorkerThreadPool::get_singleton()->wait_for_group_task_completion(task);
+		}
+	}
+
+	Vector<RID> instances;
+	Vector<Transform3D> instance_transforms;
+	for (uint32_t i = 0; i < levels.size(); i++) {
+		const Level &level = levels[i];
+		for (uint32_t j = 0; j < level.nodes.size(); j++) {
+			if (!(level.flags[j] & FLAG_CHANGED)) {
+				continue;
+			}
+			if (level.instances[j].is_valid() && !level.nodes[j]->data.ignore_notification) {
+				instances.push_back(level.instances[j]);
+				instance_transforms.push_back(level.global_transforms[j]);
+			}
+			level.nodes[j]->_notify_dirty();
+		}
+	}
+	if (!instances.is_empty()) {
+		RS::get_singleton()->instance_set_transforms(instances, instance_transforms);
+	}
+}
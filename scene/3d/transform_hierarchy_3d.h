@@ -0,0 +1,116 @@
+/*************************************************************************/
+/*  transform_hierarchy_3d.h                                             */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TRANSFORM_HIERARCHY_3D_H
+#define TRANSFORM_HIERARCHY_3D_H
+
+#include "core/math/transform_3d.h"
+#include "core/templates/local_vector.h"
+#include "core/templates/rid.h"
+#include "core/templates/safe_refcount.h"
+
+class Node3D;
+
+// Global transforms of the Node3Ds in a SceneTree, stored in contiguous
+// arrays, one set per depth level. Changing a node only flags it: the global
+// transforms are computed once per flush, level by level, so the parents are
+// always done before their children and large levels can be split between
+// threads.
+//
+// Opt-in with the `rendering/3d/use_flat_transform_hierarchy` project setting.
+class TransformHierarchy3D {
+	enum {
+		FLAG_DIRTY = 1, // Local transform changed since the last update.
+		FLAG_CHANGED = 2, // Global transform changed in the last update.
+		FLAG_DISABLE_SCALE = 4,
+	};
+
+	// Levels large enough to be updated on multiple threads, and how many
+	// nodes each task updates.
+	enum {
+		PARALLEL_THRESHOLD = 2048,
+		PARALLEL_CHUNK_SIZE = 512,
+	};
+
+	struct Level {
+		LocalVector<Node3D *> nodes;
+		// Index of the parent in the previous level, or INVALID_INDEX for
+		// the roots of level 0 (top level nodes or without Node3D parent).
+		LocalVector<uint32_t> parents;
+		LocalVector<Transform3D> local_transforms;
+		LocalVector<Transform3D> global_transforms;
+		LocalVector<uint8_t> flags;
+		// Incremented when the entry is flagged dirty, so nodes can cache the
+		// global transforms they compute before the next update.
+		LocalVector<uint32_t> versions;
+		// Instance of VisualInstance3D nodes, sent to the RenderingServer
+		// with the other changed transforms after the update.
+		LocalVector<RID> instances;
+	};
+
+	LocalVector<Level> levels;
+
+	SafeFlag pending;
+
+	void _add_node(Node3D *p_node);
+	void _remove_node(Node3D *p_node);
+	void _add_subtree(Node3D *p_node);
+	void _remove_subtree(Node3D *p_node);
+
+	void _update_range(uint32_t p_level, uint32_t p_from, uint32_t p_to);
+	void _update_chunk(uint32_t p_chunk, uint32_t p_level);
+
+public:
+	static const uint32_t INVALID_INDEX = UINT32_MAX;
+
+	void add_node(Node3D *p_node);
+	void remove_node(Node3D *p_node);
+	// Moves the node and its children to their new levels, after the node
+	// became top level or stopped being it.
+	void update_subtree(Node3D *p_node);
+
+	// Thread-safe for nodes processed on different threads.
+	void set_dirty(Node3D *p_node);
+	void set_disable_scale(Node3D *p_node, bool p_disable);
+
+	// Returns whether the global transform stored for the node is up to date,
+	// that is, neither the node nor its parents changed since the last update.
+	// r_version is set to the sum of the versions of the node and its parents,
+	// which changes whenever one of them is flagged dirty.
+	bool is_global_transform_valid(const Node3D *p_node, uint32_t *r_version = nullptr) const;
+	const Transform3D &get_global_transform(const Node3D *p_node) const;
+
+	// Computes the global transforms of the dirty subtrees, sends the changed
+	// ones to the RenderingServer instances in one call, then queues the
+	// transform notifications of the changed nodes, in depth order.
+	void update();
+};
+
+#endif // TRANSFORM_HIERARCHY_3D_H
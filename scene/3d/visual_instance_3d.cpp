@@ -61,6 +61,9 @@ void VisualInstance3D::_notification(int p_what) {
 
 		} break;
 		case NOTIFICATION_TRANSFORM_CHANGED: {
+			if (_is_in_transform_hierarchy()) {
+				break; // Already sent by the hierarchy update.
+			}
 			Transform3D gt = get_global_transform();
 			RenderingServer::get_singleton()->instance_set_transform(instance, gt);
 		} break;
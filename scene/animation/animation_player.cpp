@@ -1339,12 +1339,12 @@ void AnimationPlayer::_animation_changed() {
 }
 
 void AnimationPlayer::_stop_playing_caches() {
-	for (Set<TrackNodeCache *>::Element *E = playing_caches.front(); E; E = E->next()) {
-		if (E->get()->node && E->get()->audio_playing) {
-			E->get()->node->call("stop");
+	for (TrackNodeCache *nc : playing_caches) {
+		if (nc->node && nc->audio_playing) {
+			nc->node->call("stop");
 		}
-		if (E->get()->node && E->get()->animation_playing) {
-			AnimationPlayer *player = Object::cast_to<AnimationPlayer>(E->get()->node);
+		if (nc->node && nc->animation_playing) {
+			AnimationPlayer *player = Object::cast_to<AnimationPlayer>(nc->node);
 			if (!player) {
 				continue;
 			}
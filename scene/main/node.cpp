@@ -48,9 +48,12 @@
 #include <stdint.h>
 
 VARIANT_ENUM_CAST(Node::ProcessMode);
+VARIANT_ENUM_CAST(Node::ProcessThreadGroup);
 
 int Node::orphan_node_count = 0;
 
+thread_local Node *Node::current_process_thread_group = nullptr;
+
 void Node::_notification(int p_notification) {
 	switch (p_notification) {
 		case NOTIFICATION_PROCESS: {
@@ -80,6 +83,10 @@ void Node::_notification(int p_notification) {
 				data.process_owner = this;
 			}
 
+			if (data.process_thread_group == PROCESS_THREAD_GROUP_SUB_THREAD) {
+				get_tree()->process_thread_group_count++;
+			}
+
 			if (data.input) {
 				add_to_group("_vp_input" + itos(get_viewport()->get_instance_id()));
 			}
@@ -112,6 +119,9 @@ void Node::_notification(int p_notification) {
 			}
 
 			data.process_owner = nullptr;
+			if (data.process_thread_group == PROCESS_THREAD_GROUP_SUB_THREAD) {
+				get_tree()->process_thread_group_count--;
+			}
 			if (data.path_cache) {
 				memdelete(data.path_cache);
 				data.path_cache = nullptr;
@@ -299,6 +309,7 @@ void Node::_propagate_exit_tree() {
 }
 
 void Node::move_child(Node *p_child, int p_pos) {
+	ERR_MAIN_THREAD_GUARD;
 	ERR_FAIL_NULL(p_child);
 	ERR_FAIL_INDEX_MSG(p_pos, data.children.size() + 1, vformat("Invalid new child position: %d.", p_pos));
 	ERR_FAIL_COND_MSG(p_child->data.parent != this, "Child is not a child of this node.");
@@ -364,6 +375,7 @@ void Node::move_child_notify(Node *p_child) {
 }
 
 void Node::set_physics_process(bool p_process) {
+	ERR_MAIN_THREAD_GUARD;
 	if (data.physics_process == p_process) {
 		return;
 	}
@@ -382,6 +394,7 @@ bool Node::is_physics_processing() const {
 }
 
 void Node::set_physics_process_internal(bool p_process_internal) {
+	ERR_MAIN_THREAD_GUARD;
 	if (data.physics_process_internal == p_process_internal) {
 		return;
 	}
@@ -400,6 +413,7 @@ bool Node::is_physics_processing_internal() const {
 }
 
 void Node::set_process_mode(ProcessMode p_mode) {
+	ERR_MAIN_THREAD_GUARD;
 	if (data.process_mode == p_mode) {
 		return;
 	}
@@ -492,6 +506,60 @@ void Node::_propagate_process_owner(Node *p_owner, int p_pause_notification, int
 	}
 }
 
+void Node::set_process_thread_group(ProcessThreadGroup p_group) {
+	ERR_MAIN_THREAD_GUARD;
+	if (data.process_thread_group == p_group) {
+		return;
+	}
+
+	if (is_inside_tree()) {
+		if (data.process_thread_group == PROCESS_THREAD_GROUP_SUB_THREAD) {
+			get_tree()->process_thread_group_count--;
+		}
+		if (p_group == PROCESS_THREAD_GROUP_SUB_THREAD) {
+			get_tree()->process_thread_group_count++;
+		}
+	}
+
+	data.process_thread_group = p_group;
+	_propagate_process_thread_group_owner();
+}
+
+Node::ProcessThreadGroup Node::get_process_thread_group() const {
+	return data.process_thread_group;
+}
+
+Node *Node::get_process_thread_group_owner() const {
+	return data.process_thread_group_owner;
+}
+
+void Node::_propagate_process_thread_group_owner() {
+	switch (data.process_thread_group) {
+		case PROCESS_THREAD_GROUP_INHERIT: {
+			data.process_thread_group_owner = data.parent ? data.parent->data.process_thread_group_owner : nullptr;
+		} break;
+		case PROCESS_THREAD_GROUP_MAIN_THREAD: {
+			data.process_thread_group_owner = nullptr;
+		} break;
+		case PROCESS_THREAD_GROUP_SUB_THREAD: {
+			// A group nested in another one, even below main thread nodes, is merged into it.
+			// Otherwise moving the outer group would change the transforms of nodes processed
+			// by another thread at the same time.
+			data.process_thread_group_owner = this;
+			for (const Node *p = data.parent; p; p = p->data.parent) {
+				if (p->data.process_thread_group == PROCESS_THREAD_GROUP_SUB_THREAD) {
+					data.process_thread_group_owner = p->data.process_thread_group_owner;
+					break;
+				}
+			}
+		} break;
+	}
+
+	for (int i = 0; i < data.children.size(); i++) {
+		data.children[i]->_propagate_process_thread_group_owner();
+	}
+}
+
 void Node::set_network_master(int p_peer_id, bool p_recursive) {
 	data.network_master = p_peer_id;
 
@@ -729,6 +797,7 @@ double Node::get_process_delta_time() const {
 }
 
 void Node::set_process(bool p_process) {
+	ERR_MAIN_THREAD_GUARD;
 	if (data.process == p_process) {
 		return;
 	}
@@ -747,6 +816,7 @@ bool Node::is_processing() const {
 }
 
 void Node::set_process_internal(bool p_process_internal) {
+	ERR_MAIN_THREAD_GUARD;
 	if (data.process_internal == p_process_internal) {
 		return;
 	}
@@ -765,6 +835,7 @@ bool Node::is_processing_internal() const {
 }
 
 void Node::set_process_priority(int p_priority) {
+	ERR_MAIN_THREAD_GUARD;
 	data.process_priority = p_priority;
 
 	// Make sure we are in SceneTree.
@@ -863,6 +934,7 @@ void Node::_set_name_nocheck(const StringName &p_name) {
 }
 
 void Node::set_name(const String &p_name) {
+	ERR_MAIN_THREAD_GUARD;
 	String name = p_name.validate_node_name();
 
 	ERR_FAIL_COND(name == "");
@@ -1067,6 +1139,7 @@ void Node::_add_child_nocheck(Node *p_child, const StringName &p_name) {
 	p_child->data.pos = data.children.size();
 	data.children.push_back(p_child);
 	p_child->data.parent = this;
+	p_child->_propagate_process_thread_group_owner();
 	p_child->notification(NOTIFICATION_PARENTED);
 
 	if (data.tree) {
@@ -1080,6 +1153,7 @@ void Node::_add_child_nocheck(Node *p_child, const StringName &p_name) {
 }
 
 void Node::add_child(Node *p_child, bool p_legible_unique_name) {
+	ERR_MAIN_THREAD_GUARD;
 	ERR_FAIL_NULL(p_child);
 	ERR_FAIL_COND_MSG(p_child == this, vformat("Can't add child '%s' to itself.", p_child->get_name())); // adding to itself!
 	ERR_FAIL_COND_MSG(p_child->data.parent, vformat("Can't add child '%s' to '%s', already has a parent '%s'.", p_child->get_name(), get_name(), p_child->data.parent->get_name())); //Fail if node has a parent
@@ -1095,6 +1169,7 @@ void Node::add_child(Node *p_child, bool p_legible_unique_name) {
 }
 
 void Node::add_sibling(Node *p_sibling, bool p_legible_unique_name) {
+	ERR_MAIN_THREAD_GUARD;
 	ERR_FAIL_NULL(p_sibling);
 	ERR_FAIL_COND_MSG(p_sibling == this, vformat("Can't add sibling '%s' to itself.", p_sibling->get_name())); // adding to itself!
 	ERR_FAIL_COND_MSG(data.blocked > 0, "Parent node is busy setting up children, add_sibling() failed. Consider using call_deferred(\"add_sibling\", sibling) instead.");
@@ -1129,6 +1204,7 @@ void Node::_propagate_validate_owner() {
 }
 
 void Node::remove_child(Node *p_child) {
+	ERR_MAIN_THREAD_GUARD;
 	ERR_FAIL_NULL(p_child);
 	ERR_FAIL_COND_MSG(data.blocked > 0, "Parent node is busy setting up children, remove_node() failed. Consider using call_deferred(\"remove_child\", child) instead.");
 
@@ -1175,6 +1251,7 @@ void Node::remove_child(Node *p_child) {
 
 	p_child->data.parent = nullptr;
 	p_child->data.pos = -1;
+	p_child->_propagate_process_thread_group_owner();
 
 	// validate owner
 	p_child->_propagate_validate_owner();
@@ -1425,6 +1502,7 @@ void Node::_set_owner_nocheck(Node *p_owner) {
 }
 
 void Node::set_owner(Node *p_owner) {
+	ERR_MAIN_THREAD_GUARD;
 	if (data.owner) {
 		data.owner->data.owned.erase(data.OW);
 		data.OW = nullptr;
@@ -1567,6 +1645,7 @@ bool Node::is_in_group(const StringName &p_identifier) const {
 }
 
 void Node::add_to_group(const StringName &p_identifier, bool p_persistent) {
+	ERR_MAIN_THREAD_GUARD;
 	ERR_FAIL_COND(!p_identifier.operator String().length());
 
 	if (data.grouped.has(p_identifier)) {
@@ -1587,6 +1666,7 @@ void Node::add_to_group(const StringName &p_identifier, bool p_persistent) {
 }
 
 void Node::remove_from_group(const StringName &p_identifier) {
+	ERR_MAIN_THREAD_GUARD;
 	ERR_FAIL_COND(!data.grouped.has(p_identifier));
 
 	Map<StringName, GroupData>::Element *E = data.grouped.find(p_identifier);
@@ -1687,6 +1767,7 @@ void Node::_propagate_deferred_notification(int p_notification, bool p_reverse)
 }
 
 void Node::propagate_notification(int p_notification) {
+	ERR_THREAD_GUARD;
 	data.blocked++;
 	notification(p_notification);
 
@@ -1697,6 +1778,7 @@ void Node::propagate_notification(int p_notification) {
 }
 
 void Node::propagate_call(const StringName &p_method, const Array &p_args, const bool p_parent_first) {
+	ERR_THREAD_GUARD;
 	data.blocked++;
 
 	if (p_parent_first && has_method(p_method)) {
@@ -2190,6 +2272,7 @@ static void find_owned_by(Node *p_by, Node *p_node, List<Node *> *p_owned) {
 }
 
 void Node::replace_by(Node *p_node, bool p_keep_groups) {
+	ERR_MAIN_THREAD_GUARD;
 	ERR_FAIL_NULL(p_node);
 	ERR_FAIL_COND(p_node->data.parent);
 
@@ -2596,6 +2679,8 @@ void Node::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_process", "enable"), &Node::set_process);
 	ClassDB::bind_method(D_METHOD("set_process_priority", "priority"), &Node::set_process_priority);
 	ClassDB::bind_method(D_METHOD("get_process_priority"), &Node::get_process_priority);
+	ClassDB::bind_method(D_METHOD("set_process_thread_group", "group"), &Node::set_process_thread_group);
+	ClassDB::bind_method(D_METHOD("get_process_thread_group"), &Node::get_process_thread_group);
 	ClassDB::bind_method(D_METHOD("is_processing"), &Node::is_processing);
 	ClassDB::bind_method(D_METHOD("set_process_input", "enable"), &Node::set_process_input);
 	ClassDB::bind_method(D_METHOD("is_processing_input"), &Node::is_processing_input);
@@ -2713,6 +2798,10 @@ void Node::_bind_methods() {
 	BIND_ENUM_CONSTANT(PROCESS_MODE_ALWAYS);
 	BIND_ENUM_CONSTANT(PROCESS_MODE_DISABLED);
 
+	BIND_ENUM_CONSTANT(PROCESS_THREAD_GROUP_INHERIT);
+	BIND_ENUM_CONSTANT(PROCESS_THREAD_GROUP_MAIN_THREAD);
+	BIND_ENUM_CONSTANT(PROCESS_THREAD_GROUP_SUB_THREAD);
+
 	BIND_ENUM_CONSTANT(DUPLICATE_SIGNALS);
 	BIND_ENUM_CONSTANT(DUPLICATE_GROUPS);
 	BIND_ENUM_CONSTANT(DUPLICATE_SCRIPTS);
@@ -2733,6 +2822,7 @@ void Node::_bind_methods() {
 	ADD_GROUP("Process", "process_");
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "process_mode", PROPERTY_HINT_ENUM, "Inherit,Pausable,When Paused,Always,Disabled"), "set_process_mode", "get_process_mode");
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "process_priority"), "set_process_priority", "get_process_priority");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "process_thread_group", PROPERTY_HINT_ENUM, "Inherit,Main Thread,Sub Thread"), "set_process_thread_group", "get_process_thread_group");
 
 	ADD_GROUP("Editor Description", "editor_");
 	ADD_PROPERTY(PropertyInfo(Variant::STRING, "editor_description", PROPERTY_HINT_MULTILINE_TEXT, "", PROPERTY_USAGE_EDITOR | PROPERTY_USAGE_INTERNAL), "set_editor_description", "get_editor_description");
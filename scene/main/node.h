@@ -57,6 +57,12 @@ public:
 		PROCESS_MODE_DISABLED, // never process
 	};
 
+	enum ProcessThreadGroup {
+		PROCESS_THREAD_GROUP_INHERIT, // same as parent node
+		PROCESS_THREAD_GROUP_MAIN_THREAD, // processed on the main thread
+		PROCESS_THREAD_GROUP_SUB_THREAD, // the node and the ones inheriting from it are processed together, on a worker thread
+	};
+
 	enum DuplicateFlags {
 		DUPLICATE_SIGNALS = 1,
 		DUPLICATE_GROUPS = 2,
@@ -119,6 +125,9 @@ private:
 		ProcessMode process_mode = PROCESS_MODE_INHERIT;
 		Node *process_owner = nullptr;
 
+		ProcessThreadGroup process_thread_group = PROCESS_THREAD_GROUP_INHERIT;
+		Node *process_thread_group_owner = nullptr; // Null when processed on the main thread.
+
 		int network_master = 1; // Server by default.
 		Vector<MultiplayerAPI::RPCConfig> rpc_methods;
 
@@ -167,6 +176,7 @@ private:
 	void _propagate_validate_owner();
 	void _print_stray_nodes();
 	void _propagate_process_owner(Node *p_owner, int p_pause_notification, int p_enabled_notification);
+	void _propagate_process_thread_group_owner();
 	Array _get_node_and_resource(const NodePath &p_path);
 
 	void _duplicate_signals(const Node *p_original, Node *p_copy) const;
@@ -393,6 +403,17 @@ public:
 	bool can_process_notification(int p_what) const;
 	bool is_enabled() const;
 
+	void set_process_thread_group(ProcessThreadGroup p_group);
+	ProcessThreadGroup get_process_thread_group() const;
+	Node *get_process_thread_group_owner() const;
+
+	// Owner of the sub thread process group being processed by the caller thread, if any.
+	static thread_local Node *current_process_thread_group;
+
+	_FORCE_INLINE_ bool is_accessible_from_caller_thread() const {
+		return !current_process_thread_group || !data.inside_tree || data.process_thread_group_owner == current_process_thread_group;
+	}
+
 	void request_ready();
 
 	static void print_stray_nodes();
@@ -452,4 +473,14 @@ VARIANT_ENUM_CAST(Node::DuplicateFlags);
 
 typedef Set<Node *, Node::Comparator> NodeSet;
 
+#ifdef DEBUG_ENABLED
+// Nodes of a sub thread process group can only be used by the thread processing
+// that group, and the tree can only be changed from the main thread.
+#define ERR_THREAD_GUARD ERR_FAIL_COND_MSG(!is_accessible_from_caller_thread(), "Node '" + get_name() + "' is processed by another thread. Use call_deferred() instead.");
+#define ERR_MAIN_THREAD_GUARD ERR_FAIL_COND_MSG(Node::current_process_thread_group && is_inside_tree(), "The scene tree can't be changed while processing a thread group. Use call_deferred() instead.");
+#else
+#define ERR_THREAD_GUARD
+#define ERR_MAIN_THREAD_GUARD
+#endif
+
 #endif
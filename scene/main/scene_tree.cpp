@@ -39,8 +39,10 @@
 #include "core/object/message_queue.h"
 #include "core/os/keyboard.h"
 #include "core/os/os.h"
+#include "core/os/worker_thread_pool.h"
 #include "core/string/print_string.h"
 #include "node.h"
+#include "scene/3d/transform_hierarchy_3d.h"
 #include "scene/animation/tween.h"
 #include "scene/debugger/scene_debugger.h"
 #include "scene/resources/font.h"
@@ -115,46 +117,149 @@ void SceneTree::node_removed(Node *p_node) {
 		current_scene = nullptr;
 	}
 	emit_signal(node_removed_name, p_node);
-	if (call_lock > 0) {
-		call_skip.insert(p_node);
-	}
 }
 
 void SceneTree::node_renamed(Node *p_node) {
 	emit_signal(node_renamed_name, p_node);
 }
 
+template <class C>
+uint32_t SceneTree::Group::_find_insert_position(Node *p_node) const {
+	C compare;
+	uint32_t high = nodes.size();
+	if (!compare(p_node, nodes[high - 1])) {
+		return high;
+	}
+
+	// Binary search for the first node going after p_node.
+	uint32_t low = 0;
+	high--;
+	while (low < high) {
+		const uint32_t middle = (low + high) / 2;
+		if (compare(p_node, nodes[middle])) {
+			high = middle;
+		} else {
+			low = middle + 1;
+		}
+	}
+	return low;
+}
+
+bool SceneTree::Group::add(Node *p_node) {
+	if (nodes.find(p_node) != -1) {
+		return false;
+	}
+
+	if (changed || iterating > 0 || nodes.is_empty()) {
+		// Sorted later, when the group is used.
+		nodes.push_back(p_node);
+		changed = true;
+		return true;
+	}
+
+	// Keep the group sorted. Nodes usually enter the tree in tree order, so
+	// they mostly go at the end.
+	uint32_t pos;
+	if (sorted_by_priority) {
+		pos = _find_insert_position<Node::ComparatorWithPriority>(p_node);
+	} else {
+		pos = _find_insert_position<Node::Comparator>(p_node);
+	}
+	if (pos == nodes.size()) {
+		nodes.push_back(p_node);
+	} else {
+		nodes.insert(pos, p_node);
+	}
+	return true;
+}
+
+bool SceneTree::Group::remove(Node *p_node) {
+	const int64_t index = nodes.find(p_node);
+	if (index == -1) {
+		return false;
+	}
+
+	if (iterating > 0) {
+		// Keep the indices stable for the loops going through the group,
+		// the tombstone is removed when they are done.
+		nodes[index] = nullptr;
+		has_tombstones = true;
+	} else {
+		nodes.remove(index);
+	}
+	return true;
+}
+
+void SceneTree::Group::update_order(bool p_use_priority) {
+	if (!changed) {
+		return;
+	}
+	if (nodes.is_empty()) {
+		return;
+	}
+	if (iterating > 0) {
+		// Sorting would move the nodes under the loops going through the group.
+		return;
+	}
+
+	if (p_use_priority) {
+		SortArray<Node *, Node::ComparatorWithPriority> node_sort;
+		node_sort.sort(nodes.ptr(), nodes.size());
+	} else {
+		SortArray<Node *, Node::Comparator> node_sort;
+		node_sort.sort(nodes.ptr(), nodes.size());
+	}
+	sorted_by_priority = p_use_priority;
+	changed = false;
+}
+
+void SceneTree::Group::end_iteration() {
+	iterating--;
+	if (iterating > 0 || !has_tombstones) {
+		return;
+	}
+
+	uint32_t count = 0;
+	for (uint32_t i = 0; i < nodes.size(); i++) {
+		if (nodes[i]) {
+			nodes[count++] = nodes[i];
+		}
+	}
+	nodes.resize(count);
+	has_tombstones = false;
+}
+
 SceneTree::Group *SceneTree::add_to_group(const StringName &p_group, Node *p_node) {
-	Map<StringName, Group>::Element *E = group_map.find(p_group);
-	if (!E) {
-		E = group_map.insert(p_group, Group());
+	Group *g = group_map.getptr(p_group);
+	if (!g) {
+		g = &group_map.set(p_group, Group())->value();
 	}
 
-	ERR_FAIL_COND_V_MSG(E->get().nodes.find(p_node) != -1, &E->get(), "Already in group: " + p_group + ".");
-	E->get().nodes.push_back(p_node);
-	//E->get().last_tree_version=0;
-	E->get().changed = true;
-	return &E->get();
+	ERR_FAIL_COND_V_MSG(!g->add(p_node), g, "Already in group: " + p_group + ".");
+	return g;
 }
 
 void SceneTree::remove_from_group(const StringName &p_group, Node *p_node) {
-	Map<StringName, Group>::Element *E = group_map.find(p_group);
-	ERR_FAIL_COND(!E);
+	Group *g = group_map.getptr(p_group);
+	ERR_FAIL_COND(!g);
 
-	E->get().nodes.erase(p_node);
-	if (E->get().nodes.is_empty()) {
-		group_map.erase(E);
+	if (g->remove(p_node) && g->nodes.is_empty()) {
+		group_map.erase(p_group);
 	}
 }
 
 void SceneTree::make_group_changed(const StringName &p_group) {
-	Map<StringName, Group>::Element *E = group_map.find(p_group);
-	if (E) {
-		E->get().changed = true;
+	Group *g = group_map.getptr(p_group);
+	if (g) {
+		g->changed = true;
 	}
 }
 
 void SceneTree::flush_transform_notifications() {
+	if (transform_hierarchy_3d) {
+		transform_hierarchy_3d->update();
+	}
+
 	SelfList<Node> *n = xform_change_list.first();
 	while (n) {
 		Node *node = n->self();
@@ -185,33 +290,19 @@ void SceneTree::_flush_ugc() {
 	ugc_locked = false;
 }
 
-void SceneTree::_update_group_order(Group &g, bool p_use_priority) {
-	if (!g.changed) {
-		return;
-	}
-	if (g.nodes.is_empty()) {
-		return;
-	}
-
-	Node **nodes = g.nodes.ptrw();
-	int node_count = g.nodes.size();
-
-	if (p_use_priority) {
-		SortArray<Node *, Node::ComparatorWithPriority> node_sort;
-		node_sort.sort(nodes, node_count);
-	} else {
-		SortArray<Node *, Node::Comparator> node_sort;
-		node_sort.sort(nodes, node_count);
+void SceneTree::_end_group_iteration(const StringName &p_group, Group &g) {
+	g.end_iteration();
+	if (g.iterating == 0 && g.nodes.is_empty()) {
+		group_map.erase(p_group);
 	}
-	g.changed = false;
 }
 
 void SceneTree::call_group_flags(uint32_t p_call_flags, const StringName &p_group, const StringName &p_function, VARIANT_ARG_DECLARE) {
-	Map<StringName, Group>::Element *E = group_map.find(p_group);
-	if (!E) {
+	Group *group = group_map.getptr(p_group);
+	if (!group) {
 		return;
 	}
-	Group &g = E->get();
+	Group &g = *group;
 	if (g.nodes.is_empty()) {
 		return;
 	}
@@ -241,147 +332,137 @@ void SceneTree::call_group_flags(uint32_t p_call_flags, const StringName &p_grou
 		return;
 	}
 
-	_update_group_order(g);
-
-	Vector<Node *> nodes_copy = g.nodes;
-	Node **nodes = nodes_copy.ptrw();
-	int node_count = nodes_copy.size();
+	g.update_order();
 
-	call_lock++;
+	// Nodes added while going through the group are not called, and the ones
+	// removed are left as null tombstones.
+	g.begin_iteration();
+	const uint32_t node_count = g.nodes.size();
 
 	if (p_call_flags & GROUP_CALL_REVERSE) {
-		for (int i = node_count - 1; i >= 0; i--) {
-			if (call_lock && call_skip.has(nodes[i])) {
+		for (uint32_t i = node_count; i > 0; i--) {
+			Node *n = g.nodes[i - 1];
+			if (!n) {
 				continue;
 			}
 
 			if (p_call_flags & GROUP_CALL_REALTIME) {
-				nodes[i]->call(p_function, VARIANT_ARG_PASS);
+				n->call(p_function, VARIANT_ARG_PASS);
 			} else {
-				MessageQueue::get_singleton()->push_call(nodes[i], p_function, VARIANT_ARG_PASS);
+				MessageQueue::get_singleton()->push_call(n, p_function, VARIANT_ARG_PASS);
 			}
 		}
 
 	} else {
-		for (int i = 0; i < node_count; i++) {
-			if (call_lock && call_skip.has(nodes[i])) {
+		for (uint32_t i = 0; i < node_count; i++) {
+			Node *n = g.nodes[i];
+			if (!n) {
 				continue;
 			}
 
 			if (p_call_flags & GROUP_CALL_REALTIME) {
-				nodes[i]->call(p_function, VARIANT_ARG_PASS);
+				n->call(p_function, VARIANT_ARG_PASS);
 			} else {
-				MessageQueue::get_singleton()->push_call(nodes[i], p_function, VARIANT_ARG_PASS);
+				MessageQueue::get_singleton()->push_call(n, p_function, VARIANT_ARG_PASS);
 			}
 		}
 	}
 
-	call_lock--;
-	if (call_lock == 0) {
-		call_skip.clear();
-	}
+	_end_group_iteration(p_group, g);
 }
 
 void SceneTree::notify_group_flags(uint32_t p_call_flags, const StringName &p_group, int p_notification) {
-	Map<StringName, Group>::Element *E = group_map.find(p_group);
-	if (!E) {
+	Group *group = group_map.getptr(p_group);
+	if (!group) {
 		return;
 	}
-	Group &g = E->get();
+	Group &g = *group;
 	if (g.nodes.is_empty()) {
 		return;
 	}
 
-	_update_group_order(g);
+	g.update_order();
 
-	Vector<Node *> nodes_copy = g.nodes;
-	Node **nodes = nodes_copy.ptrw();
-	int node_count = nodes_copy.size();
-
-	call_lock++;
+	g.begin_iteration();
+	const uint32_t node_count = g.nodes.size();
 
 	if (p_call_flags & GROUP_CALL_REVERSE) {
-		for (int i = node_count - 1; i >= 0; i--) {
-			if (call_lock && call_skip.has(nodes[i])) {
+		for (uint32_t i = node_count; i > 0; i--) {
+			Node *n = g.nodes[i - 1];
+			if (!n) {
 				continue;
 			}
 
 			if (p_call_flags & GROUP_CALL_REALTIME) {
-				nodes[i]->notification(p_notification);
+				n->notification(p_notification);
 			} else {
-				MessageQueue::get_singleton()->push_notification(nodes[i], p_notification);
+				MessageQueue::get_singleton()->push_notification(n, p_notification);
 			}
 		}
 
 	} else {
-		for (int i = 0; i < node_count; i++) {
-			if (call_lock && call_skip.has(nodes[i])) {
+		for (uint32_t i = 0; i < node_count; i++) {
+			Node *n = g.nodes[i];
+			if (!n) {
 				continue;
 			}
 
 			if (p_call_flags & GROUP_CALL_REALTIME) {
-				nodes[i]->notification(p_notification);
+				n->notification(p_notification);
 			} else {
-				MessageQueue::get_singleton()->push_notification(nodes[i], p_notification);
+				MessageQueue::get_singleton()->push_notification(n, p_notification);
 			}
 		}
 	}
 
-	call_lock--;
-	if (call_lock == 0) {
-		call_skip.clear();
-	}
+	_end_group_iteration(p_group, g);
 }
 
 void SceneTree::set_group_flags(uint32_t p_call_flags, const StringName &p_group, const String &p_name, const Variant &p_value) {
-	Map<StringName, Group>::Element *E = group_map.find(p_group);
-	if (!E) {
+	Group *group = group_map.getptr(p_group);
+	if (!group) {
 		return;
 	}
-	Group &g = E->get();
+	Group &g = *group;
 	if (g.nodes.is_empty()) {
 		return;
 	}
 
-	_update_group_order(g);
-
-	Vector<Node *> nodes_copy = g.nodes;
-	Node **nodes = nodes_copy.ptrw();
-	int node_count = nodes_copy.size();
+	g.update_order();
 
-	call_lock++;
+	g.begin_iteration();
+	const uint32_t node_count = g.nodes.size();
 
 	if (p_call_flags & GROUP_CALL_REVERSE) {
-		for (int i = node_count - 1; i >= 0; i--) {
-			if (call_lock && call_skip.has(nodes[i])) {
+		for (uint32_t i = node_count; i > 0; i--) {
+			Node *n = g.nodes[i - 1];
+			if (!n) {
 				continue;
 			}
 
 			if (p_call_flags & GROUP_CALL_REALTIME) {
-				nodes[i]->set(p_name, p_value);
+				n->set(p_name, p_value);
 			} else {
-				MessageQueue::get_singleton()->push_set(nodes[i], p_name, p_value);
+				MessageQueue::get_singleton()->push_set(n, p_name, p_value);
 			}
 		}
 
 	} else {
-		for (int i = 0; i < node_count; i++) {
-			if (call_lock && call_skip.has(nodes[i])) {
+		for (uint32_t i = 0; i < node_count; i++) {
+			Node *n = g.nodes[i];
+			if (!n) {
 				continue;
 			}
 
 			if (p_call_flags & GROUP_CALL_REALTIME) {
-				nodes[i]->set(p_name, p_value);
+				n->set(p_name, p_value);
 			} else {
-				MessageQueue::get_singleton()->push_set(nodes[i], p_name, p_value);
+				MessageQueue::get_singleton()->push_set(n, p_name, p_value);
 			}
 		}
 	}
 
-	call_lock--;
-	if (call_lock == 0) {
-		call_skip.clear();
-	}
+	_end_group_iteration(p_group, g);
 }
 
 void SceneTree::call_group(const StringName &p_group, const StringName &p_function, VARIANT_ARG_DECLARE) {
@@ -815,29 +896,41 @@ bool SceneTree::is_paused() const {
 }
 
 void SceneTree::_notify_group_pause(const StringName &p_group, int p_notification) {
-	Map<StringName, Group>::Element *E = group_map.find(p_group);
-	if (!E) {
+	Group *group = group_map.getptr(p_group);
+	if (!group) {
 		return;
 	}
-	Group &g = E->get();
+	Group &g = *group;
 	if (g.nodes.is_empty()) {
 		return;
 	}
 
-	_update_group_order(g, p_notification == Node::NOTIFICATION_PROCESS || p_notification == Node::NOTIFICATION_INTERNAL_PROCESS || p_notification == Node::NOTIFICATION_PHYSICS_PROCESS || p_notification == Node::NOTIFICATION_INTERNAL_PHYSICS_PROCESS);
-
-	//copy, so copy on write happens in case something is removed from process while being called
-	//performance is not lost because only if something is added/removed the vector is copied.
-	Vector<Node *> nodes_copy = g.nodes;
+	g.update_order(p_notification == Node::NOTIFICATION_PROCESS || p_notification == Node::NOTIFICATION_INTERNAL_PROCESS || p_notification == Node::NOTIFICATION_PHYSICS_PROCESS || p_notification == Node::NOTIFICATION_INTERNAL_PHYSICS_PROCESS);
 
-	int node_count = nodes_copy.size();
-	Node **nodes = nodes_copy.ptrw();
+	// Nodes added while going through the group are not processed, and the ones
+	// removed are left as null tombstones.
+	g.begin_iteration();
+	const uint32_t node_count = g.nodes.size();
 
-	call_lock++;
+	// Sub thread process groups are notified first, in parallel, each one going
+	// through its nodes in order. The main thread nodes come after them.
+	// Physics processing stays on the main thread, as direct space queries are
+	// not thread safe.
+	const bool use_thread_groups = process_thread_group_count > 0 && (p_notification == Node::NOTIFICATION_PROCESS || p_notification == Node::NOTIFICATION_INTERNAL_PROCESS) && !Engine::get_singleton()->is_editor_hint();
+	if (use_thread_groups) {
+		const uint32_t group_count = partition_process_thread_groups(g.nodes.ptr(), node_count, process_thread_groups, process_thread_group_indices);
+		if (group_count > 0) {
+			WorkerThreadPool::GroupID task = WorkerThreadPool::get_singleton()->add_template_group_task(this, &SceneTree::_process_thread_group, p_notification, group_count);
+			WorkerThreadPool::get_singleton()->wait_for_group_task_completion(task);
+		}
+	}
 
-	for (int i = 0; i < node_count; i++) {
-		Node *n = nodes[i];
-		if (call_lock && call_skip.has(n)) {
+	for (uint32_t i = 0; i < node_count; i++) {
+		Node *n = g.nodes[i];
+		if (!n) {
+			continue;
+		}
+		if (use_thread_groups && n->data.process_thread_group_owner) {
 			continue;
 		}
 
@@ -849,13 +942,46 @@ void SceneTree::_notify_group_pause(const StringName &p_group, int p_notificatio
 		}
 
 		n->notification(p_notification);
-		//ERR_FAIL_COND(node_count != g.nodes.size());
 	}
 
-	call_lock--;
-	if (call_lock == 0) {
-		call_skip.clear();
+	_end_group_iteration(p_group, g);
+}
+
+uint32_t SceneTree::partition_process_thread_groups(Node *const *p_nodes, uint32_t p_node_count, LocalVector<ProcessThreadGroup> &r_groups, HashMap<ObjectID, uint32_t> &r_indices) {
+	uint32_t group_count = 0;
+	r_indices.clear();
+	for (uint32_t i = 0; i < p_node_count; i++) {
+		Node *n = p_nodes[i];
+		Node *owner = n ? n->data.process_thread_group_owner : nullptr;
+		if (!owner) {
+			continue;
+		}
+		const uint32_t *index = r_indices.getptr(owner->get_instance_id());
+		if (!index) {
+			if (group_count == r_groups.size()) {
+				r_groups.resize(group_count + 1);
+			}
+			r_groups[group_count].owner = owner;
+			r_groups[group_count].nodes.clear();
+			index = &r_indices.set(owner->get_instance_id(), group_count++)->value();
+		}
+		r_groups[*index].nodes.push_back(n);
+	}
+	return group_count;
+}
+
+void SceneTree::_process_thread_group(uint32_t p_index, int p_notification) {
+	const ProcessThreadGroup &group = process_thread_groups[p_index];
+
+	Node::current_process_thread_group = group.owner;
+	for (uint32_t i = 0; i < group.nodes.size(); i++) {
+		Node *n = group.nodes[i];
+		if (!n->can_process() || !n->can_process_notification(p_notification)) {
+			continue;
+		}
+		n->notification(p_notification);
 	}
+	Node::current_process_thread_group = nullptr;
 }
 
 /*
@@ -868,36 +994,30 @@ void SceneMainLoop::_update_listener_2d() {
 */
 
 void SceneTree::_call_input_pause(const StringName &p_group, const StringName &p_method, const Ref<InputEvent> &p_input, Viewport *p_viewport) {
-	Map<StringName, Group>::Element *E = group_map.find(p_group);
-	if (!E) {
+	Group *group = group_map.getptr(p_group);
+	if (!group) {
 		return;
 	}
-	Group &g = E->get();
+	Group &g = *group;
 	if (g.nodes.is_empty()) {
 		return;
 	}
 
-	_update_group_order(g);
-
-	//copy, so copy on write happens in case something is removed from process while being called
-	//performance is not lost because only if something is added/removed the vector is copied.
-	Vector<Node *> nodes_copy = g.nodes;
-
-	int node_count = nodes_copy.size();
-	Node **nodes = nodes_copy.ptrw();
+	g.update_order();
 
 	Variant arg = p_input;
 	const Variant *v[1] = { &arg };
 
-	call_lock++;
+	g.begin_iteration();
+	const uint32_t node_count = g.nodes.size();
 
-	for (int i = node_count - 1; i >= 0; i--) {
+	for (uint32_t i = node_count; i > 0; i--) {
 		if (p_viewport->is_input_handled()) {
 			break;
 		}
 
-		Node *n = nodes[i];
-		if (call_lock && call_skip.has(n)) {
+		Node *n = g.nodes[i - 1];
+		if (!n) {
 			continue;
 		}
 
@@ -916,10 +1036,7 @@ void SceneTree::_call_input_pause(const StringName &p_group, const StringName &p
 		}
 	}
 
-	call_lock--;
-	if (call_lock == 0) {
-		call_skip.clear();
-	}
+	_end_group_iteration(p_group, g);
 }
 
 Variant SceneTree::_call_group_flags(const Variant **p_args, int p_argcount, Callable::CallError &r_error) {
@@ -970,22 +1087,16 @@ int64_t SceneTree::get_frame() const {
 
 Array SceneTree::_get_nodes_in_group(const StringName &p_group) {
 	Array ret;
-	Map<StringName, Group>::Element *E = group_map.find(p_group);
-	if (!E) {
-		return ret;
-	}
-
-	_update_group_order(E->get()); //update order just in case
-	int nc = E->get().nodes.size();
-	if (nc == 0) {
+	Group *g = group_map.getptr(p_group);
+	if (!g) {
 		return ret;
 	}
 
-	ret.resize(nc);
-
-	Node **ptr = E->get().nodes.ptrw();
-	for (int i = 0; i < nc; i++) {
-		ret[i] = ptr[i];
+	g->update_order(); //update order just in case
+	for (uint32_t i = 0; i < g->nodes.size(); i++) {
+		if (g->nodes[i]) {
+			ret.push_back(g->nodes[i]);
+		}
 	}
 
 	return ret;
@@ -996,34 +1107,32 @@ bool SceneTree::has_group(const StringName &p_identifier) const {
 }
 
 Node *SceneTree::get_first_node_in_group(const StringName &p_group) {
-	Map<StringName, Group>::Element *E = group_map.find(p_group);
-	if (!E) {
+	Group *g = group_map.getptr(p_group);
+	if (!g) {
 		return nullptr; //no group
 	}
 
-	_update_group_order(E->get()); //update order just in case
+	g->update_order(); //update order just in case
 
-	if (E->get().nodes.size() == 0) {
-		return nullptr;
+	for (uint32_t i = 0; i < g->nodes.size(); i++) {
+		if (g->nodes[i]) {
+			return g->nodes[i];
+		}
 	}
-
-	return E->get().nodes[0];
+	return nullptr;
 }
 
 void SceneTree::get_nodes_in_group(const StringName &p_group, List<Node *> *p_list) {
-	Map<StringName, Group>::Element *E = group_map.find(p_group);
-	if (!E) {
+	Group *g = group_map.getptr(p_group);
+	if (!g) {
 		return;
 	}
 
-	_update_group_order(E->get()); //update order just in case
-	int nc = E->get().nodes.size();
-	if (nc == 0) {
-		return;
-	}
-	Node **ptr = E->get().nodes.ptrw();
-	for (int i = 0; i < nc; i++) {
-		p_list->push_back(ptr[i]);
+	g->update_order(); //update order just in case
+	for (uint32_t i = 0; i < g->nodes.size(); i++) {
+		if (g->nodes[i]) {
+			p_list->push_back(g->nodes[i]);
+		}
 	}
 }
 
@@ -1329,6 +1438,10 @@ SceneTree::SceneTree() {
 
 	Math::randomize();
 
+	if (GLOBAL_DEF("rendering/3d/use_flat_transform_hierarchy", false) && !Engine::get_singleton()->is_editor_hint()) {
+		transform_hierarchy_3d = memnew(TransformHierarchy3D);
+	}
+
 	// Create with mainloop.
 
 	root = memnew(Window);
@@ -1447,6 +1560,10 @@ SceneTree::~SceneTree() {
 		memdelete(root);
 	}
 
+	if (transform_hierarchy_3d) {
+		memdelete(transform_hierarchy_3d);
+	}
+
 	if (singleton == this) {
 		singleton = nullptr;
 	}
@@ -33,7 +33,10 @@
 
 #include "core/io/multiplayer_api.h"
 #include "core/os/main_loop.h"
+#include "core/os/spin_lock.h"
 #include "core/os/thread_safe.h"
+#include "core/templates/hash_map.h"
+#include "core/templates/local_vector.h"
 #include "core/templates/self_list.h"
 #include "scene/resources/mesh.h"
 #include "scene/resources/world_2d.h"
@@ -48,6 +51,7 @@ class Material;
 class Mesh;
 class SceneDebugger;
 class Tween;
+class TransformHierarchy3D;
 
 class SceneTreeTimer : public RefCounted {
 	GDCLASS(SceneTreeTimer, RefCounted);
@@ -82,12 +86,36 @@ class SceneTree : public MainLoop {
 public:
 	typedef void (*IdleCallback)();
 
-private:
 	struct Group {
-		Vector<Node *> nodes;
+		LocalVector<Node *> nodes;
+		// Loops going through the nodes. While iterating, removed nodes are
+		// replaced by null tombstones and added nodes are appended unsorted.
+		uint32_t iterating = 0;
+		bool has_tombstones = false;
 		bool changed = false;
+		bool sorted_by_priority = false;
+
+		// Inserts the node at its place if the group is sorted. Returns false if it's already in the group.
+		bool add(Node *p_node);
+		// Returns false if the node isn't in the group.
+		bool remove(Node *p_node);
+		void update_order(bool p_use_priority = false);
+		void begin_iteration() { iterating++; }
+		// Compacts the tombstones once the last loop is done.
+		void end_iteration();
+
+	private:
+		template <class C>
+		uint32_t _find_insert_position(Node *p_node) const;
+	};
+
+	// Nodes of a group being notified, by sub thread process group.
+	struct ProcessThreadGroup {
+		Node *owner = nullptr;
+		LocalVector<Node *> nodes;
 	};
 
+private:
 	Window *root = nullptr;
 
 	uint64_t tree_version = 1;
@@ -103,7 +131,7 @@ private:
 	bool paused = false;
 	int root_lock = 0;
 
-	Map<StringName, Group> group_map;
+	HashMap<StringName, Group> group_map;
 	bool _quit = false;
 	bool initialized = false;
 
@@ -125,9 +153,10 @@ private:
 		bool operator<(const UGCall &p_with) const { return group == p_with.group ? call < p_with.call : group < p_with.group; }
 	};
 
-	// Safety for when a node is deleted while a group is being called.
-	int call_lock = 0;
-	Set<Node *> call_skip; // Skip erased nodes.
+	int process_thread_group_count = 0; // Nodes in the tree with PROCESS_THREAD_GROUP_SUB_THREAD.
+	LocalVector<ProcessThreadGroup> process_thread_groups;
+	HashMap<ObjectID, uint32_t> process_thread_group_indices;
+	void _process_thread_group(uint32_t p_index, int p_notification);
 
 	List<ObjectID> delete_queue;
 
@@ -135,7 +164,7 @@ private:
 	bool ugc_locked = false;
 	void _flush_ugc();
 
-	_FORCE_INLINE_ void _update_group_order(Group &g, bool p_use_priority = false);
+	void _end_group_iteration(const StringName &p_group, Group &g);
 	void _update_listener();
 
 	Array _get_nodes_in_group(const StringName &p_group);
@@ -187,6 +216,15 @@ private:
 	friend class Viewport;
 
 	SelfList<Node>::List xform_change_list;
+	SpinLock xform_change_lock; // Nodes of sub thread process groups can be moved concurrently.
+
+	_FORCE_INLINE_ void _add_xform_change(SelfList<Node> *p_xform_change) {
+		xform_change_lock.lock();
+		xform_change_list.add(p_xform_change);
+		xform_change_lock.unlock();
+	}
+
+	TransformHierarchy3D *transform_hierarchy_3d = nullptr;
 
 #ifdef DEBUG_ENABLED // No live editor in release build.
 	friend class LiveEditor;
@@ -224,6 +262,7 @@ public:
 	};
 
 	_FORCE_INLINE_ Window *get_root() const { return root; }
+	_FORCE_INLINE_ TransformHierarchy3D *get_transform_hierarchy_3d() const { return transform_hierarchy_3d; }
 
 	void call_group_flags(uint32_t p_call_flags, const StringName &p_group, const StringName &p_function, VARIANT_ARG_LIST);
 	void notify_group_flags(uint32_t p_call_flags, const StringName &p_group, int p_notification);
@@ -235,6 +274,10 @@ public:
 
 	void flush_transform_notifications();
 
+	// Splits the nodes processed on sub threads by group, keeping their order. Null nodes are skipped.
+	// Returns the number of groups filled in r_groups, which is only grown so it can be reused.
+	static uint32_t partition_process_thread_groups(Node *const *p_nodes, uint32_t p_node_count, LocalVector<ProcessThreadGroup> &r_groups, HashMap<ObjectID, uint32_t> &r_indices);
+
 	virtual void initialize() override;
 
 	virtual bool physics_process(double p_time) override;
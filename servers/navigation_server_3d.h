@@ -87,6 +87,12 @@ public:
 	/// Returns the edge connection margin of this map.
 	virtual real_t map_get_edge_connection_margin(RID p_map) const = 0;
 
+	/// Set the size of the clusters of the hierarchical path search, 0 to disable it.
+	virtual void map_set_cluster_size(RID p_map, real_t p_cluster_size) const = 0;
+
+	/// Returns the size of the clusters of the hierarchical path search.
+	virtual real_t map_get_cluster_size(RID p_map) const = 0;
+
 	/// Returns the navigation path to reach the destination from the origin.
 	virtual Vector<Vector3> map_get_path(RID p_map, Vector3 p_origin, Vector3 p_destination, bool p_optimize, uint32_t p_navigable_layers = 1) const = 0;
 
@@ -95,6 +101,19 @@ public:
 	virtual Vector3 map_get_closest_point_normal(RID p_map, const Vector3 &p_point) const = 0;
 	virtual RID map_get_closest_point_owner(RID p_map, const Vector3 &p_point) const = 0;
 
+	/// Queues the computation of a navigation path on a worker thread, against the map as
+	/// it was last synced. Returns the query ID, to poll with `path_query_is_done()`.
+	/// Query IDs start at 1, 0 is returned when the map is invalid.
+	/// When `p_callback` is valid, it's called with the query ID and the path during the
+	/// server process once the path is ready, and the query is released.
+	virtual int64_t map_get_path_async(RID p_map, Vector3 p_origin, Vector3 p_destination, bool p_optimize, uint32_t p_navigable_layers = 1, const Callable &p_callback = Callable()) const = 0;
+
+	/// Returns true when the path of the query is ready.
+	virtual bool path_query_is_done(int64_t p_query) const = 0;
+
+	/// Returns the path of the query, waiting for it if needed, and releases the query.
+	virtual Vector<Vector3> path_query_get_result(int64_t p_query) const = 0;
+
 	/// Creates a new region.
 	virtual RID region_create() const = 0;
 
@@ -32,6 +32,7 @@
 #define AREA_2D_SW_H
 
 #include "collision_object_2d_sw.h"
+#include "core/templates/flat_set.h"
 #include "core/templates/self_list.h"
 #include "servers/physics_server_2d.h"
 //#include "servers/physics_3d/query_sw.h"
@@ -96,7 +97,7 @@ class Area2DSW : public CollisionObject2DSW {
 
 	//virtual void shape_changed_notify(Shape2DSW *p_shape);
 	//virtual void shape_deleted_notify(Shape2DSW *p_shape);
-	Set<Constraint2DSW *> constraints;
+	FlatSet<Constraint2DSW *> constraints;
 
 	virtual void _shapes_changed();
 	void _queue_monitor_update();
@@ -149,7 +150,7 @@ public:
 
 	_FORCE_INLINE_ void add_constraint(Constraint2DSW *p_constraint) { constraints.insert(p_constraint); }
 	_FORCE_INLINE_ void remove_constraint(Constraint2DSW *p_constraint) { constraints.erase(p_constraint); }
-	_FORCE_INLINE_ const Set<Constraint2DSW *> &get_constraints() const { return constraints; }
+	_FORCE_INLINE_ const FlatSet<Constraint2DSW *> &get_constraints() const { return constraints; }
 	_FORCE_INLINE_ void clear_constraints() { constraints.clear(); }
 
 	void set_monitorable(bool p_monitorable);
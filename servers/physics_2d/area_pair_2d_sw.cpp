@@ -102,7 +102,7 @@ AreaPair2DSW::~AreaPair2DSW() {
 			area->remove_body_from_query(body, body_shape, area_shape);
 		}
 	}
-	body->remove_constraint(this, 0);
+	body->remove_constraint(this);
 	area->remove_constraint(this);
 }
 
@@ -48,6 +48,9 @@ public:
 	virtual bool pre_solve(real_t p_step) override;
 	virtual void solve(real_t p_step) override;
 
+	// Processing a collision change updates the area and body monitoring data.
+	virtual bool is_pre_solve_thread_safe() const override { return !process_collision; }
+
 	AreaPair2DSW(Body2DSW *p_body, int p_body_shape, Area2DSW *p_area, int p_area_shape);
 	~AreaPair2DSW();
 };
@@ -65,6 +68,9 @@ public:
 	virtual bool pre_solve(real_t p_step) override;
 	virtual void solve(real_t p_step) override;
 
+	// Processing a collision change updates the area and body monitoring data.
+	virtual bool is_pre_solve_thread_safe() const override { return !process_collision; }
+
 	Area2Pair2DSW(Area2DSW *p_area_a, int p_shape_a, Area2DSW *p_area_b, int p_shape_b);
 	~Area2Pair2DSW();
 };
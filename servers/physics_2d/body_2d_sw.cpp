@@ -489,7 +489,8 @@ void Body2DSW::integrate_forces(real_t p_step) {
 	biased_linear_velocity = Vector2();
 
 	if (do_motion) { //shapes temporarily extend for raycast
-		_update_shapes_with_motion(motion);
+		_update_shapes_with_motion(motion, false);
+		deferred_broadphase_update = true;
 	}
 
 	// damp_area=nullptr; // clear the area, so it is set in the next frame
@@ -503,14 +504,14 @@ void Body2DSW::integrate_velocities(real_t p_step) {
 	}
 
 	if (fi_callback) {
-		get_space()->body_add_to_state_query_list(&direct_state_query_list);
+		deferred_state_query = true;
 	}
 
 	if (mode == PhysicsServer2D::BODY_MODE_KINEMATIC) {
 		_set_transform(new_transform, false);
 		_set_inv_transform(new_transform.affine_inverse());
 		if (contacts.size() == 0 && linear_velocity == Vector2() && angular_velocity == 0) {
-			set_active(false); //stopped moving, deactivate
+			deferred_sleep = true; //stopped moving, deactivate
 		}
 		return;
 	}
@@ -521,24 +522,44 @@ void Body2DSW::integrate_velocities(real_t p_step) {
 	real_t angle = get_transform().get_rotation() + total_angular_velocity * p_step;
 	Vector2 pos = get_transform().get_origin() + total_linear_velocity * p_step;
 
-	_set_transform(Transform2D(angle, pos), continuous_cd_mode == PhysicsServer2D::CCD_MODE_DISABLED);
+	_set_transform(Transform2D(angle, pos), false);
 	_set_inv_transform(get_transform().inverse());
 
 	if (continuous_cd_mode != PhysicsServer2D::CCD_MODE_DISABLED) {
 		new_transform = get_transform();
+	} else {
+		_update_shapes(false);
+		deferred_broadphase_update = true;
 	}
 
 	//_update_inertia_tensor();
 }
 
+void Body2DSW::apply_deferred_updates() {
+	if (deferred_broadphase_update) {
+		deferred_broadphase_update = false;
+		_update_broadphase();
+	}
+
+	if (deferred_state_query) {
+		deferred_state_query = false;
+		get_space()->body_add_to_state_query_list(&direct_state_query_list);
+	}
+
+	if (deferred_sleep) {
+		deferred_sleep = false;
+		set_active(false);
+	}
+}
+
 void Body2DSW::wakeup_neighbours() {
-	for (const Pair<Constraint2DSW *, int> &E : constraint_list) {
-		const Constraint2DSW *c = E.first;
+	for (const FlatMap<Constraint2DSW *, int>::Pair &E : constraint_map) {
+		const Constraint2DSW *c = E.key;
 		Body2DSW **n = c->get_body_ptr();
 		int bc = c->get_body_count();
 
 		for (int i = 0; i < bc; i++) {
-			if (i == E.second) {
+			if (i == E.value) {
 				continue;
 			}
 			Body2DSW *b = n[i];
@@ -33,8 +33,7 @@
 
 #include "area_2d_sw.h"
 #include "collision_object_2d_sw.h"
-#include "core/templates/list.h"
-#include "core/templates/pair.h"
+#include "core/templates/flat_map.h"
 #include "core/templates/vset.h"
 
 class Constraint2DSW;
@@ -81,11 +80,20 @@ class Body2DSW : public CollisionObject2DSW {
 	bool can_sleep;
 	bool first_time_kinematic;
 	bool first_integration;
+
+	// Changes to data shared with the space, recorded while the step processes
+	// bodies in parallel and applied by apply_deferred_updates().
+	bool deferred_broadphase_update = false;
+	bool deferred_state_query = false;
+	bool deferred_sleep = false;
+
+	int contact_solver_index = -1;
+
 	void _update_inertia();
 	virtual void _shapes_changed();
 	Transform2D new_transform;
 
-	List<Pair<Constraint2DSW *, int>> constraint_list;
+	FlatMap<Constraint2DSW *, int> constraint_map;
 
 	struct AreaCMP {
 		Area2DSW *area;
@@ -172,10 +180,10 @@ public:
 	_FORCE_INLINE_ uint64_t get_island_step() const { return island_step; }
 	_FORCE_INLINE_ void set_island_step(uint64_t p_step) { island_step = p_step; }
 
-	_FORCE_INLINE_ void add_constraint(Constraint2DSW *p_constraint, int p_pos) { constraint_list.push_back({ p_constraint, p_pos }); }
-	_FORCE_INLINE_ void remove_constraint(Constraint2DSW *p_constraint, int p_pos) { constraint_list.erase({ p_constraint, p_pos }); }
-	const List<Pair<Constraint2DSW *, int>> &get_constraint_list() const { return constraint_list; }
-	_FORCE_INLINE_ void clear_constraint_list() { constraint_list.clear(); }
+	_FORCE_INLINE_ void add_constraint(Constraint2DSW *p_constraint, int p_pos) { constraint_map[p_constraint] = p_pos; }
+	_FORCE_INLINE_ void remove_constraint(Constraint2DSW *p_constraint) { constraint_map.erase(p_constraint); }
+	const FlatMap<Constraint2DSW *, int> &get_constraint_map() const { return constraint_map; }
+	_FORCE_INLINE_ void clear_constraint_map() { constraint_map.clear(); }
 
 	_FORCE_INLINE_ void set_omit_force_integration(bool p_omit_force_integration) { omit_force_integration = p_omit_force_integration; }
 	_FORCE_INLINE_ bool get_omit_force_integration() const { return omit_force_integration; }
@@ -192,6 +200,10 @@ public:
 	_FORCE_INLINE_ void set_biased_angular_velocity(real_t p_velocity) { biased_angular_velocity = p_velocity; }
 	_FORCE_INLINE_ real_t get_biased_angular_velocity() const { return biased_angular_velocity; }
 
+	// Slot of the body in the contact solver of its island, while being solved.
+	_FORCE_INLINE_ void set_contact_solver_index(int p_index) { contact_solver_index = p_index; }
+	_FORCE_INLINE_ int get_contact_solver_index() const { return contact_solver_index; }
+
 	_FORCE_INLINE_ void apply_central_impulse(const Vector2 &p_impulse) {
 		linear_velocity += p_impulse * _inv_mass;
 	}
@@ -213,6 +225,8 @@ public:
 	void set_active(bool p_active);
 	_FORCE_INLINE_ bool is_active() const { return active; }
 
+	void apply_deferred_updates();
+
 	_FORCE_INLINE_ void wakeup() {
 		if ((!get_space()) || mode == PhysicsServer2D::BODY_MODE_STATIC || mode == PhysicsServer2D::BODY_MODE_KINEMATIC) {
 			return;
@@ -30,6 +30,7 @@
 
 #include "body_pair_2d_sw.h"
 #include "collision_solver_2d_sw.h"
+#include "contact_solver_2d_sw.h"
 #include "space_2d_sw.h"
 
 #define POSITION_CORRECTION
@@ -528,6 +529,37 @@ void BodyPair2DSW::solve(real_t p_step) {
 	}
 }
 
+int BodyPair2DSW::get_batched_contact_count() const {
+	if (!collided || oneway_disabled) {
+		return 0;
+	}
+
+	int count = 0;
+	for (int i = 0; i < contact_count; ++i) {
+		if (contacts[i].active) {
+			++count;
+		}
+	}
+	return count;
+}
+
+bool BodyPair2DSW::add_batched_contacts(ContactSolver2DSW *p_solver) {
+	if (!collided || oneway_disabled) {
+		return true;
+	}
+
+	real_t friction = combine_friction(A, B);
+
+	for (int i = 0; i < contact_count; ++i) {
+		Contact &c = contacts[i];
+		if (c.active) {
+			p_solver->add_contact(A, B, collide_A, collide_B, friction, &c);
+		}
+	}
+
+	return true;
+}
+
 BodyPair2DSW::BodyPair2DSW(Body2DSW *p_A, int p_shape_A, Body2DSW *p_B, int p_shape_B) :
 		Constraint2DSW(_arr, 2) {
 	A = p_A;
@@ -540,6 +572,6 @@ BodyPair2DSW::BodyPair2DSW(Body2DSW *p_A, int p_shape_A, Body2DSW *p_B, int p_sh
 }
 
 BodyPair2DSW::~BodyPair2DSW() {
-	A->remove_constraint(this, 0);
-	B->remove_constraint(this, 1);
+	A->remove_constraint(this);
+	B->remove_constraint(this);
 }
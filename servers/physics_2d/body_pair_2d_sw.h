@@ -35,6 +35,8 @@
 #include "constraint_2d_sw.h"
 
 class BodyPair2DSW : public Constraint2DSW {
+	friend class ContactSolver2DSW;
+
 	enum {
 		MAX_CONTACTS = 2
 	};
@@ -91,6 +93,14 @@ public:
 	virtual bool pre_solve(real_t p_step) override;
 	virtual void solve(real_t p_step) override;
 
+	// Static bodies can be shared between islands, reporting their contacts must be serialized.
+	virtual bool is_pre_solve_thread_safe() const override {
+		return !(A->get_mode() == PhysicsServer2D::BODY_MODE_STATIC && A->can_report_contacts()) && !(B->get_mode() == PhysicsServer2D::BODY_MODE_STATIC && B->can_report_contacts());
+	}
+
+	virtual int get_batched_contact_count() const override;
+	virtual bool add_batched_contacts(ContactSolver2DSW *p_solver) override;
+
 	BodyPair2DSW(Body2DSW *p_A, int p_shape_A, Body2DSW *p_B, int p_shape_B);
 	~BodyPair2DSW();
 };
@@ -162,7 +162,17 @@ void CollisionObject2DSW::_unregister_shapes() {
 	}
 }
 
-void CollisionObject2DSW::_update_shapes() {
+void CollisionObject2DSW::_update_shape_broadphase(int p_index) {
+	Shape &s = shapes.write[p_index];
+	if (s.bpid == 0) {
+		s.bpid = space->get_broadphase()->create(this, p_index, s.aabb_cache, _static);
+		space->get_broadphase()->set_static(s.bpid, _static);
+	}
+
+	space->get_broadphase()->move(s.bpid, s.aabb_cache);
+}
+
+void CollisionObject2DSW::_update_shapes(bool p_update_broadphase) {
 	if (!space) {
 		return;
 	}
@@ -180,16 +190,13 @@ void CollisionObject2DSW::_update_shapes() {
 		shape_aabb.grow_by((s.aabb_cache.size.x + s.aabb_cache.size.y) * 0.5 * 0.05);
 		s.aabb_cache = shape_aabb;
 
-		if (s.bpid == 0) {
-			s.bpid = space->get_broadphase()->create(this, i, shape_aabb, _static);
-			space->get_broadphase()->set_static(s.bpid, _static);
+		if (p_update_broadphase) {
+			_update_shape_broadphase(i);
 		}
-
-		space->get_broadphase()->move(s.bpid, shape_aabb);
 	}
 }
 
-void CollisionObject2DSW::_update_shapes_with_motion(const Vector2 &p_motion) {
+void CollisionObject2DSW::_update_shapes_with_motion(const Vector2 &p_motion, bool p_update_broadphase) {
 	if (!space) {
 		return;
 	}
@@ -207,12 +214,22 @@ void CollisionObject2DSW::_update_shapes_with_motion(const Vector2 &p_motion) {
 		shape_aabb = shape_aabb.merge(Rect2(shape_aabb.position + p_motion, shape_aabb.size)); //use motion
 		s.aabb_cache = shape_aabb;
 
-		if (s.bpid == 0) {
-			s.bpid = space->get_broadphase()->create(this, i, shape_aabb, _static);
-			space->get_broadphase()->set_static(s.bpid, _static);
+		if (p_update_broadphase) {
+			_update_shape_broadphase(i);
 		}
+	}
+}
+
+void CollisionObject2DSW::_update_broadphase() {
+	if (!space) {
+		return;
+	}
 
-		space->get_broadphase()->move(s.bpid, shape_aabb);
+	for (int i = 0; i < shapes.size(); i++) {
+		if (shapes[i].disabled) {
+			continue;
+		}
+		_update_shape_broadphase(i);
 	}
 }
 
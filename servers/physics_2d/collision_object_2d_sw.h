@@ -79,10 +79,14 @@ private:
 
 	SelfList<CollisionObject2DSW> pending_shape_update_list;
 
-	void _update_shapes();
+	void _update_shape_broadphase(int p_index);
 
 protected:
-	void _update_shapes_with_motion(const Vector2 &p_motion);
+	// Without p_update_broadphase, only the shape AABB caches are updated, which is
+	// safe to do from multiple threads. _update_broadphase() must be called later.
+	void _update_shapes(bool p_update_broadphase = true);
+	void _update_shapes_with_motion(const Vector2 &p_motion, bool p_update_broadphase = true);
+	void _update_broadphase();
 	void _unregister_shapes();
 
 	_FORCE_INLINE_ void _set_transform(const Transform2D &p_transform, bool p_update_shapes = true) {
@@ -33,9 +33,16 @@
 
 #include "body_2d_sw.h"
 
+#include "core/templates/safe_refcount.h"
+
+class ContactSolver2DSW;
+
 class Constraint2DSW {
+	static SafeNumeric<uint64_t> last_id;
+
 	Body2DSW **_body_ptr;
 	int _body_count;
+	uint64_t id;
 	uint64_t island_step;
 	bool disabled_collisions_between_bodies;
 
@@ -45,6 +52,7 @@ protected:
 	Constraint2DSW(Body2DSW **p_body_ptr = nullptr, int p_body_count = 0) {
 		_body_ptr = p_body_ptr;
 		_body_count = p_body_count;
+		id = last_id.increment();
 		island_step = 0;
 		disabled_collisions_between_bodies = true;
 	}
@@ -53,6 +61,10 @@ public:
 	_FORCE_INLINE_ void set_self(const RID &p_self) { self = p_self; }
 	_FORCE_INLINE_ RID get_self() const { return self; }
 
+	// Increases with the creation order. Islands are sorted by it, so the
+	// solving order doesn't depend on where the constraints were allocated.
+	_FORCE_INLINE_ uint64_t get_id() const { return id; }
+
 	_FORCE_INLINE_ uint64_t get_island_step() const { return island_step; }
 	_FORCE_INLINE_ void set_island_step(uint64_t p_step) { island_step = p_step; }
 
@@ -66,6 +78,15 @@ public:
 	virtual bool pre_solve(real_t p_step) = 0;
 	virtual void solve(real_t p_step) = 0;
 
+	// Islands are pre-solved in parallel, constraints which modify objects shared
+	// between islands during pre_solve() are deferred and pre-solved serially.
+	virtual bool is_pre_solve_thread_safe() const { return true; }
+
+	// Constraints made of contacts can have them solved in batches by ContactSolver2DSW,
+	// in which case solve() isn't called. Only used after pre_solve() returned true.
+	virtual int get_batched_contact_count() const { return 0; }
+	virtual bool add_batched_contacts(ContactSolver2DSW *p_solver) { return false; }
+
 	virtual ~Constraint2DSW() {}
 };
 
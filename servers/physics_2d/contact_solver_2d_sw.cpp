@@ -0,0 +1,412 @@
+/*************************************************************************/
+/*  contact_solver_2d_sw.cpp                                             */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "contact_solver_2d_sw.h"
+
+uint32_t ContactSolver2DSW::_get_slot(Body2DSW *p_body) {
+	if (p_body->get_mode() == PhysicsServer2D::BODY_MODE_STATIC) {
+		// Static bodies can be shared with other islands, so they are never written to
+		// and get a read-only slot (reused for consecutive contacts of the same body).
+		if (p_body != last_static_body) {
+			last_static_body = p_body;
+			last_static_slot = slots.size();
+			BodySlot slot;
+			slot.body = p_body;
+			slots.push_back(slot);
+		}
+		return last_static_slot;
+	}
+
+	int index = p_body->get_contact_solver_index();
+	if (index < 0) {
+		index = slots.size();
+		p_body->set_contact_solver_index(index);
+		BodySlot slot;
+		slot.body = p_body;
+		slot.write_back = true;
+		slots.push_back(slot);
+	}
+	return index;
+}
+
+void ContactSolver2DSW::reserve(uint32_t p_contact_count) {
+	// At worst, every contact gets its own block and two slots.
+	blocks.reserve(p_contact_count);
+	slots.reserve(p_contact_count * 2 + 1);
+}
+
+void ContactSolver2DSW::clear() {
+	blocks.clear();
+	slots.clear();
+	contact_count = 0;
+	last_static_body = nullptr;
+
+	// Slot used by the lanes of incomplete blocks.
+	slots.push_back(BodySlot());
+}
+
+void ContactSolver2DSW::add_contact(Body2DSW *p_A, Body2DSW *p_B, bool p_collide_A, bool p_collide_B, real_t p_friction, BodyPair2DSW::Contact *p_contact) {
+	uint32_t slot_A = _get_slot(p_A);
+	uint32_t slot_B = _get_slot(p_B);
+
+	// Find a recent block where no other lane writes to the same bodies.
+	Block *block = nullptr;
+	uint32_t block_count = blocks.size();
+	uint32_t search_begin = block_count > BLOCK_SEARCH_DEPTH ? block_count - BLOCK_SEARCH_DEPTH : 0;
+	for (uint32_t block_index = search_begin; block_index < block_count; ++block_index) {
+		Block &candidate = blocks[block_index];
+		if (candidate.lane_count == LANES) {
+			continue;
+		}
+
+		bool conflict = false;
+		for (uint32_t lane = 0; lane < candidate.lane_count; ++lane) {
+			if ((candidate.writes_A[lane] && (candidate.slot_A[lane] == slot_A || candidate.slot_A[lane] == slot_B)) ||
+					(candidate.writes_B[lane] && (candidate.slot_B[lane] == slot_A || candidate.slot_B[lane] == slot_B)) ||
+					(p_collide_A && (candidate.slot_A[lane] == slot_A || candidate.slot_B[lane] == slot_A)) ||
+					(p_collide_B && (candidate.slot_A[lane] == slot_B || candidate.slot_B[lane] == slot_B))) {
+				conflict = true;
+				break;
+			}
+		}
+
+		if (!conflict) {
+			block = &candidate;
+			break;
+		}
+	}
+
+	if (!block) {
+		blocks.push_back(Block());
+		block = &blocks[block_count];
+		for (uint32_t lane = 0; lane < LANES; ++lane) {
+			// Unused lanes are inactive and only use the empty slot.
+			block->slot_A[lane] = 0;
+			block->slot_B[lane] = 0;
+			block->writes_A[lane] = false;
+			block->writes_B[lane] = false;
+			block->contact[lane] = nullptr;
+			block->active[lane] = false;
+			for (int axis = 0; axis < 2; ++axis) {
+				block->normal[axis][lane] = 0.0;
+				block->rA[axis][lane] = 0.0;
+				block->rB[axis][lane] = 0.0;
+			}
+			block->mass_normal[lane] = 0.0;
+			block->mass_tangent[lane] = 0.0;
+			block->bias[lane] = 0.0;
+			block->bounce[lane] = 0.0;
+			block->friction[lane] = 0.0;
+			block->acc_normal_impulse[lane] = 0.0;
+			block->acc_tangent_impulse[lane] = 0.0;
+			block->acc_bias_impulse[lane] = 0.0;
+		}
+	}
+
+	uint32_t lane = block->lane_count++;
+	block->slot_A[lane] = slot_A;
+	block->slot_B[lane] = slot_B;
+	block->writes_A[lane] = p_collide_A;
+	block->writes_B[lane] = p_collide_B;
+	block->contact[lane] = p_contact;
+	block->active[lane] = p_contact->active;
+	for (int axis = 0; axis < 2; ++axis) {
+		block->normal[axis][lane] = p_contact->normal[axis];
+		block->rA[axis][lane] = p_contact->rA[axis];
+		block->rB[axis][lane] = p_contact->rB[axis];
+	}
+	block->mass_normal[lane] = p_contact->mass_normal;
+	block->mass_tangent[lane] = p_contact->mass_tangent;
+	block->bias[lane] = p_contact->bias;
+	block->bounce[lane] = p_contact->bounce;
+	block->friction[lane] = p_friction;
+	block->acc_normal_impulse[lane] = p_contact->acc_normal_impulse;
+	block->acc_tangent_impulse[lane] = p_contact->acc_tangent_impulse;
+	block->acc_bias_impulse[lane] = p_contact->acc_bias_impulse;
+
+	++contact_count;
+}
+
+void ContactSolver2DSW::load_velocities() {
+	for (uint32_t slot_index = 1; slot_index < slots.size(); ++slot_index) {
+		BodySlot &slot = slots[slot_index];
+		slot.inv_mass = slot.body->get_inv_mass();
+		slot.inv_inertia = slot.body->get_inv_inertia();
+		slot.linear_velocity = slot.body->get_linear_velocity();
+		slot.angular_velocity = slot.body->get_angular_velocity();
+		slot.biased_linear_velocity = slot.body->get_biased_linear_velocity();
+		slot.biased_angular_velocity = slot.body->get_biased_angular_velocity();
+	}
+}
+
+void ContactSolver2DSW::store_velocities() {
+	for (uint32_t slot_index = 1; slot_index < slots.size(); ++slot_index) {
+		const BodySlot &slot = slots[slot_index];
+		if (slot.write_back) {
+			slot.body->set_linear_velocity(slot.linear_velocity);
+			slot.body->set_angular_velocity(slot.angular_velocity);
+			slot.body->set_biased_linear_velocity(slot.biased_linear_velocity);
+			slot.body->set_biased_angular_velocity(slot.biased_angular_velocity);
+		}
+	}
+}
+
+// Values for all the lanes of a block. Every operation is a loop over the
+// lanes without branches, so it can be compiled to SIMD instructions.
+
+struct LaneMask2D {
+	bool v[ContactSolver2DSW::LANES];
+
+	_FORCE_INLINE_ static LaneMask2D load(const bool *p_values) {
+		LaneMask2D r;
+		for (uint32_t i = 0; i < ContactSolver2DSW::LANES; ++i) {
+			r.v[i] = p_values[i];
+		}
+		return r;
+	}
+};
+
+struct LaneReal2D {
+	real_t v[ContactSolver2DSW::LANES];
+
+#define LANE_REAL_OPERATOR(m_op)                                               \
+	_FORCE_INLINE_ LaneReal2D operator m_op(const LaneReal2D &p_other) const { \
+		LaneReal2D r;                                                          \
+		for (uint32_t i = 0; i < ContactSolver2DSW::LANES; ++i) {              \
+			r.v[i] = v[i] m_op p_other.v[i];                                   \
+		}                                                                      \
+		return r;                                                              \
+	}
+
+	LANE_REAL_OPERATOR(+)
+	LANE_REAL_OPERATOR(-)
+	LANE_REAL_OPERATOR(*)
+
+#undef LANE_REAL_OPERATOR
+
+	_FORCE_INLINE_ LaneReal2D operator-() const {
+		LaneReal2D r;
+		for (uint32_t i = 0; i < ContactSolver2DSW::LANES; ++i) {
+			r.v[i] = -v[i];
+		}
+		return r;
+	}
+
+	_FORCE_INLINE_ static LaneReal2D load(const real_t *p_values) {
+		LaneReal2D r;
+		for (uint32_t i = 0; i < ContactSolver2DSW::LANES; ++i) {
+			r.v[i] = p_values[i];
+		}
+		return r;
+	}
+	_FORCE_INLINE_ void store(real_t *r_values) const {
+		for (uint32_t i = 0; i < ContactSolver2DSW::LANES; ++i) {
+			r_values[i] = v[i];
+		}
+	}
+};
+
+// Keeps the previous value in inactive lanes.
+_FORCE_INLINE_ static LaneReal2D lane_select(const LaneMask2D &p_mask, const LaneReal2D &p_a, const LaneReal2D &p_b) {
+	LaneReal2D r;
+	for (uint32_t i = 0; i < ContactSolver2DSW::LANES; ++i) {
+		r.v[i] = p_mask.v[i] ? p_a.v[i] : p_b.v[i];
+	}
+	return r;
+}
+
+_FORCE_INLINE_ static LaneReal2D lane_max_zero(const LaneReal2D &p_a) {
+	LaneReal2D r;
+	for (uint32_t i = 0; i < ContactSolver2DSW::LANES; ++i) {
+		r.v[i] = p_a.v[i] < 0.0f ? 0.0f : p_a.v[i];
+	}
+	return r;
+}
+
+_FORCE_INLINE_ static LaneReal2D lane_clamp(const LaneReal2D &p_a, const LaneReal2D &p_max) {
+	LaneReal2D r;
+	for (uint32_t i = 0; i < ContactSolver2DSW::LANES; ++i) {
+		r.v[i] = p_a.v[i] < -p_max.v[i] ? -p_max.v[i] : (p_a.v[i] > p_max.v[i] ? p_max.v[i] : p_a.v[i]);
+	}
+	return r;
+}
+
+struct LaneVector2 {
+	LaneReal2D x, y;
+
+	_FORCE_INLINE_ LaneVector2 operator+(const LaneVector2 &p_other) const { return { x + p_other.x, y + p_other.y }; }
+	_FORCE_INLINE_ LaneVector2 operator-(const LaneVector2 &p_other) const { return { x - p_other.x, y - p_other.y }; }
+	_FORCE_INLINE_ LaneVector2 operator-() const { return { -x, -y }; }
+	_FORCE_INLINE_ LaneVector2 operator*(const LaneReal2D &p_scalar) const { return { x * p_scalar, y * p_scalar }; }
+
+	_FORCE_INLINE_ LaneReal2D dot(const LaneVector2 &p_other) const { return x * p_other.x + y * p_other.y; }
+	_FORCE_INLINE_ LaneReal2D cross(const LaneVector2 &p_other) const { return x * p_other.y - y * p_other.x; }
+	_FORCE_INLINE_ LaneVector2 orthogonal() const { return { y, -x }; }
+
+	_FORCE_INLINE_ static LaneVector2 load(const real_t (*p_values)[ContactSolver2DSW::LANES]) {
+		return { LaneReal2D::load(p_values[0]), LaneReal2D::load(p_values[1]) };
+	}
+};
+
+// Velocity of the point at p_r, relative to the center of mass.
+_FORCE_INLINE_ static LaneVector2 lane_point_velocity(const LaneVector2 &p_linear_velocity, const LaneReal2D &p_angular_velocity, const LaneVector2 &p_r) {
+	return { p_linear_velocity.x - p_angular_velocity * p_r.y, p_linear_velocity.y + p_angular_velocity * p_r.x };
+}
+
+// Body data gathered from the slots of a block.
+struct ContactSolver2DSW::LaneBodies {
+	LaneReal2D inv_mass;
+	LaneReal2D inv_inertia;
+	LaneVector2 linear_velocity;
+	LaneReal2D angular_velocity;
+	LaneVector2 biased_linear_velocity;
+	LaneReal2D biased_angular_velocity;
+};
+
+void ContactSolver2DSW::_gather(const uint32_t *p_slots, const bool *p_writes, LaneBodies &r_bodies) const {
+	for (uint32_t lane = 0; lane < LANES; ++lane) {
+		const BodySlot &slot = slots[p_slots[lane]];
+
+		// Bodies which don't respond to the contact behave as if they had infinite mass.
+		const bool writes = p_writes[lane];
+		r_bodies.inv_mass.v[lane] = writes ? slot.inv_mass : 0.0f;
+		r_bodies.inv_inertia.v[lane] = writes ? slot.inv_inertia : 0.0f;
+
+		r_bodies.linear_velocity.x.v[lane] = slot.linear_velocity.x;
+		r_bodies.linear_velocity.y.v[lane] = slot.linear_velocity.y;
+		r_bodies.angular_velocity.v[lane] = slot.angular_velocity;
+		r_bodies.biased_linear_velocity.x.v[lane] = slot.biased_linear_velocity.x;
+		r_bodies.biased_linear_velocity.y.v[lane] = slot.biased_linear_velocity.y;
+		r_bodies.biased_angular_velocity.v[lane] = slot.biased_angular_velocity;
+	}
+}
+
+void ContactSolver2DSW::_scatter(uint32_t p_lane_count, const uint32_t *p_slots, const bool *p_writes, const LaneBodies &p_bodies) {
+	for (uint32_t lane = 0; lane < p_lane_count; ++lane) {
+		if (!p_writes[lane]) {
+			continue;
+		}
+
+		BodySlot &slot = slots[p_slots[lane]];
+		slot.linear_velocity = Vector2(p_bodies.linear_velocity.x.v[lane], p_bodies.linear_velocity.y.v[lane]);
+		slot.angular_velocity = p_bodies.angular_velocity.v[lane];
+		slot.biased_linear_velocity = Vector2(p_bodies.biased_linear_velocity.x.v[lane], p_bodies.biased_linear_velocity.y.v[lane]);
+		slot.biased_angular_velocity = p_bodies.biased_angular_velocity.v[lane];
+	}
+}
+
+void ContactSolver2DSW::_solve_block(Block &p_block) {
+	LaneBodies A;
+	LaneBodies B;
+	_gather(p_block.slot_A, p_block.writes_A, A);
+	_gather(p_block.slot_B, p_block.writes_B, B);
+
+	// Same math as BodyPair2DSW::solve(), inactive lanes keep their accumulated impulses.
+
+	const LaneMask2D active = LaneMask2D::load(p_block.active);
+	const LaneVector2 normal = LaneVector2::load(p_block.normal);
+	const LaneVector2 tangent = normal.orthogonal();
+	const LaneVector2 rA = LaneVector2::load(p_block.rA);
+	const LaneVector2 rB = LaneVector2::load(p_block.rB);
+	const LaneReal2D mass_normal = LaneReal2D::load(p_block.mass_normal);
+
+	// Relative velocity at contact.
+
+	LaneVector2 dv = lane_point_velocity(B.linear_velocity, B.angular_velocity, rB) - lane_point_velocity(A.linear_velocity, A.angular_velocity, rA);
+	LaneVector2 dbv = lane_point_velocity(B.biased_linear_velocity, B.biased_angular_velocity, rB) - lane_point_velocity(A.biased_linear_velocity, A.biased_angular_velocity, rA);
+
+	LaneReal2D vn = dv.dot(normal);
+	LaneReal2D vbn = dbv.dot(normal);
+	LaneReal2D vt = dv.dot(tangent);
+
+	// Bias impulse.
+
+	LaneReal2D jbn = (LaneReal2D::load(p_block.bias) - vbn) * mass_normal;
+	LaneReal2D jbnOld = LaneReal2D::load(p_block.acc_bias_impulse);
+	LaneReal2D acc_bias_impulse = lane_select(active, lane_max_zero(jbnOld + jbn), jbnOld);
+
+	LaneVector2 jb = normal * (acc_bias_impulse - jbnOld);
+
+	A.biased_linear_velocity = A.biased_linear_velocity - jb * A.inv_mass;
+	A.biased_angular_velocity = A.biased_angular_velocity + A.inv_inertia * rA.cross(-jb);
+	B.biased_linear_velocity = B.biased_linear_velocity + jb * B.inv_mass;
+	B.biased_angular_velocity = B.biased_angular_velocity + B.inv_inertia * rB.cross(jb);
+
+	// Normal and friction impulses.
+
+	LaneReal2D jn = -(LaneReal2D::load(p_block.bounce) + vn) * mass_normal;
+	LaneReal2D jnOld = LaneReal2D::load(p_block.acc_normal_impulse);
+	LaneReal2D acc_normal_impulse = lane_select(active, lane_max_zero(jnOld + jn), jnOld);
+
+	LaneReal2D jtMax = LaneReal2D::load(p_block.friction) * acc_normal_impulse;
+	LaneReal2D jt = -vt * LaneReal2D::load(p_block.mass_tangent);
+	LaneReal2D jtOld = LaneReal2D::load(p_block.acc_tangent_impulse);
+	LaneReal2D acc_tangent_impulse = lane_select(active, lane_clamp(jtOld + jt, jtMax), jtOld);
+
+	LaneVector2 j = normal * (acc_normal_impulse - jnOld) + tangent * (acc_tangent_impulse - jtOld);
+
+	A.linear_velocity = A.linear_velocity - j * A.inv_mass;
+	A.angular_velocity = A.angular_velocity + A.inv_inertia * rA.cross(-j);
+	B.linear_velocity = B.linear_velocity + j * B.inv_mass;
+	B.angular_velocity = B.angular_velocity + B.inv_inertia * rB.cross(j);
+
+	acc_bias_impulse.store(p_block.acc_bias_impulse);
+	acc_normal_impulse.store(p_block.acc_normal_impulse);
+	acc_tangent_impulse.store(p_block.acc_tangent_impulse);
+
+	_scatter(p_block.lane_count, p_block.slot_A, p_block.writes_A, A);
+	_scatter(p_block.lane_count, p_block.slot_B, p_block.writes_B, B);
+}
+
+void ContactSolver2DSW::solve() {
+	uint32_t block_count = blocks.size();
+	for (uint32_t block_index = 0; block_index < block_count; ++block_index) {
+		_solve_block(blocks[block_index]);
+	}
+}
+
+void ContactSolver2DSW::finish() {
+	uint32_t block_count = blocks.size();
+	for (uint32_t block_index = 0; block_index < block_count; ++block_index) {
+		const Block &block = blocks[block_index];
+		for (uint32_t lane = 0; lane < block.lane_count; ++lane) {
+			BodyPair2DSW::Contact *contact = block.contact[lane];
+			contact->acc_normal_impulse = block.acc_normal_impulse[lane];
+			contact->acc_tangent_impulse = block.acc_tangent_impulse[lane];
+			contact->acc_bias_impulse = block.acc_bias_impulse[lane];
+		}
+	}
+
+	for (uint32_t slot_index = 1; slot_index < slots.size(); ++slot_index) {
+		if (slots[slot_index].write_back) {
+			slots[slot_index].body->set_contact_solver_index(-1);
+		}
+	}
+}
@@ -0,0 +1,121 @@
+/*************************************************************************/
+/*  contact_solver_2d_sw.h                                               */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef CONTACT_SOLVER_2D_SW_H
+#define CONTACT_SOLVER_2D_SW_H
+
+#include "body_pair_2d_sw.h"
+
+#include "core/templates/local_vector.h"
+
+// Solves the contacts of an island in blocks of LANES contacts, stored as
+// structure of arrays so the sequential impulse math runs on all the lanes of
+// a block at once (each operation is a fixed size loop over the lanes, which
+// the compiler turns into SIMD instructions for the target).
+// Contacts are assigned to blocks so that a body is written by at most one lane
+// of a block, which makes the lanes independent from each other.
+//
+// Body velocities are copied into the solver by load_velocities() and copied
+// back by store_velocities(). Bodies are expected to belong to a single island,
+// except static bodies which are only read.
+class ContactSolver2DSW {
+public:
+	enum {
+		LANES = 4
+	};
+
+private:
+	enum {
+		BLOCK_SEARCH_DEPTH = 8 // How many of the last blocks are checked for a free lane.
+	};
+
+	struct BodySlot {
+		Body2DSW *body = nullptr;
+		bool write_back = false;
+		real_t inv_mass = 0.0;
+		real_t inv_inertia = 0.0;
+		Vector2 linear_velocity;
+		real_t angular_velocity = 0.0;
+		Vector2 biased_linear_velocity;
+		real_t biased_angular_velocity = 0.0;
+	};
+
+	struct Block {
+		uint32_t lane_count = 0;
+		uint32_t slot_A[LANES];
+		uint32_t slot_B[LANES];
+		bool writes_A[LANES];
+		bool writes_B[LANES];
+		BodyPair2DSW::Contact *contact[LANES];
+
+		bool active[LANES];
+		real_t normal[2][LANES];
+		real_t rA[2][LANES];
+		real_t rB[2][LANES];
+		real_t mass_normal[LANES];
+		real_t mass_tangent[LANES];
+		real_t bias[LANES];
+		real_t bounce[LANES];
+		real_t friction[LANES];
+		real_t acc_normal_impulse[LANES];
+		real_t acc_tangent_impulse[LANES];
+		real_t acc_bias_impulse[LANES];
+	};
+
+	struct LaneBodies;
+
+	LocalVector<BodySlot> slots;
+	LocalVector<Block> blocks;
+	uint32_t contact_count = 0;
+
+	Body2DSW *last_static_body = nullptr;
+	uint32_t last_static_slot = 0;
+
+	uint32_t _get_slot(Body2DSW *p_body);
+	void _gather(const uint32_t *p_slots, const bool *p_writes, LaneBodies &r_bodies) const;
+	void _scatter(uint32_t p_lane_count, const uint32_t *p_slots, const bool *p_writes, const LaneBodies &p_bodies);
+	void _solve_block(Block &p_block);
+
+public:
+	// Must be called from the stepping thread, so the memory used while solving
+	// in parallel doesn't need to be allocated from worker threads.
+	void reserve(uint32_t p_contact_count);
+
+	void clear();
+	void add_contact(Body2DSW *p_A, Body2DSW *p_B, bool p_collide_A, bool p_collide_B, real_t p_friction, BodyPair2DSW::Contact *p_contact);
+	_FORCE_INLINE_ bool is_empty() const { return contact_count == 0; }
+
+	void load_velocities();
+	void solve();
+	void store_velocities();
+	void finish();
+};
+
+#endif // CONTACT_SOLVER_2D_SW_H
@@ -540,7 +540,7 @@ void PhysicsServer2DSW::body_set_space(RID p_body, RID p_space) {
 		return; //pointless
 	}
 
-	body->clear_constraint_list();
+	body->clear_constraint_map();
 	body->set_space(space);
 };
 
@@ -1279,8 +1279,10 @@ void PhysicsServer2DSW::flush_queries() {
 			"integrate_forces",
 			"generate_islands",
 			"setup_constraints",
+			"pre_solve_constraints",
 			"solve_constraints",
-			"integrate_velocities"
+			"integrate_velocities",
+			"sleep_islands"
 		};
 
 		for (int i = 0; i < Space2DSW::ELAPSED_TIME_MAX; i++) {
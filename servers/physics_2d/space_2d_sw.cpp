@@ -1100,7 +1100,10 @@ void Space2DSW::call_queries() {
 }
 
 void Space2DSW::setup() {
-	contact_debug_count = 0;
+	contact_debug_count.set(0);
+	if (!contact_debug.is_empty()) {
+		contact_debug.ptrw(); // Ensure the buffer is not shared before adding contacts from multiple threads.
+	}
 
 	while (inertia_update_list.first()) {
 		inertia_update_list.first()->self()->update_inertias();
@@ -1184,7 +1187,7 @@ Space2DSW::Space2DSW() {
 	active_objects = 0;
 	island_count = 0;
 
-	contact_debug_count = 0;
+	contact_debug_count.set(0);
 
 	locked = false;
 	contact_recycle_radius = 1.0;
@@ -39,6 +39,7 @@
 #include "collision_object_2d_sw.h"
 #include "core/config/project_settings.h"
 #include "core/templates/hash_map.h"
+#include "core/templates/safe_refcount.h"
 #include "core/typedefs.h"
 
 class PhysicsDirectSpaceState2DSW : public PhysicsDirectSpaceState2D {
@@ -66,8 +67,10 @@ public:
 		ELAPSED_TIME_INTEGRATE_FORCES,
 		ELAPSED_TIME_GENERATE_ISLANDS,
 		ELAPSED_TIME_SETUP_CONSTRAINTS,
+		ELAPSED_TIME_PRE_SOLVE_CONSTRAINTS,
 		ELAPSED_TIME_SOLVE_CONSTRAINTS,
 		ELAPSED_TIME_INTEGRATE_VELOCITIES,
+		ELAPSED_TIME_SLEEP_ISLANDS,
 		ELAPSED_TIME_MAX
 
 	};
@@ -124,7 +127,7 @@ private:
 	int _cull_aabb_for_body(Body2DSW *p_body, const Rect2 &p_aabb);
 
 	Vector<Vector2> contact_debug;
-	int contact_debug_count;
+	SafeNumeric<int> contact_debug_count;
 
 	friend class PhysicsDirectSpaceState2DSW;
 
@@ -188,12 +191,13 @@ public:
 	void set_debug_contacts(int p_amount) { contact_debug.resize(p_amount); }
 	_FORCE_INLINE_ bool is_debugging_contacts() const { return !contact_debug.is_empty(); }
 	_FORCE_INLINE_ void add_debug_contact(const Vector2 &p_contact) {
-		if (contact_debug_count < contact_debug.size()) {
-			contact_debug.write[contact_debug_count++] = p_contact;
+		int index = contact_debug_count.postincrement();
+		if (index < contact_debug.size()) {
+			contact_debug.write[index] = p_contact;
 		}
 	}
 	_FORCE_INLINE_ Vector<Vector2> get_debug_contacts() { return contact_debug; }
-	_FORCE_INLINE_ int get_debug_contact_count() { return contact_debug_count; }
+	_FORCE_INLINE_ int get_debug_contact_count() { return MIN(contact_debug_count.get(), contact_debug.size()); }
 
 	PhysicsDirectSpaceState2DSW *get_direct_state();
 
@@ -31,6 +31,7 @@
 #include "step_2d_sw.h"
 
 #include "core/os/os.h"
+#include "core/os/worker_thread_pool.h"
 
 #define BODY_ISLAND_COUNT_RESERVE 128
 #define BODY_ISLAND_SIZE_RESERVE 512
@@ -38,6 +39,20 @@
 #define ISLAND_SIZE_RESERVE 512
 #define CONSTRAINT_COUNT_RESERVE 1024
 
+// Bodies and constraints are found through pointer-keyed containers. Islands
+// are sorted by these stable keys, so the results don't depend on the heap layout.
+struct BodyIDComparator {
+	_FORCE_INLINE_ bool operator()(const Body2DSW *p_a, const Body2DSW *p_b) const {
+		return p_a->get_self().get_id() < p_b->get_self().get_id();
+	}
+};
+
+struct ConstraintIDComparator {
+	_FORCE_INLINE_ bool operator()(const Constraint2DSW *p_a, const Constraint2DSW *p_b) const {
+		return p_a->get_id() < p_b->get_id();
+	}
+};
+
 void Step2DSW::_populate_island(Body2DSW *p_body, LocalVector<Body2DSW *> &p_body_island, LocalVector<Constraint2DSW *> &p_constraint_island) {
 	p_body->set_island_step(_step);
 
@@ -46,8 +61,8 @@ void Step2DSW::_populate_island(Body2DSW *p_body, LocalVector<Body2DSW *> &p_bod
 		p_body_island.push_back(p_body);
 	}
 
-	for (const Pair<Constraint2DSW *, int> &E : p_body->get_constraint_list()) {
-		Constraint2DSW *constraint = (Constraint2DSW *)E.first;
+	for (const FlatMap<Constraint2DSW *, int>::Pair &E : p_body->get_constraint_map()) {
+		Constraint2DSW *constraint = E.key;
 		if (constraint->get_island_step() == _step) {
 			continue; // Already processed.
 		}
@@ -56,7 +71,7 @@ void Step2DSW::_populate_island(Body2DSW *p_body, LocalVector<Body2DSW *> &p_bod
 		all_constraints.push_back(constraint);
 
 		for (int i = 0; i < constraint->get_body_count(); i++) {
-			if (i == E.second) {
+			if (i == E.value) {
 				continue;
 			}
 			Body2DSW *other_body = constraint->get_body_ptr()[i];
@@ -71,57 +86,112 @@ void Step2DSW::_populate_island(Body2DSW *p_body, LocalVector<Body2DSW *> &p_bod
 	}
 }
 
+void Step2DSW::_gather_active_bodies(Space2DSW *p_space) {
+	// Bodies are processed from arrays, as the active list can't be split across threads.
+	active_bodies.clear();
+	const SelfList<Body2DSW> *b = p_space->get_active_body_list().first();
+	while (b) {
+		active_bodies.push_back(b->self());
+		b = b->next();
+	}
+}
+
+void Step2DSW::_integrate_forces(uint32_t p_body_index, void *p_userdata) {
+	active_bodies[p_body_index]->integrate_forces(delta);
+}
+
 void Step2DSW::_setup_contraint(uint32_t p_constraint_index, void *p_userdata) {
 	Constraint2DSW *constraint = all_constraints[p_constraint_index];
 	constraint->setup(delta);
 }
 
-void Step2DSW::_pre_solve_island(LocalVector<Constraint2DSW *> &p_constraint_island) const {
-	uint32_t constraint_count = p_constraint_island.size();
+void Step2DSW::_pre_solve_island(uint32_t p_island_index, void *p_userdata) {
+	LocalVector<Constraint2DSW *> &constraint_island = constraint_islands[p_island_index];
+	LocalVector<Constraint2DSW *> &deferred_constraints = deferred_pre_solve_islands[p_island_index];
+	deferred_constraints.clear();
+
+	uint32_t contact_count = 0;
+
+	uint32_t constraint_count = constraint_island.size();
 	uint32_t valid_constraint_count = 0;
 	for (uint32_t constraint_index = 0; constraint_index < constraint_count; ++constraint_index) {
-		Constraint2DSW *constraint = p_constraint_island[constraint_index];
-		if (p_constraint_island[constraint_index]->pre_solve(delta)) {
+		Constraint2DSW *constraint = constraint_island[constraint_index];
+		if (!constraint->is_pre_solve_thread_safe()) {
+			// Pre-solved after all islands, on the stepping thread.
+			deferred_constraints.push_back(constraint);
+		} else if (constraint->pre_solve(delta)) {
 			// Keep this constraint for solving.
-			p_constraint_island[valid_constraint_count++] = constraint;
+			constraint_island[valid_constraint_count++] = constraint;
+			contact_count += constraint->get_batched_contact_count();
 		}
 	}
-	p_constraint_island.resize(valid_constraint_count);
+	constraint_island.resize(valid_constraint_count);
+
+	island_contact_counts[p_island_index] = contact_count;
 }
 
-void Step2DSW::_solve_island(uint32_t p_island_index, void *p_userdata) const {
-	const LocalVector<Constraint2DSW *> &constraint_island = constraint_islands[p_island_index];
+void Step2DSW::_solve_island(uint32_t p_island_index, void *p_userdata) {
+	LocalVector<Constraint2DSW *> &constraint_island = constraint_islands[p_island_index];
+	ContactSolver2DSW &contact_solver = contact_solvers[p_island_index];
+
+	// Contacts are solved in batches, other constraints one by one.
+	contact_solver.clear();
+	uint32_t constraint_count = 0;
+	for (uint32_t constraint_index = 0; constraint_index < constraint_island.size(); ++constraint_index) {
+		Constraint2DSW *constraint = constraint_island[constraint_index];
+		if (!constraint->add_batched_contacts(&contact_solver)) {
+			constraint_island[constraint_count++] = constraint;
+		}
+	}
+
+	bool solve_contacts = !contact_solver.is_empty();
+	if (solve_contacts) {
+		contact_solver.load_velocities();
+	}
 
 	for (int i = 0; i < iterations; i++) {
-		uint32_t constraint_count = constraint_island.size();
+		if (solve_contacts) {
+			contact_solver.solve();
+			if (constraint_count > 0) {
+				contact_solver.store_velocities();
+			}
+		}
+
 		for (uint32_t constraint_index = 0; constraint_index < constraint_count; ++constraint_index) {
 			constraint_island[constraint_index]->solve(delta);
 		}
+
+		if (solve_contacts && constraint_count > 0) {
+			contact_solver.load_velocities();
+		}
+	}
+
+	if (solve_contacts) {
+		contact_solver.store_velocities();
+		contact_solver.finish();
 	}
 }
 
-void Step2DSW::_check_suspend(LocalVector<Body2DSW *> &p_body_island) const {
+void Step2DSW::_integrate_velocities(uint32_t p_body_index, void *p_userdata) {
+	active_bodies[p_body_index]->integrate_velocities(delta);
+}
+
+void Step2DSW::_check_suspend(uint32_t p_island_index, void *p_userdata) {
+	const LocalVector<Body2DSW *> &body_island = body_islands[p_island_index];
+
 	bool can_sleep = true;
 
-	uint32_t body_count = p_body_island.size();
+	uint32_t body_count = body_island.size();
 	for (uint32_t body_index = 0; body_index < body_count; ++body_index) {
-		Body2DSW *body = p_body_island[body_index];
+		Body2DSW *body = body_island[body_index];
 
 		if (!body->sleep_test(delta)) {
 			can_sleep = false;
 		}
 	}
 
-	// Put all to sleep or wake up everyone.
-	for (uint32_t body_index = 0; body_index < body_count; ++body_index) {
-		Body2DSW *body = p_body_island[body_index];
-
-		bool active = body->is_active();
-
-		if (active == can_sleep) {
-			body->set_active(!can_sleep);
-		}
-	}
+	// The island is put to sleep or woken up on the stepping thread.
+	body_island_can_sleep[p_island_index] = can_sleep;
 }
 
 void Step2DSW::step(Space2DSW *p_space, real_t p_delta, int p_iterations) {
@@ -132,23 +202,24 @@ void Step2DSW::step(Space2DSW *p_space, real_t p_delta, int p_iterations) {
 	iterations = p_iterations;
 	delta = p_delta;
 
-	const SelfList<Body2DSW>::List *body_list = &p_space->get_active_body_list();
-
 	/* INTEGRATE FORCES */
 
 	uint64_t profile_begtime = OS::get_singleton()->get_ticks_usec();
 	uint64_t profile_endtime = 0;
 
-	int active_count = 0;
+	_gather_active_bodies(p_space);
 
-	const SelfList<Body2DSW> *b = body_list->first();
-	while (b) {
-		b->self()->integrate_forces(p_delta);
-		b = b->next();
-		active_count++;
+	uint32_t body_count = active_bodies.size();
+
+	WorkerThreadPool::GroupID group_task = WorkerThreadPool::get_singleton()->add_template_group_task(this, &Step2DSW::_integrate_forces, nullptr, body_count);
+	WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group_task);
+
+	// Broadphase updates are not thread-safe.
+	for (uint32_t body_index = 0; body_index < body_count; ++body_index) {
+		active_bodies[body_index]->apply_deferred_updates();
 	}
 
-	p_space->set_active_objects(active_count);
+	p_space->set_active_objects(body_count);
 
 	{ //profile
 		profile_endtime = OS::get_singleton()->get_ticks_usec();
@@ -162,36 +233,40 @@ void Step2DSW::step(Space2DSW *p_space, real_t p_delta, int p_iterations) {
 
 	const SelfList<Area2DSW>::List &aml = p_space->get_moved_area_list();
 
+	area_constraints.clear();
 	while (aml.first()) {
-		for (const Set<Constraint2DSW *>::Element *E = aml.first()->self()->get_constraints().front(); E; E = E->next()) {
-			Constraint2DSW *constraint = E->get();
+		for (Constraint2DSW *constraint : aml.first()->self()->get_constraints()) {
 			if (constraint->get_island_step() == _step) {
 				continue;
 			}
 			constraint->set_island_step(_step);
+			area_constraints.push_back(constraint);
+		}
+		p_space->area_remove_from_moved_list((SelfList<Area2DSW> *)aml.first()); //faster to remove here
+	}
+	area_constraints.sort_custom<ConstraintIDComparator>();
 
-			// Each constraint can be on a separate island for areas as there's no solving phase.
-			++island_count;
-			if (constraint_islands.size() < island_count) {
-				constraint_islands.resize(island_count);
-			}
-			LocalVector<Constraint2DSW *> &constraint_island = constraint_islands[island_count - 1];
-			constraint_island.clear();
+	for (uint32_t constraint_index = 0; constraint_index < area_constraints.size(); ++constraint_index) {
+		Constraint2DSW *constraint = area_constraints[constraint_index];
 
-			all_constraints.push_back(constraint);
-			constraint_island.push_back(constraint);
+		// Each constraint can be on a separate island for areas as there's no solving phase.
+		++island_count;
+		if (constraint_islands.size() < island_count) {
+			constraint_islands.resize(island_count);
 		}
-		p_space->area_remove_from_moved_list((SelfList<Area2DSW> *)aml.first()); //faster to remove here
+		LocalVector<Constraint2DSW *> &constraint_island = constraint_islands[island_count - 1];
+		constraint_island.clear();
+
+		all_constraints.push_back(constraint);
+		constraint_island.push_back(constraint);
 	}
 
 	/* GENERATE CONSTRAINT ISLANDS FOR ACTIVE RIGID BODIES */
 
-	b = body_list->first();
-
 	uint32_t body_island_count = 0;
 
-	while (b) {
-		Body2DSW *body = b->self();
+	for (uint32_t body_index = 0; body_index < body_count; ++body_index) {
+		Body2DSW *body = active_bodies[body_index];
 
 		if (body->get_island_step() != _step) {
 			++body_island_count;
@@ -211,6 +286,8 @@ void Step2DSW::step(Space2DSW *p_space, real_t p_delta, int p_iterations) {
 			constraint_island.reserve(ISLAND_SIZE_RESERVE);
 
 			_populate_island(body, body_island, constraint_island);
+			body_island.sort_custom<BodyIDComparator>();
+			constraint_island.sort_custom<ConstraintIDComparator>();
 
 			if (body_island.is_empty()) {
 				--body_island_count;
@@ -220,7 +297,6 @@ void Step2DSW::step(Space2DSW *p_space, real_t p_delta, int p_iterations) {
 				--island_count;
 			}
 		}
-		b = b->next();
 	}
 
 	p_space->set_island_count((int)island_count);
@@ -234,7 +310,8 @@ void Step2DSW::step(Space2DSW *p_space, real_t p_delta, int p_iterations) {
 	/* SETUP CONSTRAINTS / PROCESS COLLISIONS */
 
 	uint32_t total_contraint_count = all_constraints.size();
-	work_pool.do_work(total_contraint_count, this, &Step2DSW::_setup_contraint, nullptr);
+	group_task = WorkerThreadPool::get_singleton()->add_template_group_task(this, &Step2DSW::_setup_contraint, nullptr, total_contraint_count);
+	WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group_task);
 
 	{ //profile
 		profile_endtime = OS::get_singleton()->get_ticks_usec();
@@ -244,9 +321,37 @@ void Step2DSW::step(Space2DSW *p_space, real_t p_delta, int p_iterations) {
 
 	/* PRE-SOLVE CONSTRAINT ISLANDS */
 
-	// Warning: This doesn't run on threads, because it involves thread-unsafe processing.
+	if (deferred_pre_solve_islands.size() < island_count) {
+		deferred_pre_solve_islands.resize(island_count);
+	}
+	if (contact_solvers.size() < island_count) {
+		contact_solvers.resize(island_count);
+	}
+	island_contact_counts.resize(island_count);
+	for (uint32_t island_index = 0; island_index < island_count; ++island_index) {
+		deferred_pre_solve_islands[island_index].reserve(constraint_islands[island_index].size());
+	}
+
+	group_task = WorkerThreadPool::get_singleton()->add_template_group_task(this, &Step2DSW::_pre_solve_island, nullptr, island_count);
+	WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group_task);
+
+	// Process the thread-unsafe constraints in island order so the result is deterministic.
 	for (uint32_t island_index = 0; island_index < island_count; ++island_index) {
-		_pre_solve_island(constraint_islands[island_index]);
+		const LocalVector<Constraint2DSW *> &deferred_constraints = deferred_pre_solve_islands[island_index];
+		for (uint32_t constraint_index = 0; constraint_index < deferred_constraints.size(); ++constraint_index) {
+			Constraint2DSW *constraint = deferred_constraints[constraint_index];
+			if (constraint->pre_solve(delta)) {
+				constraint_islands[island_index].push_back(constraint);
+				island_contact_counts[island_index] += constraint->get_batched_contact_count();
+			}
+		}
+		contact_solvers[island_index].reserve(island_contact_counts[island_index]);
+	}
+
+	{ //profile
+		profile_endtime = OS::get_singleton()->get_ticks_usec();
+		p_space->set_elapsed_time(Space2DSW::ELAPSED_TIME_PRE_SOLVE_CONSTRAINTS, profile_endtime - profile_begtime);
+		profile_begtime = profile_endtime;
 	}
 
 	/* SOLVE CONSTRAINT ISLANDS */
@@ -254,7 +359,8 @@ void Step2DSW::step(Space2DSW *p_space, real_t p_delta, int p_iterations) {
 	// Warning: _solve_island modifies the constraint islands for optimization purpose,
 	// their content is not reliable after these calls and shouldn't be used anymore.
 	if (island_count > 1) {
-		work_pool.do_work(island_count, this, &Step2DSW::_solve_island, nullptr);
+		group_task = WorkerThreadPool::get_singleton()->add_template_group_task(this, &Step2DSW::_solve_island, nullptr, island_count);
+		WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group_task);
 	} else if (island_count > 0) {
 		_solve_island(0);
 	}
@@ -267,22 +373,41 @@ void Step2DSW::step(Space2DSW *p_space, real_t p_delta, int p_iterations) {
 
 	/* INTEGRATE VELOCITIES */
 
-	b = body_list->first();
-	while (b) {
-		const SelfList<Body2DSW> *n = b->next();
-		b->self()->integrate_velocities(p_delta);
-		b = n; // in case it shuts itself down
+	group_task = WorkerThreadPool::get_singleton()->add_template_group_task(this, &Step2DSW::_integrate_velocities, nullptr, body_count);
+	WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group_task);
+
+	for (uint32_t body_index = 0; body_index < body_count; ++body_index) {
+		active_bodies[body_index]->apply_deferred_updates();
+	}
+
+	{ //profile
+		profile_endtime = OS::get_singleton()->get_ticks_usec();
+		p_space->set_elapsed_time(Space2DSW::ELAPSED_TIME_INTEGRATE_VELOCITIES, profile_endtime - profile_begtime);
+		profile_begtime = profile_endtime;
 	}
 
 	/* SLEEP / WAKE UP ISLANDS */
 
+	body_island_can_sleep.resize(body_island_count);
+
+	group_task = WorkerThreadPool::get_singleton()->add_template_group_task(this, &Step2DSW::_check_suspend, nullptr, body_island_count);
+	WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group_task);
+
+	// Put all to sleep or wake up everyone.
 	for (uint32_t island_index = 0; island_index < body_island_count; ++island_index) {
-		_check_suspend(body_islands[island_index]);
+		const LocalVector<Body2DSW *> &body_island = body_islands[island_index];
+		bool can_sleep = body_island_can_sleep[island_index];
+		for (uint32_t body_index = 0; body_index < body_island.size(); ++body_index) {
+			Body2DSW *body = body_island[body_index];
+			if (body->is_active() == can_sleep) {
+				body->set_active(!can_sleep);
+			}
+		}
 	}
 
 	{ //profile
 		profile_endtime = OS::get_singleton()->get_ticks_usec();
-		p_space->set_elapsed_time(Space2DSW::ELAPSED_TIME_INTEGRATE_VELOCITIES, profile_endtime - profile_begtime);
+		p_space->set_elapsed_time(Space2DSW::ELAPSED_TIME_SLEEP_ISLANDS, profile_endtime - profile_begtime);
 		//profile_begtime=profile_endtime;
 	}
 
@@ -298,11 +423,10 @@ Step2DSW::Step2DSW() {
 
 	body_islands.reserve(BODY_ISLAND_COUNT_RESERVE);
 	constraint_islands.reserve(ISLAND_COUNT_RESERVE);
+	deferred_pre_solve_islands.reserve(ISLAND_COUNT_RESERVE);
+	contact_solvers.reserve(ISLAND_COUNT_RESERVE);
 	all_constraints.reserve(CONSTRAINT_COUNT_RESERVE);
-
-	work_pool.init();
 }
 
 Step2DSW::~Step2DSW() {
-	work_pool.finish();
 }
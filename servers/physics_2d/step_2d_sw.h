@@ -31,10 +31,10 @@
 #ifndef STEP_2D_SW_H
 #define STEP_2D_SW_H
 
+#include "contact_solver_2d_sw.h"
 #include "space_2d_sw.h"
 
 #include "core/templates/local_vector.h"
-#include "core/templates/thread_work_pool.h"
 
 class Step2DSW {
 	uint64_t _step;
@@ -42,17 +42,26 @@ class Step2DSW {
 	int iterations = 0;
 	real_t delta = 0.0;
 
-	ThreadWorkPool work_pool;
+	LocalVector<Body2DSW *> active_bodies;
 
 	LocalVector<LocalVector<Body2DSW *>> body_islands;
 	LocalVector<LocalVector<Constraint2DSW *>> constraint_islands;
+	LocalVector<LocalVector<Constraint2DSW *>> deferred_pre_solve_islands;
+	LocalVector<uint32_t> island_contact_counts;
+	LocalVector<ContactSolver2DSW> contact_solvers;
 	LocalVector<Constraint2DSW *> all_constraints;
+	LocalVector<Constraint2DSW *> area_constraints;
+	LocalVector<bool> body_island_can_sleep;
+
+	void _gather_active_bodies(Space2DSW *p_space);
 
 	void _populate_island(Body2DSW *p_body, LocalVector<Body2DSW *> &p_body_island, LocalVector<Constraint2DSW *> &p_constraint_island);
+	void _integrate_forces(uint32_t p_body_index, void *p_userdata = nullptr);
 	void _setup_contraint(uint32_t p_constraint_index, void *p_userdata = nullptr);
-	void _pre_solve_island(LocalVector<Constraint2DSW *> &p_constraint_island) const;
-	void _solve_island(uint32_t p_island_index, void *p_userdata = nullptr) const;
-	void _check_suspend(LocalVector<Body2DSW *> &p_body_island) const;
+	void _pre_solve_island(uint32_t p_island_index, void *p_userdata = nullptr);
+	void _solve_island(uint32_t p_island_index, void *p_userdata = nullptr);
+	void _integrate_velocities(uint32_t p_body_index, void *p_userdata = nullptr);
+	void _check_suspend(uint32_t p_island_index, void *p_userdata = nullptr);
 
 public:
 	void step(Space2DSW *p_space, real_t p_delta, int p_iterations);
@@ -32,6 +32,7 @@
 #define AREA_SW_H
 
 #include "collision_object_3d_sw.h"
+#include "core/templates/flat_set.h"
 #include "core/templates/self_list.h"
 #include "servers/physics_server_3d.h"
 //#include "servers/physics_3d/query_sw.h"
@@ -97,7 +98,7 @@ class Area3DSW : public CollisionObject3DSW {
 	//virtual void shape_changed_notify(ShapeSW *p_shape);
 	//virtual void shape_deleted_notify(ShapeSW *p_shape);
 
-	Set<Constraint3DSW *> constraints;
+	FlatSet<Constraint3DSW *> constraints;
 
 	virtual void _shapes_changed();
 	void _queue_monitor_update();
@@ -150,7 +151,7 @@ public:
 
 	_FORCE_INLINE_ void add_constraint(Constraint3DSW *p_constraint) { constraints.insert(p_constraint); }
 	_FORCE_INLINE_ void remove_constraint(Constraint3DSW *p_constraint) { constraints.erase(p_constraint); }
-	_FORCE_INLINE_ const Set<Constraint3DSW *> &get_constraints() const { return constraints; }
+	_FORCE_INLINE_ const FlatSet<Constraint3DSW *> &get_constraints() const { return constraints; }
 	_FORCE_INLINE_ void clear_constraints() { constraints.clear(); }
 
 	void set_monitorable(bool p_monitorable);
@@ -531,7 +531,8 @@ void Body3DSW::integrate_forces(real_t p_step) {
 	biased_linear_velocity = Vector3();
 
 	if (do_motion) { //shapes temporarily extend for raycast
-		_update_shapes_with_motion(motion);
+		_update_shapes_with_motion(motion, false);
+		deferred_broadphase_update = true;
 	}
 
 	def_area = nullptr; // clear the area, so it is set in the next frame
@@ -544,7 +545,7 @@ void Body3DSW::integrate_velocities(real_t p_step) {
 	}
 
 	if (fi_callback) {
-		get_space()->body_add_to_state_query_list(&direct_state_query_list);
+		deferred_state_query = true;
 	}
 
 	//apply axis lock linear
@@ -567,7 +568,7 @@ void Body3DSW::integrate_velocities(real_t p_step) {
 		_set_transform(new_transform, false);
 		_set_inv_transform(new_transform.affine_inverse());
 		if (contacts.size() == 0 && linear_velocity == Vector3() && angular_velocity == Vector3()) {
-			set_active(false); //stopped moving, deactivate
+			deferred_sleep = true; //stopped moving, deactivate
 		}
 
 		return;
@@ -596,7 +597,9 @@ void Body3DSW::integrate_velocities(real_t p_step) {
 
 	transform.origin += total_linear_velocity * p_step;
 
-	_set_transform(transform);
+	_set_transform(transform, false);
+	_update_shapes(false);
+	deferred_broadphase_update = true;
 	_set_inv_transform(get_transform().inverse());
 
 	_update_transform_dependant();
@@ -607,6 +610,28 @@ void Body3DSW::integrate_velocities(real_t p_step) {
 	*/
 }
 
+void Body3DSW::apply_deferred_updates() {
+	if (deferred_broadphase_update) {
+		deferred_broadphase_update = false;
+		_update_broadphase();
+	}
+
+	if (deferred_state_query) {
+		deferred_state_query = false;
+		get_space()->body_add_to_state_query_list(&direct_state_query_list);
+	}
+
+	if (deferred_wakeup) {
+		deferred_wakeup = false;
+		set_active(true);
+	}
+
+	if (deferred_sleep) {
+		deferred_sleep = false;
+		set_active(false);
+	}
+}
+
 /*
 void BodySW::simulate_motion(const Transform3D& p_xform,real_t p_step) {
 	Transform3D inv_xform = p_xform.affine_inverse();
@@ -640,13 +665,13 @@ void BodySW::simulate_motion(const Transform3D& p_xform,real_t p_step) {
 */
 
 void Body3DSW::wakeup_neighbours() {
-	for (Map<Constraint3DSW *, int>::Element *E = constraint_map.front(); E; E = E->next()) {
-		const Constraint3DSW *c = E->key();
+	for (const FlatMap<Constraint3DSW *, int>::Pair &E : constraint_map) {
+		const Constraint3DSW *c = E.key;
 		Body3DSW **n = c->get_body_ptr();
 		int bc = c->get_body_count();
 
 		for (int i = 0; i < bc; i++) {
-			if (i == E->get()) {
+			if (i == E.value) {
 				continue;
 			}
 			Body3DSW *b = n[i];
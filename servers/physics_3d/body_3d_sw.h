@@ -33,6 +33,7 @@
 
 #include "area_3d_sw.h"
 #include "collision_object_3d_sw.h"
+#include "core/templates/flat_map.h"
 #include "core/templates/vset.h"
 
 class Constraint3DSW;
@@ -90,11 +91,21 @@ class Body3DSW : public CollisionObject3DSW {
 	bool continuous_cd;
 	bool can_sleep;
 	bool first_time_kinematic;
+
+	// Changes to data shared with the space, recorded while the step processes
+	// bodies in parallel and applied by apply_deferred_updates().
+	bool deferred_broadphase_update = false;
+	bool deferred_state_query = false;
+	bool deferred_wakeup = false;
+	bool deferred_sleep = false;
+
+	int contact_solver_index = -1;
+
 	void _update_inertia();
 	virtual void _shapes_changed();
 	Transform3D new_transform;
 
-	Map<Constraint3DSW *, int> constraint_map;
+	FlatMap<Constraint3DSW *, int> constraint_map;
 
 	struct AreaCMP {
 		Area3DSW *area;
@@ -184,7 +195,7 @@ public:
 
 	_FORCE_INLINE_ void add_constraint(Constraint3DSW *p_constraint, int p_pos) { constraint_map[p_constraint] = p_pos; }
 	_FORCE_INLINE_ void remove_constraint(Constraint3DSW *p_constraint) { constraint_map.erase(p_constraint); }
-	const Map<Constraint3DSW *, int> &get_constraint_map() const { return constraint_map; }
+	const FlatMap<Constraint3DSW *, int> &get_constraint_map() const { return constraint_map; }
 	_FORCE_INLINE_ void clear_constraint_map() { constraint_map.clear(); }
 
 	_FORCE_INLINE_ void set_omit_force_integration(bool p_omit_force_integration) { omit_force_integration = p_omit_force_integration; }
@@ -200,9 +211,16 @@ public:
 	_FORCE_INLINE_ void set_angular_velocity(const Vector3 &p_velocity) { angular_velocity = p_velocity; }
 	_FORCE_INLINE_ Vector3 get_angular_velocity() const { return angular_velocity; }
 
+	_FORCE_INLINE_ void set_biased_linear_velocity(const Vector3 &p_velocity) { biased_linear_velocity = p_velocity; }
 	_FORCE_INLINE_ const Vector3 &get_biased_linear_velocity() const { return biased_linear_velocity; }
+
+	_FORCE_INLINE_ void set_biased_angular_velocity(const Vector3 &p_velocity) { biased_angular_velocity = p_velocity; }
 	_FORCE_INLINE_ const Vector3 &get_biased_angular_velocity() const { return biased_angular_velocity; }
 
+	// Slot of the body in the contact solver of its island, while being solved.
+	_FORCE_INLINE_ void set_contact_solver_index(int p_index) { contact_solver_index = p_index; }
+	_FORCE_INLINE_ int get_contact_solver_index() const { return contact_solver_index; }
+
 	_FORCE_INLINE_ void apply_central_impulse(const Vector3 &p_impulse) {
 		linear_velocity += p_impulse * _inv_mass;
 	}
@@ -247,6 +265,10 @@ public:
 	void set_active(bool p_active);
 	_FORCE_INLINE_ bool is_active() const { return active; }
 
+	// Thread-safe version of set_active(true), applied by apply_deferred_updates().
+	_FORCE_INLINE_ void wakeup_deferred() { deferred_wakeup = true; }
+	void apply_deferred_updates();
+
 	_FORCE_INLINE_ void wakeup() {
 		if ((!get_space()) || mode == PhysicsServer3D::BODY_MODE_STATIC || mode == PhysicsServer3D::BODY_MODE_KINEMATIC) {
 			return;
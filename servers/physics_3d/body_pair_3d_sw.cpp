@@ -31,6 +31,7 @@
 #include "body_pair_3d_sw.h"
 
 #include "collision_solver_3d_sw.h"
+#include "contact_solver_3d_sw.h"
 #include "core/os/os.h"
 #include "space_3d_sw.h"
 
@@ -523,6 +524,37 @@ void BodyPair3DSW::solve(real_t p_step) {
 	}
 }
 
+int BodyPair3DSW::get_batched_contact_count() const {
+	if (!collided) {
+		return 0;
+	}
+
+	int count = 0;
+	for (int i = 0; i < contact_count; i++) {
+		if (contacts[i].active) {
+			count++;
+		}
+	}
+	return count;
+}
+
+bool BodyPair3DSW::add_batched_contacts(ContactSolver3DSW *p_solver) {
+	if (!collided) {
+		return true;
+	}
+
+	real_t friction = combine_friction(A, B);
+
+	for (int i = 0; i < contact_count; i++) {
+		Contact &c = contacts[i];
+		if (c.active) {
+			p_solver->add_contact(A, B, collide_A, collide_B, friction, &c);
+		}
+	}
+
+	return true;
+}
+
 BodyPair3DSW::BodyPair3DSW(Body3DSW *p_A, int p_shape_A, Body3DSW *p_B, int p_shape_B) :
 		BodyContact3DSW(_arr, 2) {
 	A = p_A;
@@ -717,7 +749,7 @@ bool BodySoftBodyPair3DSW::pre_solve(real_t p_step) {
 		do_process = true;
 
 		if (body_collides) {
-			body->set_active(true);
+			body->wakeup_deferred();
 		}
 
 		// Precompute normal mass, tangent mass, and bias.
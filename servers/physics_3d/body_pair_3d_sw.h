@@ -37,6 +37,8 @@
 #include "soft_body_3d_sw.h"
 
 class BodyContact3DSW : public Constraint3DSW {
+	friend class ContactSolver3DSW;
+
 protected:
 	struct Contact {
 		Vector3 position;
@@ -105,6 +107,14 @@ public:
 	virtual bool pre_solve(real_t p_step) override;
 	virtual void solve(real_t p_step) override;
 
+	// Static bodies can be shared between islands, reporting their contacts must be serialized.
+	virtual bool is_pre_solve_thread_safe() const override {
+		return !(A->get_mode() == PhysicsServer3D::BODY_MODE_STATIC && A->can_report_contacts()) && !(B->get_mode() == PhysicsServer3D::BODY_MODE_STATIC && B->can_report_contacts());
+	}
+
+	virtual int get_batched_contact_count() const override;
+	virtual bool add_batched_contacts(ContactSolver3DSW *p_solver) override;
+
 	BodyPair3DSW(Body3DSW *p_A, int p_shape_A, Body3DSW *p_B, int p_shape_B);
 	~BodyPair3DSW();
 };
@@ -133,6 +143,10 @@ public:
 	virtual bool pre_solve(real_t p_step) override;
 	virtual void solve(real_t p_step) override;
 
+	virtual bool is_pre_solve_thread_safe() const override {
+		return !(body->get_mode() == PhysicsServer3D::BODY_MODE_STATIC && body->can_report_contacts());
+	}
+
 	virtual SoftBody3DSW *get_soft_body_ptr(int p_index) const override { return soft_body; }
 	virtual int get_soft_body_count() const override { return 1; }
 
@@ -151,7 +151,17 @@ void CollisionObject3DSW::_unregister_shapes() {
 	}
 }
 
-void CollisionObject3DSW::_update_shapes() {
+void CollisionObject3DSW::_update_shape_broadphase(int p_index) {
+	Shape &s = shapes.write[p_index];
+	if (s.bpid == 0) {
+		s.bpid = space->get_broadphase()->create(this, p_index, s.aabb_cache, _static);
+		space->get_broadphase()->set_static(s.bpid, _static);
+	}
+
+	space->get_broadphase()->move(s.bpid, s.aabb_cache);
+}
+
+void CollisionObject3DSW::_update_shapes(bool p_update_broadphase) {
 	if (!space) {
 		return;
 	}
@@ -172,16 +182,13 @@ void CollisionObject3DSW::_update_shapes() {
 		Vector3 scale = xform.get_basis().get_scale();
 		s.area_cache = s.shape->get_area() * scale.x * scale.y * scale.z;
 
-		if (s.bpid == 0) {
-			s.bpid = space->get_broadphase()->create(this, i, shape_aabb, _static);
-			space->get_broadphase()->set_static(s.bpid, _static);
+		if (p_update_broadphase) {
+			_update_shape_broadphase(i);
 		}
-
-		space->get_broadphase()->move(s.bpid, shape_aabb);
 	}
 }
 
-void CollisionObject3DSW::_update_shapes_with_motion(const Vector3 &p_motion) {
+void CollisionObject3DSW::_update_shapes_with_motion(const Vector3 &p_motion, bool p_update_broadphase) {
 	if (!space) {
 		return;
 	}
@@ -199,12 +206,22 @@ void CollisionObject3DSW::_update_shapes_with_motion(const Vector3 &p_motion) {
 		shape_aabb.merge_with(AABB(shape_aabb.position + p_motion, shape_aabb.size)); //use motion
 		s.aabb_cache = shape_aabb;
 
-		if (s.bpid == 0) {
-			s.bpid = space->get_broadphase()->create(this, i, shape_aabb, _static);
-			space->get_broadphase()->set_static(s.bpid, _static);
+		if (p_update_broadphase) {
+			_update_shape_broadphase(i);
 		}
+	}
+}
+
+void CollisionObject3DSW::_update_broadphase() {
+	if (!space) {
+		return;
+	}
 
-		space->get_broadphase()->move(s.bpid, shape_aabb);
+	for (int i = 0; i < shapes.size(); i++) {
+		if (shapes[i].disabled) {
+			continue;
+		}
+		_update_shape_broadphase(i);
 	}
 }
 
@@ -1,5 +1,5 @@
 /*************************************************************************/
-/*  renderer_thread_pool.h                                               */
+/*  constraint_3d_sw.cpp                                                 */
 /*************************************************************************/
 /*                       This file is part of:                           */
 /*                           GODOT ENGINE                                */
@@ -28,18 +28,6 @@
 /* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
 /*************************************************************************/
 
-#ifndef RENDERERTHREADPOOL_H
-#define RENDERERTHREADPOOL_H
+#include "constraint_3d_sw.h"
 
-#include "core/templates/thread_work_pool.h"
-
-class RendererThreadPool {
-public:
-	ThreadWorkPool thread_work_pool;
-
-	static RendererThreadPool *singleton;
-	RendererThreadPool();
-	~RendererThreadPool();
-};
-
-#endif // RENDERERTHREADPOOL_H
+SafeNumeric<uint64_t> Constraint3DSW::last_id;
@@ -0,0 +1,537 @@
+/*************************************************************************/
+/*  contact_solver_3d_sw.cpp                                             */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "contact_solver_3d_sw.h"
+
+#define MIN_VELOCITY 0.0001
+#define MAX_BIAS_ROTATION (Math_PI / 8)
+
+uint32_t ContactSolver3DSW::_get_slot(Body3DSW *p_body) {
+	if (p_body->get_mode() == PhysicsServer3D::BODY_MODE_STATIC) {
+		// Static bodies can be shared with other islands, so they are never written to
+		// and get a read-only slot (reused for consecutive contacts of the same body).
+		if (p_body != last_static_body) {
+			last_static_body = p_body;
+			last_static_slot = slots.size();
+			BodySlot slot;
+			slot.body = p_body;
+			slots.push_back(slot);
+		}
+		return last_static_slot;
+	}
+
+	int index = p_body->get_contact_solver_index();
+	if (index < 0) {
+		index = slots.size();
+		p_body->set_contact_solver_index(index);
+		BodySlot slot;
+		slot.body = p_body;
+		slot.write_back = true;
+		slots.push_back(slot);
+	}
+	return index;
+}
+
+void ContactSolver3DSW::reserve(uint32_t p_contact_count) {
+	// At worst, every contact gets its own block and two slots.
+	blocks.reserve(p_contact_count);
+	slots.reserve(p_contact_count * 2 + 1);
+}
+
+void ContactSolver3DSW::clear() {
+	blocks.clear();
+	slots.clear();
+	contact_count = 0;
+	last_static_body = nullptr;
+
+	// Slot used by the lanes of incomplete blocks.
+	slots.push_back(BodySlot());
+}
+
+void ContactSolver3DSW::add_contact(Body3DSW *p_A, Body3DSW *p_B, bool p_collide_A, bool p_collide_B, real_t p_friction, BodyContact3DSW::Contact *p_contact) {
+	uint32_t slot_A = _get_slot(p_A);
+	uint32_t slot_B = _get_slot(p_B);
+
+	// Find a recent block where no other lane writes to the same bodies.
+	Block *block = nullptr;
+	uint32_t block_count = blocks.size();
+	uint32_t search_begin = block_count > BLOCK_SEARCH_DEPTH ? block_count - BLOCK_SEARCH_DEPTH : 0;
+	for (uint32_t block_index = search_begin; block_index < block_count; ++block_index) {
+		Block &candidate = blocks[block_index];
+		if (candidate.lane_count == LANES) {
+			continue;
+		}
+		bool conflict = false;
+		for (uint32_t lane = 0; lane < candidate.lane_count; ++lane) {
+			if ((candidate.writes_A[lane] && (candidate.slot_A[lane] == slot_A || candidate.slot_A[lane] == slot_B)) ||
+					(candidate.writes_B[lane] && (candidate.slot_B[lane] == slot_A || candidate.slot_B[lane] == slot_B)) ||
+					(p_collide_A && (candidate.slot_A[lane] == slot_A || candidate.slot_B[lane] == slot_A)) ||
+					(p_collide_B && (candidate.slot_A[lane] == slot_B || candidate.slot_B[lane] == slot_B))) {
+				conflict = true;
+				break;
+			}
+		}
+		if (!conflict) {
+			block = &candidate;
+			break;
+		}
+	}
+
+	if (!block) {
+		blocks.push_back(Block());
+		block = &blocks[block_count];
+		for (uint32_t lane = 0; lane < LANES; ++lane) {
+			// Unused lanes are inactive and only use the empty slot.
+			block->slot_A[lane] = 0;
+			block->slot_B[lane] = 0;
+			block->writes_A[lane] = false;
+			block->writes_B[lane] = false;
+			block->contact[lane] = nullptr;
+			block->active[lane] = false;
+			for (int axis = 0; axis < 3; ++axis) {
+				block->normal[axis][lane] = 0.0;
+				block->rA[axis][lane] = 0.0;
+				block->rB[axis][lane] = 0.0;
+				block->acc_tangent_impulse[axis][lane] = 0.0;
+			}
+			block->mass_normal[lane] = 0.0;
+			block->bias[lane] = 0.0;
+			block->bounce[lane] = 0.0;
+			block->friction[lane] = 0.0;
+			block->acc_normal_impulse[lane] = 0.0;
+			block->acc_bias_impulse[lane] = 0.0;
+			block->acc_bias_impulse_center_of_mass[lane] = 0.0;
+		}
+	}
+
+	uint32_t lane = block->lane_count++;
+	block->slot_A[lane] = slot_A;
+	block->slot_B[lane] = slot_B;
+	block->writes_A[lane] = p_collide_A;
+	block->writes_B[lane] = p_collide_B;
+	block->contact[lane] = p_contact;
+	block->active[lane] = p_contact->active;
+	for (int axis = 0; axis < 3; ++axis) {
+		block->normal[axis][lane] = p_contact->normal[axis];
+		block->rA[axis][lane] = p_contact->rA[axis];
+		block->rB[axis][lane] = p_contact->rB[axis];
+		block->acc_tangent_impulse[axis][lane] = p_contact->acc_tangent_impulse[axis];
+	}
+	block->mass_normal[lane] = p_contact->mass_normal;
+	block->bias[lane] = p_contact->bias;
+	block->bounce[lane] = p_contact->bounce;
+	block->friction[lane] = p_friction;
+	block->acc_normal_impulse[lane] = p_contact->acc_normal_impulse;
+	block->acc_bias_impulse[lane] = p_contact->acc_bias_impulse;
+	block->acc_bias_impulse_center_of_mass[lane] = p_contact->acc_bias_impulse_center_of_mass;
+
+	++contact_count;
+}
+
+void ContactSolver3DSW::load_velocities() {
+	for (uint32_t slot_index = 1; slot_index < slots.size(); ++slot_index) {
+		BodySlot &slot = slots[slot_index];
+		slot.inv_mass = slot.body->get_inv_mass();
+		slot.inv_inertia_tensor = slot.body->get_inv_inertia_tensor();
+		slot.linear_velocity = slot.body->get_linear_velocity();
+		slot.angular_velocity = slot.body->get_angular_velocity();
+		slot.biased_linear_velocity = slot.body->get_biased_linear_velocity();
+		slot.biased_angular_velocity = slot.body->get_biased_angular_velocity();
+	}
+}
+
+void ContactSolver3DSW::store_velocities() {
+	for (uint32_t slot_index = 1; slot_index < slots.size(); ++slot_index) {
+		const BodySlot &slot = slots[slot_index];
+		if (slot.write_back) {
+			slot.body->set_linear_velocity(slot.linear_velocity);
+			slot.body->set_angular_velocity(slot.angular_velocity);
+			slot.body->set_biased_linear_velocity(slot.biased_linear_velocity);
+			slot.body->set_biased_angular_velocity(slot.biased_angular_velocity);
+		}
+	}
+}
+
+// Values for all the lanes of a block. Every operation is a loop over the
+// lanes without branches, so it can be compiled to SIMD instructions.
+
+struct LaneMask3D {
+	bool v[ContactSolver3DSW::LANES];
+
+	_FORCE_INLINE_ LaneMask3D operator&&(const LaneMask3D &p_other) const {
+		LaneMask3D r;
+		for (uint32_t i = 0; i < ContactSolver3DSW::LANES; ++i) {
+			r.v[i] = v[i] && p_other.v[i];
+		}
+		return r;
+	}
+	_FORCE_INLINE_ LaneMask3D operator||(const LaneMask3D &p_other) const {
+		LaneMask3D r;
+		for (uint32_t i = 0; i < ContactSolver3DSW::LANES; ++i) {
+			r.v[i] = v[i] || p_other.v[i];
+		}
+		return r;
+	}
+
+	_FORCE_INLINE_ static LaneMask3D load(const bool *p_values) {
+		LaneMask3D r;
+		for (uint32_t i = 0; i < ContactSolver3DSW::LANES; ++i) {
+			r.v[i] = p_values[i];
+		}
+		return r;
+	}
+	_FORCE_INLINE_ void store(bool *r_values) const {
+		for (uint32_t i = 0; i < ContactSolver3DSW::LANES; ++i) {
+			r_values[i] = v[i];
+		}
+	}
+};
+
+struct LaneReal3D {
+	real_t v[ContactSolver3DSW::LANES];
+
+#define LANE_REAL_OPERATOR(m_op)                                               \
+	_FORCE_INLINE_ LaneReal3D operator m_op(const LaneReal3D &p_other) const { \
+		LaneReal3D r;                                                          \
+		for (uint32_t i = 0; i < ContactSolver3DSW::LANES; ++i) {              \
+			r.v[i] = v[i] m_op p_other.v[i];                                   \
+		}                                                                      \
+		return r;                                                              \
+	}
+
+	LANE_REAL_OPERATOR(+)
+	LANE_REAL_OPERATOR(-)
+	LANE_REAL_OPERATOR(*)
+	LANE_REAL_OPERATOR(/)
+
+#undef LANE_REAL_OPERATOR
+
+	_FORCE_INLINE_ LaneReal3D operator-() const {
+		LaneReal3D r;
+		for (uint32_t i = 0; i < ContactSolver3DSW::LANES; ++i) {
+			r.v[i] = -v[i];
+		}
+		return r;
+	}
+	_FORCE_INLINE_ LaneMask3D operator>(const LaneReal3D &p_other) const {
+		LaneMask3D r;
+		for (uint32_t i = 0; i < ContactSolver3DSW::LANES; ++i) {
+			r.v[i] = v[i] > p_other.v[i];
+		}
+		return r;
+	}
+
+	_FORCE_INLINE_ static LaneReal3D splat(real_t p_value) {
+		LaneReal3D r;
+		for (uint32_t i = 0; i < ContactSolver3DSW::LANES; ++i) {
+			r.v[i] = p_value;
+		}
+		return r;
+	}
+	_FORCE_INLINE_ static LaneReal3D load(const real_t *p_values) {
+		LaneReal3D r;
+		for (uint32_t i = 0; i < ContactSolver3DSW::LANES; ++i) {
+			r.v[i] = p_values[i];
+		}
+		return r;
+	}
+	_FORCE_INLINE_ void store(real_t *r_values) const {
+		for (uint32_t i = 0; i < ContactSolver3DSW::LANES; ++i) {
+			r_values[i] = v[i];
+		}
+	}
+};
+
+_FORCE_INLINE_ static LaneReal3D lane_select(const LaneMask3D &p_mask, const LaneReal3D &p_a, const LaneReal3D &p_b) {
+	LaneReal3D r;
+	for (uint32_t i = 0; i < ContactSolver3DSW::LANES; ++i) {
+		r.v[i] = p_mask.v[i] ? p_a.v[i] : p_b.v[i];
+	}
+	return r;
+}
+
+_FORCE_INLINE_ static LaneReal3D lane_max(const LaneReal3D &p_a, const LaneReal3D &p_b) {
+	return lane_select(p_a > p_b, p_a, p_b);
+}
+
+_FORCE_INLINE_ static LaneReal3D lane_abs(const LaneReal3D &p_a) {
+	return lane_select(p_a > LaneReal3D::splat(0.0), p_a, -p_a);
+}
+
+_FORCE_INLINE_ static LaneReal3D lane_sqrt(const LaneReal3D &p_a) {
+	LaneReal3D r;
+	for (uint32_t i = 0; i < ContactSolver3DSW::LANES; ++i) {
+		r.v[i] = Math::sqrt(p_a.v[i]);
+	}
+	return r;
+}
+
+struct LaneVector3 {
+	LaneReal3D x, y, z;
+
+	_FORCE_INLINE_ LaneVector3 operator+(const LaneVector3 &p_other) const { return { x + p_other.x, y + p_other.y, z + p_other.z }; }
+	_FORCE_INLINE_ LaneVector3 operator-(const LaneVector3 &p_other) const { return { x - p_other.x, y - p_other.y, z - p_other.z }; }
+	_FORCE_INLINE_ LaneVector3 operator-() const { return { -x, -y, -z }; }
+	_FORCE_INLINE_ LaneVector3 operator*(const LaneReal3D &p_scalar) const { return { x * p_scalar, y * p_scalar, z * p_scalar }; }
+	_FORCE_INLINE_ LaneVector3 operator/(const LaneReal3D &p_scalar) const { return { x / p_scalar, y / p_scalar, z / p_scalar }; }
+
+	_FORCE_INLINE_ LaneReal3D dot(const LaneVector3 &p_other) const { return x * p_other.x + y * p_other.y + z * p_other.z; }
+	_FORCE_INLINE_ LaneVector3 cross(const LaneVector3 &p_other) const {
+		return { y * p_other.z - z * p_other.y, z * p_other.x - x * p_other.z, x * p_other.y - y * p_other.x };
+	}
+	_FORCE_INLINE_ LaneReal3D length() const { return lane_sqrt(dot(*this)); }
+
+	_FORCE_INLINE_ static LaneVector3 select(const LaneMask3D &p_mask, const LaneVector3 &p_a, const LaneVector3 &p_b) {
+		return { lane_select(p_mask, p_a.x, p_b.x), lane_select(p_mask, p_a.y, p_b.y), lane_select(p_mask, p_a.z, p_b.z) };
+	}
+	_FORCE_INLINE_ static LaneVector3 load(const real_t (*p_values)[ContactSolver3DSW::LANES]) {
+		return { LaneReal3D::load(p_values[0]), LaneReal3D::load(p_values[1]), LaneReal3D::load(p_values[2]) };
+	}
+	_FORCE_INLINE_ void store(real_t (*r_values)[ContactSolver3DSW::LANES]) const {
+		x.store(r_values[0]);
+		y.store(r_values[1]);
+		z.store(r_values[2]);
+	}
+};
+
+struct LaneBasis {
+	LaneReal3D elements[3][3];
+
+	_FORCE_INLINE_ LaneVector3 xform(const LaneVector3 &p_vector) const {
+		return {
+			elements[0][0] * p_vector.x + elements[0][1] * p_vector.y + elements[0][2] * p_vector.z,
+			elements[1][0] * p_vector.x + elements[1][1] * p_vector.y + elements[1][2] * p_vector.z,
+			elements[2][0] * p_vector.x + elements[2][1] * p_vector.y + elements[2][2] * p_vector.z
+		};
+	}
+};
+
+// Body data gathered from the slots of a block.
+struct ContactSolver3DSW::LaneBodies {
+	LaneReal3D inv_mass;
+	LaneBasis inv_inertia_tensor;
+	LaneVector3 linear_velocity;
+	LaneVector3 angular_velocity;
+	LaneVector3 biased_linear_velocity;
+	LaneVector3 biased_angular_velocity;
+};
+
+void ContactSolver3DSW::_gather(const uint32_t *p_slots, const bool *p_writes, LaneBodies &r_bodies) const {
+	for (uint32_t lane = 0; lane < LANES; ++lane) {
+		const BodySlot &slot = slots[p_slots[lane]];
+
+		// Bodies which don't respond to the contact behave as if they had infinite mass.
+		const bool writes = p_writes[lane];
+		r_bodies.inv_mass.v[lane] = writes ? slot.inv_mass : 0.0f;
+		for (int i = 0; i < 3; ++i) {
+			for (int j = 0; j < 3; ++j) {
+				r_bodies.inv_inertia_tensor.elements[i][j].v[lane] = writes ? slot.inv_inertia_tensor[i][j] : 0.0f;
+			}
+		}
+
+		r_bodies.linear_velocity.x.v[lane] = slot.linear_velocity.x;
+		r_bodies.linear_velocity.y.v[lane] = slot.linear_velocity.y;
+		r_bodies.linear_velocity.z.v[lane] = slot.linear_velocity.z;
+		r_bodies.angular_velocity.x.v[lane] = slot.angular_velocity.x;
+		r_bodies.angular_velocity.y.v[lane] = slot.angular_velocity.y;
+		r_bodies.angular_velocity.z.v[lane] = slot.angular_velocity.z;
+		r_bodies.biased_linear_velocity.x.v[lane] = slot.biased_linear_velocity.x;
+		r_bodies.biased_linear_velocity.y.v[lane] = slot.biased_linear_velocity.y;
+		r_bodies.biased_linear_velocity.z.v[lane] = slot.biased_linear_velocity.z;
+		r_bodies.biased_angular_velocity.x.v[lane] = slot.biased_angular_velocity.x;
+		r_bodies.biased_angular_velocity.y.v[lane] = slot.biased_angular_velocity.y;
+		r_bodies.biased_angular_velocity.z.v[lane] = slot.biased_angular_velocity.z;
+	}
+}
+
+void ContactSolver3DSW::_scatter(uint32_t p_lane_count, const uint32_t *p_slots, const bool *p_writes, const LaneBodies &p_bodies) {
+	for (uint32_t lane = 0; lane < p_lane_count; ++lane) {
+		if (!p_writes[lane]) {
+			continue;
+		}
+
+		BodySlot &slot = slots[p_slots[lane]];
+		slot.linear_velocity = Vector3(p_bodies.linear_velocity.x.v[lane], p_bodies.linear_velocity.y.v[lane], p_bodies.linear_velocity.z.v[lane]);
+		slot.angular_velocity = Vector3(p_bodies.angular_velocity.x.v[lane], p_bodies.angular_velocity.y.v[lane], p_bodies.angular_velocity.z.v[lane]);
+		slot.biased_linear_velocity = Vector3(p_bodies.biased_linear_velocity.x.v[lane], p_bodies.biased_linear_velocity.y.v[lane], p_bodies.biased_linear_velocity.z.v[lane]);
+		slot.biased_angular_velocity = Vector3(p_bodies.biased_angular_velocity.x.v[lane], p_bodies.biased_angular_velocity.y.v[lane], p_bodies.biased_angular_velocity.z.v[lane]);
+	}
+}
+
+void ContactSolver3DSW::_solve_block(Block &p_block, real_t p_max_bias_av) {
+	LaneBodies A;
+	LaneBodies B;
+	_gather(p_block.slot_A, p_block.writes_A, A);
+	_gather(p_block.slot_B, p_block.writes_B, B);
+
+	// Same math as BodyPair3DSW::solve(), with the branches turned into selects.
+
+	const LaneReal3D zero = LaneReal3D::splat(0.0);
+	const LaneReal3D one = LaneReal3D::splat(1.0);
+	const LaneReal3D min_velocity = LaneReal3D::splat(MIN_VELOCITY);
+	const LaneReal3D max_bias_av = LaneReal3D::splat(p_max_bias_av);
+
+	const LaneMask3D active = LaneMask3D::load(p_block.active);
+	const LaneVector3 normal = LaneVector3::load(p_block.normal);
+	const LaneVector3 rA = LaneVector3::load(p_block.rA);
+	const LaneVector3 rB = LaneVector3::load(p_block.rB);
+	const LaneReal3D mass_normal = LaneReal3D::load(p_block.mass_normal);
+	const LaneReal3D bias = LaneReal3D::load(p_block.bias);
+	const LaneReal3D inv_mass_sum = A.inv_mass + B.inv_mass;
+
+	// Bias impulse.
+
+	LaneVector3 dbv = B.biased_linear_velocity + B.biased_angular_velocity.cross(rB) - A.biased_linear_velocity - A.biased_angular_velocity.cross(rA);
+	LaneReal3D vbn = dbv.dot(normal);
+
+	const LaneMask3D apply_bias = active && lane_abs(bias - vbn) > min_velocity;
+
+	LaneReal3D jbn = (bias - vbn) * mass_normal;
+	LaneReal3D jbnOld = LaneReal3D::load(p_block.acc_bias_impulse);
+	LaneReal3D acc_bias_impulse = lane_select(apply_bias, lane_max(jbnOld + jbn, zero), jbnOld);
+	LaneVector3 jb = normal * (acc_bias_impulse - jbnOld);
+
+	LaneVector3 delta_bavA = A.inv_inertia_tensor.xform(rA.cross(-jb));
+	LaneVector3 delta_bavB = B.inv_inertia_tensor.xform(rB.cross(jb));
+	LaneReal3D delta_bavA_length = delta_bavA.length();
+	LaneReal3D delta_bavB_length = delta_bavB.length();
+	delta_bavA = LaneVector3::select(delta_bavA_length > max_bias_av, delta_bavA * (max_bias_av / delta_bavA_length), delta_bavA);
+	delta_bavB = LaneVector3::select(delta_bavB_length > max_bias_av, delta_bavB * (max_bias_av / delta_bavB_length), delta_bavB);
+
+	A.biased_linear_velocity = A.biased_linear_velocity - jb * A.inv_mass;
+	A.biased_angular_velocity = A.biased_angular_velocity + delta_bavA;
+	B.biased_linear_velocity = B.biased_linear_velocity + jb * B.inv_mass;
+	B.biased_angular_velocity = B.biased_angular_velocity + delta_bavB;
+
+	dbv = B.biased_linear_velocity + B.biased_angular_velocity.cross(rB) - A.biased_linear_velocity - A.biased_angular_velocity.cross(rA);
+	vbn = dbv.dot(normal);
+
+	const LaneMask3D apply_bias_com = apply_bias && lane_abs(bias - vbn) > min_velocity;
+
+	LaneReal3D jbn_com = (bias - vbn) / lane_select(apply_bias_com, inv_mass_sum, one);
+	LaneReal3D jbnOld_com = LaneReal3D::load(p_block.acc_bias_impulse_center_of_mass);
+	LaneReal3D acc_bias_impulse_com = lane_select(apply_bias_com, lane_max(jbnOld_com + jbn_com, zero), jbnOld_com);
+	LaneVector3 jb_com = normal * (acc_bias_impulse_com - jbnOld_com);
+
+	A.biased_linear_velocity = A.biased_linear_velocity - jb_com * A.inv_mass;
+	B.biased_linear_velocity = B.biased_linear_velocity + jb_com * B.inv_mass;
+
+	// Normal impulse.
+
+	LaneVector3 dv = B.linear_velocity + B.angular_velocity.cross(rB) - A.linear_velocity - A.angular_velocity.cross(rA);
+	LaneReal3D vn = dv.dot(normal);
+
+	const LaneMask3D apply_normal = active && lane_abs(vn) > min_velocity;
+
+	LaneReal3D jn = -(LaneReal3D::load(p_block.bounce) + vn) * mass_normal;
+	LaneReal3D jnOld = LaneReal3D::load(p_block.acc_normal_impulse);
+	LaneReal3D acc_normal_impulse = lane_select(apply_normal, lane_max(jnOld + jn, zero), jnOld);
+	LaneVector3 j = normal * (acc_normal_impulse - jnOld);
+
+	A.linear_velocity = A.linear_velocity - j * A.inv_mass;
+	A.angular_velocity = A.angular_velocity + A.inv_inertia_tensor.xform(rA.cross(-j));
+	B.linear_velocity = B.linear_velocity + j * B.inv_mass;
+	B.angular_velocity = B.angular_velocity + B.inv_inertia_tensor.xform(rB.cross(j));
+
+	// Friction impulse.
+
+	LaneVector3 dtv = B.linear_velocity + B.angular_velocity.cross(rB) - A.linear_velocity - A.angular_velocity.cross(rA);
+	LaneReal3D tn = normal.dot(dtv);
+
+	// Tangential velocity.
+	LaneVector3 tv = dtv - normal * tn;
+	LaneReal3D tvl = tv.length();
+
+	const LaneMask3D apply_friction = active && tvl > min_velocity;
+
+	tv = tv / lane_select(apply_friction, tvl, one);
+
+	LaneVector3 temp1 = A.inv_inertia_tensor.xform(rA.cross(tv));
+	LaneVector3 temp2 = B.inv_inertia_tensor.xform(rB.cross(tv));
+
+	LaneReal3D t = -tvl / lane_select(apply_friction, inv_mass_sum + tv.dot(temp1.cross(rA) + temp2.cross(rB)), one);
+
+	LaneVector3 jtOld = LaneVector3::load(p_block.acc_tangent_impulse);
+	LaneVector3 acc_tangent_impulse = jtOld + tv * t;
+
+	LaneReal3D fi_len = acc_tangent_impulse.length();
+	LaneReal3D jtMax = acc_normal_impulse * LaneReal3D::load(p_block.friction);
+
+	const LaneMask3D limit_friction = fi_len > LaneReal3D::splat(CMP_EPSILON) && fi_len > jtMax;
+	acc_tangent_impulse = LaneVector3::select(limit_friction, acc_tangent_impulse * (jtMax / lane_select(limit_friction, fi_len, one)), acc_tangent_impulse);
+	acc_tangent_impulse = LaneVector3::select(apply_friction, acc_tangent_impulse, jtOld);
+
+	LaneVector3 jt = acc_tangent_impulse - jtOld;
+
+	A.linear_velocity = A.linear_velocity - jt * A.inv_mass;
+	A.angular_velocity = A.angular_velocity + A.inv_inertia_tensor.xform(rA.cross(-jt));
+	B.linear_velocity = B.linear_velocity + jt * B.inv_mass;
+	B.angular_velocity = B.angular_velocity + B.inv_inertia_tensor.xform(rB.cross(jt));
+
+	// Contacts stay active as long as they apply impulses.
+	(apply_bias || apply_normal || apply_friction).store(p_block.active);
+	acc_bias_impulse.store(p_block.acc_bias_impulse);
+	acc_bias_impulse_com.store(p_block.acc_bias_impulse_center_of_mass);
+	acc_normal_impulse.store(p_block.acc_normal_impulse);
+	acc_tangent_impulse.store(p_block.acc_tangent_impulse);
+
+	_scatter(p_block.lane_count, p_block.slot_A, p_block.writes_A, A);
+	_scatter(p_block.lane_count, p_block.slot_B, p_block.writes_B, B);
+}
+
+void ContactSolver3DSW::solve(real_t p_step) {
+	const real_t max_bias_av = MAX_BIAS_ROTATION / p_step;
+
+	uint32_t block_count = blocks.size();
+	for (uint32_t block_index = 0; block_index < block_count; ++block_index) {
+		_solve_block(blocks[block_index], max_bias_av);
+	}
+}
+
+void ContactSolver3DSW::finish() {
+	uint32_t block_count = blocks.size();
+	for (uint32_t block_index = 0; block_index < block_count; ++block_index) {
+		const Block &block = blocks[block_index];
+		for (uint32_t lane = 0; lane < block.lane_count; ++lane) {
+			BodyContact3DSW::Contact *contact = block.contact[lane];
+			contact->active = block.active[lane];
+			contact->acc_normal_impulse = block.acc_normal_impulse[lane];
+			contact->acc_tangent_impulse = Vector3(block.acc_tangent_impulse[0][lane], block.acc_tangent_impulse[1][lane], block.acc_tangent_impulse[2][lane]);
+			contact->acc_bias_impulse = block.acc_bias_impulse[lane];
+			contact->acc_bias_impulse_center_of_mass = block.acc_bias_impulse_center_of_mass[lane];
+		}
+	}
+
+	for (uint32_t slot_index = 1; slot_index < slots.size(); ++slot_index) {
+		if (slots[slot_index].write_back) {
+			slots[slot_index].body->set_contact_solver_index(-1);
+		}
+	}
+}
@@ -1630,8 +1630,11 @@ void PhysicsServer3DSW::flush_queries() {
 			"integrate_forces",
 			"generate_islands",
 			"setup_constraints",
+			"pre_solve_constraints",
 			"solve_constraints",
-			"integrate_velocities"
+			"integrate_velocities",
+			"sleep_islands",
+			"solve_soft_bodies"
 		};
 
 		for (int i = 0; i < Space3DSW::ELAPSED_TIME_MAX; i++) {
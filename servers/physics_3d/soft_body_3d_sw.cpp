@@ -192,17 +192,17 @@ void SoftBody3DSW::update_normals() {
 }
 
 void SoftBody3DSW::update_bounds() {
+	update_bounds_shape(compute_bounds());
+}
+
+// Returns true if a node moved out of the previous bounds.
+bool SoftBody3DSW::compute_bounds() {
 	AABB prev_bounds = bounds;
 	prev_bounds.grow_by(collision_margin);
 
 	bounds = AABB();
 
 	const uint32_t nodes_count = nodes.size();
-	if (nodes_count == 0) {
-		deinitialize_shape();
-		return;
-	}
-
 	bool first = true;
 	bool moved = false;
 	for (uint32_t node_index = 0; node_index < nodes_count; ++node_index) {
@@ -218,8 +218,17 @@ void SoftBody3DSW::update_bounds() {
 		}
 	}
 
+	return moved;
+}
+
+void SoftBody3DSW::update_bounds_shape(bool p_moved) {
+	if (nodes.size() == 0) {
+		deinitialize_shape();
+		return;
+	}
+
 	if (get_space()) {
-		initialize_shape(moved);
+		initialize_shape(p_moved);
 	}
 }
 
@@ -961,7 +970,9 @@ void SoftBody3DSW::predict_motion(real_t p_delta) {
 	}
 
 	// Bounds and tree update.
-	update_bounds();
+	// The shape is updated in apply_deferred_updates(), as it also moves it in the broadphase.
+	deferred_bounds_moved = compute_bounds();
+	deferred_bounds_update = true;
 
 	// Node tree update.
 	for (i = 0, ni = nodes.size(); i < ni; ++i) {
@@ -1021,6 +1032,13 @@ void SoftBody3DSW::solve_constraints(real_t p_delta) {
 	update_normals();
 }
 
+void SoftBody3DSW::apply_deferred_updates() {
+	if (deferred_bounds_update) {
+		deferred_bounds_update = false;
+		update_bounds_shape(deferred_bounds_moved);
+	}
+}
+
 void SoftBody3DSW::solve_links(real_t kst, real_t ti) {
 	for (uint32_t i = 0, ni = links.size(); i < ni; ++i) {
 		Link &link = links[i];
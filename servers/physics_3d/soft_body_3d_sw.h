@@ -36,6 +36,7 @@
 #include "core/math/aabb.h"
 #include "core/math/dynamic_bvh.h"
 #include "core/math/vector3.h"
+#include "core/templates/flat_set.h"
 #include "core/templates/local_vector.h"
 #include "core/templates/set.h"
 #include "core/templates/vset.h"
@@ -102,12 +103,16 @@ class SoftBody3DSW : public CollisionObject3DSW {
 
 	SelfList<SoftBody3DSW> active_list;
 
-	Set<Constraint3DSW *> constraints;
+	FlatSet<Constraint3DSW *> constraints;
 
 	VSet<RID> exceptions;
 
 	uint64_t island_step = 0;
 
+	// Shape update recorded by predict_motion(), applied by apply_deferred_updates().
+	bool deferred_bounds_update = false;
+	bool deferred_bounds_moved = false;
+
 public:
 	SoftBody3DSW();
 
@@ -118,7 +123,7 @@ public:
 
 	_FORCE_INLINE_ void add_constraint(Constraint3DSW *p_constraint) { constraints.insert(p_constraint); }
 	_FORCE_INLINE_ void remove_constraint(Constraint3DSW *p_constraint) { constraints.erase(p_constraint); }
-	_FORCE_INLINE_ const Set<Constraint3DSW *> &get_constraints() const { return constraints; }
+	_FORCE_INLINE_ const FlatSet<Constraint3DSW *> &get_constraints() const { return constraints; }
 	_FORCE_INLINE_ void clear_constraints() { constraints.clear(); }
 
 	_FORCE_INLINE_ void add_exception(const RID &p_exception) { exceptions.insert(p_exception); }
@@ -179,6 +184,7 @@ public:
 
 	void predict_motion(real_t p_delta);
 	void solve_constraints(real_t p_delta);
+	void apply_deferred_updates();
 
 	_FORCE_INLINE_ uint32_t get_node_index(void *p_node) const { return ((Node *)p_node)->index; }
 	_FORCE_INLINE_ uint32_t get_face_index(void *p_face) const { return ((Face *)p_face)->index; }
@@ -196,6 +202,8 @@ protected:
 private:
 	void update_normals();
 	void update_bounds();
+	bool compute_bounds();
+	void update_bounds_shape(bool p_moved);
 	void update_constants();
 	void update_area();
 	void reset_link_rest_lengths();
@@ -32,6 +32,7 @@
 
 #include "collision_solver_3d_sw.h"
 #include "core/config/project_settings.h"
+#include "core/os/worker_thread_pool.h"
 #include "physics_server_3d_sw.h"
 
 _FORCE_INLINE_ static bool _can_collide_with(CollisionObject3DSW *p_object, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
@@ -54,6 +55,26 @@ _FORCE_INLINE_ static bool _can_collide_with(CollisionObject3DSW *p_object, uint
 	return true;
 }
 
+// Intersects a segment with a shape of an object, giving the point and normal in world space.
+_FORCE_INLINE_ static bool _intersect_segment_with_shape(const CollisionObject3DSW *p_object, int p_shape_idx, const Vector3 &p_from, const Vector3 &p_to, Vector3 &r_point, Vector3 &r_normal) {
+	Transform3D inv_xform = p_object->get_shape_inv_transform(p_shape_idx) * p_object->get_inv_transform();
+
+	Vector3 local_from = inv_xform.xform(p_from);
+	Vector3 local_to = inv_xform.xform(p_to);
+
+	const Shape3DSW *shape = p_object->get_shape(p_shape_idx);
+
+	Vector3 shape_point, shape_normal;
+	if (!shape->intersect_segment(local_from, local_to, shape_point, shape_normal)) {
+		return false;
+	}
+
+	Transform3D xform = p_object->get_transform() * p_object->get_shape_transform(p_shape_idx);
+	r_point = xform.xform(shape_point);
+	r_normal = inv_xform.basis.xform_inv(shape_normal).normalized();
+	return true;
+}
+
 int PhysicsDirectSpaceState3DSW::intersect_point(const Vector3 &p_point, ShapeResult *r_results, int p_result_max, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
 	ERR_FAIL_COND_V(space->locked, false);
 	int amount = space->broadphase->cull_point(p_point, space->intersection_query_results, Space3DSW::INTERSECTION_QUERY_MAX, space->intersection_query_subindex_results);
@@ -134,27 +155,17 @@ bool PhysicsDirectSpaceState3DSW::intersect_ray(const Vector3 &p_from, const Vec
 		}
 
 		const CollisionObject3DSW *col_obj = space->intersection_query_results[i];
-
 		int shape_idx = space->intersection_query_subindex_results[i];
-		Transform3D inv_xform = col_obj->get_shape_inv_transform(shape_idx) * col_obj->get_inv_transform();
-
-		Vector3 local_from = inv_xform.xform(begin);
-		Vector3 local_to = inv_xform.xform(end);
-
-		const Shape3DSW *shape = col_obj->get_shape(shape_idx);
 
 		Vector3 shape_point, shape_normal;
 
-		if (shape->intersect_segment(local_from, local_to, shape_point, shape_normal)) {
-			Transform3D xform = col_obj->get_transform() * col_obj->get_shape_transform(shape_idx);
-			shape_point = xform.xform(shape_point);
-
+		if (_intersect_segment_with_shape(col_obj, shape_idx, begin, end, shape_point, shape_normal)) {
 			real_t ld = normal.dot(shape_point);
 
 			if (ld < min_d) {
 				min_d = ld;
 				res_point = shape_point;
-				res_normal = inv_xform.basis.xform_inv(shape_normal).normalized();
+				res_normal = shape_normal;
 				res_shape = shape_idx;
 				res_obj = col_obj;
 				collided = true;
@@ -235,121 +246,121 @@ int PhysicsDirectSpaceState3DSW::intersect_shape(const RID &p_shape, const Trans
 	return cc;
 }
 
-bool PhysicsDirectSpaceState3DSW::cast_motion(const RID &p_shape, const Transform3D &p_xform, const Vector3 &p_motion, real_t p_margin, real_t &p_closest_safe, real_t &p_closest_unsafe, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas, ShapeRestInfo *r_info) {
-	Shape3DSW *shape = PhysicsServer3DSW::singletonsw->shape_owner.getornull(p_shape);
-	ERR_FAIL_COND_V(!shape, false);
+void PhysicsDirectSpaceState3DSW::_cast_motion_against_shape(CastMotionState &r_state, const CollisionObject3DSW *p_col_obj, int p_shape_idx) {
+	MotionShape3DSW mshape;
+	mshape.shape = r_state.shape;
+	mshape.motion = r_state.xform_inv.basis.xform(r_state.motion);
 
-	AABB aabb = p_xform.xform(shape->get_aabb());
-	aabb = aabb.merge(AABB(aabb.position + p_motion, aabb.size)); //motion
-	aabb = aabb.grow(p_margin);
+	Vector3 point_A, point_B;
+	Vector3 sep_axis = r_state.motion_normal;
 
-	int amount = space->broadphase->cull_aabb(aabb, space->intersection_query_results, Space3DSW::INTERSECTION_QUERY_MAX, space->intersection_query_subindex_results);
+	Transform3D col_obj_xform = p_col_obj->get_transform() * p_col_obj->get_shape_transform(p_shape_idx);
+	//test initial overlap, does it collide if going all the way?
+	if (CollisionSolver3DSW::solve_distance(&mshape, r_state.xform, p_col_obj->get_shape(p_shape_idx), col_obj_xform, point_A, point_B, r_state.aabb, &sep_axis)) {
+		return;
+	}
 
-	real_t best_safe = 1;
-	real_t best_unsafe = 1;
+	//test initial overlap, ignore objects it's inside of.
+	sep_axis = r_state.motion_normal;
 
-	Transform3D xform_inv = p_xform.affine_inverse();
-	MotionShape3DSW mshape;
-	mshape.shape = shape;
-	mshape.motion = xform_inv.basis.xform(p_motion);
+	if (!CollisionSolver3DSW::solve_distance(r_state.shape, r_state.xform, p_col_obj->get_shape(p_shape_idx), col_obj_xform, point_A, point_B, r_state.aabb, &sep_axis)) {
+		return;
+	}
 
-	bool best_first = true;
+	//just do kinematic solving
+	real_t low = 0.0;
+	real_t hi = 1.0;
+	real_t fraction_coeff = 0.5;
+	for (int j = 0; j < 8; j++) { //steps should be customizable..
+		real_t fraction = low + (hi - low) * fraction_coeff;
 
-	Vector3 motion_normal = p_motion.normalized();
+		mshape.motion = r_state.xform_inv.basis.xform(r_state.motion * fraction);
 
-	Vector3 closest_A, closest_B;
+		Vector3 lA, lB;
+		Vector3 sep = r_state.motion_normal; //important optimization for this to work fast enough
+		bool collided = !CollisionSolver3DSW::solve_distance(&mshape, r_state.xform, p_col_obj->get_shape(p_shape_idx), col_obj_xform, lA, lB, r_state.aabb, &sep);
 
-	for (int i = 0; i < amount; i++) {
-		if (!_can_collide_with(space->intersection_query_results[i], p_collision_mask, p_collide_with_bodies, p_collide_with_areas)) {
-			continue;
+		if (collided) {
+			hi = fraction;
+			if ((j == 0) || (low > 0.0)) { // Did it not collide before?
+				// When alternating or first iteration, use dichotomy.
+				fraction_coeff = 0.5;
+			} else {
+				// When colliding again, converge faster towards low fraction
+				// for more accurate results with long motions that collide near the start.
+				fraction_coeff = 0.25;
+			}
+		} else {
+			point_A = lA;
+			point_B = lB;
+			low = fraction;
+			if ((j == 0) || (hi < 1.0)) { // Did it collide before?
+				// When alternating or first iteration, use dichotomy.
+				fraction_coeff = 0.5;
+			} else {
+				// When not colliding again, converge faster towards high fraction
+				// for more accurate results with long motions that collide near the end.
+				fraction_coeff = 0.75;
+			}
 		}
+	}
 
-		if (p_exclude.has(space->intersection_query_results[i]->get_self())) {
-			continue; //ignore excluded
+	if (low < r_state.best_safe) {
+		r_state.best_first = true; //force reset
+		r_state.best_safe = low;
+		r_state.best_unsafe = hi;
+	}
+
+	if (r_state.info && (r_state.best_first || (point_A.distance_squared_to(point_B) < r_state.closest_A.distance_squared_to(r_state.closest_B) && low <= r_state.best_safe))) {
+		r_state.closest_A = point_A;
+		r_state.closest_B = point_B;
+		r_state.info->collider_id = p_col_obj->get_instance_id();
+		r_state.info->rid = p_col_obj->get_self();
+		r_state.info->shape = p_shape_idx;
+		r_state.info->point = r_state.closest_B;
+		r_state.info->normal = (r_state.closest_A - r_state.closest_B).normalized();
+		r_state.best_first = false;
+		if (p_col_obj->get_type() == CollisionObject3DSW::TYPE_BODY) {
+			const Body3DSW *body = static_cast<const Body3DSW *>(p_col_obj);
+			Vector3 rel_vec = r_state.closest_B - (body->get_transform().origin + body->get_center_of_mass());
+			r_state.info->linear_velocity = body->get_linear_velocity() + (body->get_angular_velocity()).cross(rel_vec);
 		}
+	}
+}
 
-		const CollisionObject3DSW *col_obj = space->intersection_query_results[i];
-		int shape_idx = space->intersection_query_subindex_results[i];
+bool PhysicsDirectSpaceState3DSW::cast_motion(const RID &p_shape, const Transform3D &p_xform, const Vector3 &p_motion, real_t p_margin, real_t &p_closest_safe, real_t &p_closest_unsafe, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas, ShapeRestInfo *r_info) {
+	Shape3DSW *shape = PhysicsServer3DSW::singletonsw->shape_owner.getornull(p_shape);
+	ERR_FAIL_COND_V(!shape, false);
 
-		Vector3 point_A, point_B;
-		Vector3 sep_axis = motion_normal;
+	AABB aabb = p_xform.xform(shape->get_aabb());
+	aabb = aabb.merge(AABB(aabb.position + p_motion, aabb.size)); //motion
+	aabb = aabb.grow(p_margin);
 
-		Transform3D col_obj_xform = col_obj->get_transform() * col_obj->get_shape_transform(shape_idx);
-		//test initial overlap, does it collide if going all the way?
-		if (CollisionSolver3DSW::solve_distance(&mshape, p_xform, col_obj->get_shape(shape_idx), col_obj_xform, point_A, point_B, aabb, &sep_axis)) {
-			continue;
-		}
+	int amount = space->broadphase->cull_aabb(aabb, space->intersection_query_results, Space3DSW::INTERSECTION_QUERY_MAX, space->intersection_query_subindex_results);
 
-		//test initial overlap, ignore objects it's inside of.
-		sep_axis = motion_normal;
+	CastMotionState state;
+	state.shape = shape;
+	state.xform = p_xform;
+	state.xform_inv = p_xform.affine_inverse();
+	state.motion = p_motion;
+	state.motion_normal = p_motion.normalized();
+	state.aabb = aabb;
+	state.info = r_info;
 
-		if (!CollisionSolver3DSW::solve_distance(shape, p_xform, col_obj->get_shape(shape_idx), col_obj_xform, point_A, point_B, aabb, &sep_axis)) {
+	for (int i = 0; i < amount; i++) {
+		if (!_can_collide_with(space->intersection_query_results[i], p_collision_mask, p_collide_with_bodies, p_collide_with_areas)) {
 			continue;
 		}
 
-		//just do kinematic solving
-		real_t low = 0.0;
-		real_t hi = 1.0;
-		real_t fraction_coeff = 0.5;
-		for (int j = 0; j < 8; j++) { //steps should be customizable..
-			real_t fraction = low + (hi - low) * fraction_coeff;
-
-			mshape.motion = xform_inv.basis.xform(p_motion * fraction);
-
-			Vector3 lA, lB;
-			Vector3 sep = motion_normal; //important optimization for this to work fast enough
-			bool collided = !CollisionSolver3DSW::solve_distance(&mshape, p_xform, col_obj->get_shape(shape_idx), col_obj_xform, lA, lB, aabb, &sep);
-
-			if (collided) {
-				hi = fraction;
-				if ((j == 0) || (low > 0.0)) { // Did it not collide before?
-					// When alternating or first iteration, use dichotomy.
-					fraction_coeff = 0.5;
-				} else {
-					// When colliding again, converge faster towards low fraction
-					// for more accurate results with long motions that collide near the start.
-					fraction_coeff = 0.25;
-				}
-			} else {
-				point_A = lA;
-				point_B = lB;
-				low = fraction;
-				if ((j == 0) || (hi < 1.0)) { // Did it collide before?
-					// When alternating or first iteration, use dichotomy.
-					fraction_coeff = 0.5;
-				} else {
-					// When not colliding again, converge faster towards high fraction
-					// for more accurate results with long motions that collide near the end.
-					fraction_coeff = 0.75;
-				}
-			}
-		}
-
-		if (low < best_safe) {
-			best_first = true; //force reset
-			best_safe = low;
-			best_unsafe = hi;
+		if (p_exclude.has(space->intersection_query_results[i]->get_self())) {
+			continue; //ignore excluded
 		}
 
-		if (r_info && (best_first || (point_A.distance_squared_to(point_B) < closest_A.distance_squared_to(closest_B) && low <= best_safe))) {
-			closest_A = point_A;
-			closest_B = point_B;
-			r_info->collider_id = col_obj->get_instance_id();
-			r_info->rid = col_obj->get_self();
-			r_info->shape = shape_idx;
-			r_info->point = closest_B;
-			r_info->normal = (closest_A - closest_B).normalized();
-			best_first = false;
-			if (col_obj->get_type() == CollisionObject3DSW::TYPE_BODY) {
-				const Body3DSW *body = static_cast<const Body3DSW *>(col_obj);
-				Vector3 rel_vec = closest_B - (body->get_transform().origin + body->get_center_of_mass());
-				r_info->linear_velocity = body->get_linear_velocity() + (body->get_angular_velocity()).cross(rel_vec);
-			}
-		}
+		_cast_motion_against_shape(state, space->intersection_query_results[i], space->intersection_query_subindex_results[i]);
 	}
 
-	p_closest_safe = best_safe;
-	p_closest_unsafe = best_unsafe;
+	p_closest_safe = state.best_safe;
+	p_closest_unsafe = state.best_unsafe;
 
 	return true;
 }
@@ -531,6 +542,323 @@ Vector3 PhysicsDirectSpaceState3DSW::get_closest_point_to_object_volume(RID p_ob
 	}
 }
 
+// Spreads the lower 10 bits of a value so that there are two zero bits between each bit.
+_FORCE_INLINE_ static uint32_t _morton_expand_bits(uint32_t p_value) {
+	p_value = (p_value * 0x00010001u) & 0xFF0000FFu;
+	p_value = (p_value * 0x00000101u) & 0x0F00F00Fu;
+	p_value = (p_value * 0x00000011u) & 0xC30C30C3u;
+	p_value = (p_value * 0x00000005u) & 0x49249249u;
+	return p_value;
+}
+
+struct QueryBatchSortKey {
+	uint32_t code;
+	uint32_t index;
+
+	_FORCE_INLINE_ bool operator<(const QueryBatchSortKey &p_other) const {
+		return code == p_other.code ? index < p_other.index : code < p_other.code;
+	}
+};
+
+void PhysicsDirectSpaceState3DSW::_cull_query_batch(QueryBatch &r_batch, uint32_t p_begin, uint32_t p_end) {
+	AABB aabb = r_batch.aabbs[r_batch.order[p_begin]];
+	for (uint32_t i = p_begin + 1; i < p_end; i++) {
+		aabb.merge_with(r_batch.aabbs[r_batch.order[i]]);
+	}
+
+	int amount = space->broadphase->cull_aabb(aabb, space->intersection_query_results, Space3DSW::INTERSECTION_QUERY_MAX, space->intersection_query_subindex_results);
+
+	if (amount >= Space3DSW::INTERSECTION_QUERY_MAX && p_end - p_begin > 1) {
+		// Results may have been dropped, cull each half on its own.
+		uint32_t middle = (p_begin + p_end) / 2;
+		_cull_query_batch(r_batch, p_begin, middle);
+		_cull_query_batch(r_batch, middle, p_end);
+		return;
+	}
+
+	QueryBatchChunk chunk;
+	chunk.query_begin = p_begin;
+	chunk.query_end = p_end;
+	chunk.candidate_begin = r_batch.candidates.size();
+
+	for (int i = 0; i < amount; i++) {
+		CollisionObject3DSW *col_obj = space->intersection_query_results[i];
+		if (!_can_collide_with(col_obj, r_batch.collision_mask, r_batch.collide_with_bodies, r_batch.collide_with_areas)) {
+			continue;
+		}
+		if (r_batch.exclude->has(col_obj->get_self())) {
+			continue;
+		}
+
+		QueryBatchCandidate candidate;
+		candidate.object = col_obj;
+		candidate.shape = space->intersection_query_subindex_results[i];
+		r_batch.candidates.push_back(candidate);
+	}
+
+	chunk.candidate_end = r_batch.candidates.size();
+	r_batch.chunks.push_back(chunk);
+}
+
+void PhysicsDirectSpaceState3DSW::_build_query_batch(QueryBatch &r_batch) {
+	uint32_t query_count = r_batch.aabbs.size();
+
+	AABB bounds = r_batch.aabbs[0];
+	for (uint32_t i = 1; i < query_count; i++) {
+		bounds.merge_with(r_batch.aabbs[i]);
+	}
+
+	// Sort the queries along a Morton curve, so nearby queries end up in the same chunk.
+	Vector3 scale;
+	for (int axis = 0; axis < 3; axis++) {
+		scale[axis] = bounds.size[axis] > CMP_EPSILON ? 1023.0 / bounds.size[axis] : 0.0;
+	}
+
+	LocalVector<QueryBatchSortKey> keys;
+	keys.resize(query_count);
+	for (uint32_t i = 0; i < query_count; i++) {
+		Vector3 cell = (r_batch.aabbs[i].position + r_batch.aabbs[i].size * 0.5 - bounds.position) * scale;
+		keys[i].code = (_morton_expand_bits((uint32_t)cell.x) << 2) | (_morton_expand_bits((uint32_t)cell.y) << 1) | _morton_expand_bits((uint32_t)cell.z);
+		keys[i].index = i;
+	}
+	keys.sort();
+
+	r_batch.order.resize(query_count);
+	for (uint32_t i = 0; i < query_count; i++) {
+		r_batch.order[i] = keys[i].index;
+	}
+
+	for (uint32_t begin = 0; begin < query_count; begin += QUERY_BATCH_CHUNK_SIZE) {
+		_cull_query_batch(r_batch, begin, MIN(begin + (uint32_t)QUERY_BATCH_CHUNK_SIZE, query_count));
+	}
+}
+
+void PhysicsDirectSpaceState3DSW::_run_query_batch(QueryBatch &p_batch, void (PhysicsDirectSpaceState3DSW::*p_method)(uint32_t, QueryBatch *)) {
+	uint32_t chunk_count = p_batch.chunks.size();
+	if (chunk_count == 1) {
+		(this->*p_method)(0, &p_batch);
+		return;
+	}
+
+	WorkerThreadPool::GroupID group_task = WorkerThreadPool::get_singleton()->add_template_group_task(this, p_method, &p_batch, chunk_count);
+	WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group_task);
+}
+
+void PhysicsDirectSpaceState3DSW::_intersect_ray_batch_chunk(uint32_t p_chunk_index, QueryBatch *p_batch) {
+	const QueryBatchChunk &chunk = p_batch->chunks[p_chunk_index];
+
+	for (uint32_t i = chunk.query_begin; i < chunk.query_end; i++) {
+		uint32_t query_index = p_batch->order[i];
+		const Vector3 &from = p_batch->from[query_index];
+		const Vector3 &to = p_batch->to[query_index];
+		Vector3 normal = (to - from).normalized();
+
+		RayResult &result = p_batch->ray_results[query_index];
+		result = RayResult();
+		result.shape = -1;
+
+		const CollisionObject3DSW *res_obj = nullptr;
+		real_t min_d = 1e10;
+
+		for (uint32_t j = chunk.candidate_begin; j < chunk.candidate_end; j++) {
+			const QueryBatchCandidate &candidate = p_batch->candidates[j];
+			if (!candidate.object->get_shape_aabb(candidate.shape).intersects_segment(from, to)) {
+				continue;
+			}
+
+			Vector3 shape_point, shape_normal;
+			if (!_intersect_segment_with_shape(candidate.object, candidate.shape, from, to, shape_point, shape_normal)) {
+				continue;
+			}
+
+			real_t ld = normal.dot(shape_point);
+			if (ld < min_d) {
+				min_d = ld;
+				result.position = shape_point;
+				result.normal = shape_normal;
+				result.shape = candidate.shape;
+				res_obj = candidate.object;
+			}
+		}
+
+		if (res_obj) {
+			result.collider_id = res_obj->get_instance_id();
+			if (result.collider_id.is_valid()) {
+				result.collider = ObjectDB::get_instance(result.collider_id);
+			}
+			result.rid = res_obj->get_self();
+		}
+	}
+}
+
+int PhysicsDirectSpaceState3DSW::intersect_ray_batch(const Vector3 *p_from, const Vector3 *p_to, int p_ray_count, RayResult *r_results, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
+	ERR_FAIL_COND_V(space->locked, 0);
+	if (p_ray_count <= 0) {
+		return 0;
+	}
+
+	QueryBatch batch;
+	batch.exclude = &p_exclude;
+	batch.collision_mask = p_collision_mask;
+	batch.collide_with_bodies = p_collide_with_bodies;
+	batch.collide_with_areas = p_collide_with_areas;
+	batch.from = p_from;
+	batch.to = p_to;
+	batch.ray_results = r_results;
+
+	batch.aabbs.resize(p_ray_count);
+	for (int i = 0; i < p_ray_count; i++) {
+		batch.aabbs[i] = AABB(p_from[i], Vector3());
+		batch.aabbs[i].expand_to(p_to[i]);
+	}
+
+	_build_query_batch(batch);
+	_run_query_batch(batch, &PhysicsDirectSpaceState3DSW::_intersect_ray_batch_chunk);
+
+	int hit_count = 0;
+	for (int i = 0; i < p_ray_count; i++) {
+		if (r_results[i].shape >= 0) {
+			hit_count++;
+		}
+	}
+	return hit_count;
+}
+
+void PhysicsDirectSpaceState3DSW::_intersect_shape_batch_chunk(uint32_t p_chunk_index, QueryBatch *p_batch) {
+	const QueryBatchChunk &chunk = p_batch->chunks[p_chunk_index];
+
+	for (uint32_t i = chunk.query_begin; i < chunk.query_end; i++) {
+		uint32_t query_index = p_batch->order[i];
+		const Transform3D &xform = p_batch->xforms[query_index];
+		const AABB &aabb = p_batch->aabbs[query_index];
+		ShapeResult *results = &p_batch->shape_results[query_index * p_batch->result_max];
+
+		int cc = 0;
+		for (uint32_t j = chunk.candidate_begin; j < chunk.candidate_end && cc < p_batch->result_max; j++) {
+			const QueryBatchCandidate &candidate = p_batch->candidates[j];
+			const CollisionObject3DSW *col_obj = candidate.object;
+			if (!col_obj->get_shape_aabb(candidate.shape).intersects(aabb)) {
+				continue;
+			}
+
+			if (!CollisionSolver3DSW::solve_static(p_batch->shape, xform, col_obj->get_shape(candidate.shape), col_obj->get_transform() * col_obj->get_shape_transform(candidate.shape), nullptr, nullptr, nullptr, p_batch->margin, 0)) {
+				continue;
+			}
+
+			results[cc].collider_id = col_obj->get_instance_id();
+			if (results[cc].collider_id.is_valid()) {
+				results[cc].collider = ObjectDB::get_instance(results[cc].collider_id);
+			} else {
+				results[cc].collider = nullptr;
+			}
+			results[cc].rid = col_obj->get_self();
+			results[cc].shape = candidate.shape;
+
+			cc++;
+		}
+
+		p_batch->result_counts[query_index] = cc;
+	}
+}
+
+void PhysicsDirectSpaceState3DSW::intersect_shape_batch(const RID &p_shape, const Transform3D *p_xforms, int p_query_count, real_t p_margin, ShapeResult *r_results, int p_result_max, int *r_result_counts, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
+	ERR_FAIL_COND(space->locked);
+	if (p_query_count <= 0) {
+		return;
+	}
+	if (p_result_max <= 0) {
+		for (int i = 0; i < p_query_count; i++) {
+			r_result_counts[i] = 0;
+		}
+		return;
+	}
+
+	Shape3DSW *shape = PhysicsServer3DSW::singletonsw->shape_owner.getornull(p_shape);
+	ERR_FAIL_COND(!shape);
+
+	QueryBatch batch;
+	batch.exclude = &p_exclude;
+	batch.collision_mask = p_collision_mask;
+	batch.collide_with_bodies = p_collide_with_bodies;
+	batch.collide_with_areas = p_collide_with_areas;
+	batch.shape = shape;
+	batch.xforms = p_xforms;
+	batch.margin = p_margin;
+	batch.shape_results = r_results;
+	batch.result_max = p_result_max;
+	batch.result_counts = r_result_counts;
+
+	batch.aabbs.resize(p_query_count);
+	for (int i = 0; i < p_query_count; i++) {
+		batch.aabbs[i] = p_xforms[i].xform(shape->get_aabb());
+	}
+
+	_build_query_batch(batch);
+	_run_query_batch(batch, &PhysicsDirectSpaceState3DSW::_intersect_shape_batch_chunk);
+}
+
+void PhysicsDirectSpaceState3DSW::_cast_motion_batch_chunk(uint32_t p_chunk_index, QueryBatch *p_batch) {
+	const QueryBatchChunk &chunk = p_batch->chunks[p_chunk_index];
+
+	for (uint32_t i = chunk.query_begin; i < chunk.query_end; i++) {
+		uint32_t query_index = p_batch->order[i];
+
+		CastMotionState state;
+		state.shape = p_batch->shape;
+		state.xform = p_batch->xforms[query_index];
+		state.xform_inv = state.xform.affine_inverse();
+		state.motion = p_batch->motions[query_index];
+		state.motion_normal = state.motion.normalized();
+		state.aabb = p_batch->aabbs[query_index];
+		state.info = p_batch->rest_infos ? &p_batch->rest_infos[query_index] : nullptr;
+
+		for (uint32_t j = chunk.candidate_begin; j < chunk.candidate_end; j++) {
+			const QueryBatchCandidate &candidate = p_batch->candidates[j];
+			if (!candidate.object->get_shape_aabb(candidate.shape).intersects(state.aabb)) {
+				continue;
+			}
+
+			_cast_motion_against_shape(state, candidate.object, candidate.shape);
+		}
+
+		p_batch->closest_safe[query_index] = state.best_safe;
+		p_batch->closest_unsafe[query_index] = state.best_unsafe;
+	}
+}
+
+void PhysicsDirectSpaceState3DSW::cast_motion_batch(const RID &p_shape, const Transform3D *p_xforms, const Vector3 *p_motions, int p_query_count, real_t p_margin, real_t *r_closest_safe, real_t *r_closest_unsafe, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas, ShapeRestInfo *r_infos) {
+	ERR_FAIL_COND(space->locked);
+	if (p_query_count <= 0) {
+		return;
+	}
+
+	Shape3DSW *shape = PhysicsServer3DSW::singletonsw->shape_owner.getornull(p_shape);
+	ERR_FAIL_COND(!shape);
+
+	QueryBatch batch;
+	batch.exclude = &p_exclude;
+	batch.collision_mask = p_collision_mask;
+	batch.collide_with_bodies = p_collide_with_bodies;
+	batch.collide_with_areas = p_collide_with_areas;
+	batch.shape = shape;
+	batch.xforms = p_xforms;
+	batch.margin = p_margin;
+	batch.motions = p_motions;
+	batch.closest_safe = r_closest_safe;
+	batch.closest_unsafe = r_closest_unsafe;
+	batch.rest_infos = r_infos;
+
+	batch.aabbs.resize(p_query_count);
+	for (int i = 0; i < p_query_count; i++) {
+		AABB aabb = p_xforms[i].xform(shape->get_aabb());
+		aabb = aabb.merge(AABB(aabb.position + p_motions[i], aabb.size));
+		batch.aabbs[i] = aabb.grow(p_margin);
+	}
+
+	_build_query_batch(batch);
+	_run_query_batch(batch, &PhysicsDirectSpaceState3DSW::_cast_motion_batch_chunk);
+}
+
 PhysicsDirectSpaceState3DSW::PhysicsDirectSpaceState3DSW() {
 	space = nullptr;
 }
@@ -1046,7 +1374,10 @@ void Space3DSW::call_queries() {
 }
 
 void Space3DSW::setup() {
-	contact_debug_count = 0;
+	contact_debug_count.set(0);
+	if (!contact_debug.is_empty()) {
+		contact_debug.ptrw(); // Ensure the buffer is not shared before adding contacts from multiple threads.
+	}
 	while (inertia_update_list.first()) {
 		inertia_update_list.first()->self()->update_inertias();
 		inertia_update_list.remove(inertia_update_list.first());
@@ -1133,7 +1464,7 @@ Space3DSW::Space3DSW() {
 	collision_pairs = 0;
 	active_objects = 0;
 	island_count = 0;
-	contact_debug_count = 0;
+	contact_debug_count.set(0);
 
 	locked = false;
 	contact_recycle_radius = 0.01;
@@ -39,12 +39,88 @@
 #include "collision_object_3d_sw.h"
 #include "core/config/project_settings.h"
 #include "core/templates/hash_map.h"
+#include "core/templates/local_vector.h"
+#include "core/templates/safe_refcount.h"
 #include "core/typedefs.h"
 #include "soft_body_3d_sw.h"
 
 class PhysicsDirectSpaceState3DSW : public PhysicsDirectSpaceState3D {
 	GDCLASS(PhysicsDirectSpaceState3DSW, PhysicsDirectSpaceState3D);
 
+	enum {
+		QUERY_BATCH_CHUNK_SIZE = 32 // Queries sharing one broadphase traversal (fewer if the culled objects overflow).
+	};
+
+	struct QueryBatchCandidate {
+		CollisionObject3DSW *object = nullptr;
+		int shape = 0;
+	};
+
+	struct QueryBatchChunk {
+		uint32_t query_begin = 0;
+		uint32_t query_end = 0;
+		uint32_t candidate_begin = 0;
+		uint32_t candidate_end = 0;
+	};
+
+	// Queries are sorted spatially and split into chunks; each chunk culls the broadphase
+	// once, serially, then the chunks are tested against their candidates in parallel.
+	struct QueryBatch {
+		const Set<RID> *exclude = nullptr;
+		uint32_t collision_mask = 0;
+		bool collide_with_bodies = true;
+		bool collide_with_areas = false;
+
+		LocalVector<AABB> aabbs;
+		LocalVector<uint32_t> order;
+		LocalVector<QueryBatchCandidate> candidates;
+		LocalVector<QueryBatchChunk> chunks;
+
+		// Ray queries.
+		const Vector3 *from = nullptr;
+		const Vector3 *to = nullptr;
+		RayResult *ray_results = nullptr;
+
+		// Shape queries.
+		Shape3DSW *shape = nullptr;
+		const Transform3D *xforms = nullptr;
+		real_t margin = 0.0;
+		ShapeResult *shape_results = nullptr;
+		int result_max = 0;
+		int *result_counts = nullptr;
+
+		// Motion queries, also using the shape, transforms and margin.
+		const Vector3 *motions = nullptr;
+		real_t *closest_safe = nullptr;
+		real_t *closest_unsafe = nullptr;
+		ShapeRestInfo *rest_infos = nullptr;
+	};
+
+	struct CastMotionState {
+		Shape3DSW *shape = nullptr;
+		Transform3D xform;
+		Transform3D xform_inv;
+		Vector3 motion;
+		Vector3 motion_normal;
+		AABB aabb;
+
+		real_t best_safe = 1.0;
+		real_t best_unsafe = 1.0;
+		bool best_first = true;
+		Vector3 closest_A;
+		Vector3 closest_B;
+		ShapeRestInfo *info = nullptr;
+	};
+
+	void _cast_motion_against_shape(CastMotionState &r_state, const CollisionObject3DSW *p_col_obj, int p_shape_idx);
+
+	void _cull_query_batch(QueryBatch &r_batch, uint32_t p_begin, uint32_t p_end);
+	void _build_query_batch(QueryBatch &r_batch);
+	void _intersect_ray_batch_chunk(uint32_t p_chunk_index, QueryBatch *p_batch);
+	void _intersect_shape_batch_chunk(uint32_t p_chunk_index, QueryBatch *p_batch);
+	void _cast_motion_batch_chunk(uint32_t p_chunk_index, QueryBatch *p_batch);
+	void _run_query_batch(QueryBatch &p_batch, void (PhysicsDirectSpaceState3DSW::*p_method)(uint32_t, QueryBatch *));
+
 public:
 	Space3DSW *space;
 
@@ -56,6 +132,10 @@ public:
 	virtual bool rest_info(RID p_shape, const Transform3D &p_shape_xform, real_t p_margin, ShapeRestInfo *r_info, const Set<RID> &p_exclude = Set<RID>(), uint32_t p_collision_mask = 0xFFFFFFFF, bool p_collide_with_bodies = true, bool p_collide_with_areas = false) override;
 	virtual Vector3 get_closest_point_to_object_volume(RID p_object, const Vector3 p_point) const override;
 
+	virtual int intersect_ray_batch(const Vector3 *p_from, const Vector3 *p_to, int p_ray_count, RayResult *r_results, const Set<RID> &p_exclude = Set<RID>(), uint32_t p_collision_mask = 0xFFFFFFFF, bool p_collide_with_bodies = true, bool p_collide_with_areas = false) override;
+	virtual void intersect_shape_batch(const RID &p_shape, const Transform3D *p_xforms, int p_query_count, real_t p_margin, ShapeResult *r_results, int p_result_max, int *r_result_counts, const Set<RID> &p_exclude = Set<RID>(), uint32_t p_collision_mask = 0xFFFFFFFF, bool p_collide_with_bodies = true, bool p_collide_with_areas = false) override;
+	virtual void cast_motion_batch(const RID &p_shape, const Transform3D *p_xforms, const Vector3 *p_motions, int p_query_count, real_t p_margin, real_t *r_closest_safe, real_t *r_closest_unsafe, const Set<RID> &p_exclude = Set<RID>(), uint32_t p_collision_mask = 0xFFFFFFFF, bool p_collide_with_bodies = true, bool p_collide_with_areas = false, ShapeRestInfo *r_infos = nullptr) override;
+
 	PhysicsDirectSpaceState3DSW();
 };
 
@@ -65,8 +145,11 @@ public:
 		ELAPSED_TIME_INTEGRATE_FORCES,
 		ELAPSED_TIME_GENERATE_ISLANDS,
 		ELAPSED_TIME_SETUP_CONSTRAINTS,
+		ELAPSED_TIME_PRE_SOLVE_CONSTRAINTS,
 		ELAPSED_TIME_SOLVE_CONSTRAINTS,
 		ELAPSED_TIME_INTEGRATE_VELOCITIES,
+		ELAPSED_TIME_SLEEP_ISLANDS,
+		ELAPSED_TIME_SOLVE_SOFT_BODIES,
 		ELAPSED_TIME_MAX
 
 	};
@@ -119,7 +202,7 @@ private:
 	RID static_global_body;
 
 	Vector<Vector3> contact_debug;
-	int contact_debug_count;
+	SafeNumeric<int> contact_debug_count;
 
 	friend class PhysicsDirectSpaceState3DSW;
 
@@ -190,12 +273,14 @@ public:
 	void set_debug_contacts(int p_amount) { contact_debug.resize(p_amount); }
 	_FORCE_INLINE_ bool is_debugging_contacts() const { return !contact_debug.is_empty(); }
 	_FORCE_INLINE_ void add_debug_contact(const Vector3 &p_contact) {
-		if (contact_debug_count < contact_debug.size()) {
-			contact_debug.write[contact_debug_count++] = p_contact;
+		// Called from the step threads, setup() made the buffer unique so writing doesn't copy it.
+		int index = contact_debug_count.postincrement();
+		if (index < contact_debug.size()) {
+			contact_debug.write[index] = p_contact;
 		}
 	}
 	_FORCE_INLINE_ Vector<Vector3> get_debug_contacts() { return contact_debug; }
-	_FORCE_INLINE_ int get_debug_contact_count() { return contact_debug_count; }
+	_FORCE_INLINE_ int get_debug_contact_count() { return MIN(contact_debug_count.get(), contact_debug.size()); }
 
 	void set_static_global_body(RID p_body) { static_global_body = p_body; }
 	RID get_static_global_body() { return static_global_body; }
@@ -32,6 +32,7 @@
 #include "joints_3d_sw.h"
 
 #include "core/os/os.h"
+#include "core/os/worker_thread_pool.h"
 
 #define BODY_ISLAND_COUNT_RESERVE 128
 #define BODY_ISLAND_SIZE_RESERVE 512
@@ -39,6 +40,20 @@
 #define ISLAND_SIZE_RESERVE 512
 #define CONSTRAINT_COUNT_RESERVE 1024
 
+// Bodies and constraints are found through pointer-keyed maps. Islands are
+// sorted by these stable keys, so the results don't depend on the heap layout.
+struct BodyIDComparator {
+	_FORCE_INLINE_ bool operator()(const Body3DSW *p_a, const Body3DSW *p_b) const {
+		return p_a->get_self().get_id() < p_b->get_self().get_id();
+	}
+};
+
+struct ConstraintIDComparator {
+	_FORCE_INLINE_ bool operator()(const Constraint3DSW *p_a, const Constraint3DSW *p_b) const {
+		return p_a->get_id() < p_b->get_id();
+	}
+};
+
 void Step3DSW::_populate_island(Body3DSW *p_body, LocalVector<Body3DSW *> &p_body_island, LocalVector<Constraint3DSW *> &p_constraint_island) {
 	p_body->set_island_step(_step);
 
@@ -47,8 +62,8 @@ void Step3DSW::_populate_island(Body3DSW *p_body, LocalVector<Body3DSW *> &p_bod
 		p_body_island.push_back(p_body);
 	}
 
-	for (Map<Constraint3DSW *, int>::Element *E = p_body->get_constraint_map().front(); E; E = E->next()) {
-		Constraint3DSW *constraint = (Constraint3DSW *)E->key();
+	for (const FlatMap<Constraint3DSW *, int>::Pair &E : p_body->get_constraint_map()) {
+		Constraint3DSW *constraint = E.key;
 		if (constraint->get_island_step() == _step) {
 			continue; // Already processed.
 		}
@@ -59,7 +74,7 @@ void Step3DSW::_populate_island(Body3DSW *p_body, LocalVector<Body3DSW *> &p_bod
 
 		// Find connected rigid bodies.
 		for (int i = 0; i < constraint->get_body_count(); i++) {
-			if (i == E->get()) {
+			if (i == E.value) {
 				continue;
 			}
 			Body3DSW *other_body = constraint->get_body_ptr()[i];
@@ -86,8 +101,7 @@ void Step3DSW::_populate_island(Body3DSW *p_body, LocalVector<Body3DSW *> &p_bod
 void Step3DSW::_populate_island_soft_body(SoftBody3DSW *p_soft_body, LocalVector<Body3DSW *> &p_body_island, LocalVector<Constraint3DSW *> &p_constraint_island) {
 	p_soft_body->set_island_step(_step);
 
-	for (Set<Constraint3DSW *>::Element *E = p_soft_body->get_constraints().front(); E; E = E->next()) {
-		Constraint3DSW *constraint = (Constraint3DSW *)E->get();
+	for (Constraint3DSW *constraint : p_soft_body->get_constraints()) {
 		if (constraint->get_island_step() == _step) {
 			continue; // Already processed.
 		}
@@ -110,36 +124,99 @@ void Step3DSW::_populate_island_soft_body(SoftBody3DSW *p_soft_body, LocalVector
 	}
 }
 
+void Step3DSW::_gather_active_bodies(Space3DSW *p_space) {
+	// Bodies are processed from arrays, as the active lists can't be split across threads.
+	active_bodies.clear();
+	const SelfList<Body3DSW> *b = p_space->get_active_body_list().first();
+	while (b) {
+		active_bodies.push_back(b->self());
+		b = b->next();
+	}
+}
+
+void Step3DSW::_integrate_forces(uint32_t p_body_index, void *p_userdata) {
+	active_bodies[p_body_index]->integrate_forces(delta);
+}
+
+void Step3DSW::_predict_soft_body_motion(uint32_t p_soft_body_index, void *p_userdata) {
+	active_soft_bodies[p_soft_body_index]->predict_motion(delta);
+}
+
 void Step3DSW::_setup_contraint(uint32_t p_constraint_index, void *p_userdata) {
 	Constraint3DSW *constraint = all_constraints[p_constraint_index];
 	constraint->setup(delta);
 }
 
-void Step3DSW::_pre_solve_island(LocalVector<Constraint3DSW *> &p_constraint_island) const {
-	uint32_t constraint_count = p_constraint_island.size();
+void Step3DSW::_pre_solve_island(uint32_t p_island_index, void *p_userdata) {
+	LocalVector<Constraint3DSW *> &constraint_island = constraint_islands[p_island_index];
+	LocalVector<Constraint3DSW *> &deferred_constraints = deferred_pre_solve_islands[p_island_index];
+	deferred_constraints.clear();
+
+	uint32_t contact_count = 0;
+
+	uint32_t constraint_count = constraint_island.size();
 	uint32_t valid_constraint_count = 0;
 	for (uint32_t constraint_index = 0; constraint_index < constraint_count; ++constraint_index) {
-		Constraint3DSW *constraint = p_constraint_island[constraint_index];
-		if (p_constraint_island[constraint_index]->pre_solve(delta)) {
+		Constraint3DSW *constraint = constraint_island[constraint_index];
+		if (!constraint->is_pre_solve_thread_safe()) {
+			// Pre-solved after all islands, on the stepping thread.
+			deferred_constraints.push_back(constraint);
+		} else if (constraint->pre_solve(delta)) {
 			// Keep this constraint for solving.
-			p_constraint_island[valid_constraint_count++] = constraint;
+			constraint_island[valid_constraint_count++] = constraint;
+			contact_count += constraint->get_batched_contact_count();
 		}
 	}
-	p_constraint_island.resize(valid_constraint_count);
+	constraint_island.resize(valid_constraint_count);
+
+	island_contact_counts[p_island_index] = contact_count;
 }
 
 void Step3DSW::_solve_island(uint32_t p_island_index, void *p_userdata) {
 	LocalVector<Constraint3DSW *> &constraint_island = constraint_islands[p_island_index];
+	ContactSolver3DSW &contact_solver = contact_solvers[p_island_index];
+
+	// Contacts are solved in batches, other constraints one by one.
+	contact_solver.clear();
+	uint32_t constraint_count = 0;
+	for (uint32_t constraint_index = 0; constraint_index < constraint_island.size(); ++constraint_index) {
+		Constraint3DSW *constraint = constraint_island[constraint_index];
+		if (!constraint->add_batched_contacts(&contact_solver)) {
+			constraint_island[constraint_count++] = constraint;
+		}
+	}
 
 	int current_priority = 1;
 
-	uint32_t constraint_count = constraint_island.size();
-	while (constraint_count > 0) {
+	bool solve_contacts = !contact_solver.is_empty();
+	if (solve_contacts) {
+		contact_solver.load_velocities();
+	}
+
+	while (constraint_count > 0 || solve_contacts) {
 		for (int i = 0; i < iterations; i++) {
+			if (solve_contacts) {
+				contact_solver.solve(delta);
+				if (constraint_count > 0) {
+					contact_solver.store_velocities();
+				}
+			}
+
 			// Go through all iterations.
 			for (uint32_t constraint_index = 0; constraint_index < constraint_count; ++constraint_index) {
 				constraint_island[constraint_index]->solve(delta);
 			}
+
+			if (solve_contacts && constraint_count > 0) {
+				contact_solver.load_velocities();
+			}
+		}
+
+		if (solve_contacts) {
+			// Contacts have the lowest priority, so they are only part of the first pass.
+			contact_solver.store_velocities();
+			contact_solver.finish();
+			solve_contacts = false;
 		}
 
 		// Check priority to keep only higher priority constraints.
@@ -156,28 +233,30 @@ void Step3DSW::_solve_island(uint32_t p_island_index, void *p_userdata) {
 	}
 }
 
-void Step3DSW::_check_suspend(const LocalVector<Body3DSW *> &p_body_island) const {
+void Step3DSW::_integrate_velocities(uint32_t p_body_index, void *p_userdata) {
+	active_bodies[p_body_index]->integrate_velocities(delta);
+}
+
+void Step3DSW::_check_suspend(uint32_t p_island_index, void *p_userdata) {
+	const LocalVector<Body3DSW *> &body_island = body_islands[p_island_index];
+
 	bool can_sleep = true;
 
-	uint32_t body_count = p_body_island.size();
+	uint32_t body_count = body_island.size();
 	for (uint32_t body_index = 0; body_index < body_count; ++body_index) {
-		Body3DSW *body = p_body_island[body_index];
+		Body3DSW *body = body_island[body_index];
 
 		if (!body->sleep_test(delta)) {
 			can_sleep = false;
 		}
 	}
 
-	// Put all to sleep or wake up everyone.
-	for (uint32_t body_index = 0; body_index < body_count; ++body_index) {
-		Body3DSW *body = p_body_island[body_index];
-
-		bool active = body->is_active();
+	// The island is put to sleep or woken up on the stepping thread.
+	body_island_can_sleep[p_island_index] = can_sleep;
+}
 
-		if (active == can_sleep) {
-			body->set_active(!can_sleep);
-		}
-	}
+void Step3DSW::_solve_soft_body_constraints(uint32_t p_soft_body_index, void *p_userdata) {
+	active_soft_bodies[p_soft_body_index]->solve_constraints(delta);
 }
 
 void Step3DSW::step(Space3DSW *p_space, real_t p_delta, int p_iterations) {
@@ -188,34 +267,40 @@ void Step3DSW::step(Space3DSW *p_space, real_t p_delta, int p_iterations) {
 	iterations = p_iterations;
 	delta = p_delta;
 
-	const SelfList<Body3DSW>::List *body_list = &p_space->get_active_body_list();
-
-	const SelfList<SoftBody3DSW>::List *soft_body_list = &p_space->get_active_soft_body_list();
-
 	/* INTEGRATE FORCES */
 
 	uint64_t profile_begtime = OS::get_singleton()->get_ticks_usec();
 	uint64_t profile_endtime = 0;
 
-	int active_count = 0;
+	_gather_active_bodies(p_space);
 
-	const SelfList<Body3DSW> *b = body_list->first();
-	while (b) {
-		b->self()->integrate_forces(p_delta);
-		b = b->next();
-		active_count++;
+	active_soft_bodies.clear();
+	const SelfList<SoftBody3DSW> *sb = p_space->get_active_soft_body_list().first();
+	while (sb) {
+		active_soft_bodies.push_back(sb->self());
+		sb = sb->next();
 	}
 
+	uint32_t body_count = active_bodies.size();
+	uint32_t soft_body_count = active_soft_bodies.size();
+
+	WorkerThreadPool::GroupID group_task = WorkerThreadPool::get_singleton()->add_template_group_task(this, &Step3DSW::_integrate_forces, nullptr, body_count);
+	WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group_task);
+
 	/* UPDATE SOFT BODY MOTION */
 
-	const SelfList<SoftBody3DSW> *sb = soft_body_list->first();
-	while (sb) {
-		sb->self()->predict_motion(p_delta);
-		sb = sb->next();
-		active_count++;
+	group_task = WorkerThreadPool::get_singleton()->add_template_group_task(this, &Step3DSW::_predict_soft_body_motion, nullptr, soft_body_count);
+	WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group_task);
+
+	// Broadphase updates are not thread-safe.
+	for (uint32_t body_index = 0; body_index < body_count; ++body_index) {
+		active_bodies[body_index]->apply_deferred_updates();
+	}
+	for (uint32_t soft_body_index = 0; soft_body_index < soft_body_count; ++soft_body_index) {
+		active_soft_bodies[soft_body_index]->apply_deferred_updates();
 	}
 
-	p_space->set_active_objects(active_count);
+	p_space->set_active_objects(body_count + soft_body_count);
 
 	{ //profile
 		profile_endtime = OS::get_singleton()->get_ticks_usec();
@@ -229,36 +314,40 @@ void Step3DSW::step(Space3DSW *p_space, real_t p_delta, int p_iterations) {
 
 	const SelfList<Area3DSW>::List &aml = p_space->get_moved_area_list();
 
+	area_constraints.clear();
 	while (aml.first()) {
-		for (const Set<Constraint3DSW *>::Element *E = aml.first()->self()->get_constraints().front(); E; E = E->next()) {
-			Constraint3DSW *constraint = E->get();
+		for (Constraint3DSW *constraint : aml.first()->self()->get_constraints()) {
 			if (constraint->get_island_step() == _step) {
 				continue;
 			}
 			constraint->set_island_step(_step);
+			area_constraints.push_back(constraint);
+		}
+		p_space->area_remove_from_moved_list((SelfList<Area3DSW> *)aml.first()); //faster to remove here
+	}
+	area_constraints.sort_custom<ConstraintIDComparator>();
 
-			// Each constraint can be on a separate island for areas as there's no solving phase.
-			++island_count;
-			if (constraint_islands.size() < island_count) {
-				constraint_islands.resize(island_count);
-			}
-			LocalVector<Constraint3DSW *> &constraint_island = constraint_islands[island_count - 1];
-			constraint_island.clear();
+	for (uint32_t constraint_index = 0; constraint_index < area_constraints.size(); ++constraint_index) {
+		Constraint3DSW *constraint = area_constraints[constraint_index];
 
-			all_constraints.push_back(constraint);
-			constraint_island.push_back(constraint);
+		// Each constraint can be on a separate island for areas as there's no solving phase.
+		++island_count;
+		if (constraint_islands.size() < island_count) {
+			constraint_islands.resize(island_count);
 		}
-		p_space->area_remove_from_moved_list((SelfList<Area3DSW> *)aml.first()); //faster to remove here
+		LocalVector<Constraint3DSW *> &constraint_island = constraint_islands[island_count - 1];
+		constraint_island.clear();
+
+		all_constraints.push_back(constraint);
+		constraint_island.push_back(constraint);
 	}
 
 	/* GENERATE CONSTRAINT ISLANDS FOR ACTIVE RIGID BODIES */
 
-	b = body_list->first();
-
 	uint32_t body_island_count = 0;
 
-	while (b) {
-		Body3DSW *body = b->self();
+	for (uint32_t body_index = 0; body_index < body_count; ++body_index) {
+		Body3DSW *body = active_bodies[body_index];
 
 		if (body->get_island_step() != _step) {
 			++body_island_count;
@@ -278,6 +367,8 @@ void Step3DSW::step(Space3DSW *p_space, real_t p_delta, int p_iterations) {
 			constraint_island.reserve(ISLAND_SIZE_RESERVE);
 
 			_populate_island(body, body_island, constraint_island);
+			body_island.sort_custom<BodyIDComparator>();
+			constraint_island.sort_custom<ConstraintIDComparator>();
 
 			if (body_island.is_empty()) {
 				--body_island_count;
@@ -287,14 +378,12 @@ void Step3DSW::step(Space3DSW *p_space, real_t p_delta, int p_iterations) {
 				--island_count;
 			}
 		}
-		b = b->next();
 	}
 
 	/* GENERATE CONSTRAINT ISLANDS FOR ACTIVE SOFT BODIES */
 
-	sb = soft_body_list->first();
-	while (sb) {
-		SoftBody3DSW *soft_body = sb->self();
+	for (uint32_t soft_body_index = 0; soft_body_index < soft_body_count; ++soft_body_index) {
+		SoftBody3DSW *soft_body = active_soft_bodies[soft_body_index];
 
 		if (soft_body->get_island_step() != _step) {
 			++body_island_count;
@@ -314,6 +403,8 @@ void Step3DSW::step(Space3DSW *p_space, real_t p_delta, int p_iterations) {
 			constraint_island.reserve(ISLAND_SIZE_RESERVE);
 
 			_populate_island_soft_body(soft_body, body_island, constraint_island);
+			body_island.sort_custom<BodyIDComparator>();
+			constraint_island.sort_custom<ConstraintIDComparator>();
 
 			if (body_island.is_empty()) {
 				--body_island_count;
@@ -323,7 +414,6 @@ void Step3DSW::step(Space3DSW *p_space, real_t p_delta, int p_iterations) {
 				--island_count;
 			}
 		}
-		sb = sb->next();
 	}
 
 	p_space->set_island_count((int)island_count);
@@ -337,7 +427,8 @@ void Step3DSW::step(Space3DSW *p_space, real_t p_delta, int p_iterations) {
 	/* SETUP CONSTRAINTS / PROCESS COLLISIONS */
 
 	uint32_t total_contraint_count = all_constraints.size();
-	work_pool.do_work(total_contraint_count, this, &Step3DSW::_setup_contraint, nullptr);
+	group_task = WorkerThreadPool::get_singleton()->add_template_group_task(this, &Step3DSW::_setup_contraint, nullptr, total_contraint_count);
+	WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group_task);
 
 	{ //profile
 		profile_endtime = OS::get_singleton()->get_ticks_usec();
@@ -347,9 +438,43 @@ void Step3DSW::step(Space3DSW *p_space, real_t p_delta, int p_iterations) {
 
 	/* PRE-SOLVE CONSTRAINT ISLANDS */
 
-	// Warning: This doesn't run on threads, because it involves thread-unsafe processing.
+	if (deferred_pre_solve_islands.size() < island_count) {
+		deferred_pre_solve_islands.resize(island_count);
+	}
+	if (contact_solvers.size() < island_count) {
+		contact_solvers.resize(island_count);
+	}
+	island_contact_counts.resize(island_count);
 	for (uint32_t island_index = 0; island_index < island_count; ++island_index) {
-		_pre_solve_island(constraint_islands[island_index]);
+		deferred_pre_solve_islands[island_index].reserve(constraint_islands[island_index].size());
+	}
+
+	group_task = WorkerThreadPool::get_singleton()->add_template_group_task(this, &Step3DSW::_pre_solve_island, nullptr, island_count);
+	WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group_task);
+
+	// Process the thread-unsafe constraints and wake up bodies, in island order so the result is deterministic.
+	for (uint32_t island_index = 0; island_index < island_count; ++island_index) {
+		const LocalVector<Constraint3DSW *> &deferred_constraints = deferred_pre_solve_islands[island_index];
+		for (uint32_t constraint_index = 0; constraint_index < deferred_constraints.size(); ++constraint_index) {
+			Constraint3DSW *constraint = deferred_constraints[constraint_index];
+			if (constraint->pre_solve(delta)) {
+				constraint_islands[island_index].push_back(constraint);
+				island_contact_counts[island_index] += constraint->get_batched_contact_count();
+			}
+		}
+		contact_solvers[island_index].reserve(island_contact_counts[island_index]);
+	}
+	for (uint32_t island_index = 0; island_index < body_island_count; ++island_index) {
+		const LocalVector<Body3DSW *> &body_island = body_islands[island_index];
+		for (uint32_t body_index = 0; body_index < body_island.size(); ++body_index) {
+			body_island[body_index]->apply_deferred_updates();
+		}
+	}
+
+	{ //profile
+		profile_endtime = OS::get_singleton()->get_ticks_usec();
+		p_space->set_elapsed_time(Space3DSW::ELAPSED_TIME_PRE_SOLVE_CONSTRAINTS, profile_endtime - profile_begtime);
+		profile_begtime = profile_endtime;
 	}
 
 	/* SOLVE CONSTRAINT ISLANDS */
@@ -357,7 +482,8 @@ void Step3DSW::step(Space3DSW *p_space, real_t p_delta, int p_iterations) {
 	// Warning: _solve_island modifies the constraint islands for optimization purpose,
 	// their content is not reliable after these calls and shouldn't be used anymore.
 	if (island_count > 1) {
-		work_pool.do_work(island_count, this, &Step3DSW::_solve_island, nullptr);
+		group_task = WorkerThreadPool::get_singleton()->add_template_group_task(this, &Step3DSW::_solve_island, nullptr, island_count);
+		WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group_task);
 	} else if (island_count > 0) {
 		_solve_island(0);
 	}
@@ -370,30 +496,56 @@ void Step3DSW::step(Space3DSW *p_space, real_t p_delta, int p_iterations) {
 
 	/* INTEGRATE VELOCITIES */
 
-	b = body_list->first();
-	while (b) {
-		const SelfList<Body3DSW> *n = b->next();
-		b->self()->integrate_velocities(p_delta);
-		b = n;
+	// Pre-solving may have woken up bodies.
+	_gather_active_bodies(p_space);
+	body_count = active_bodies.size();
+
+	group_task = WorkerThreadPool::get_singleton()->add_template_group_task(this, &Step3DSW::_integrate_velocities, nullptr, body_count);
+	WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group_task);
+
+	for (uint32_t body_index = 0; body_index < body_count; ++body_index) {
+		active_bodies[body_index]->apply_deferred_updates();
+	}
+
+	{ //profile
+		profile_endtime = OS::get_singleton()->get_ticks_usec();
+		p_space->set_elapsed_time(Space3DSW::ELAPSED_TIME_INTEGRATE_VELOCITIES, profile_endtime - profile_begtime);
+		profile_begtime = profile_endtime;
 	}
 
 	/* SLEEP / WAKE UP ISLANDS */
 
+	body_island_can_sleep.resize(body_island_count);
+
+	group_task = WorkerThreadPool::get_singleton()->add_template_group_task(this, &Step3DSW::_check_suspend, nullptr, body_island_count);
+	WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group_task);
+
+	// Put all to sleep or wake up everyone.
 	for (uint32_t island_index = 0; island_index < body_island_count; ++island_index) {
-		_check_suspend(body_islands[island_index]);
+		const LocalVector<Body3DSW *> &body_island = body_islands[island_index];
+		bool can_sleep = body_island_can_sleep[island_index];
+		for (uint32_t body_index = 0; body_index < body_island.size(); ++body_index) {
+			Body3DSW *body = body_island[body_index];
+			if (body->is_active() == can_sleep) {
+				body->set_active(!can_sleep);
+			}
+		}
+	}
+
+	{ //profile
+		profile_endtime = OS::get_singleton()->get_ticks_usec();
+		p_space->set_elapsed_time(Space3DSW::ELAPSED_TIME_SLEEP_ISLANDS, profile_endtime - profile_begtime);
+		profile_begtime = profile_endtime;
 	}
 
 	/* UPDATE SOFT BODY CONSTRAINTS */
 
-	sb = soft_body_list->first();
-	while (sb) {
-		sb->self()->solve_constraints(p_delta);
-		sb = sb->next();
-	}
+	group_task = WorkerThreadPool::get_singleton()->add_template_group_task(this, &Step3DSW::_solve_soft_body_constraints, nullptr, soft_body_count);
+	WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group_task);
 
 	{ //profile
 		profile_endtime = OS::get_singleton()->get_ticks_usec();
-		p_space->set_elapsed_time(Space3DSW::ELAPSED_TIME_INTEGRATE_VELOCITIES, profile_endtime - profile_begtime);
+		p_space->set_elapsed_time(Space3DSW::ELAPSED_TIME_SOLVE_SOFT_BODIES, profile_endtime - profile_begtime);
 		profile_begtime = profile_endtime;
 	}
 
@@ -409,11 +561,10 @@ Step3DSW::Step3DSW() {
 
 	body_islands.reserve(BODY_ISLAND_COUNT_RESERVE);
 	constraint_islands.reserve(ISLAND_COUNT_RESERVE);
+	deferred_pre_solve_islands.reserve(ISLAND_COUNT_RESERVE);
+	contact_solvers.reserve(ISLAND_COUNT_RESERVE);
 	all_constraints.reserve(CONSTRAINT_COUNT_RESERVE);
-
-	work_pool.init();
 }
 
 Step3DSW::~Step3DSW() {
-	work_pool.finish();
 }
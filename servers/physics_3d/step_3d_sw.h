@@ -31,10 +31,10 @@
 #ifndef STEP_SW_H
 #define STEP_SW_H
 
+#include "contact_solver_3d_sw.h"
 #include "space_3d_sw.h"
 
 #include "core/templates/local_vector.h"
-#include "core/templates/thread_work_pool.h"
 
 class Step3DSW {
 	uint64_t _step;
@@ -42,18 +42,30 @@ class Step3DSW {
 	int iterations = 0;
 	real_t delta = 0.0;
 
-	ThreadWorkPool work_pool;
+	LocalVector<Body3DSW *> active_bodies;
+	LocalVector<SoftBody3DSW *> active_soft_bodies;
 
 	LocalVector<LocalVector<Body3DSW *>> body_islands;
 	LocalVector<LocalVector<Constraint3DSW *>> constraint_islands;
+	LocalVector<LocalVector<Constraint3DSW *>> deferred_pre_solve_islands;
+	LocalVector<uint32_t> island_contact_counts;
+	LocalVector<ContactSolver3DSW> contact_solvers;
 	LocalVector<Constraint3DSW *> all_constraints;
+	LocalVector<Constraint3DSW *> area_constraints;
+	LocalVector<bool> body_island_can_sleep;
+
+	void _gather_active_bodies(Space3DSW *p_space);
 
 	void _populate_island(Body3DSW *p_body, LocalVector<Body3DSW *> &p_body_island, LocalVector<Constraint3DSW *> &p_constraint_island);
 	void _populate_island_soft_body(SoftBody3DSW *p_soft_body, LocalVector<Body3DSW *> &p_body_island, LocalVector<Constraint3DSW *> &p_constraint_island);
+	void _integrate_forces(uint32_t p_body_index, void *p_userdata = nullptr);
+	void _predict_soft_body_motion(uint32_t p_soft_body_index, void *p_userdata = nullptr);
 	void _setup_contraint(uint32_t p_constraint_index, void *p_userdata = nullptr);
-	void _pre_solve_island(LocalVector<Constraint3DSW *> &p_constraint_island) const;
+	void _pre_solve_island(uint32_t p_island_index, void *p_userdata = nullptr);
 	void _solve_island(uint32_t p_island_index, void *p_userdata = nullptr);
-	void _check_suspend(const LocalVector<Body3DSW *> &p_body_island) const;
+	void _integrate_velocities(uint32_t p_body_index, void *p_userdata = nullptr);
+	void _check_suspend(uint32_t p_island_index, void *p_userdata = nullptr);
+	void _solve_soft_body_constraints(uint32_t p_soft_body_index, void *p_userdata = nullptr);
 
 public:
 	void step(Space3DSW *p_space, real_t p_delta, int p_iterations);
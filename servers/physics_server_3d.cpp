@@ -356,6 +356,158 @@ Dictionary PhysicsDirectSpaceState3D::_get_rest_info(const Ref<PhysicsShapeQuery
 	return r;
 }
 
+Dictionary PhysicsDirectSpaceState3D::_intersect_ray_batch(const PackedVector3Array &p_from, const PackedVector3Array &p_to, const Vector<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
+	ERR_FAIL_COND_V(p_from.size() != p_to.size(), Dictionary());
+
+	Set<RID> exclude;
+	for (int i = 0; i < p_exclude.size(); i++) {
+		exclude.insert(p_exclude[i]);
+	}
+
+	int ray_count = p_from.size();
+	Vector<RayResult> results;
+	results.resize(ray_count);
+	intersect_ray_batch(p_from.ptr(), p_to.ptr(), ray_count, results.ptrw(), exclude, p_collision_mask, p_collide_with_bodies, p_collide_with_areas);
+
+	// Results go to packed arrays, so large batches don't allocate a dictionary per ray.
+	PackedVector3Array positions;
+	PackedVector3Array normals;
+	PackedInt64Array collider_ids;
+	PackedInt32Array shapes;
+	positions.resize(ray_count);
+	normals.resize(ray_count);
+	collider_ids.resize(ray_count);
+	shapes.resize(ray_count);
+
+	Vector3 *positions_ptr = positions.ptrw();
+	Vector3 *normals_ptr = normals.ptrw();
+	int64_t *collider_ids_ptr = collider_ids.ptrw();
+	int32_t *shapes_ptr = shapes.ptrw();
+	for (int i = 0; i < ray_count; i++) {
+		const RayResult &result = results[i];
+		positions_ptr[i] = result.position;
+		normals_ptr[i] = result.normal;
+		collider_ids_ptr[i] = result.shape >= 0 ? (int64_t)result.collider_id : 0;
+		shapes_ptr[i] = result.shape;
+	}
+
+	Dictionary d;
+	d["position"] = positions;
+	d["normal"] = normals;
+	d["collider_id"] = collider_ids;
+	d["shape"] = shapes;
+
+	return d;
+}
+
+Dictionary PhysicsDirectSpaceState3D::_intersect_shape_batch(const Ref<PhysicsShapeQueryParameters3D> &p_shape_query, const Array &p_transforms, int p_max_results) {
+	ERR_FAIL_COND_V(!p_shape_query.is_valid(), Dictionary());
+	ERR_FAIL_COND_V(p_max_results <= 0, Dictionary());
+
+	int query_count = p_transforms.size();
+	Vector<Transform3D> xforms;
+	xforms.resize(query_count);
+	for (int i = 0; i < query_count; i++) {
+		xforms.write[i] = p_transforms[i];
+	}
+
+	Vector<ShapeResult> results;
+	results.resize(query_count * p_max_results);
+	PackedInt32Array counts;
+	counts.resize(query_count);
+	intersect_shape_batch(p_shape_query->shape, xforms.ptr(), query_count, p_shape_query->margin, results.ptrw(), p_max_results, counts.ptrw(), p_shape_query->exclude, p_shape_query->collision_mask, p_shape_query->collide_with_bodies, p_shape_query->collide_with_areas);
+
+	PackedInt64Array collider_ids;
+	PackedInt32Array shapes;
+	collider_ids.resize(results.size());
+	shapes.resize(results.size());
+
+	int64_t *collider_ids_ptr = collider_ids.ptrw();
+	int32_t *shapes_ptr = shapes.ptrw();
+	for (int i = 0; i < query_count; i++) {
+		for (int j = 0; j < p_max_results; j++) {
+			int index = i * p_max_results + j;
+			if (j < counts[i]) {
+				collider_ids_ptr[index] = (int64_t)results[index].collider_id;
+				shapes_ptr[index] = results[index].shape;
+			} else {
+				collider_ids_ptr[index] = 0;
+				shapes_ptr[index] = -1;
+			}
+		}
+	}
+
+	Dictionary d;
+	d["count"] = counts;
+	d["collider_id"] = collider_ids;
+	d["shape"] = shapes;
+
+	return d;
+}
+
+Dictionary PhysicsDirectSpaceState3D::_cast_motion_batch(const Ref<PhysicsShapeQueryParameters3D> &p_shape_query, const Array &p_transforms, const PackedVector3Array &p_motions) {
+	ERR_FAIL_COND_V(!p_shape_query.is_valid(), Dictionary());
+	ERR_FAIL_COND_V(p_transforms.size() != p_motions.size(), Dictionary());
+
+	int query_count = p_transforms.size();
+	Vector<Transform3D> xforms;
+	xforms.resize(query_count);
+	for (int i = 0; i < query_count; i++) {
+		xforms.write[i] = p_transforms[i];
+	}
+
+	Vector<real_t> closest_safe;
+	Vector<real_t> closest_unsafe;
+	closest_safe.resize(query_count);
+	closest_unsafe.resize(query_count);
+	cast_motion_batch(p_shape_query->shape, xforms.ptr(), p_motions.ptr(), query_count, p_shape_query->margin, closest_safe.ptrw(), closest_unsafe.ptrw(), p_shape_query->exclude, p_shape_query->collision_mask, p_shape_query->collide_with_bodies, p_shape_query->collide_with_areas);
+
+	PackedFloat64Array safe;
+	PackedFloat64Array unsafe;
+	safe.resize(query_count);
+	unsafe.resize(query_count);
+
+	double *safe_ptr = safe.ptrw();
+	double *unsafe_ptr = unsafe.ptrw();
+	for (int i = 0; i < query_count; i++) {
+		safe_ptr[i] = closest_safe[i];
+		unsafe_ptr[i] = closest_unsafe[i];
+	}
+
+	Dictionary d;
+	d["safe"] = safe;
+	d["unsafe"] = unsafe;
+
+	return d;
+}
+
+int PhysicsDirectSpaceState3D::intersect_ray_batch(const Vector3 *p_from, const Vector3 *p_to, int p_ray_count, RayResult *r_results, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
+	int hit_count = 0;
+	for (int i = 0; i < p_ray_count; i++) {
+		if (intersect_ray(p_from[i], p_to[i], r_results[i], p_exclude, p_collision_mask, p_collide_with_bodies, p_collide_with_areas)) {
+			hit_count++;
+		} else {
+			r_results[i] = RayResult();
+			r_results[i].shape = -1;
+		}
+	}
+	return hit_count;
+}
+
+void PhysicsDirectSpaceState3D::intersect_shape_batch(const RID &p_shape, const Transform3D *p_xforms, int p_query_count, real_t p_margin, ShapeResult *r_results, int p_result_max, int *r_result_counts, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
+	for (int i = 0; i < p_query_count; i++) {
+		r_result_counts[i] = intersect_shape(p_shape, p_xforms[i], p_margin, &r_results[i * p_result_max], p_result_max, p_exclude, p_collision_mask, p_collide_with_bodies, p_collide_with_areas);
+	}
+}
+
+void PhysicsDirectSpaceState3D::cast_motion_batch(const RID &p_shape, const Transform3D *p_xforms, const Vector3 *p_motions, int p_query_count, real_t p_margin, real_t *r_closest_safe, real_t *r_closest_unsafe, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas, ShapeRestInfo *r_infos) {
+	for (int i = 0; i < p_query_count; i++) {
+		r_closest_safe[i] = 1.0;
+		r_closest_unsafe[i] = 1.0;
+		cast_motion(p_shape, p_xforms[i], p_motions[i], p_margin, r_closest_safe[i], r_closest_unsafe[i], p_exclude, p_collision_mask, p_collide_with_bodies, p_collide_with_areas, r_infos ? &r_infos[i] : nullptr);
+	}
+}
+
 PhysicsDirectSpaceState3D::PhysicsDirectSpaceState3D() {
 }
 
@@ -365,6 +517,9 @@ void PhysicsDirectSpaceState3D::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("cast_motion", "shape", "motion"), &PhysicsDirectSpaceState3D::_cast_motion);
 	ClassDB::bind_method(D_METHOD("collide_shape", "shape", "max_results"), &PhysicsDirectSpaceState3D::_collide_shape, DEFVAL(32));
 	ClassDB::bind_method(D_METHOD("get_rest_info", "shape"), &PhysicsDirectSpaceState3D::_get_rest_info);
+	ClassDB::bind_method(D_METHOD("intersect_ray_batch", "from", "to", "exclude", "collision_mask", "collide_with_bodies", "collide_with_areas"), &PhysicsDirectSpaceState3D::_intersect_ray_batch, DEFVAL(Array()), DEFVAL(0x7FFFFFFF), DEFVAL(true), DEFVAL(false));
+	ClassDB::bind_method(D_METHOD("intersect_shape_batch", "shape", "transforms", "max_results"), &PhysicsDirectSpaceState3D::_intersect_shape_batch, DEFVAL(32));
+	ClassDB::bind_method(D_METHOD("cast_motion_batch", "shape", "transforms", "motions"), &PhysicsDirectSpaceState3D::_cast_motion_batch);
 }
 
 ///////////////////////////////
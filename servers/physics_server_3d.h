@@ -149,6 +149,9 @@ private:
 	Array _cast_motion(const Ref<PhysicsShapeQueryParameters3D> &p_shape_query, const Vector3 &p_motion);
 	Array _collide_shape(const Ref<PhysicsShapeQueryParameters3D> &p_shape_query, int p_max_results = 32);
 	Dictionary _get_rest_info(const Ref<PhysicsShapeQueryParameters3D> &p_shape_query);
+	Dictionary _intersect_ray_batch(const PackedVector3Array &p_from, const PackedVector3Array &p_to, const Vector<RID> &p_exclude = Vector<RID>(), uint32_t p_collision_mask = 0, bool p_collide_with_bodies = true, bool p_collide_with_areas = false);
+	Dictionary _intersect_shape_batch(const Ref<PhysicsShapeQueryParameters3D> &p_shape_query, const Array &p_transforms, int p_max_results = 32);
+	Dictionary _cast_motion_batch(const Ref<PhysicsShapeQueryParameters3D> &p_shape_query, const Array &p_transforms, const PackedVector3Array &p_motions);
 
 protected:
 	static void _bind_methods();
@@ -193,6 +196,15 @@ public:
 
 	virtual Vector3 get_closest_point_to_object_volume(RID p_object, const Vector3 p_point) const = 0;
 
+	// Batched versions of intersect_ray() and intersect_shape(), sharing the same filters for all the queries.
+	// Ray i writes r_results[i], with a shape of -1 when it hits nothing. Returns the number of rays that hit.
+	virtual int intersect_ray_batch(const Vector3 *p_from, const Vector3 *p_to, int p_ray_count, RayResult *r_results, const Set<RID> &p_exclude = Set<RID>(), uint32_t p_collision_mask = 0xFFFFFFFF, bool p_collide_with_bodies = true, bool p_collide_with_areas = false);
+	// Query i writes up to p_result_max results from r_results[i * p_result_max], and their amount to r_result_counts[i].
+	virtual void intersect_shape_batch(const RID &p_shape, const Transform3D *p_xforms, int p_query_count, real_t p_margin, ShapeResult *r_results, int p_result_max, int *r_result_counts, const Set<RID> &p_exclude = Set<RID>(), uint32_t p_collision_mask = 0xFFFFFFFF, bool p_collide_with_bodies = true, bool p_collide_with_areas = false);
+	// Query i moves the shape from p_xforms[i] by p_motions[i], and writes r_closest_safe[i] and r_closest_unsafe[i].
+	// r_infos[i], if given, is only written when the motion collides.
+	virtual void cast_motion_batch(const RID &p_shape, const Transform3D *p_xforms, const Vector3 *p_motions, int p_query_count, real_t p_margin, real_t *r_closest_safe, real_t *r_closest_unsafe, const Set<RID> &p_exclude = Set<RID>(), uint32_t p_collision_mask = 0xFFFFFFFF, bool p_collide_with_bodies = true, bool p_collide_with_areas = false, ShapeRestInfo *r_infos = nullptr);
+
 	PhysicsDirectSpaceState3D();
 };
 
@@ -36,6 +36,8 @@
 #include "rendering_server_globals.h"
 
 static const int z_range = RS::CANVAS_ITEM_Z_MAX - RS::CANVAS_ITEM_Z_MIN + 1;
+// Items with at least this many children look them up in a BVH when culling.
+static const int children_bvh_threshold = 64;
 
 void RendererCanvasCull::_render_canvas_item_tree(RID p_to_render_target, Canvas::ChildItem *p_child_items, int p_child_item_count, Item *p_canvas_item, const Transform2D &p_transform, const Rect2 &p_clip_rect, const Color &p_modulate, RendererCanvasRender::Light *p_lights, RendererCanvasRender::Light *p_directional_lights, RenderingServer::CanvasItemTextureFilter p_default_filter, RenderingServer::CanvasItemTextureRepeat p_default_repeat, bool p_snap_2d_vertices_to_pixel) {
 	RENDER_TIMESTAMP("Cull CanvasItem Tree");
@@ -75,25 +77,33 @@ void RendererCanvasCull::_render_canvas_item_tree(RID p_to_render_target, Canvas
 	}
 }
 
+void _collect_ysort_children(RendererCanvasCull::Item *p_canvas_item, Transform2D p_transform, RendererCanvasCull::Item *p_material_owner, RendererCanvasCull::Item **r_items, int &r_index);
+
+void _collect_ysort_child(RendererCanvasCull::Item *p_child, const Transform2D &p_transform, RendererCanvasCull::Item *p_material_owner, RendererCanvasCull::Item **r_items, int &r_index) {
+	if (!p_child->visible) {
+		return;
+	}
+
+	if (r_items) {
+		r_items[r_index] = p_child;
+		p_child->ysort_xform = p_transform;
+		p_child->ysort_pos = p_transform.xform(p_child->xform.elements[2]);
+		p_child->material_owner = p_child->use_parent_material ? p_material_owner : nullptr;
+		p_child->ysort_index = r_index;
+	}
+
+	r_index++;
+
+	if (p_child->sort_y) {
+		_collect_ysort_children(p_child, p_transform * p_child->xform, p_child->use_parent_material ? p_material_owner : p_child, r_items, r_index);
+	}
+}
+
 void _collect_ysort_children(RendererCanvasCull::Item *p_canvas_item, Transform2D p_transform, RendererCanvasCull::Item *p_material_owner, RendererCanvasCull::Item **r_items, int &r_index) {
 	int child_item_count = p_canvas_item->child_items.size();
 	RendererCanvasCull::Item **child_items = p_canvas_item->child_items.ptrw();
 	for (int i = 0; i < child_item_count; i++) {
-		if (child_items[i]->visible) {
-			if (r_items) {
-				r_items[r_index] = child_items[i];
-				child_items[i]->ysort_xform = p_transform;
-				child_items[i]->ysort_pos = p_transform.xform(child_items[i]->xform.elements[2]);
-				child_items[i]->material_owner = child_items[i]->use_parent_material ? p_material_owner : nullptr;
-				child_items[i]->ysort_index = r_index;
-			}
-
-			r_index++;
-
-			if (child_items[i]->sort_y) {
-				_collect_ysort_children(child_items[i], p_transform * child_items[i]->xform, child_items[i]->use_parent_material ? p_material_owner : child_items[i], r_items, r_index);
-			}
-		}
+		_collect_ysort_child(child_items[i], p_transform, p_material_owner, r_items, r_index);
 	}
 }
 
@@ -104,6 +114,125 @@ void _mark_ysort_dirty(RendererCanvasCull::Item *ysort_owner, RID_Owner<Renderer
 	} while (ysort_owner && ysort_owner->sort_y);
 }
 
+void _mark_bounds_dirty(RendererCanvasCull::Item *p_item, RID_Owner<RendererCanvasCull::Item, true> &canvas_item_owner) {
+	p_item->bounds_dirty = true;
+	RendererCanvasCull::Item *parent = canvas_item_owner.owns(p_item->parent) ? canvas_item_owner.getornull(p_item->parent) : nullptr;
+	// A dirty item always has dirty parents.
+	while (parent && !parent->bounds_dirty) {
+		parent->bounds_dirty = true;
+		parent = canvas_item_owner.owns(parent->parent) ? canvas_item_owner.getornull(parent->parent) : nullptr;
+	}
+}
+
+void _update_item_bounds(RendererCanvasCull::Item *p_item) {
+	RendererCanvasCull::Item *ci = p_item;
+
+	Rect2 bounds;
+	bool empty = true;
+	bool cull_disabled = ci->vp_render || ci->copy_back_buffer || ci->canvas_group || ci->update_when_visible;
+
+	if (ci->commands != nullptr || ci->visibility_notifier) {
+		bounds = ci->get_rect();
+		if (ci->visibility_notifier && ci->visibility_notifier->area.size != Vector2()) {
+			bounds = bounds.merge(ci->visibility_notifier->area);
+		}
+		empty = false;
+	}
+
+	// The rect of these commands changes with their resource.
+	for (const RendererCanvasCull::Item::Command *c = ci->commands; c && !cull_disabled; c = c->next) {
+		if (c->type == RendererCanvasCull::Item::Command::TYPE_MESH || c->type == RendererCanvasCull::Item::Command::TYPE_MULTIMESH || c->type == RendererCanvasCull::Item::Command::TYPE_PARTICLES) {
+			cull_disabled = true;
+		}
+	}
+
+	int child_item_count = ci->child_items.size();
+	RendererCanvasCull::Item **child_items = ci->child_items.ptrw();
+
+	if (child_item_count >= children_bvh_threshold) {
+		if (!ci->children_bvh) {
+			ci->children_bvh = memnew(DynamicBVH);
+		}
+	} else if (ci->children_bvh && child_item_count < children_bvh_threshold / 2) {
+		memdelete(ci->children_bvh);
+		ci->children_bvh = nullptr;
+		for (int i = 0; i < child_item_count; i++) {
+			child_items[i]->children_bvh_id = DynamicBVH::ID();
+		}
+	}
+
+	ci->unculled_children.clear();
+	for (int i = 0; i < child_item_count; i++) {
+		RendererCanvasCull::Item *child = child_items[i];
+		child->child_order = i;
+		const bool child_dirty = child->bounds_dirty;
+		if (child_dirty) {
+			// Invisible children are updated too, so no dirty item is left under a clean one.
+			_update_item_bounds(child);
+		}
+
+		if (ci->children_bvh) {
+			const Rect2 &r = child->parent_bounds;
+			const AABB aabb(Vector3(r.position.x, r.position.y, 0), Vector3(r.size.x, r.size.y, 0));
+			if (!child->children_bvh_id.is_valid()) {
+				child->children_bvh_id = ci->children_bvh->insert(aabb, child);
+			} else if (child_dirty) {
+				ci->children_bvh->update(child->children_bvh_id, aabb);
+			}
+		}
+
+		if (!child->visible) {
+			continue;
+		}
+		if (child->cull_disabled) {
+			ci->unculled_children.push_back(child);
+			cull_disabled = true;
+		}
+		if (!child->bounds_empty) {
+			bounds = empty ? child->parent_bounds : bounds.merge(child->parent_bounds);
+			empty = false;
+		}
+	}
+
+	ci->bounds = bounds;
+	ci->bounds_empty = empty;
+	ci->cull_disabled = cull_disabled;
+	// Grown, as the origin may be snapped to pixels when drawing.
+	ci->parent_bounds = ci->xform.xform(bounds).grow(1.0);
+	ci->bounds_dirty = false;
+}
+
+struct _ChildItemCollector {
+	LocalVector<RendererCanvasCull::Item *> *items;
+	_FORCE_INLINE_ bool operator()(void *p_data) {
+		RendererCanvasCull::Item *child = (RendererCanvasCull::Item *)p_data;
+		if (!child->cull_disabled) {
+			items->push_back(child);
+		}
+		return false;
+	}
+};
+
+// Returns false if the children can't be looked up in the BVH of the item.
+bool _collect_children_on_screen(RendererCanvasCull::Item *p_canvas_item, const Transform2D &p_xform, const Rect2 &p_clip_rect, LocalVector<RendererCanvasCull::Item *> &r_children) {
+	if (!p_canvas_item->children_bvh || p_xform.basis_determinant() == 0) {
+		return false;
+	}
+
+	const Rect2 local_clip_rect = p_xform.affine_inverse().xform(Rect2(Point2(), p_clip_rect.size));
+	_ChildItemCollector collector;
+	collector.items = &r_children;
+	p_canvas_item->children_bvh->aabb_query(AABB(Vector3(local_clip_rect.position.x, local_clip_rect.position.y, 0), Vector3(local_clip_rect.size.x, local_clip_rect.size.y, 0)), collector);
+	for (uint32_t i = 0; i < p_canvas_item->unculled_children.size(); i++) {
+		r_children.push_back(p_canvas_item->unculled_children[i]);
+	}
+
+	// Back in drawing order.
+	SortArray<RendererCanvasCull::Item *, RendererCanvasCull::ItemChildOrderSort> sorter;
+	sorter.sort(r_children.ptr(), r_children.size());
+	return true;
+}
+
 void RendererCanvasCull::_attach_canvas_item_for_draw(RendererCanvasCull::Item *ci, RendererCanvasCull::Item *p_canvas_clip, RendererCanvasRender::Item **z_list, RendererCanvasRender::Item **z_last_list, const Transform2D &xform, const Rect2 &p_clip_rect, Rect2 global_rect, const Color &modulate, int p_z, RendererCanvasCull::Item *p_material_owner, bool use_canvas_group, RendererCanvasRender::Item *canvas_group_from, const Transform2D &p_xform) {
 	if (ci->copy_back_buffer) {
 		ci->copy_back_buffer->screen_rect = xform.xform(ci->copy_back_buffer->rect).intersection(p_clip_rect);
@@ -224,6 +353,28 @@ void RendererCanvasCull::_cull_canvas_item(Item *p_canvas_item, const Transform2
 	if (ci->children_order_dirty) {
 		ci->child_items.sort_custom<ItemIndexSort>();
 		ci->children_order_dirty = false;
+		ci->bounds_dirty = true; // Updates the order of the children.
+	}
+
+	Transform2D xform = ci->xform;
+	if (snapping_2d_transforms_to_pixel) {
+		xform.elements[2] = xform.elements[2].floor();
+	}
+	xform = p_transform * xform;
+
+	if (ci->bounds_dirty) {
+		_update_item_bounds(ci);
+	}
+	if (!ci->cull_disabled) {
+		if (ci->bounds_empty) {
+			return;
+		}
+		Rect2 global_bounds = xform.xform(ci->bounds);
+		global_bounds.position += p_clip_rect.position;
+		if (!p_clip_rect.intersects(global_bounds, true)) {
+			// Neither the item nor its children are on screen.
+			return;
+		}
 	}
 
 	Rect2 rect = ci->get_rect();
@@ -234,12 +385,6 @@ void RendererCanvasCull::_cull_canvas_item(Item *p_canvas_item, const Transform2
 		}
 	}
 
-	Transform2D xform = ci->xform;
-	if (snapping_2d_transforms_to_pixel) {
-		xform.elements[2] = xform.elements[2].floor();
-	}
-	xform = p_transform * xform;
-
 	Rect2 global_rect = xform.xform(rect);
 	global_rect.position += p_clip_rect.position;
 
@@ -291,7 +436,16 @@ void RendererCanvasCull::_cull_canvas_item(Item *p_canvas_item, const Transform2
 
 			child_items[0] = ci;
 			int i = 1;
-			_collect_ysort_children(ci, Transform2D(), p_material_owner, child_items, i);
+			// Only the children on screen are sorted, with their own y-sorted children.
+			LocalVector<Item *> visible_children;
+			if (_collect_children_on_screen(ci, xform, p_clip_rect, visible_children)) {
+				for (uint32_t j = 0; j < visible_children.size(); j++) {
+					_collect_ysort_child(visible_children[j], Transform2D(), p_material_owner, child_items, i);
+				}
+				child_item_count = i;
+			} else {
+				_collect_ysort_children(ci, Transform2D(), p_material_owner, child_items, i);
+			}
 			ci->ysort_xform = ci->xform.affine_inverse();
 
 			SortArray<Item *, ItemPtrSort> sorter;
@@ -318,6 +472,13 @@ void RendererCanvasCull::_cull_canvas_item(Item *p_canvas_item, const Transform2
 			canvas_group_from = z_last_list[zidx];
 		}
 
+		// Only visit the children on screen, in their drawing order.
+		LocalVector<Item *> visible_children;
+		if (_collect_children_on_screen(ci, xform, p_clip_rect, visible_children)) {
+			child_items = visible_children.ptr();
+			child_item_count = visible_children.size();
+		}
+
 		for (int i = 0; i < child_item_count; i++) {
 			if (!child_items[i]->behind && !use_canvas_group) {
 				continue;
@@ -446,6 +607,12 @@ void RendererCanvasCull::canvas_item_set_parent(RID p_item, RID p_parent) {
 			if (item_owner->sort_y) {
 				_mark_ysort_dirty(item_owner, canvas_item_owner);
 			}
+
+			if (canvas_item->children_bvh_id.is_valid()) {
+				item_owner->children_bvh->remove(canvas_item->children_bvh_id);
+				canvas_item->children_bvh_id = DynamicBVH::ID();
+			}
+			_mark_bounds_dirty(item_owner, canvas_item_owner);
 		}
 
 		canvas_item->parent = RID();
@@ -473,11 +640,13 @@ void RendererCanvasCull::canvas_item_set_parent(RID p_item, RID p_parent) {
 	}
 
 	canvas_item->parent = p_parent;
+	_mark_bounds_dirty(canvas_item, canvas_item_owner);
 }
 
 void RendererCanvasCull::canvas_item_set_visible(RID p_item, bool p_visible) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_bounds_dirty(canvas_item, canvas_item_owner);
 
 	canvas_item->visible = p_visible;
 
@@ -494,6 +663,7 @@ void RendererCanvasCull::canvas_item_set_light_mask(RID p_item, int p_mask) {
 void RendererCanvasCull::canvas_item_set_transform(RID p_item, const Transform2D &p_transform) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_bounds_dirty(canvas_item, canvas_item_owner);
 
 	canvas_item->xform = p_transform;
 }
@@ -515,6 +685,7 @@ void RendererCanvasCull::canvas_item_set_distance_field_mode(RID p_item, bool p_
 void RendererCanvasCull::canvas_item_set_custom_rect(RID p_item, bool p_custom_rect, const Rect2 &p_rect) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_bounds_dirty(canvas_item, canvas_item_owner);
 
 	canvas_item->custom_rect = p_custom_rect;
 	canvas_item->rect = p_rect;
@@ -544,6 +715,7 @@ void RendererCanvasCull::canvas_item_set_draw_behind_parent(RID p_item, bool p_e
 void RendererCanvasCull::canvas_item_set_update_when_visible(RID p_item, bool p_update) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_bounds_dirty(canvas_item, canvas_item_owner);
 
 	canvas_item->update_when_visible = p_update;
 }
@@ -551,6 +723,7 @@ void RendererCanvasCull::canvas_item_set_update_when_visible(RID p_item, bool p_
 void RendererCanvasCull::canvas_item_add_line(RID p_item, const Point2 &p_from, const Point2 &p_to, const Color &p_color, float p_width) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_bounds_dirty(canvas_item, canvas_item_owner);
 
 	Item::CommandPrimitive *line = canvas_item->alloc_command<Item::CommandPrimitive>();
 	ERR_FAIL_COND(!line);
@@ -575,6 +748,7 @@ void RendererCanvasCull::canvas_item_add_polyline(RID p_item, const Vector<Point
 	ERR_FAIL_COND(p_points.size() < 2);
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_bounds_dirty(canvas_item, canvas_item_owner);
 
 	Color color = Color(1, 1, 1, 1);
 
@@ -716,6 +890,7 @@ void RendererCanvasCull::canvas_item_add_multiline(RID p_item, const Vector<Poin
 	ERR_FAIL_COND(p_points.size() < 2);
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_bounds_dirty(canvas_item, canvas_item_owner);
 
 	Item::CommandPolygon *pline = canvas_item->alloc_command<Item::CommandPolygon>();
 	ERR_FAIL_COND(!pline);
@@ -732,6 +907,7 @@ void RendererCanvasCull::canvas_item_add_multiline(RID p_item, const Vector<Poin
 void RendererCanvasCull::canvas_item_add_rect(RID p_item, const Rect2 &p_rect, const Color &p_color) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_bounds_dirty(canvas_item, canvas_item_owner);
 
 	Item::CommandRect *rect = canvas_item->alloc_command<Item::CommandRect>();
 	ERR_FAIL_COND(!rect);
@@ -742,6 +918,7 @@ void RendererCanvasCull::canvas_item_add_rect(RID p_item, const Rect2 &p_rect, c
 void RendererCanvasCull::canvas_item_add_circle(RID p_item, const Point2 &p_pos, float p_radius, const Color &p_color) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_bounds_dirty(canvas_item, canvas_item_owner);
 
 	Item::CommandPolygon *circle = canvas_item->alloc_command<Item::CommandPolygon>();
 	ERR_FAIL_COND(!circle);
@@ -778,6 +955,7 @@ void RendererCanvasCull::canvas_item_add_circle(RID p_item, const Point2 &p_pos,
 void RendererCanvasCull::canvas_item_add_texture_rect(RID p_item, const Rect2 &p_rect, RID p_texture, bool p_tile, const Color &p_modulate, bool p_transpose) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_bounds_dirty(canvas_item, canvas_item_owner);
 
 	Item::CommandRect *rect = canvas_item->alloc_command<Item::CommandRect>();
 	ERR_FAIL_COND(!rect);
@@ -809,6 +987,7 @@ void RendererCanvasCull::canvas_item_add_texture_rect(RID p_item, const Rect2 &p
 void RendererCanvasCull::canvas_item_add_texture_rect_region(RID p_item, const Rect2 &p_rect, RID p_texture, const Rect2 &p_src_rect, const Color &p_modulate, bool p_transpose, bool p_clip_uv) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_bounds_dirty(canvas_item, canvas_item_owner);
 
 	Item::CommandRect *rect = canvas_item->alloc_command<Item::CommandRect>();
 	ERR_FAIL_COND(!rect);
@@ -850,6 +1029,7 @@ void RendererCanvasCull::canvas_item_add_texture_rect_region(RID p_item, const R
 void RendererCanvasCull::canvas_item_add_nine_patch(RID p_item, const Rect2 &p_rect, const Rect2 &p_source, RID p_texture, const Vector2 &p_topleft, const Vector2 &p_bottomright, RS::NinePatchAxisMode p_x_axis_mode, RS::NinePatchAxisMode p_y_axis_mode, bool p_draw_center, const Color &p_modulate) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_bounds_dirty(canvas_item, canvas_item_owner);
 
 	Item::CommandNinePatch *style = canvas_item->alloc_command<Item::CommandNinePatch>();
 	ERR_FAIL_COND(!style);
@@ -874,6 +1054,7 @@ void RendererCanvasCull::canvas_item_add_primitive(RID p_item, const Vector<Poin
 
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_bounds_dirty(canvas_item, canvas_item_owner);
 
 	Item::CommandPrimitive *prim = canvas_item->alloc_command<Item::CommandPrimitive>();
 	ERR_FAIL_COND(!prim);
@@ -900,6 +1081,7 @@ void RendererCanvasCull::canvas_item_add_primitive(RID p_item, const Vector<Poin
 void RendererCanvasCull::canvas_item_add_polygon(RID p_item, const Vector<Point2> &p_points, const Vector<Color> &p_colors, const Vector<Point2> &p_uvs, RID p_texture) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_bounds_dirty(canvas_item, canvas_item_owner);
 #ifdef DEBUG_ENABLED
 	int pointcount = p_points.size();
 	ERR_FAIL_COND(pointcount < 3);
@@ -921,6 +1103,7 @@ void RendererCanvasCull::canvas_item_add_polygon(RID p_item, const Vector<Point2
 void RendererCanvasCull::canvas_item_add_triangle_array(RID p_item, const Vector<int> &p_indices, const Vector<Point2> &p_points, const Vector<Color> &p_colors, const Vector<Point2> &p_uvs, const Vector<int> &p_bones, const Vector<float> &p_weights, RID p_texture, int p_count) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_bounds_dirty(canvas_item, canvas_item_owner);
 
 	int vertex_count = p_points.size();
 	ERR_FAIL_COND(vertex_count == 0);
@@ -944,6 +1127,7 @@ void RendererCanvasCull::canvas_item_add_triangle_array(RID p_item, const Vector
 void RendererCanvasCull::canvas_item_add_set_transform(RID p_item, const Transform2D &p_transform) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_bounds_dirty(canvas_item, canvas_item_owner);
 
 	Item::CommandTransform *tr = canvas_item->alloc_command<Item::CommandTransform>();
 	ERR_FAIL_COND(!tr);
@@ -953,6 +1137,7 @@ void RendererCanvasCull::canvas_item_add_set_transform(RID p_item, const Transfo
 void RendererCanvasCull::canvas_item_add_mesh(RID p_item, const RID &p_mesh, const Transform2D &p_transform, const Color &p_modulate, RID p_texture) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_bounds_dirty(canvas_item, canvas_item_owner);
 	ERR_FAIL_COND(!p_mesh.is_valid());
 
 	Item::CommandMesh *m = canvas_item->alloc_command<Item::CommandMesh>();
@@ -972,6 +1157,7 @@ void RendererCanvasCull::canvas_item_add_mesh(RID p_item, const RID &p_mesh, con
 void RendererCanvasCull::canvas_item_add_particles(RID p_item, RID p_particles, RID p_texture) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_bounds_dirty(canvas_item, canvas_item_owner);
 
 	Item::CommandParticles *part = canvas_item->alloc_command<Item::CommandParticles>();
 	ERR_FAIL_COND(!part);
@@ -986,6 +1172,7 @@ void RendererCanvasCull::canvas_item_add_particles(RID p_item, RID p_particles,
 void RendererCanvasCull::canvas_item_add_multimesh(RID p_item, RID p_mesh, RID p_texture) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_bounds_dirty(canvas_item, canvas_item_owner);
 
 	Item::CommandMultiMesh *mm = canvas_item->alloc_command<Item::CommandMultiMesh>();
 	ERR_FAIL_COND(!mm);
@@ -997,6 +1184,7 @@ void RendererCanvasCull::canvas_item_add_multimesh(RID p_item, RID p_mesh, RID p
 void RendererCanvasCull::canvas_item_add_clip_ignore(RID p_item, bool p_ignore) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_bounds_dirty(canvas_item, canvas_item_owner);
 
 	Item::CommandClipIgnore *ci = canvas_item->alloc_command<Item::CommandClipIgnore>();
 	ERR_FAIL_COND(!ci);
@@ -1006,6 +1194,7 @@ void RendererCanvasCull::canvas_item_add_clip_ignore(RID p_item, bool p_ignore)
 void RendererCanvasCull::canvas_item_add_animation_slice(RID p_item, double p_animation_length, double p_slice_begin, double p_slice_end, double p_offset) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_bounds_dirty(canvas_item, canvas_item_owner);
 
 	Item::CommandAnimationSlice *as = canvas_item->alloc_command<Item::CommandAnimationSlice>();
 	ERR_FAIL_COND(!as);
@@ -1072,6 +1261,7 @@ void RendererCanvasCull::canvas_item_attach_skeleton(RID p_item, RID p_skeleton)
 void RendererCanvasCull::canvas_item_set_copy_to_backbuffer(RID p_item, bool p_enable, const Rect2 &p_rect) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_bounds_dirty(canvas_item, canvas_item_owner);
 	if (p_enable && (canvas_item->copy_back_buffer == nullptr)) {
 		canvas_item->copy_back_buffer = memnew(RendererCanvasRender::Item::CopyBackBuffer);
 	}
@@ -1089,6 +1279,7 @@ void RendererCanvasCull::canvas_item_set_copy_to_backbuffer(RID p_item, bool p_e
 void RendererCanvasCull::canvas_item_clear(RID p_item) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_bounds_dirty(canvas_item, canvas_item_owner);
 
 	canvas_item->clear();
 }
@@ -1129,6 +1320,7 @@ void RendererCanvasCull::canvas_item_set_use_parent_material(RID p_item, bool p_
 void RendererCanvasCull::canvas_item_set_visibility_notifier(RID p_item, bool p_enable, const Rect2 &p_area, const Callable &p_enter_callable, const Callable &p_exit_callable) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_bounds_dirty(canvas_item, canvas_item_owner);
 
 	if (p_enable) {
 		if (!canvas_item->visibility_notifier) {
@@ -1149,6 +1341,7 @@ void RendererCanvasCull::canvas_item_set_visibility_notifier(RID p_item, bool p_
 void RendererCanvasCull::canvas_item_set_canvas_group_mode(RID p_item, RS::CanvasGroupMode p_mode, float p_clear_margin, bool p_fit_empty, float p_fit_margin, bool p_blur_mipmaps) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_bounds_dirty(canvas_item, canvas_item_owner);
 
 	if (p_mode == RS::CANVAS_GROUP_MODE_DISABLED) {
 		if (canvas_item->canvas_group != nullptr) {
@@ -1609,11 +1802,18 @@ bool RendererCanvasCull::free(RID p_rid) {
 				if (item_owner->sort_y) {
 					_mark_ysort_dirty(item_owner, canvas_item_owner);
 				}
+
+				if (canvas_item->children_bvh_id.is_valid()) {
+					item_owner->children_bvh->remove(canvas_item->children_bvh_id);
+					canvas_item->children_bvh_id = DynamicBVH::ID();
+				}
+				_mark_bounds_dirty(item_owner, canvas_item_owner);
 			}
 		}
 
 		for (int i = 0; i < canvas_item->child_items.size(); i++) {
 			canvas_item->child_items[i]->parent = RID();
+			canvas_item->child_items[i]->children_bvh_id = DynamicBVH::ID();
 		}
 
 		if (canvas_item->visibility_notifier != nullptr) {
@@ -31,6 +31,8 @@
 #ifndef RENDERING_SERVER_CANVAS_CULL_H
 #define RENDERING_SERVER_CANVAS_CULL_H
 
+#include "core/math/dynamic_bvh.h"
+#include "core/templates/local_vector.h"
 #include "core/templates/paged_allocator.h"
 #include "renderer_compositor.h"
 #include "renderer_viewport.h"
@@ -56,6 +58,22 @@ public:
 
 		Vector<Item *> child_items;
 
+		// Culling bounds of the item and its children, in local coordinates.
+		// A subtree is skipped when its bounds are out of the screen.
+		Rect2 bounds;
+		Rect2 parent_bounds; // Bounds in the coordinates of the parent.
+		bool bounds_dirty = true;
+		bool bounds_empty = true;
+		// Set when the item or a child must be visited even out of the screen,
+		// or when its rect can change without notice.
+		bool cull_disabled = false;
+
+		// With many children, they are looked up in a BVH of their parent bounds.
+		DynamicBVH *children_bvh = nullptr;
+		DynamicBVH::ID children_bvh_id; // Leaf of the item in the BVH of its parent.
+		int child_order = 0; // Position in the children of its parent, to draw the ones found in the BVH in order.
+		LocalVector<Item *> unculled_children; // Children with cull_disabled.
+
 		struct VisibilityNotifierData {
 			Rect2 area;
 			Callable enter_callable;
@@ -85,6 +103,12 @@ public:
 			ysort_pos = Vector2();
 			ysort_index = 0;
 		}
+
+		~Item() {
+			if (children_bvh) {
+				memdelete(children_bvh);
+			}
+		}
 	};
 
 	struct ItemIndexSort {
@@ -93,6 +117,12 @@ public:
 		}
 	};
 
+	struct ItemChildOrderSort {
+		_FORCE_INLINE_ bool operator()(const Item *p_left, const Item *p_right) const {
+			return p_left->child_order < p_right->child_order;
+		}
+	};
+
 	struct ItemPtrSort {
 		_FORCE_INLINE_ bool operator()(const Item *p_left, const Item *p_right) const {
 			if (Math::is_equal_approx(p_left->ysort_pos.y, p_right->ysort_pos.y)) {
@@ -905,6 +905,23 @@ public:
 
 	uint32_t thread_cull_threshold = 200;
 
+	struct DirtyInstanceSort {
+		_FORCE_INLINE_ bool operator()(const Instance *p_a, const Instance *p_b) const {
+			if (p_a->scenario != p_b->scenario) {
+				return p_a->scenario < p_b->scenario;
+			}
+			// Geometry and volume instances live in different indexers.
+			const bool a_geometry = (1 << p_a->base_type) & RS::INSTANCE_GEOMETRY_MASK;
+			const bool b_geometry = (1 << p_b->base_type) & RS::INSTANCE_GEOMETRY_MASK;
+			if (a_geometry != b_geometry) {
+				return a_geometry;
+			}
+			return p_a->base_type < p_b->base_type;
+		}
+	};
+
+	LocalVector<Instance *> dirty_instances;
+
 	RID_Owner<Instance, true> instance_owner;
 
 	uint32_t geometry_instance_pair_mask; // used in traditional forward, unnecessary on clustered
@@ -916,6 +933,7 @@ public:
 	virtual void instance_set_scenario(RID p_instance, RID p_scenario);
 	virtual void instance_set_layer_mask(RID p_instance, uint32_t p_mask);
 	virtual void instance_set_transform(RID p_instance, const Transform3D &p_transform);
+	virtual void instance_set_transforms(const Vector<RID> &p_instances, const Vector<Transform3D> &p_transforms);
 	virtual void instance_attach_object_instance_id(RID p_instance, ObjectID p_id);
 	virtual void instance_set_blend_shape_weight(RID p_instance, int p_shape, float p_weight);
 	virtual void instance_set_surface_override_material(RID p_instance, int p_surface, RID p_material);
@@ -956,6 +974,8 @@ public:
 	_FORCE_INLINE_ void _update_instance(Instance *p_instance);
 	_FORCE_INLINE_ void _update_instance_aabb(Instance *p_instance);
 	_FORCE_INLINE_ void _update_dirty_instance(Instance *p_instance);
+	_FORCE_INLINE_ bool _can_update_instance_aabb_threaded(const Instance *p_instance) const;
+	void _update_dirty_instance_aabb_threaded(uint32_t p_index, Instance **p_instances);
 	_FORCE_INLINE_ void _update_instance_lightmap_captures(Instance *p_instance);
 	void _unpair_instance(Instance *p_instance);
 
@@ -0,0 +1,232 @@
+/*************************************************************************/
+/*  test_contact_solver.h                                                */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_CONTACT_SOLVER_H
+#define TEST_CONTACT_SOLVER_H
+
+#include "servers/physics_2d/body_pair_2d_sw.h"
+#include "servers/physics_2d/contact_solver_2d_sw.h"
+#include "servers/physics_2d/physics_server_2d_sw.h"
+#include "servers/physics_3d/body_pair_3d_sw.h"
+#include "servers/physics_3d/contact_solver_3d_sw.h"
+#include "servers/physics_3d/physics_server_3d_sw.h"
+
+#include "tests/test_macros.h"
+
+namespace TestContactSolver {
+
+static const int STACK_BODY_COUNT = 4; // A static ground and three boxes.
+static const int STACK_ITERATIONS = 256; // The solvers go through the contacts in a different order, enough iterations make them converge.
+static const real_t STACK_STEP = 1.0 / 60.0;
+static const real_t STACK_TOLERANCE = 0.002; // Relative to the initial falling speed of 1.
+
+// A static ground with boxes stacked on it, slightly overlapping, falling and
+// sliding sideways. The contacts are solved either by the pairs one by one, or
+// in batches by the contact solver, and the resulting velocities returned.
+static void _solve_stack_3d(bool p_batched, Vector3 *r_linear_velocities, Vector3 *r_angular_velocities) {
+	// The bodies register their shape updates with the server.
+	PhysicsServer3DSW *server = memnew(PhysicsServer3DSW);
+	server->init();
+
+	Space3DSW *space = memnew(Space3DSW);
+	BoxShape3DSW *shape = memnew(BoxShape3DSW);
+	shape->set_data(Vector3(0.5, 0.5, 0.5));
+
+	Body3DSW *bodies[STACK_BODY_COUNT];
+	for (int i = 0; i < STACK_BODY_COUNT; i++) {
+		bodies[i] = memnew(Body3DSW);
+		bodies[i]->add_shape(shape);
+		bodies[i]->set_mode(i == 0 ? PhysicsServer3D::BODY_MODE_STATIC : PhysicsServer3D::BODY_MODE_DYNAMIC);
+		bodies[i]->set_space(space);
+		bodies[i]->set_state(PhysicsServer3D::BODY_STATE_TRANSFORM, Transform3D(Basis(), Vector3(0.02 * i, 0.99 * i, 0)));
+		bodies[i]->update_inertias();
+		if (i > 0) {
+			bodies[i]->set_linear_velocity(Vector3(0.1 * i, -1.0, 0.05));
+			bodies[i]->set_angular_velocity(Vector3(0, 0.2, 0));
+		}
+	}
+
+	BodyPair3DSW *pairs[STACK_BODY_COUNT - 1];
+	for (int i = 0; i < STACK_BODY_COUNT - 1; i++) {
+		pairs[i] = memnew(BodyPair3DSW(bodies[i], 0, bodies[i + 1], 0));
+		CHECK(pairs[i]->setup(STACK_STEP));
+		CHECK(pairs[i]->pre_solve(STACK_STEP));
+	}
+
+	if (p_batched) {
+		ContactSolver3DSW solver;
+		uint32_t contact_count = 0;
+		for (int i = 0; i < STACK_BODY_COUNT - 1; i++) {
+			contact_count += pairs[i]->get_batched_contact_count();
+		}
+		solver.reserve(contact_count);
+		solver.clear();
+		for (int i = 0; i < STACK_BODY_COUNT - 1; i++) {
+			CHECK(pairs[i]->add_batched_contacts(&solver));
+		}
+		solver.load_velocities();
+		for (int iteration = 0; iteration < STACK_ITERATIONS; iteration++) {
+			solver.solve(STACK_STEP);
+		}
+		solver.store_velocities();
+		solver.finish();
+	} else {
+		for (int iteration = 0; iteration < STACK_ITERATIONS; iteration++) {
+			for (int i = 0; i < STACK_BODY_COUNT - 1; i++) {
+				pairs[i]->solve(STACK_STEP);
+			}
+		}
+	}
+
+	for (int i = 0; i < STACK_BODY_COUNT; i++) {
+		r_linear_velocities[i] = bodies[i]->get_linear_velocity();
+		r_angular_velocities[i] = bodies[i]->get_angular_velocity();
+	}
+
+	for (int i = 0; i < STACK_BODY_COUNT - 1; i++) {
+		memdelete(pairs[i]);
+	}
+	for (int i = 0; i < STACK_BODY_COUNT; i++) {
+		bodies[i]->set_space(nullptr);
+		memdelete(bodies[i]);
+	}
+	memdelete(shape);
+	memdelete(space);
+
+	server->finish();
+	memdelete(server);
+}
+
+TEST_CASE("[ContactSolver3DSW] Solve a stack of boxes like the body pairs") {
+	Vector3 linear_velocities[2][STACK_BODY_COUNT];
+	Vector3 angular_velocities[2][STACK_BODY_COUNT];
+	_solve_stack_3d(false, linear_velocities[0], angular_velocities[0]);
+	_solve_stack_3d(true, linear_velocities[1], angular_velocities[1]);
+
+	for (int i = 1; i < STACK_BODY_COUNT; i++) {
+		INFO("Box ", i);
+		CHECK_MESSAGE(linear_velocities[0][i].y > -0.5, "The contacts should slow the boxes down.");
+		CHECK(linear_velocities[1][i].distance_to(linear_velocities[0][i]) < STACK_TOLERANCE);
+		CHECK(angular_velocities[1][i].distance_to(angular_velocities[0][i]) < STACK_TOLERANCE);
+	}
+}
+
+static void _solve_stack_2d(bool p_batched, Vector2 *r_linear_velocities, real_t *r_angular_velocities) {
+	// The bodies register their shape updates with the server.
+	PhysicsServer2DSW *server = memnew(PhysicsServer2DSW);
+	server->init();
+
+	Space2DSW *space = memnew(Space2DSW);
+	RectangleShape2DSW *shape = memnew(RectangleShape2DSW);
+	shape->set_data(Vector2(0.5, 0.5));
+
+	Body2DSW *bodies[STACK_BODY_COUNT];
+	for (int i = 0; i < STACK_BODY_COUNT; i++) {
+		bodies[i] = memnew(Body2DSW);
+		bodies[i]->add_shape(shape);
+		bodies[i]->set_mode(i == 0 ? PhysicsServer2D::BODY_MODE_STATIC : PhysicsServer2D::BODY_MODE_DYNAMIC);
+		bodies[i]->set_space(space);
+		// The y axis points down in 2D.
+		bodies[i]->set_state(PhysicsServer2D::BODY_STATE_TRANSFORM, Transform2D(0, Vector2(0.02 * i, -0.99 * i)));
+		bodies[i]->update_inertias();
+		if (i > 0) {
+			bodies[i]->set_linear_velocity(Vector2(0.1 * i, 1.0));
+			bodies[i]->set_angular_velocity(0.2);
+		}
+	}
+
+	BodyPair2DSW *pairs[STACK_BODY_COUNT - 1];
+	for (int i = 0; i < STACK_BODY_COUNT - 1; i++) {
+		pairs[i] = memnew(BodyPair2DSW(bodies[i], 0, bodies[i + 1], 0));
+		CHECK(pairs[i]->setup(STACK_STEP));
+		CHECK(pairs[i]->pre_solve(STACK_STEP));
+	}
+
+	if (p_batched) {
+		ContactSolver2DSW solver;
+		uint32_t contact_count = 0;
+		for (int i = 0; i < STACK_BODY_COUNT - 1; i++) {
+			contact_count += pairs[i]->get_batched_contact_count();
+		}
+		solver.reserve(contact_count);
+		solver.clear();
+		for (int i = 0; i < STACK_BODY_COUNT - 1; i++) {
+			CHECK(pairs[i]->add_batched_contacts(&solver));
+		}
+		solver.load_velocities();
+		for (int iteration = 0; iteration < STACK_ITERATIONS; iteration++) {
+			solver.solve();
+		}
+		solver.store_velocities();
+		solver.finish();
+	} else {
+		for (int iteration = 0; iteration < STACK_ITERATIONS; iteration++) {
+			for (int i = 0; i < STACK_BODY_COUNT - 1; i++) {
+				pairs[i]->solve(STACK_STEP);
+			}
+		}
+	}
+
+	for (int i = 0; i < STACK_BODY_COUNT; i++) {
+		r_linear_velocities[i] = bodies[i]->get_linear_velocity();
+		r_angular_velocities[i] = bodies[i]->get_angular_velocity();
+	}
+
+	for (int i = 0; i < STACK_BODY_COUNT - 1; i++) {
+		memdelete(pairs[i]);
+	}
+	for (int i = 0; i < STACK_BODY_COUNT; i++) {
+		bodies[i]->set_space(nullptr);
+		memdelete(bodies[i]);
+	}
+	memdelete(shape);
+	memdelete(space);
+
+	server->finish();
+	memdelete(server);
+}
+
+TEST_CASE("[ContactSolver2DSW] Solve a stack of boxes like the body pairs") {
+	Vector2 linear_velocities[2][STACK_BODY_COUNT];
+	real_t angular_velocities[2][STACK_BODY_COUNT];
+	_solve_stack_2d(false, linear_velocities[0], angular_velocities[0]);
+	_solve_stack_2d(true, linear_velocities[1], angular_velocities[1]);
+
+	for (int i = 1; i < STACK_BODY_COUNT; i++) {
+		INFO("Box ", i);
+		CHECK_MESSAGE(linear_velocities[0][i].y < 0.5, "The contacts should slow the boxes down.");
+		CHECK(linear_velocities[1][i].distance_to(linear_velocities[0][i]) < STACK_TOLERANCE);
+		CHECK(Math::abs(angular_velocities[1][i] - angular_velocities[0][i]) < STACK_TOLERANCE);
+	}
+}
+
+} // namespace TestContactSolver
+
+#endif // TEST_CONTACT_SOLVER_H
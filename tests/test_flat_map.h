@@ -0,0 +1,167 @@
+/*************************************************************************/
+/*  test_flat_map.h                                                      */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_FLAT_MAP_H
+#define TEST_FLAT_MAP_H
+
+#include "core/os/os.h"
+#include "core/templates/flat_map.h"
+#include "core/templates/flat_set.h"
+#include "core/templates/map.h"
+#include "core/templates/set.h"
+
+#include "tests/test_macros.h"
+
+namespace TestFlatMap {
+
+TEST_CASE("[FlatSet] Insert, erase and iterate in order") {
+	FlatSet<int, 2> set;
+	CHECK(set.insert(5));
+	CHECK(set.insert(1));
+	CHECK(set.insert(3));
+	CHECK_FALSE(set.insert(3));
+	// Past the inline capacity.
+	CHECK(set.insert(4));
+	CHECK(set.insert(2));
+	CHECK(set.size() == 5);
+
+	int expected = 1;
+	for (int value : set) {
+		CHECK(value == expected);
+		expected++;
+	}
+
+	CHECK(set.has(4));
+	CHECK(set.find(4) == 3);
+	CHECK(set.erase(4));
+	CHECK_FALSE(set.erase(4));
+	CHECK_FALSE(set.has(4));
+	CHECK(set.find(4) == -1);
+	CHECK(set[3] == 5);
+
+	set.reset();
+	CHECK(set.is_empty());
+	CHECK(set.insert(7));
+	CHECK(set[0] == 7);
+}
+
+TEST_CASE("[FlatMap] Insert, erase and look up") {
+	FlatMap<int, String, 2> map;
+	map.insert(3, "three");
+	map[1] = "one";
+	map.insert(2, "two");
+	map.insert(3, "THREE");
+	map[4] = "four";
+	CHECK(map.size() == 4);
+
+	CHECK(map.getk(0) == 1);
+	CHECK(map.getv(2) == "THREE");
+	CHECK(map[4] == "four");
+	CHECK(map.getptr(5) == nullptr);
+	CHECK(*map.getptr(2) == "two");
+
+	int key = 1;
+	for (const FlatMap<int, String, 2>::Pair &E : map) {
+		CHECK(E.key == key);
+		key++;
+	}
+
+	CHECK(map.erase(1));
+	CHECK_FALSE(map.erase(1));
+	CHECK(map.find(1) == -1);
+	CHECK(map.find(4) == 2);
+
+	const FlatMap<int, String, 2> copy = map;
+	map.clear();
+	CHECK(map.is_empty());
+	CHECK(copy.size() == 3);
+	CHECK(copy[2] == "two");
+}
+
+// Adds and removes the links of a few nodes, then walks them, like the bodies of
+// a physics space do with their constraints every step.
+template <class T>
+static uint64_t benchmark_map(int p_links) {
+	const int node_count = 1000;
+	T *maps = memnew_arr(T, node_count);
+	int sum = 0;
+
+	const uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	for (int round = 0; round < 100; round++) {
+		for (int i = 0; i < node_count; i++) {
+			for (int j = 0; j < p_links; j++) {
+				maps[i][(void *)(intptr_t)((i * 7919 + j * 104729) % 65536)] = j;
+			}
+		}
+		for (int walk = 0; walk < 10; walk++) {
+			for (int i = 0; i < node_count; i++) {
+				sum += T::walk(maps[i]);
+			}
+		}
+		for (int i = 0; i < node_count; i++) {
+			maps[i].clear();
+		}
+	}
+	const uint64_t usec = OS::get_singleton()->get_ticks_usec() - begin;
+
+	memdelete_arr(maps);
+	CHECK(sum != 0);
+	return usec;
+}
+
+struct TreeMap : public Map<void *, int> {
+	static int walk(const TreeMap &p_map) {
+		int sum = 0;
+		for (const Map<void *, int>::Element *E = p_map.front(); E; E = E->next()) {
+			sum += E->get();
+		}
+		return sum + 1;
+	}
+};
+
+struct SortedArrayMap : public FlatMap<void *, int> {
+	static int walk(const SortedArrayMap &p_map) {
+		int sum = 0;
+		for (const FlatMap<void *, int>::Pair &E : p_map) {
+			sum += E.value;
+		}
+		return sum + 1;
+	}
+};
+
+TEST_CASE_PENDING("[FlatMap] Benchmark against Map") {
+	for (int links = 1; links <= 16; links *= 2) {
+		MESSAGE(vformat("%d links: Map %d usec, FlatMap %d usec.", links, benchmark_map<TreeMap>(links), benchmark_map<SortedArrayMap>(links)));
+	}
+}
+
+} // namespace TestFlatMap
+
+#endif // TEST_FLAT_MAP_H
@@ -0,0 +1,312 @@
+/*************************************************************************/
+/*  test_hash_map.h                                                      */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_HASH_MAP_H
+#define TEST_HASH_MAP_H
+
+#include "core/math/random_number_generator.h"
+#include "core/os/os.h"
+#include "core/string/string_name.h"
+#include "core/templates/hash_map.h"
+#include "core/templates/map.h"
+
+#include "tests/test_macros.h"
+
+namespace TestHashMap {
+
+TEST_CASE("[HashMap] Insert, overwrite and erase") {
+	HashMap<int, int> map;
+	map.set(42, 84);
+	map[7] = 14;
+	map.set(42, 1234);
+
+	CHECK(map.size() == 2);
+	CHECK(map[42] == 1234);
+	CHECK(map.get(7) == 14);
+	CHECK(map.has(7));
+	CHECK(map.getptr(8) == nullptr);
+
+	CHECK(map.erase(42));
+	CHECK_FALSE(map.erase(42));
+	CHECK_FALSE(map.has(42));
+	CHECK(map.size() == 1);
+
+	CHECK(map.erase(7));
+	CHECK(map.is_empty());
+	CHECK(map.next(nullptr) == nullptr);
+}
+
+TEST_CASE("[HashMap] Iterate in insertion order") {
+	HashMap<int, int> map;
+	for (int i = 0; i < 100; i++) {
+		map[i * 7919] = i;
+	}
+	for (int i = 0; i < 100; i += 3) {
+		map.erase(i * 7919);
+	}
+
+	int expected = 1;
+	const int *key = nullptr;
+	while ((key = map.next(key))) {
+		CHECK(*key == expected * 7919);
+		CHECK(map[*key] == expected);
+		expected += expected % 3 == 2 ? 2 : 1;
+	}
+	CHECK(expected == 100);
+
+	List<int> keys;
+	map.get_key_list(&keys);
+	CHECK(keys.size() == (int)map.size());
+	CHECK(keys.front()->get() == 7919);
+}
+
+TEST_CASE("[HashMap] Keep values in place when the table grows") {
+	HashMap<int, int> map;
+	int *first = &map[0];
+	*first = 42;
+	for (int i = 1; i < 1000; i++) {
+		map[i] = i;
+	}
+
+	CHECK(first == map.getptr(0));
+	CHECK(*first == 42);
+}
+
+TEST_CASE("[HashMap] Copy") {
+	HashMap<int, int> map;
+	for (int i = 0; i < 50; i++) {
+		map[i] = i * 2;
+	}
+	HashMap<int, int> copy = map;
+	map.clear();
+
+	CHECK(copy.size() == 50);
+	for (int i = 0; i < 50; i++) {
+		CHECK(copy[i] == i * 2);
+	}
+	CHECK(*copy.next(nullptr) == 0);
+}
+
+TEST_CASE("[HashMap] Look up with another key type") {
+	HashMap<StringName, int> map;
+	map[StringName("position")] = 1;
+	map[StringName("rotation")] = 2;
+
+	const String name = "rotation";
+	const int *value = map.getptr_as(name);
+	REQUIRE(value != nullptr);
+	CHECK(*value == 2);
+	CHECK(map.getptr_as(String("scale")) == nullptr);
+}
+
+TEST_CASE("[HashMap] Match Map on random operations") {
+	Ref<RandomNumberGenerator> rng = memnew(RandomNumberGenerator);
+	rng->set_seed(0);
+
+	HashMap<int, int> map;
+	Map<int, int> expected;
+	for (int i = 0; i < 20000; i++) {
+		const int key = rng->randi_range(0, 500);
+		switch (rng->randi_range(0, 2)) {
+			case 0: {
+				map[key] = i;
+				expected[key] = i;
+			} break;
+			case 1: {
+				CHECK(map.erase(key) == expected.erase(key));
+			} break;
+			case 2: {
+				const int *value = map.getptr(key);
+				const Map<int, int>::Element *E = expected.find(key);
+				REQUIRE((value != nullptr) == (E != nullptr));
+				if (value) {
+					CHECK(*value == E->get());
+				}
+			} break;
+		}
+		REQUIRE(map.size() == (unsigned int)expected.size());
+	}
+}
+
+// The chained HashMap used before open addressing, only what the benchmark needs.
+template <class TKey, class TData, class Hasher = HashMapHasherDefault>
+class _ChainedHashMap {
+	static const int MIN_HASH_TABLE_POWER = 3;
+	static const int RELATIONSHIP = 8;
+
+	struct Element {
+		uint32_t hash = 0;
+		Element *next = nullptr;
+		TKey key;
+		TData data;
+	};
+
+	Element **hash_table = nullptr;
+	int hash_table_power = 0;
+	int elements = 0;
+
+	void _resize_hash_table(int p_power) {
+		Element **new_hash_table = memnew_arr(Element *, 1 << p_power);
+		for (int i = 0; i < (1 << p_power); i++) {
+			new_hash_table[i] = nullptr;
+		}
+		for (int i = 0; hash_table && i < (1 << hash_table_power); i++) {
+			while (hash_table[i]) {
+				Element *e = hash_table[i];
+				hash_table[i] = e->next;
+				const uint32_t pos = e->hash & ((1 << p_power) - 1);
+				e->next = new_hash_table[pos];
+				new_hash_table[pos] = e;
+			}
+		}
+		if (hash_table) {
+			memdelete_arr(hash_table);
+		}
+		hash_table = new_hash_table;
+		hash_table_power = p_power;
+	}
+
+	void _check_hash_table() {
+		if (elements > (1 << hash_table_power) * RELATIONSHIP) {
+			_resize_hash_table(hash_table_power + 1);
+		} else if (hash_table_power > MIN_HASH_TABLE_POWER && elements < (1 << (hash_table_power - 1)) * RELATIONSHIP) {
+			_resize_hash_table(hash_table_power - 1);
+		}
+	}
+
+public:
+	TData &operator[](const TKey &p_key) {
+		if (!hash_table) {
+			_resize_hash_table(MIN_HASH_TABLE_POWER);
+		}
+		const uint32_t hash = Hasher::hash(p_key);
+		const uint32_t pos = hash & ((1 << hash_table_power) - 1);
+		for (Element *e = hash_table[pos]; e; e = e->next) {
+			if (e->hash == hash && e->key == p_key) {
+				return e->data;
+			}
+		}
+		Element *e = memnew(Element);
+		e->hash = hash;
+		e->key = p_key;
+		e->next = hash_table[pos];
+		hash_table[pos] = e;
+		elements++;
+		_check_hash_table();
+		return e->data;
+	}
+
+	TData *getptr(const TKey &p_key) {
+		if (!hash_table) {
+			return nullptr;
+		}
+		const uint32_t hash = Hasher::hash(p_key);
+		for (Element *e = hash_table[hash & ((1 << hash_table_power) - 1)]; e; e = e->next) {
+			if (e->hash == hash && e->key == p_key) {
+				return &e->data;
+			}
+		}
+		return nullptr;
+	}
+
+	bool erase(const TKey &p_key) {
+		if (!hash_table) {
+			return false;
+		}
+		const uint32_t hash = Hasher::hash(p_key);
+		Element **e = &hash_table[hash & ((1 << hash_table_power) - 1)];
+		for (; *e; e = &(*e)->next) {
+			if ((*e)->hash == hash && (*e)->key == p_key) {
+				Element *erased = *e;
+				*e = erased->next;
+				memdelete(erased);
+				elements--;
+				_check_hash_table();
+				return true;
+			}
+		}
+		return false;
+	}
+
+	~_ChainedHashMap() {
+		for (int i = 0; hash_table && i < (1 << hash_table_power); i++) {
+			while (hash_table[i]) {
+				Element *e = hash_table[i];
+				hash_table[i] = e->next;
+				memdelete(e);
+			}
+		}
+		if (hash_table) {
+			memdelete_arr(hash_table);
+		}
+	}
+};
+
+template <class M>
+static uint64_t _benchmark_map(int p_count) {
+	const uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	M map;
+	int64_t sum = 0;
+	for (int i = 0; i < p_count; i++) {
+		map[i * 2654435761u] = i;
+	}
+	// Look up every key and as many missing ones, in an order unrelated to the insertion order.
+	for (int r = 0; r < 10; r++) {
+		for (int i = 0; i < p_count * 2; i++) {
+			const uint32_t key = uint32_t(i * 40503ull % (p_count * 2));
+			const int *value = map.getptr(key * 2654435761u);
+			if (value) {
+				sum += *value;
+			}
+		}
+	}
+	for (int i = 0; i < p_count; i += 2) {
+		map.erase(i * 2654435761u);
+	}
+	CHECK(sum == int64_t(p_count - 1) * p_count * 5);
+	return OS::get_singleton()->get_ticks_usec() - begin;
+}
+
+TEST_CASE_PENDING("[HashMap] Benchmark insertion, lookup and erasure") {
+	for (int count = 16; count <= 1000000; count *= 25) {
+		uint64_t hash_map_usec = 0;
+		uint64_t chained_usec = 0;
+		const int repeats = 4000000 / count;
+		for (int i = 0; i < repeats; i++) {
+			hash_map_usec += _benchmark_map<HashMap<uint32_t, int>>(count);
+			chained_usec += _benchmark_map<_ChainedHashMap<uint32_t, int>>(count);
+		}
+		MESSAGE(vformat("%d elements, %d times: HashMap %d usec, chained HashMap %d usec.", count, repeats, hash_map_usec, chained_usec));
+	}
+}
+
+} // namespace TestHashMap
+
+#endif // TEST_HASH_MAP_H
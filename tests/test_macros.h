@@ -39,6 +39,8 @@
 #include "thirdparty/doctest/doctest.h"
 
 // The test is skipped with this, run pending tests with `--test --no-skip`.
+// Benchmarks are pending tests with `Benchmark` in their name, which print their timings with `MESSAGE()`.
+// Run them with `--test --no-skip --test-case="*Benchmark*"`.
 #define TEST_CASE_PENDING(name) TEST_CASE(name *doctest::skip())
 
 // The test case is marked as failed, but does not fail the entire test run.
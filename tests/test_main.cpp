@@ -40,15 +40,18 @@
 #include "test_color.h"
 #include "test_command_queue.h"
 #include "test_config_file.h"
+#include "test_contact_solver.h"
 #include "test_crypto.h"
 #include "test_curve.h"
 #include "test_dictionary.h"
 #include "test_expression.h"
 #include "test_file_access.h"
+#include "test_flat_map.h"
 #include "test_geometry_2d.h"
 #include "test_geometry_3d.h"
 #include "test_gradient.h"
 #include "test_gui.h"
+#include "test_hash_map.h"
 #include "test_hashing_context.h"
 #include "test_image.h"
 #include "test_json.h"
@@ -67,18 +70,25 @@
 #include "test_pck_packer.h"
 #include "test_physics_2d.h"
 #include "test_physics_3d.h"
+#include "test_physics_direct_space_state_3d.h"
 #include "test_random_number_generator.h"
 #include "test_rect2.h"
 #include "test_render.h"
+#include "test_renderer_canvas_cull.h"
 #include "test_resource.h"
+#include "test_scene_tree.h"
 #include "test_shader_lang.h"
+#include "test_small_object_allocator.h"
 #include "test_string.h"
+#include "test_string_name.h"
 #include "test_text_server.h"
 #include "test_time.h"
+#include "test_transform_hierarchy_3d.h"
 #include "test_translation.h"
 #include "test_validate_testing.h"
 #include "test_variant.h"
 #include "test_vector.h"
+#include "test_worker_thread_pool.h"
 #include "test_xml_parser.h"
 
 #include "modules/modules_tests.gen.h"
@@ -0,0 +1,197 @@
+/*************************************************************************/
+/*  test_physics_direct_space_state_3d.h                                 */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_PHYSICS_DIRECT_SPACE_STATE_3D_H
+#define TEST_PHYSICS_DIRECT_SPACE_STATE_3D_H
+
+#include "core/math/random_pcg.h"
+#include "servers/physics_3d/physics_server_3d_sw.h"
+
+#include "tests/test_macros.h"
+
+namespace TestPhysicsDirectSpaceState3D {
+
+static const int GRID_SIZE = 8;
+static const int QUERY_COUNT = 200; // Enough for several chunks.
+
+// A server with a space holding a grid of static boxes and spheres, so the batched
+// queries can be compared to the single ones on the same space.
+struct QueryScene {
+	PhysicsServer3DSW *server = nullptr;
+	RID space;
+	RID box;
+	RID sphere;
+	Vector<RID> bodies;
+
+	PhysicsDirectSpaceState3D *get_state() const {
+		return server->space_get_direct_state(space);
+	}
+
+	QueryScene() {
+		server = memnew(PhysicsServer3DSW);
+		server->init();
+		space = server->space_create();
+
+		box = server->box_shape_create();
+		server->shape_set_data(box, Vector3(0.4, 0.4, 0.4));
+		sphere = server->sphere_shape_create();
+		server->shape_set_data(sphere, 0.3);
+
+		for (int i = 0; i < GRID_SIZE; i++) {
+			for (int j = 0; j < GRID_SIZE; j++) {
+				RID body = server->body_create();
+				server->body_set_mode(body, PhysicsServer3D::BODY_MODE_STATIC);
+				server->body_add_shape(body, (i + j) % 2 ? box : sphere);
+				server->body_set_space(body, space);
+				server->body_set_state(body, PhysicsServer3D::BODY_STATE_TRANSFORM, Transform3D(Basis(), Vector3(i * 1.5, (i * j) % 3 * 0.5, j * 1.5)));
+				bodies.push_back(body);
+			}
+		}
+	}
+
+	~QueryScene() {
+		for (int i = 0; i < bodies.size(); i++) {
+			server->free(bodies[i]);
+		}
+		server->free(box);
+		server->free(sphere);
+		server->free(space);
+		server->finish();
+		memdelete(server);
+	}
+};
+
+static Vector3 _random_point(RandomPCG &p_rng) {
+	return Vector3(p_rng.random(-1.0, GRID_SIZE * 1.5), p_rng.random(-1.0, 2.0), p_rng.random(-1.0, GRID_SIZE * 1.5));
+}
+
+TEST_CASE("[PhysicsDirectSpaceState3D] Batched rays match single rays") {
+	QueryScene scene;
+	PhysicsDirectSpaceState3D *state = scene.get_state();
+
+	RandomPCG rng(1234);
+	Vector3 from[QUERY_COUNT];
+	Vector3 to[QUERY_COUNT];
+	for (int i = 0; i < QUERY_COUNT; i++) {
+		from[i] = _random_point(rng);
+		to[i] = _random_point(rng);
+	}
+
+	PhysicsDirectSpaceState3D::RayResult results[QUERY_COUNT];
+	int hit_count = state->intersect_ray_batch(from, to, QUERY_COUNT, results);
+
+	int expected_hit_count = 0;
+	for (int i = 0; i < QUERY_COUNT; i++) {
+		PhysicsDirectSpaceState3D::RayResult expected;
+		bool hit = state->intersect_ray(from[i], to[i], expected);
+		CHECK_MESSAGE(hit == (results[i].shape >= 0), "Ray ", i, " should hit the same as the single query.");
+		if (hit) {
+			expected_hit_count++;
+			CHECK(results[i].rid == expected.rid);
+			CHECK(results[i].collider_id == expected.collider_id);
+			CHECK(results[i].position.is_equal_approx(expected.position));
+			CHECK(results[i].normal.is_equal_approx(expected.normal));
+		}
+	}
+	CHECK(hit_count == expected_hit_count);
+	CHECK_MESSAGE(expected_hit_count > 0, "Some rays should hit.");
+}
+
+TEST_CASE("[PhysicsDirectSpaceState3D] Batched shape queries match single shape queries") {
+	QueryScene scene;
+	PhysicsDirectSpaceState3D *state = scene.get_state();
+
+	const int result_max = 8;
+	RandomPCG rng(5678);
+	Transform3D xforms[QUERY_COUNT];
+	for (int i = 0; i < QUERY_COUNT; i++) {
+		xforms[i] = Transform3D(Basis(Vector3(0, 1, 0), rng.random(0.0, Math_TAU)), _random_point(rng));
+	}
+
+	PhysicsDirectSpaceState3D::ShapeResult results[QUERY_COUNT * result_max];
+	int counts[QUERY_COUNT];
+	state->intersect_shape_batch(scene.box, xforms, QUERY_COUNT, 0.0, results, result_max, counts);
+
+	int total = 0;
+	for (int i = 0; i < QUERY_COUNT; i++) {
+		PhysicsDirectSpaceState3D::ShapeResult expected[result_max];
+		int expected_count = state->intersect_shape(scene.box, xforms[i], 0.0, expected, result_max);
+		CHECK_MESSAGE(counts[i] == expected_count, "Query ", i, " should find as many shapes as the single query.");
+
+		// The order of the results is not specified, so compare them as sets.
+		Set<RID> expected_rids;
+		for (int j = 0; j < expected_count; j++) {
+			expected_rids.insert(expected[j].rid);
+		}
+		for (int j = 0; j < counts[i]; j++) {
+			CHECK(expected_rids.has(results[i * result_max + j].rid));
+		}
+		total += expected_count;
+	}
+	CHECK_MESSAGE(total > 0, "Some shapes should intersect.");
+}
+
+TEST_CASE("[PhysicsDirectSpaceState3D] Batched motions match single motions") {
+	QueryScene scene;
+	PhysicsDirectSpaceState3D *state = scene.get_state();
+
+	RandomPCG rng(91011);
+	Transform3D xforms[QUERY_COUNT];
+	Vector3 motions[QUERY_COUNT];
+	for (int i = 0; i < QUERY_COUNT; i++) {
+		xforms[i] = Transform3D(Basis(), _random_point(rng));
+		motions[i] = _random_point(rng) - xforms[i].origin;
+	}
+
+	real_t safe[QUERY_COUNT];
+	real_t unsafe[QUERY_COUNT];
+	PhysicsDirectSpaceState3D::ShapeRestInfo infos[QUERY_COUNT];
+	state->cast_motion_batch(scene.sphere, xforms, motions, QUERY_COUNT, 0.0, safe, unsafe, Set<RID>(), 0xFFFFFFFF, true, false, infos);
+
+	int blocked = 0;
+	for (int i = 0; i < QUERY_COUNT; i++) {
+		real_t expected_safe = 1.0;
+		real_t expected_unsafe = 1.0;
+		PhysicsDirectSpaceState3D::ShapeRestInfo expected_info;
+		CHECK(state->cast_motion(scene.sphere, xforms[i], motions[i], 0.0, expected_safe, expected_unsafe, Set<RID>(), 0xFFFFFFFF, true, false, &expected_info));
+		CHECK_MESSAGE(Math::is_equal_approx(safe[i], expected_safe), "Motion ", i, " should be as safe as the single query.");
+		CHECK(Math::is_equal_approx(unsafe[i], expected_unsafe));
+		if (expected_safe < 1.0) {
+			blocked++;
+			CHECK(infos[i].rid == expected_info.rid);
+			CHECK(infos[i].point.is_equal_approx(expected_info.point));
+		}
+	}
+	CHECK_MESSAGE(blocked > 0, "Some motions should be blocked.");
+}
+
+} // namespace TestPhysicsDirectSpaceState3D
+
+#endif // TEST_PHYSICS_DIRECT_SPACE_STATE_3D_H
@@ -0,0 +1,211 @@
+/*************************************************************************/
+/*  test_renderer_canvas_cull.h                                          */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_RENDERER_CANVAS_CULL_H
+#define TEST_RENDERER_CANVAS_CULL_H
+
+#include "servers/rendering/rasterizer_dummy.h"
+#include "servers/rendering/renderer_canvas_cull.h"
+#include "servers/rendering/rendering_server_globals.h"
+
+#include "tests/test_macros.h"
+
+namespace TestRendererCanvasCull {
+
+// Keeps the items in the order they are drawn.
+class RecordingCanvasRender : public RasterizerCanvasDummy {
+public:
+	LocalVector<RendererCanvasRender::Item *> items;
+
+	void canvas_render_items(RID p_to_render_target, Item *p_item_list, const Color &p_modulate, Light *p_light_list, Light *p_directional_list, const Transform2D &p_canvas_transform, RS::CanvasItemTextureFilter p_default_filter, RS::CanvasItemTextureRepeat p_default_repeat, bool p_snap_2d_vertices_to_pixel, bool &r_sdf_used) override {
+		items.clear();
+		for (Item *item = p_item_list; item; item = item->next) {
+			items.push_back(item);
+		}
+		r_sdf_used = false;
+	}
+};
+
+// A canvas with a parent item holding enough children to be culled with a BVH.
+// Child i is a 10x10 rect at (i * 20, (i * 37) % 100). Some children use another
+// z index, some are drawn behind the parent, and one copies the back buffer, which
+// is never culled.
+struct CanvasScene {
+	static const int CHILD_COUNT = 100;
+
+	RecordingCanvasRender recorder;
+	RasterizerStorageDummy storage;
+	RendererCanvasRender *previous_canvas_render = nullptr;
+	RendererStorage *previous_storage = nullptr;
+	RendererCanvasCull *canvas_cull = nullptr;
+	RID canvas;
+	RID parent;
+	Vector<RID> children;
+	Vector<RID> grandchildren;
+
+	RendererCanvasCull::Item *get_item(RID p_item) const {
+		return canvas_cull->canvas_item_owner.getornull(p_item);
+	}
+
+	RID create_item(RID p_parent, const Vector2 &p_position) {
+		RID item = canvas_cull->canvas_item_allocate();
+		canvas_cull->canvas_item_initialize(item);
+		canvas_cull->canvas_item_set_parent(item, p_parent);
+		canvas_cull->canvas_item_set_transform(item, Transform2D(0, p_position));
+		canvas_cull->canvas_item_add_rect(item, Rect2(0, 0, 10, 10), Color(1, 1, 1));
+		return item;
+	}
+
+	// Returns the items drawn when the given rect of the canvas is on screen.
+	LocalVector<RendererCanvasRender::Item *> render(const Rect2 &p_screen_rect) {
+		canvas_cull->render_canvas(RID(), canvas_cull->canvas_owner.getornull(canvas), Transform2D(0, -p_screen_rect.position), nullptr, nullptr, Rect2(Point2(), p_screen_rect.size), RS::CANVAS_ITEM_TEXTURE_FILTER_DEFAULT, RS::CANVAS_ITEM_TEXTURE_REPEAT_DEFAULT, false, false);
+		return recorder.items;
+	}
+
+	CanvasScene(bool p_sort_y) {
+		previous_canvas_render = RSG::canvas_render;
+		previous_storage = RSG::storage;
+		RSG::canvas_render = &recorder;
+		RSG::storage = &storage;
+		canvas_cull = memnew(RendererCanvasCull);
+
+		canvas = canvas_cull->canvas_allocate();
+		canvas_cull->canvas_initialize(canvas);
+		parent = create_item(canvas, Vector2(5, 5));
+		canvas_cull->canvas_item_set_sort_children_by_y(parent, p_sort_y);
+
+		for (int i = 0; i < CHILD_COUNT; i++) {
+			RID child = create_item(parent, Vector2(i * 20, (i * 37) % 100));
+			if (i % 7 == 3) {
+				canvas_cull->canvas_item_set_z_index(child, 1);
+			}
+			if (i % 11 == 5) {
+				canvas_cull->canvas_item_set_draw_behind_parent(child, true);
+			}
+			if (i == CHILD_COUNT - 1) {
+				canvas_cull->canvas_item_set_copy_to_backbuffer(child, true, Rect2());
+			}
+			// A child of its own, y-sorted with the others when both sort by y.
+			if (i % 13 == 0) {
+				canvas_cull->canvas_item_set_sort_children_by_y(child, p_sort_y);
+				grandchildren.push_back(create_item(child, Vector2(0, 30)));
+			}
+			children.push_back(child);
+		}
+	}
+
+	~CanvasScene() {
+		for (int i = 0; i < grandchildren.size(); i++) {
+			canvas_cull->free(grandchildren[i]);
+		}
+		for (int i = 0; i < children.size(); i++) {
+			canvas_cull->free(children[i]);
+		}
+		canvas_cull->free(parent);
+		canvas_cull->free(canvas);
+		memdelete(canvas_cull);
+		RSG::canvas_render = previous_canvas_render;
+		RSG::storage = previous_storage;
+	}
+};
+
+// Culling must only remove items: the items drawn when part of the canvas is on
+// screen are the ones drawn when all of it is, in the same order, minus those
+// entirely off screen.
+static void _check_culled_order(CanvasScene &p_scene, const Rect2 &p_screen_rect) {
+	const Rect2 whole_canvas(-100, -100, 4000, 400);
+	LocalVector<RendererCanvasRender::Item *> all_items = p_scene.render(whole_canvas);
+	LocalVector<RendererCanvasRender::Item *> expected;
+	for (uint32_t i = 0; i < all_items.size(); i++) {
+		const RendererCanvasRender::Item *item = all_items[i];
+		Rect2 canvas_rect = item->final_transform.xform(item->get_rect());
+		canvas_rect.position += whole_canvas.position;
+		if (item->copy_back_buffer || p_screen_rect.intersects(canvas_rect, true)) {
+			expected.push_back(all_items[i]);
+		}
+	}
+
+	LocalVector<RendererCanvasRender::Item *> items = p_scene.render(p_screen_rect);
+	CHECK(items.size() < all_items.size());
+	REQUIRE(items.size() == expected.size());
+	for (uint32_t i = 0; i < items.size(); i++) {
+		CHECK_MESSAGE(items[i] == expected[i], vformat("Item %d differs.", i));
+	}
+
+	// The higher z index is drawn last.
+	for (uint32_t i = 1; i < items.size(); i++) {
+		CHECK(items[i - 1]->z_final <= items[i]->z_final);
+	}
+}
+
+TEST_CASE("[RendererCanvasCull] Keep the draw order and z index of culled children") {
+	CanvasScene scene(false);
+	const RendererCanvasCull::Item *parent = scene.get_item(scene.parent);
+
+	_check_culled_order(scene, Rect2(0, 0, 205, 120));
+	REQUIRE(parent->children_bvh != nullptr);
+	_check_culled_order(scene, Rect2(900, 40, 300, 30));
+	_check_culled_order(scene, Rect2(1500, -50, 800, 100));
+	// Nothing but the children that are never culled.
+	_check_culled_order(scene, Rect2(0, 1000, 100, 100));
+
+	// Children drawn behind the parent come before it, the others after it.
+	LocalVector<RendererCanvasRender::Item *> items = scene.render(Rect2(0, 0, 120, 120));
+	const RendererCanvasRender::Item *behind = scene.get_item(scene.children[5]);
+	CHECK(behind->behind);
+	int64_t parent_index = items.find((RendererCanvasRender::Item *)parent);
+	int64_t behind_index = items.find((RendererCanvasRender::Item *)behind);
+	REQUIRE(parent_index >= 0);
+	REQUIRE(behind_index >= 0);
+	CHECK(behind_index < parent_index);
+}
+
+TEST_CASE("[RendererCanvasCull] Keep the y-sort order and z index of culled children") {
+	CanvasScene scene(true);
+	const RendererCanvasCull::Item *parent = scene.get_item(scene.parent);
+
+	_check_culled_order(scene, Rect2(0, 0, 205, 120));
+	REQUIRE(parent->children_bvh != nullptr);
+	_check_culled_order(scene, Rect2(900, 40, 300, 30));
+	_check_culled_order(scene, Rect2(1500, -50, 800, 100));
+	_check_culled_order(scene, Rect2(0, 1000, 100, 100));
+
+	// Within a z index, the items are sorted by their position.
+	LocalVector<RendererCanvasRender::Item *> items = scene.render(Rect2(0, 0, 1000, 200));
+	for (uint32_t i = 1; i < items.size(); i++) {
+		if (items[i - 1]->z_final == items[i]->z_final && !items[i]->copy_back_buffer) {
+			CHECK(items[i - 1]->final_transform.get_origin().y <= items[i]->final_transform.get_origin().y);
+		}
+	}
+}
+
+} // namespace TestRendererCanvasCull
+
+#endif // TEST_RENDERER_CANVAS_CULL_H
@@ -0,0 +1,237 @@
+/*************************************************************************/
+/*  test_scene_tree.h                                                    */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_SCENE_TREE_H
+#define TEST_SCENE_TREE_H
+
+#include "scene/main/node.h"
+#include "scene/main/scene_tree.h"
+
+#include "tests/test_macros.h"
+
+namespace TestSceneTree {
+
+TEST_CASE("[SceneTree] Partition nodes by process thread group") {
+	Node *root = memnew(Node);
+	Node *a = memnew(Node);
+	a->set_process_thread_group(Node::PROCESS_THREAD_GROUP_SUB_THREAD);
+	root->add_child(a);
+	Node *a1 = memnew(Node);
+	a->add_child(a1);
+	Node *a2 = memnew(Node);
+	a->add_child(a2);
+	Node *on_main = memnew(Node);
+	a->add_child(on_main);
+	on_main->set_process_thread_group(Node::PROCESS_THREAD_GROUP_MAIN_THREAD);
+	Node *b = memnew(Node);
+	root->add_child(b);
+	Node *b1 = memnew(Node);
+	b->add_child(b1);
+	b->set_process_thread_group(Node::PROCESS_THREAD_GROUP_SUB_THREAD);
+
+	CHECK(root->get_process_thread_group_owner() == nullptr);
+	CHECK(a1->get_process_thread_group_owner() == a);
+	CHECK(on_main->get_process_thread_group_owner() == nullptr);
+	CHECK_MESSAGE(b1->get_process_thread_group_owner() == b, "Children should follow the group set on their parent.");
+
+	// Sorted by process priority, with a node removed while notifying left as null.
+	Node *nodes[] = { b1, a2, root, nullptr, a, on_main, b, a1 };
+	LocalVector<SceneTree::ProcessThreadGroup> groups;
+	HashMap<ObjectID, uint32_t> indices;
+	REQUIRE(SceneTree::partition_process_thread_groups(nodes, 8, groups, indices) == 2);
+
+	CHECK(groups[0].owner == b);
+	REQUIRE(groups[0].nodes.size() == 2);
+	CHECK(groups[0].nodes[0] == b1);
+	CHECK(groups[0].nodes[1] == b);
+
+	CHECK(groups[1].owner == a);
+	REQUIRE(groups[1].nodes.size() == 3);
+	CHECK_MESSAGE(groups[1].nodes[0] == a2, "Nodes should keep their order within their group.");
+	CHECK(groups[1].nodes[1] == a);
+	CHECK(groups[1].nodes[2] == a1);
+
+	// The groups are reused for the next notification.
+	Node *fewer[] = { a1, root };
+	REQUIRE(SceneTree::partition_process_thread_groups(fewer, 2, groups, indices) == 1);
+	CHECK(groups[0].owner == a);
+	REQUIRE(groups[0].nodes.size() == 1);
+	CHECK(groups[0].nodes[0] == a1);
+
+	memdelete(root);
+}
+
+TEST_CASE("[SceneTree] Nested process thread groups are merged") {
+	Node *root = memnew(Node);
+	Node *outer = memnew(Node);
+	outer->set_process_thread_group(Node::PROCESS_THREAD_GROUP_SUB_THREAD);
+	root->add_child(outer);
+	Node *on_main = memnew(Node);
+	on_main->set_process_thread_group(Node::PROCESS_THREAD_GROUP_MAIN_THREAD);
+	outer->add_child(on_main);
+	Node *inner = memnew(Node);
+	inner->set_process_thread_group(Node::PROCESS_THREAD_GROUP_SUB_THREAD);
+	on_main->add_child(inner);
+	Node *leaf = memnew(Node);
+	inner->add_child(leaf);
+
+	CHECK(outer->get_process_thread_group_owner() == outer);
+	CHECK(on_main->get_process_thread_group_owner() == nullptr);
+	CHECK_MESSAGE(inner->get_process_thread_group_owner() == outer, "A group below another one should be processed with it.");
+	CHECK(leaf->get_process_thread_group_owner() == outer);
+
+	outer->set_process_thread_group(Node::PROCESS_THREAD_GROUP_INHERIT);
+	CHECK(outer->get_process_thread_group_owner() == nullptr);
+	CHECK_MESSAGE(inner->get_process_thread_group_owner() == inner, "Without an outer group, the group should be on its own.");
+	CHECK(leaf->get_process_thread_group_owner() == inner);
+
+	outer->set_process_thread_group(Node::PROCESS_THREAD_GROUP_SUB_THREAD);
+	CHECK(inner->get_process_thread_group_owner() == outer);
+	CHECK(leaf->get_process_thread_group_owner() == outer);
+
+	on_main->remove_child(inner);
+	CHECK_MESSAGE(inner->get_process_thread_group_owner() == inner, "A group moved out of another one should be on its own.");
+	CHECK(leaf->get_process_thread_group_owner() == inner);
+
+	root->add_child(inner);
+	CHECK(inner->get_process_thread_group_owner() == inner);
+	Node *nodes[] = { leaf, outer, inner };
+	LocalVector<SceneTree::ProcessThreadGroup> groups;
+	HashMap<ObjectID, uint32_t> indices;
+	CHECK(SceneTree::partition_process_thread_groups(nodes, 3, groups, indices) == 2);
+
+	inner->get_parent()->remove_child(inner);
+	outer->add_child(inner);
+	CHECK(inner->get_process_thread_group_owner() == outer);
+	CHECK(leaf->get_process_thread_group_owner() == outer);
+	CHECK(SceneTree::partition_process_thread_groups(nodes, 3, groups, indices) == 1);
+	CHECK(groups[0].nodes.size() == 3);
+
+	memdelete(root);
+}
+
+// Groups sorted by priority only compare the nodes' priorities, so they work outside of a tree.
+static Node *_create_node_with_priority(int p_priority) {
+	Node *node = memnew(Node);
+	node->set_process_priority(p_priority);
+	return node;
+}
+
+TEST_CASE("[SceneTree] Insert nodes in sorted groups") {
+	Node *nodes[6];
+	for (int i = 0; i < 6; i++) {
+		nodes[i] = _create_node_with_priority(i * 10);
+	}
+
+	SceneTree::Group group;
+	CHECK(group.add(nodes[4]));
+	CHECK(group.add(nodes[1]));
+	CHECK(group.changed);
+	group.update_order(true);
+	CHECK_FALSE(group.changed);
+	CHECK(group.sorted_by_priority);
+
+	CHECK(group.add(nodes[2]));
+	CHECK(group.add(nodes[0]));
+	CHECK(group.add(nodes[5]));
+	CHECK(group.add(nodes[3]));
+	CHECK_MESSAGE(!group.changed, "Nodes should be inserted at their place in a sorted group.");
+	REQUIRE(group.nodes.size() == 6);
+	for (int i = 0; i < 6; i++) {
+		CHECK(group.nodes[i] == nodes[i]);
+	}
+
+	CHECK_FALSE_MESSAGE(group.add(nodes[3]), "A node should only be added once.");
+	CHECK(group.nodes.size() == 6);
+
+	CHECK(group.remove(nodes[2]));
+	CHECK_FALSE(group.remove(nodes[2]));
+	REQUIRE(group.nodes.size() == 5);
+	CHECK(group.nodes[2] == nodes[3]);
+
+	for (int i = 0; i < 6; i++) {
+		memdelete(nodes[i]);
+	}
+}
+
+TEST_CASE("[SceneTree] Leave tombstones in groups while iterating") {
+	Node *nodes[4];
+	for (int i = 0; i < 4; i++) {
+		nodes[i] = _create_node_with_priority(i * 10);
+	}
+
+	SceneTree::Group group;
+	group.add(nodes[1]);
+	group.add(nodes[2]);
+	group.add(nodes[3]);
+	group.update_order(true);
+
+	group.begin_iteration();
+	group.begin_iteration();
+	CHECK(group.remove(nodes[2]));
+	REQUIRE_MESSAGE(group.nodes.size() == 3, "Removing a node while iterating should keep the indices.");
+	CHECK(group.nodes[1] == nullptr);
+	CHECK(group.has_tombstones);
+
+	group.add(nodes[0]);
+	REQUIRE(group.nodes.size() == 4);
+	CHECK_MESSAGE(group.nodes[3] == nodes[0], "Nodes added while iterating should be appended.");
+	group.update_order(true);
+	CHECK_MESSAGE(group.changed, "The group shouldn't be sorted while iterating.");
+	CHECK(group.nodes[3] == nodes[0]);
+
+	group.end_iteration();
+	CHECK(group.iterating == 1);
+	CHECK_MESSAGE(group.nodes.size() == 4, "Tombstones should stay until the last loop is done.");
+
+	group.end_iteration();
+	CHECK(group.iterating == 0);
+	CHECK_FALSE(group.has_tombstones);
+	REQUIRE(group.nodes.size() == 3);
+	CHECK(group.nodes[0] == nodes[1]);
+	CHECK(group.nodes[1] == nodes[3]);
+	CHECK(group.nodes[2] == nodes[0]);
+
+	group.update_order(true);
+	CHECK(group.nodes[0] == nodes[0]);
+	CHECK(group.nodes[1] == nodes[1]);
+	CHECK(group.nodes[2] == nodes[3]);
+
+	CHECK(group.remove(nodes[1]));
+	CHECK_MESSAGE(group.nodes.size() == 2, "Nodes should be removed right away when not iterating.");
+
+	for (int i = 0; i < 4; i++) {
+		memdelete(nodes[i]);
+	}
+}
+
+} // namespace TestSceneTree
+
+#endif // TEST_SCENE_TREE_H
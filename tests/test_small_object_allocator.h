@@ -0,0 +1,184 @@
+/*************************************************************************/
+/*  test_small_object_allocator.h                                        */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_SMALL_OBJECT_ALLOCATOR_H
+#define TEST_SMALL_OBJECT_ALLOCATOR_H
+
+#include "core/os/os.h"
+#include "core/os/small_object_allocator.h"
+#include "core/os/thread.h"
+#include "core/templates/local_vector.h"
+
+#include "tests/test_macros.h"
+
+namespace TestSmallObjectAllocator {
+
+TEST_CASE("[SmallObjectAllocator] Allocate blocks of every size") {
+	LocalVector<uint8_t *> blocks;
+	for (int size = 0; size <= SmallObjectAllocator::MAX_SMALL_SIZE; size++) {
+		uint8_t *block = (uint8_t *)SmallObjectAllocator::alloc(size);
+		REQUIRE(block != nullptr);
+		CHECK(((uintptr_t)block & 15) == 0);
+		CHECK(SmallObjectAllocator::owns(block));
+		memset(block, size & 0xFF, size);
+		blocks.push_back(block);
+	}
+
+	for (int size = 0; size <= SmallObjectAllocator::MAX_SMALL_SIZE; size++) {
+		bool intact = true;
+		for (int i = 0; i < size; i++) {
+			intact = intact && blocks[size][i] == (size & 0xFF);
+		}
+		CHECK_MESSAGE(intact, vformat("Block of %d bytes was overwritten.", size));
+		SmallObjectAllocator::free(blocks[size]);
+	}
+
+	void *large = SmallObjectAllocator::alloc(SmallObjectAllocator::MAX_SMALL_SIZE + 1);
+	CHECK_FALSE(SmallObjectAllocator::owns(large));
+	SmallObjectAllocator::free(large);
+}
+
+TEST_CASE("[SmallObjectAllocator] Reallocate blocks") {
+	uint8_t *block = (uint8_t *)SmallObjectAllocator::alloc(20);
+	for (int i = 0; i < 20; i++) {
+		block[i] = i;
+	}
+
+	// Same size class.
+	CHECK(SmallObjectAllocator::realloc(block, 30) == block);
+
+	block = (uint8_t *)SmallObjectAllocator::realloc(block, 200);
+	CHECK(SmallObjectAllocator::owns(block));
+	block = (uint8_t *)SmallObjectAllocator::realloc(block, 4000);
+	CHECK_FALSE(SmallObjectAllocator::owns(block));
+	block = (uint8_t *)SmallObjectAllocator::realloc(block, 10);
+	for (int i = 0; i < 10; i++) {
+		CHECK(block[i] == i);
+	}
+
+	CHECK(SmallObjectAllocator::realloc(block, 0) == nullptr);
+}
+
+TEST_CASE("[SmallObjectAllocator] Count bytes per size class") {
+	// Reserved first, the engine allocations also go through the allocator when it's enabled.
+	LocalVector<void *> blocks;
+	blocks.reserve(10);
+
+	SmallObjectAllocator::Stats before;
+	SmallObjectAllocator::get_stats(before);
+
+	for (int i = 0; i < 10; i++) {
+		blocks.push_back(SmallObjectAllocator::alloc(100));
+	}
+
+	SmallObjectAllocator::Stats after;
+	SmallObjectAllocator::get_stats(after);
+	// 100 bytes are in the 112 bytes class.
+	CHECK(SmallObjectAllocator::get_size_class_size(6) == 112);
+	CHECK(after.bytes[6] - before.bytes[6] == 10 * 112);
+	CHECK(after.cache_hits + after.cache_misses - before.cache_hits - before.cache_misses == 10);
+
+	for (uint32_t i = 0; i < blocks.size(); i++) {
+		SmallObjectAllocator::free(blocks[i]);
+	}
+	SmallObjectAllocator::get_stats(after);
+	CHECK(after.bytes[6] == before.bytes[6]);
+}
+
+static void allocate_blocks(void *p_userdata) {
+	LocalVector<void *> &blocks = *(LocalVector<void *> *)p_userdata;
+	for (uint32_t i = 0; i < blocks.size(); i++) {
+		blocks[i] = SmallObjectAllocator::alloc(16 + i % 200);
+		memset(blocks[i], 0xAB, 16);
+	}
+}
+
+TEST_CASE("[SmallObjectAllocator] Free blocks allocated by another thread") {
+	// Makes sure this thread has a cache, which counts its remote frees.
+	SmallObjectAllocator::free(SmallObjectAllocator::alloc(16));
+
+	LocalVector<void *> blocks;
+	blocks.resize(1000);
+	Thread thread;
+	thread.start(allocate_blocks, &blocks);
+	thread.wait_to_finish();
+
+	SmallObjectAllocator::Stats before;
+	SmallObjectAllocator::get_stats(before);
+
+	for (uint32_t i = 0; i < blocks.size(); i++) {
+		CHECK(SmallObjectAllocator::owns(blocks[i]));
+		CHECK(*(uint8_t *)blocks[i] == 0xAB);
+		SmallObjectAllocator::free(blocks[i]);
+	}
+
+	SmallObjectAllocator::Stats after;
+	SmallObjectAllocator::get_stats(after);
+	CHECK(after.remote_frees - before.remote_frees == blocks.size());
+
+	// The exited thread's cache is reused, along with the freed blocks.
+	thread.start(allocate_blocks, &blocks);
+	thread.wait_to_finish();
+	for (uint32_t i = 0; i < blocks.size(); i++) {
+		SmallObjectAllocator::free(blocks[i]);
+	}
+}
+
+template <class A>
+static uint64_t benchmark_allocator(int p_rounds) {
+	LocalVector<void *> blocks;
+	blocks.resize(1000);
+	const uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	for (int r = 0; r < p_rounds; r++) {
+		for (uint32_t i = 0; i < blocks.size(); i++) {
+			blocks[i] = A::alloc(16 + (i * 7) % 200);
+		}
+		// Out of order, like objects with different lifetimes.
+		for (uint32_t i = 0; i < blocks.size(); i++) {
+			A::free(blocks[(i * 379) % blocks.size()]);
+		}
+	}
+	return OS::get_singleton()->get_ticks_usec() - begin;
+}
+
+struct SystemAllocator {
+	static void *alloc(size_t p_bytes) { return ::malloc(p_bytes); }
+	static void free(void *p_memory) { ::free(p_memory); }
+};
+
+TEST_CASE_PENDING("[SmallObjectAllocator] Benchmark against the system allocator") {
+	const int rounds = 3000;
+	MESSAGE(vformat("System allocator: %d usec.", benchmark_allocator<SystemAllocator>(rounds)));
+	MESSAGE(vformat("Small object allocator: %d usec.", benchmark_allocator<SmallObjectAllocator>(rounds)));
+}
+
+} // namespace TestSmallObjectAllocator
+
+#endif // TEST_SMALL_OBJECT_ALLOCATOR_H
@@ -0,0 +1,130 @@
+/*************************************************************************/
+/*  test_string_name.h                                                   */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_STRING_NAME_H
+#define TEST_STRING_NAME_H
+
+#include "core/os/os.h"
+#include "core/os/worker_thread_pool.h"
+#include "core/string/string_name.h"
+#include "core/templates/local_vector.h"
+
+#include "tests/test_macros.h"
+
+namespace TestStringName {
+
+TEST_CASE("[StringName] Equal names share their data") {
+	const StringName a = "test_string_name_equal";
+	const StringName b = String("test_string_name_") + "equal";
+	const StringName c = StringName::search("test_string_name_equal");
+
+	CHECK(a == b);
+	CHECK(a.data_unique_pointer() == b.data_unique_pointer());
+	CHECK(a == c);
+	CHECK(a.hash() == String("test_string_name_equal").hash());
+	CHECK(StringName::search("test_string_name_missing") == StringName());
+}
+
+TEST_CASE("[StringName] Names are freed when unreferenced") {
+	{
+		StringName name = String("test_string_name_freed");
+		CHECK(StringName::search("test_string_name_freed") == name);
+	}
+	CHECK(StringName::search("test_string_name_freed") == StringName());
+}
+
+struct Interner {
+	LocalVector<String> names;
+	LocalVector<const void *> data;
+	int repeats = 1;
+
+	void intern(uint32_t p_index, void *p_userdata) {
+		for (int r = 0; r < repeats; r++) {
+			for (uint32_t i = 0; i < names.size(); i++) {
+				// Threads go through the names in different orders, so they create and free the same names concurrently.
+				const uint32_t index = (i * 7 + p_index * 131) % names.size();
+				StringName name = names[index];
+				if (r == 0 && p_index == 0) {
+					data[index] = name.data_unique_pointer();
+				}
+			}
+		}
+	}
+};
+
+TEST_CASE("[StringName] Create names on multiple threads") {
+	Interner interner;
+	LocalVector<StringName> kept;
+	for (int i = 0; i < 2000; i++) {
+		interner.names.push_back("test_string_name_thread_" + itos(i));
+		// Keep half of the names alive, the others are created and freed by the threads.
+		if (i % 2 == 0) {
+			kept.push_back(interner.names[i]);
+		}
+	}
+	interner.data.resize(interner.names.size());
+
+	WorkerThreadPool::GroupID group = WorkerThreadPool::get_singleton()->add_template_group_task(&interner, &Interner::intern, (void *)nullptr, 16);
+	WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group);
+
+	for (uint32_t i = 0; i < kept.size(); i++) {
+		CHECK(kept[i].data_unique_pointer() == interner.data[i * 2]);
+		CHECK(StringName(interner.names[i * 2]).data_unique_pointer() == kept[i].data_unique_pointer());
+	}
+	for (uint32_t i = 1; i < interner.names.size(); i += 2) {
+		CHECK(StringName::search(interner.names[i]) == StringName());
+	}
+}
+
+TEST_CASE_PENDING("[StringName] Benchmark creating names from strings on multiple threads") {
+	Interner interner;
+	LocalVector<StringName> kept;
+	for (int i = 0; i < 20000; i++) {
+		interner.names.push_back("test_string_name_benchmark_" + itos(i));
+		if (i % 2 == 0) {
+			kept.push_back(interner.names[i]);
+		}
+	}
+	interner.data.resize(interner.names.size());
+	interner.repeats = 20;
+
+	const int thread_count = MAX(1, OS::get_singleton()->get_processor_count());
+	for (int tasks = 1; tasks <= thread_count; tasks *= 2) {
+		const uint64_t begin = OS::get_singleton()->get_ticks_usec();
+		WorkerThreadPool::GroupID group = WorkerThreadPool::get_singleton()->add_template_group_task(&interner, &Interner::intern, (void *)nullptr, tasks, tasks);
+		WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group);
+		const uint64_t usec = OS::get_singleton()->get_ticks_usec() - begin;
+		MESSAGE(vformat("%d threads created %d names in %d usec.", tasks, tasks * interner.repeats * interner.names.size(), usec));
+	}
+}
+
+} // namespace TestStringName
+
+#endif // TEST_STRING_NAME_H
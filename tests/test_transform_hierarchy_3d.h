@@ -0,0 +1,185 @@
+/*************************************************************************/
+/*  test_transform_hierarchy_3d.h                                        */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_TRANSFORM_HIERARCHY_3D_H
+#define TEST_TRANSFORM_HIERARCHY_3D_H
+
+#include "scene/3d/node_3d.h"
+#include "scene/3d/transform_hierarchy_3d.h"
+
+#include "tests/test_macros.h"
+
+namespace TestTransformHierarchy3D {
+
+// Nodes are only translated, so their global positions are the sums of the ones of their parents.
+static Node3D *_create_child(Node *p_parent, const Vector3 &p_position) {
+	Node3D *node = memnew(Node3D);
+	node->set_position(p_position);
+	if (p_parent) {
+		p_parent->add_child(node);
+	}
+	return node;
+}
+
+TEST_CASE("[TransformHierarchy3D] Compute global transforms") {
+	TransformHierarchy3D hierarchy;
+	Node3D *root = _create_child(nullptr, Vector3(1, 0, 0));
+	Node3D *child = _create_child(root, Vector3(0, 2, 0));
+	Node3D *grandchild = _create_child(child, Vector3(0, 0, 3));
+	hierarchy.add_node(root);
+	hierarchy.add_node(child);
+	hierarchy.add_node(grandchild);
+
+	CHECK_FALSE(hierarchy.is_global_transform_valid(grandchild));
+	hierarchy.update();
+	CHECK(hierarchy.is_global_transform_valid(grandchild));
+	CHECK(hierarchy.get_global_transform(grandchild).origin == Vector3(1, 2, 3));
+
+	// Only the parent changed, its children are updated with it.
+	child->set_position(Vector3(0, 4, 0));
+	hierarchy.set_dirty(child);
+	CHECK(hierarchy.is_global_transform_valid(root));
+	CHECK_FALSE(hierarchy.is_global_transform_valid(grandchild));
+	hierarchy.update();
+	CHECK(hierarchy.get_global_transform(child).origin == Vector3(1, 4, 0));
+	CHECK(hierarchy.get_global_transform(grandchild).origin == Vector3(1, 4, 3));
+
+	memdelete(root);
+}
+
+TEST_CASE("[TransformHierarchy3D] Change versions only with the node and its parents") {
+	TransformHierarchy3D hierarchy;
+	Node3D *root = _create_child(nullptr, Vector3(1, 0, 0));
+	Node3D *child = _create_child(root, Vector3(0, 2, 0));
+	Node3D *grandchild = _create_child(child, Vector3(0, 0, 3));
+	Node3D *other = _create_child(root, Vector3(0, 4, 0));
+	hierarchy.add_node(root);
+	hierarchy.add_node(child);
+	hierarchy.add_node(other);
+	hierarchy.add_node(grandchild);
+	hierarchy.update();
+
+	uint32_t version = 0;
+	uint32_t new_version = 0;
+	CHECK(hierarchy.is_global_transform_valid(grandchild, &version));
+
+	// A sibling of the parent changing keeps the cached transforms of the grandchild.
+	other->set_position(Vector3(0, 5, 0));
+	hierarchy.set_dirty(other);
+	CHECK(hierarchy.is_global_transform_valid(grandchild, &new_version));
+	CHECK(new_version == version);
+
+	root->set_position(Vector3(2, 0, 0));
+	hierarchy.set_dirty(root);
+	CHECK_FALSE(hierarchy.is_global_transform_valid(grandchild, &new_version));
+	CHECK(new_version != version);
+
+	// The versions don't change with the update, only the validity.
+	version = new_version;
+	hierarchy.update();
+	CHECK(hierarchy.is_global_transform_valid(grandchild, &new_version));
+	CHECK(new_version == version);
+	CHECK(hierarchy.get_global_transform(grandchild).origin == Vector3(2, 2, 3));
+
+	memdelete(root);
+}
+
+TEST_CASE("[TransformHierarchy3D] Point the children of moved nodes to their new index") {
+	TransformHierarchy3D hierarchy;
+	Node3D *root = _create_child(nullptr, Vector3(1, 0, 0));
+	Node3D *first = _create_child(root, Vector3(0, 1, 0));
+	Node3D *second = _create_child(root, Vector3(0, 2, 0));
+	Node3D *last = _create_child(root, Vector3(0, 3, 0));
+	Node3D *first_child = _create_child(first, Vector3(0, 0, 1));
+	Node3D *last_child = _create_child(last, Vector3(0, 0, 3));
+	hierarchy.add_node(root);
+	hierarchy.add_node(first);
+	hierarchy.add_node(second);
+	hierarchy.add_node(last);
+	hierarchy.add_node(first_child);
+	hierarchy.add_node(last_child);
+	hierarchy.update();
+
+	// Removing the first node moves the last one of its level in its place.
+	hierarchy.remove_node(first_child);
+	hierarchy.remove_node(first);
+	root->remove_child(first);
+	memdelete(first);
+
+	last->set_position(Vector3(0, 5, 0));
+	hierarchy.set_dirty(last);
+	CHECK_FALSE(hierarchy.is_global_transform_valid(last_child));
+	hierarchy.update();
+	CHECK(hierarchy.get_global_transform(second).origin == Vector3(1, 2, 0));
+	CHECK(hierarchy.get_global_transform(last).origin == Vector3(1, 5, 0));
+	CHECK(hierarchy.get_global_transform(last_child).origin == Vector3(1, 5, 3));
+
+	memdelete(root);
+}
+
+TEST_CASE("[TransformHierarchy3D] Move subtrees that change top level") {
+	TransformHierarchy3D hierarchy;
+	Node3D *root = _create_child(nullptr, Vector3(1, 0, 0));
+	Node3D *child = _create_child(root, Vector3(0, 2, 0));
+	Node3D *grandchild = _create_child(child, Vector3(0, 0, 3));
+	Node3D *other = _create_child(root, Vector3(0, 4, 0));
+	hierarchy.add_node(root);
+	hierarchy.add_node(child);
+	hierarchy.add_node(other);
+	hierarchy.add_node(grandchild);
+	hierarchy.update();
+
+	// The top level node no longer follows its parent, but its children follow it.
+	child->set_as_top_level(true);
+	hierarchy.update_subtree(child);
+	hierarchy.update();
+	CHECK(hierarchy.get_global_transform(child).origin == Vector3(0, 2, 0));
+	CHECK(hierarchy.get_global_transform(grandchild).origin == Vector3(0, 2, 3));
+	CHECK(hierarchy.get_global_transform(other).origin == Vector3(1, 4, 0));
+
+	root->set_position(Vector3(5, 0, 0));
+	hierarchy.set_dirty(root);
+	CHECK(hierarchy.is_global_transform_valid(grandchild));
+	hierarchy.update();
+	CHECK(hierarchy.get_global_transform(grandchild).origin == Vector3(0, 2, 3));
+	CHECK(hierarchy.get_global_transform(other).origin == Vector3(5, 4, 0));
+
+	child->set_as_top_level(false);
+	hierarchy.update_subtree(child);
+	hierarchy.update();
+	CHECK(hierarchy.get_global_transform(child).origin == Vector3(5, 2, 0));
+	CHECK(hierarchy.get_global_transform(grandchild).origin == Vector3(5, 2, 3));
+
+	memdelete(root);
+}
+
+} // namespace TestTransformHierarchy3D
+
+#endif // TEST_TRANSFORM_HIERARCHY_3D_H
@@ -0,0 +1,155 @@
+/*************************************************************************/
+/*  test_worker_thread_pool.h                                            */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_WORKER_THREAD_POOL_H
+#define TEST_WORKER_THREAD_POOL_H
+
+#include "core/os/worker_thread_pool.h"
+#include "core/templates/local_vector.h"
+
+#include "tests/test_macros.h"
+
+#include <atomic>
+
+namespace TestWorkerThreadPool {
+
+struct Counter {
+	LocalVector<uint32_t> hits;
+	std::atomic<uint32_t> total;
+	std::atomic<uint32_t> order;
+	uint32_t first_finished = 0;
+	uint32_t second_started = 0;
+	int low_priority_thread = -2;
+
+	void hit(uint32_t p_index, void *p_userdata) {
+		hits[p_index]++;
+		total.fetch_add(1);
+	}
+
+	void count(uint32_t p_index, void *p_userdata) {
+		total.fetch_add(1);
+	}
+
+	void nested(uint32_t p_index, uint32_t p_elements) {
+		WorkerThreadPool::GroupID group = WorkerThreadPool::get_singleton()->add_template_group_task(this, &Counter::count, nullptr, p_elements);
+		WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group);
+	}
+
+	void first(void *p_userdata) {
+		first_finished = order.fetch_add(1) + 1;
+	}
+
+	void second(void *p_userdata) {
+		second_started = order.fetch_add(1) + 1;
+	}
+
+	void low_priority(void *p_userdata) {
+		low_priority_thread = WorkerThreadPool::get_singleton()->get_thread_index();
+	}
+
+	Counter() {
+		total.store(0);
+		order.store(0);
+	}
+};
+
+TEST_CASE("[WorkerThreadPool] Group task processes every element once") {
+	Counter counter;
+	counter.hits.resize(10000);
+	for (uint32_t i = 0; i < counter.hits.size(); i++) {
+		counter.hits[i] = 0;
+	}
+
+	WorkerThreadPool::GroupID group = WorkerThreadPool::get_singleton()->add_template_group_task(&counter, &Counter::hit, nullptr, counter.hits.size());
+	WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group);
+
+	bool all_once = true;
+	for (uint32_t i = 0; i < counter.hits.size(); i++) {
+		if (counter.hits[i] != 1) {
+			all_once = false;
+		}
+	}
+	CHECK_MESSAGE(all_once, "Every element should have been processed exactly once.");
+	CHECK(counter.total.load() == 10000);
+}
+
+TEST_CASE("[WorkerThreadPool] Empty group task completes immediately") {
+	Counter counter;
+	WorkerThreadPool::GroupID group = WorkerThreadPool::get_singleton()->add_template_group_task(&counter, &Counter::hit, nullptr, 0);
+	CHECK(WorkerThreadPool::get_singleton()->is_group_task_completed(group));
+	WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group);
+	CHECK(counter.total.load() == 0);
+}
+
+TEST_CASE("[WorkerThreadPool] Nested group tasks") {
+	Counter counter;
+
+	// Each outer element spawns and waits on its own group, which must not deadlock
+	// even when every worker is busy waiting.
+	const uint32_t outer = 32;
+	WorkerThreadPool::GroupID group = WorkerThreadPool::get_singleton()->add_template_group_task(&counter, &Counter::nested, 64u, outer);
+	WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group);
+
+	CHECK(counter.total.load() == outer * 64);
+}
+
+TEST_CASE("[WorkerThreadPool] Task dependencies") {
+	Counter counter;
+
+	WorkerThreadPool::TaskID first = WorkerThreadPool::get_singleton()->add_template_task(&counter, &Counter::first, nullptr);
+	WorkerThreadPool::TaskID second = WorkerThreadPool::get_singleton()->add_template_task(&counter, &Counter::second, nullptr, &first, 1);
+
+	WorkerThreadPool::get_singleton()->wait_for_task_completion(second);
+	CHECK(WorkerThreadPool::get_singleton()->is_task_completed(first));
+	WorkerThreadPool::get_singleton()->wait_for_task_completion(first);
+
+	CHECK_MESSAGE(counter.first_finished == 1, "The dependency should run first.");
+	CHECK_MESSAGE(counter.second_started == 2, "The dependent task should run after its dependency.");
+}
+
+TEST_CASE("[WorkerThreadPool] Low priority tasks only run on workers") {
+	Counter counter;
+	counter.hits.resize(1000);
+	for (uint32_t i = 0; i < counter.hits.size(); i++) {
+		counter.hits[i] = 0;
+	}
+
+	WorkerThreadPool::TaskID task = WorkerThreadPool::get_singleton()->add_template_task(&counter, &Counter::low_priority, nullptr, nullptr, 0, false);
+	WorkerThreadPool::GroupID group = WorkerThreadPool::get_singleton()->add_template_group_task(&counter, &Counter::hit, nullptr, counter.hits.size());
+	WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group);
+	WorkerThreadPool::get_singleton()->wait_for_task_completion(task);
+
+	CHECK(counter.total.load() == 1000);
+	CHECK_MESSAGE(counter.low_priority_thread >= 0, "Waiting on the main thread should leave the low priority task to the workers.");
+}
+
+} // namespace TestWorkerThreadPool
+
+#endif // TEST_WORKER_THREAD_POOL_H